@@ -11,6 +11,7 @@
 #include "Graph/GraphDevice.h"
 #include "Resource/util-resource.h"
 #include "String/StringUtil.h"
+#include "Types/FrameArena.h"
 #include "UI/MainWindow.h"
 #include "Windows/FileUtil.h"
 
@@ -587,6 +588,12 @@ void ff::AppGlobals::FrameResetTimer(IMainWindow *window)
 
 bool ff::AppGlobals::FrameAdvance(IMainWindow *window)
 {
+	// Everything allocated for the previous frame is done with
+	ff::GetFrameArena().Reset();
+
+	// Free shared objects that other threads let go of
+	ff::MergeBiasedRefs();
+
 	_advancingGame++;
 
 	_frameTimer.SetTimeScale(GetTimeScale());
@@ -0,0 +1,1461 @@
+#include "pch.h"
+#include "Data/Data.h"
+#include "Dict/BinaryDict.h"
+#include "Dict/Dict.h"
+#include "Dict/Value.h"
+#include "Globals/ProcessGlobals.h"
+#include "String/StringCache.h"
+
+// Binary dict versions:
+// 0: first version
+static const DWORD BINARY_DICT_MAGIC = 0x54434942; // "BICT"
+static const DWORD BINARY_DICT_VERSION = 0;
+static const size_t BINARY_DICT_ALIGN = 8;
+static const size_t BINARY_DICT_KEYS_PER_BUCKET = 4;
+static const DWORD BINARY_DICT_MAX_SEED = 0x00FFFFFF;
+
+struct BinaryDictHeader
+{
+	DWORD magic;
+	DWORD version;
+	DWORD size;
+	DWORD table;
+};
+
+// Followed by hash_t hashes[count] and Slot slots[count]
+struct BinaryDictTable
+{
+	DWORD count;
+	DWORD index; // offset of a BinaryDictIndex, zero when there isn't one (always zero before FrozenDict)
+};
+
+// A minimal perfect hash for the keys of one table, followed by DWORD seeds[buckets]
+// and DWORD positions[count]. A key's hash picks its bucket, the bucket's seed picks
+// a unique position, and that position has the key's index in the table.
+struct BinaryDictIndex
+{
+	DWORD buckets;
+	DWORD reserved;
+};
+
+// Where a value that doesn't fit in a slot was saved
+struct BinaryDictRange
+{
+	DWORD offset;
+	DWORD count;
+};
+
+struct ff::details::BinaryDictSlot
+{
+	DWORD type;
+	DWORD name; // offset of the text, zero when only the hash was saved
+
+	union
+	{
+		int _int; // also bool
+		float _float;
+		double _double;
+		int _point[2];
+		float _pointF[2];
+		BinaryDictRange _range;
+	};
+};
+
+static_assert(sizeof(BinaryDictHeader) % BINARY_DICT_ALIGN == 0, "Header must keep the table aligned");
+static_assert(sizeof(BinaryDictTable) % BINARY_DICT_ALIGN == 0, "Table must keep the hashes aligned");
+static_assert(sizeof(BinaryDictIndex) % BINARY_DICT_ALIGN == 0, "Index must keep the seeds aligned");
+static_assert(sizeof(ff::RectInt) == 16 && sizeof(ff::RectFloat) == 16 && sizeof(GUID) == 16, "Bad 16 byte value");
+
+// Both of these map 32 bits onto the range with a multiply instead of a divide
+static size_t GetIndexBucket(ff::hash_t hash, size_t buckets)
+{
+	return (size_t)(((hash >> 32) * (uint64_t)buckets) >> 32);
+}
+
+static size_t GetIndexPosition(ff::hash_t hash, DWORD seed, size_t count)
+{
+	uint64_t mixed = hash + seed * 0x9E3779B97F4A7C15ull;
+	mixed = (mixed ^ (mixed >> 31)) * 0xBF58476D1CE4E5B9ull;
+	mixed ^= mixed >> 29;
+
+	return (size_t)(((mixed & 0xFFFFFFFF) * (uint64_t)count) >> 32);
+}
+
+// Builds the whole thing in one vector. Nothing is ever written before the thing
+// that points to it, which the reader depends on to not get stuck in a loop.
+class BinaryDictWriter
+{
+public:
+	BinaryDictWriter(ff::Vector<BYTE> &data, bool nameHashOnly, bool perfectHash);
+
+	bool WriteHeader(const ff::Dict &dict, bool chain);
+
+private:
+	typedef ff::details::BinaryDictSlot Slot;
+
+	struct Key
+	{
+		ff::hash_t hash;
+		ff::String name;
+	};
+
+	size_t Alloc(size_t size);
+	size_t WriteBytes(const void *data, size_t size);
+	size_t WriteText(ff::StringRef text);
+	bool WriteTable(const ff::Dict &dict, bool chain, size_t &table);
+	bool WriteIndex(const ff::Vector<Key> &keys, size_t &index);
+	bool WriteSlot(size_t offset, const ff::ValueHandle *value);
+	bool WriteSlot(size_t offset, ff::Value *value);
+	bool WriteHandle(const ff::ValueHandle *value, Slot &slot);
+	bool WriteValue(ff::Value *value, Slot &slot);
+
+	ff::Vector<BYTE> &_data;
+	ff::Map<ff::String, size_t> _texts;
+	bool _nameHashOnly;
+	bool _perfectHash;
+};
+
+BinaryDictWriter::BinaryDictWriter(ff::Vector<BYTE> &data, bool nameHashOnly, bool perfectHash)
+	: _data(data)
+	, _nameHashOnly(nameHashOnly)
+	, _perfectHash(perfectHash)
+{
+}
+
+bool BinaryDictWriter::WriteHeader(const ff::Dict &dict, bool chain)
+{
+	size_t header = Alloc(sizeof(BinaryDictHeader));
+	size_t table = 0;
+	assertRetVal(WriteTable(dict, chain, table), false);
+	assertRetVal(_data.Size() <= (size_t)std::numeric_limits<DWORD>::max(), false);
+
+	BinaryDictHeader &headerData = *reinterpret_cast<BinaryDictHeader *>(_data.Data(header, sizeof(BinaryDictHeader)));
+	headerData.magic = BINARY_DICT_MAGIC;
+	headerData.version = BINARY_DICT_VERSION;
+	headerData.size = (DWORD)_data.Size();
+	headerData.table = (DWORD)table;
+
+	return true;
+}
+
+// Returns the aligned offset of zeroed bytes. Any pointer into the data is invalid after this.
+size_t BinaryDictWriter::Alloc(size_t size)
+{
+	size_t offset = (_data.Size() + BINARY_DICT_ALIGN - 1) & ~(BINARY_DICT_ALIGN - 1);
+	size_t end = offset + size;
+
+	if (end > _data.Allocated())
+	{
+		// Vectors grow slowly when they are this big
+		_data.Reserve(std::max(end, _data.Allocated() * 2));
+	}
+
+	size_t oldSize = _data.Size();
+	_data.Resize(end);
+
+	if (end > oldSize)
+	{
+		std::memset(_data.Data(oldSize, end - oldSize), 0, end - oldSize);
+	}
+
+	return offset;
+}
+
+size_t BinaryDictWriter::WriteBytes(const void *data, size_t size)
+{
+	size_t offset = Alloc(size);
+
+	if (size)
+	{
+		std::memcpy(_data.Data(offset, size), data, size);
+	}
+
+	return offset;
+}
+
+// Text is a DWORD length and then null terminated chars. The same text is only saved once.
+size_t BinaryDictWriter::WriteText(ff::StringRef text)
+{
+	ff::BucketIter iter = _texts.Get(text);
+	if (iter != ff::INVALID_ITER)
+	{
+		return _texts.ValueAt(iter);
+	}
+
+	DWORD count = (DWORD)text.size();
+	size_t charsSize = (text.size() + 1) * sizeof(wchar_t);
+	size_t offset = Alloc(sizeof(DWORD) + charsSize);
+
+	std::memcpy(_data.Data(offset, sizeof(DWORD)), &count, sizeof(DWORD));
+	std::memcpy(_data.Data(offset + sizeof(DWORD), charsSize), text.c_str(), charsSize);
+
+	_texts.SetKey(text, offset);
+	return offset;
+}
+
+bool BinaryDictWriter::WriteTable(const ff::Dict &dict, bool chain, size_t &table)
+{
+	// Values that only have a legacy name hash can't be found in a binary dict
+	assertRetVal(dict.GetLegacyHashes(chain).IsEmpty(), false);
+
+	ff::Vector<ff::String> names = dict.GetAllNames(chain, false, false);
+	ff::Vector<Key> keys;
+	keys.Reserve(names.Size());
+
+	for (ff::String &name : names)
+	{
+		Key key;
+		key.hash = ff::StringCache::HashString(name);
+		key.name = std::move(name);
+		keys.Push(std::move(key));
+	}
+
+	std::sort(keys.begin(), keys.end(), [](const Key &lhs, const Key &rhs)
+	{
+		return lhs.hash < rhs.hash;
+	});
+
+	size_t count = keys.Size();
+	size_t hashes = sizeof(BinaryDictTable);
+	size_t slots = hashes + count * sizeof(ff::hash_t);
+	table = Alloc(slots + count * sizeof(Slot));
+
+	BinaryDictTable tableData = { (DWORD)count, 0 };
+	std::memcpy(_data.Data(table, sizeof(tableData)), &tableData, sizeof(tableData));
+
+	for (size_t i = 0; i < count; i++)
+	{
+		std::memcpy(_data.Data(table + hashes + i * sizeof(ff::hash_t), sizeof(ff::hash_t)), &keys[i].hash, sizeof(ff::hash_t));
+	}
+
+	for (size_t i = 0; i < count; i++)
+	{
+		size_t slot = table + slots + i * sizeof(Slot);
+		assertRetVal(WriteSlot(slot, dict.GetHandle(keys[i].name, chain)), false);
+
+		if (!_nameHashOnly)
+		{
+			DWORD name = (DWORD)WriteText(keys[i].name);
+			std::memcpy(_data.Data(slot + offsetof(Slot, name), sizeof(DWORD)), &name, sizeof(DWORD));
+		}
+	}
+
+	if (_perfectHash && count)
+	{
+		size_t index = 0;
+		assertRetVal(WriteIndex(keys, index), false);
+
+		tableData.index = (DWORD)index;
+		std::memcpy(_data.Data(table, sizeof(tableData)), &tableData, sizeof(tableData));
+	}
+
+	return true;
+}
+
+// Hash and displace: the biggest buckets pick a seed first, while there are still lots of free positions
+bool BinaryDictWriter::WriteIndex(const ff::Vector<Key> &keys, size_t &index)
+{
+	size_t count = keys.Size();
+	size_t buckets = (count + BINARY_DICT_KEYS_PER_BUCKET - 1) / BINARY_DICT_KEYS_PER_BUCKET;
+
+	// Sort the keys by bucket, biggest buckets first
+	ff::Vector<size_t> bucketSizes;
+	bucketSizes.Resize(buckets);
+	std::memset(bucketSizes.Data(), 0, buckets * sizeof(size_t));
+
+	for (const Key &key : keys)
+	{
+		bucketSizes[GetIndexBucket(key.hash, buckets)]++;
+	}
+
+	ff::Vector<size_t> bucketKeys;
+	bucketKeys.Resize(count);
+
+	for (size_t i = 0; i < count; i++)
+	{
+		bucketKeys[i] = i;
+	}
+
+	std::sort(bucketKeys.begin(), bucketKeys.end(), [&keys, &bucketSizes, buckets](size_t lhs, size_t rhs)
+	{
+		size_t lhsBucket = GetIndexBucket(keys[lhs].hash, buckets);
+		size_t rhsBucket = GetIndexBucket(keys[rhs].hash, buckets);
+
+		return (bucketSizes[lhsBucket] != bucketSizes[rhsBucket])
+			? bucketSizes[lhsBucket] > bucketSizes[rhsBucket]
+			: lhsBucket < rhsBucket;
+	});
+
+	ff::Vector<DWORD> seeds;
+	ff::Vector<DWORD> positions;
+	ff::Vector<bool> used;
+	ff::Vector<size_t> bucketPositions;
+	seeds.Resize(buckets);
+	positions.Resize(count);
+	used.Resize(count);
+	std::memset(seeds.Data(), 0, buckets * sizeof(DWORD));
+	std::fill(used.begin(), used.end(), false);
+
+	for (size_t start = 0, end = 0; start < count; start = end)
+	{
+		size_t bucket = GetIndexBucket(keys[bucketKeys[start]].hash, buckets);
+		for (end = start + 1; end < count && GetIndexBucket(keys[bucketKeys[end]].hash, buckets) == bucket; end++);
+
+		// Every key in the bucket needs a position that isn't used yet
+		auto findPositions = [&](DWORD seed)
+		{
+			bucketPositions.Clear();
+
+			for (size_t i = start; i < end; i++)
+			{
+				size_t position = GetIndexPosition(keys[bucketKeys[i]].hash, seed, count);
+				if (used[position] || std::find(bucketPositions.begin(), bucketPositions.end(), position) != bucketPositions.end())
+				{
+					return false;
+				}
+
+				bucketPositions.Push(position);
+			}
+
+			return true;
+		};
+
+		DWORD seed = 0;
+		while (!findPositions(seed))
+		{
+			assertRetVal(++seed < BINARY_DICT_MAX_SEED, false);
+		}
+
+		seeds[bucket] = seed;
+
+		for (size_t i = start; i < end; i++)
+		{
+			size_t position = bucketPositions[i - start];
+			used[position] = true;
+			positions[position] = (DWORD)bucketKeys[i];
+		}
+	}
+
+	BinaryDictIndex indexData = { (DWORD)buckets, 0 };
+	index = Alloc(sizeof(indexData) + seeds.ByteSize() + positions.ByteSize());
+	std::memcpy(_data.Data(index, sizeof(indexData)), &indexData, sizeof(indexData));
+	std::memcpy(_data.Data(index + sizeof(indexData), seeds.ByteSize()), seeds.Data(), seeds.ByteSize());
+	std::memcpy(_data.Data(index + sizeof(indexData) + seeds.ByteSize(), positions.ByteSize()), positions.Data(), positions.ByteSize());
+
+	return true;
+}
+
+bool BinaryDictWriter::WriteSlot(size_t offset, const ff::ValueHandle *value)
+{
+	Slot slot;
+	std::memset(&slot, 0, sizeof(slot));
+	assertRetVal(WriteHandle(value, slot), false);
+
+	std::memcpy(_data.Data(offset, sizeof(Slot)), &slot, sizeof(Slot));
+	return true;
+}
+
+bool BinaryDictWriter::WriteSlot(size_t offset, ff::Value *value)
+{
+	Slot slot;
+	std::memset(&slot, 0, sizeof(slot));
+	assertRetVal(WriteValue(value, slot), false);
+
+	std::memcpy(_data.Data(offset, sizeof(Slot)), &slot, sizeof(Slot));
+	return true;
+}
+
+// Inline scalars go straight into the slot, asking for their Value would create one that the dict keeps forever
+bool BinaryDictWriter::WriteHandle(const ff::ValueHandle *value, Slot &slot)
+{
+	assertRetVal(value && value->IsValid(), false);
+
+	if (!value->IsInline())
+	{
+		return WriteValue(value->GetValue(), slot);
+	}
+
+	slot.type = (DWORD)value->GetType();
+
+	switch (value->GetType())
+	{
+	default:
+		assertRetVal(false, false);
+
+	case ff::Value::Type::Null:
+		break;
+
+	case ff::Value::Type::Bool:
+		slot._int = value->AsBool() ? 1 : 0;
+		break;
+
+	case ff::Value::Type::Double:
+		slot._double = value->AsDouble();
+		break;
+
+	case ff::Value::Type::Float:
+		slot._float = value->AsFloat();
+		break;
+
+	case ff::Value::Type::Int:
+		slot._int = value->AsInt();
+		break;
+
+	case ff::Value::Type::Point:
+		slot._point[0] = value->AsPoint().x;
+		slot._point[1] = value->AsPoint().y;
+		break;
+
+	case ff::Value::Type::PointF:
+		slot._pointF[0] = value->AsPointF().x;
+		slot._pointF[1] = value->AsPointF().y;
+		break;
+	}
+
+	return true;
+}
+
+bool BinaryDictWriter::WriteValue(ff::Value *value, Slot &slot)
+{
+	assertRetVal(value, false);
+
+	slot.type = (DWORD)value->GetType();
+
+	switch (value->GetType())
+	{
+	default:
+		// Can't be saved, just like SaveDict
+		slot.type = (DWORD)ff::Value::Type::Null;
+		break;
+
+	case ff::Value::Type::Null:
+		break;
+
+	case ff::Value::Type::Bool:
+		slot._int = value->AsBool() ? 1 : 0;
+		break;
+
+	case ff::Value::Type::Double:
+		slot._double = value->AsDouble();
+		break;
+
+	case ff::Value::Type::Float:
+		slot._float = value->AsFloat();
+		break;
+
+	case ff::Value::Type::Int:
+		slot._int = value->AsInt();
+		break;
+
+	case ff::Value::Type::Point:
+		slot._point[0] = value->AsPoint().x;
+		slot._point[1] = value->AsPoint().y;
+		break;
+
+	case ff::Value::Type::PointF:
+		slot._pointF[0] = value->AsPointF().x;
+		slot._pointF[1] = value->AsPointF().y;
+		break;
+
+	case ff::Value::Type::Rect:
+		slot._range.offset = (DWORD)WriteBytes(&value->AsRect(), sizeof(ff::RectInt));
+		slot._range.count = sizeof(ff::RectInt);
+		break;
+
+	case ff::Value::Type::RectF:
+		slot._range.offset = (DWORD)WriteBytes(&value->AsRectF(), sizeof(ff::RectFloat));
+		slot._range.count = sizeof(ff::RectFloat);
+		break;
+
+	case ff::Value::Type::Guid:
+		slot._range.offset = (DWORD)WriteBytes(&value->AsGuid(), sizeof(GUID));
+		slot._range.count = sizeof(GUID);
+		break;
+
+	case ff::Value::Type::String:
+		slot._range.offset = (DWORD)WriteText(value->AsString());
+		slot._range.count = (DWORD)value->AsString().size();
+		break;
+
+	case ff::Value::Type::Data:
+		{
+			ff::IData *data = value->AsData();
+			size_t size = data ? data->GetSize() : 0;
+
+			slot._range.offset = (DWORD)WriteBytes(size ? data->GetMem() : nullptr, size);
+			slot._range.count = (DWORD)size;
+		}
+		break;
+
+	case ff::Value::Type::Dict:
+		{
+			size_t table = 0;
+			assertRetVal(WriteTable(value->AsDict(), true, table), false);
+
+			slot._range.offset = (DWORD)table;
+			std::memcpy(&slot._range.count, _data.Data(table, sizeof(DWORD)), sizeof(DWORD));
+		}
+		break;
+
+	case ff::Value::Type::DoubleVector:
+		{
+			const ff::Vector<double> &doubles = value->AsDoubleVector();
+			slot._range.offset = (DWORD)WriteBytes(doubles.Size() ? doubles.ConstData() : nullptr, doubles.ByteSize());
+			slot._range.count = (DWORD)doubles.Size();
+		}
+		break;
+
+	case ff::Value::Type::FloatVector:
+		{
+			const ff::Vector<float> &floats = value->AsFloatVector();
+			slot._range.offset = (DWORD)WriteBytes(floats.Size() ? floats.ConstData() : nullptr, floats.ByteSize());
+			slot._range.count = (DWORD)floats.Size();
+		}
+		break;
+
+	case ff::Value::Type::IntVector:
+		{
+			const ff::Vector<int> &ints = value->AsIntVector();
+			slot._range.offset = (DWORD)WriteBytes(ints.Size() ? ints.ConstData() : nullptr, ints.ByteSize());
+			slot._range.count = (DWORD)ints.Size();
+		}
+		break;
+
+	case ff::Value::Type::DataVector:
+		{
+			const ff::Vector<ff::ComPtr<ff::IData>> &datas = value->AsDataVector();
+			size_t ranges = Alloc(datas.Size() * sizeof(BinaryDictRange));
+
+			for (size_t i = 0; i < datas.Size(); i++)
+			{
+				ff::IData *data = datas[i];
+				size_t size = data ? data->GetSize() : 0;
+
+				BinaryDictRange range;
+				range.offset = (DWORD)WriteBytes(size ? data->GetMem() : nullptr, size);
+				range.count = (DWORD)size;
+
+				std::memcpy(_data.Data(ranges + i * sizeof(range), sizeof(range)), &range, sizeof(range));
+			}
+
+			slot._range.offset = (DWORD)ranges;
+			slot._range.count = (DWORD)datas.Size();
+		}
+		break;
+
+	case ff::Value::Type::StringVector:
+		{
+			const ff::Vector<ff::String> &strings = value->AsStringVector();
+			size_t texts = Alloc(strings.Size() * sizeof(DWORD));
+
+			for (size_t i = 0; i < strings.Size(); i++)
+			{
+				DWORD text = (DWORD)WriteText(strings[i]);
+				std::memcpy(_data.Data(texts + i * sizeof(DWORD), sizeof(DWORD)), &text, sizeof(DWORD));
+			}
+
+			slot._range.offset = (DWORD)texts;
+			slot._range.count = (DWORD)strings.Size();
+		}
+		break;
+
+	case ff::Value::Type::ValueVector:
+		{
+			const ff::Vector<ff::ValuePtr> &values = value->AsValueVector();
+			size_t slots = Alloc(values.Size() * sizeof(Slot));
+
+			for (size_t i = 0; i < values.Size(); i++)
+			{
+				assertRetVal(WriteSlot(slots + i * sizeof(Slot), values[i]), false);
+			}
+
+			slot._range.offset = (DWORD)slots;
+			slot._range.count = (DWORD)values.Size();
+		}
+		break;
+	}
+
+	return true;
+}
+
+bool ff::SaveBinaryDict(const Dict &dict, bool chain, bool nameHashOnly, bool perfectHash, IData **data)
+{
+	assertRetVal(data, false);
+	*data = nullptr;
+
+	ComPtr<IDataVector> dataVector;
+	assertRetVal(CreateDataVector(0, &dataVector), false);
+
+	BinaryDictWriter writer(dataVector->GetVector(), nameHashOnly, perfectHash);
+	assertRetVal(writer.WriteHeader(dict, chain), false);
+
+	*data = dataVector.Detach();
+	return true;
+}
+
+ff::BinaryDict::BinaryDict()
+	: _mem(nullptr)
+	, _size(0)
+	, _hashes(nullptr)
+	, _slots(nullptr)
+	, _count(0)
+	, _indexSeeds(nullptr)
+	, _indexPositions(nullptr)
+	, _indexBuckets(0)
+{
+}
+
+ff::BinaryDict::BinaryDict(const BinaryDict &rhs)
+	: _data(rhs._data)
+	, _mem(rhs._mem)
+	, _size(rhs._size)
+	, _hashes(rhs._hashes)
+	, _slots(rhs._slots)
+	, _count(rhs._count)
+	, _indexSeeds(rhs._indexSeeds)
+	, _indexPositions(rhs._indexPositions)
+	, _indexBuckets(rhs._indexBuckets)
+{
+}
+
+ff::BinaryDict::BinaryDict(BinaryDict &&rhs)
+	: _data(std::move(rhs._data))
+	, _mem(rhs._mem)
+	, _size(rhs._size)
+	, _hashes(rhs._hashes)
+	, _slots(rhs._slots)
+	, _count(rhs._count)
+	, _indexSeeds(rhs._indexSeeds)
+	, _indexPositions(rhs._indexPositions)
+	, _indexBuckets(rhs._indexBuckets)
+{
+	rhs.Close();
+}
+
+ff::BinaryDict::~BinaryDict()
+{
+}
+
+const ff::BinaryDict &ff::BinaryDict::operator=(const BinaryDict &rhs)
+{
+	if (this != &rhs)
+	{
+		_data = rhs._data;
+		_mem = rhs._mem;
+		_size = rhs._size;
+		_hashes = rhs._hashes;
+		_slots = rhs._slots;
+		_count = rhs._count;
+		_indexSeeds = rhs._indexSeeds;
+		_indexPositions = rhs._indexPositions;
+		_indexBuckets = rhs._indexBuckets;
+	}
+
+	return *this;
+}
+
+bool ff::BinaryDict::Open(IData *data)
+{
+	Close();
+	assertRetVal(data, false);
+	noAssertRetVal(data->GetSize() >= sizeof(BinaryDictHeader), false);
+
+	ComPtr<IData> alignedData = data;
+	if ((size_t)data->GetMem() % BINARY_DICT_ALIGN)
+	{
+		// Only happens for data inside of other data, memory mapped files are always aligned
+		ComPtr<IDataVector> dataVector;
+		assertRetVal(CreateDataVector(0, &dataVector), false);
+		dataVector->GetVector().Push(data->GetMem(), data->GetSize());
+		assertRetVal((size_t)dataVector->GetMem() % BINARY_DICT_ALIGN == 0, false);
+
+		alignedData = dataVector;
+	}
+
+	BinaryDictHeader header;
+	std::memcpy(&header, alignedData->GetMem(), sizeof(header));
+
+	// Bad files aren't bugs, so no asserts
+	noAssertRetVal(header.magic == BINARY_DICT_MAGIC && header.version == BINARY_DICT_VERSION, false);
+	noAssertRetVal(header.size >= sizeof(header) && header.size <= alignedData->GetSize(), false);
+	noAssertRetVal(InternalOpen(alignedData, header.size, header.table), false);
+
+	return true;
+}
+
+void ff::BinaryDict::Close()
+{
+	_data = nullptr;
+	_mem = nullptr;
+	_size = 0;
+	_hashes = nullptr;
+	_slots = nullptr;
+	_count = 0;
+	_indexSeeds = nullptr;
+	_indexPositions = nullptr;
+	_indexBuckets = 0;
+}
+
+bool ff::BinaryDict::InternalOpen(IData *data, size_t size, DWORD table)
+{
+	_data = data;
+	_mem = data->GetMem();
+	_size = size;
+
+	const BinaryDictTable *tableData = reinterpret_cast<const BinaryDictTable *>(GetBytes(table, 1, sizeof(BinaryDictTable)));
+	if (!tableData)
+	{
+		Close();
+		return false;
+	}
+
+	size_t count = tableData->count;
+	size_t hashes = table + sizeof(BinaryDictTable);
+	size_t slots = hashes + count * sizeof(hash_t);
+
+	_hashes = reinterpret_cast<const hash_t *>(GetBytes(hashes, count, sizeof(hash_t)));
+	_slots = reinterpret_cast<const Slot *>(GetBytes(slots, count, sizeof(Slot)));
+	_count = count;
+
+	if (!_hashes || !_slots || (tableData->index && count && !InternalOpenIndex(tableData->index)))
+	{
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+bool ff::BinaryDict::InternalOpenIndex(DWORD index)
+{
+	const BinaryDictIndex *indexData = reinterpret_cast<const BinaryDictIndex *>(GetBytes(index, 1, sizeof(BinaryDictIndex)));
+	noAssertRetVal(indexData && indexData->buckets, false);
+
+	size_t buckets = indexData->buckets;
+	size_t seeds = index + sizeof(BinaryDictIndex);
+	size_t positions = seeds + buckets * sizeof(DWORD);
+
+	_indexSeeds = reinterpret_cast<const DWORD *>(GetBytes(seeds, buckets, sizeof(DWORD)));
+	_indexPositions = _indexSeeds ? reinterpret_cast<const DWORD *>(GetBytes(positions, _count, sizeof(DWORD))) : nullptr;
+	_indexBuckets = buckets;
+
+	return _indexPositions != nullptr;
+}
+
+bool ff::BinaryDict::IsValid() const
+{
+	return _mem != nullptr;
+}
+
+bool ff::BinaryDict::IsEmpty() const
+{
+	return _count == 0;
+}
+
+size_t ff::BinaryDict::Size() const
+{
+	return _count;
+}
+
+bool ff::BinaryDict::IsIndexed() const
+{
+	return _indexPositions != nullptr || (IsValid() && !_count);
+}
+
+ff::IData *ff::BinaryDict::GetData() const
+{
+	return _data;
+}
+
+ff::hash_t ff::BinaryDict::KeyHashAt(size_t index) const
+{
+	assertRetVal(index < _count, 0);
+	return _hashes[index];
+}
+
+ff::String ff::BinaryDict::KeyAt(size_t index) const
+{
+	const Slot *slot = SlotAt(index);
+	assertRetVal(slot, String());
+
+	if (slot->name)
+	{
+		size_t count = 0;
+		const wchar_t *chars = GetText(slot->name, count);
+		assertRetVal(chars, String());
+
+		return String(chars, count);
+	}
+
+	// Real strings are only known if they were ever cached
+	return ProcessGlobals::Get()->GetStringCache()->GetString(_hashes[index]);
+}
+
+ff::Value::Type ff::BinaryDict::TypeAt(size_t index) const
+{
+	const Slot *slot = SlotAt(index);
+	assertRetVal(slot, Value::Type::Null);
+
+	return (Value::Type)slot->type;
+}
+
+size_t ff::BinaryDict::IndexOf(ff::StringRef name) const
+{
+	return IndexOfHash(ProcessGlobals::Get()->GetStringCache()->GetHash(name));
+}
+
+size_t ff::BinaryDict::IndexOfHash(hash_t hash) const
+{
+	if (_indexPositions)
+	{
+		// Positions can only be bad in bad data, so they are checked along with the hash
+		DWORD seed = _indexSeeds[GetIndexBucket(hash, _indexBuckets)];
+		size_t index = _indexPositions[GetIndexPosition(hash, seed, _count)];
+
+		return (index < _count && _hashes[index] == hash) ? index : INVALID_SIZE;
+	}
+	else if (_count)
+	{
+		const hash_t *end = _hashes + _count;
+		const hash_t *found = std::lower_bound(_hashes, end, hash);
+
+		if (found != end && *found == hash)
+		{
+			return found - _hashes;
+		}
+	}
+
+	return INVALID_SIZE;
+}
+
+ff::Vector<ff::String> ff::BinaryDict::GetAllNames(bool sorted) const
+{
+	Vector<String> names;
+	names.Reserve(_count);
+
+	for (size_t i = 0; i < _count; i++)
+	{
+		names.Push(KeyAt(i));
+	}
+
+	if (sorted && names.Size())
+	{
+		std::sort(names.begin(), names.end());
+	}
+
+	return names;
+}
+
+bool ff::BinaryDict::GetValueAt(size_t index, Value **value) const
+{
+	const Slot *slot = SlotAt(index);
+	assertRetVal(slot && value, false);
+
+	return CreateValue(*slot, value);
+}
+
+ff::ValuePtr ff::BinaryDict::GetValue(ff::StringRef name) const
+{
+	ValuePtr value;
+	const Slot *slot = FindSlot(name);
+
+	if (slot && !CreateValue(*slot, &value))
+	{
+		value = nullptr;
+	}
+
+	return value;
+}
+
+int ff::BinaryDict::GetInt(ff::StringRef name, int defaultValue) const
+{
+	const Slot *slot = FindSlot(name);
+
+	if (slot)
+	{
+		if (slot->type == (DWORD)Value::Type::Int)
+		{
+			return slot->_int;
+		}
+		else
+		{
+			ValuePtr newValue;
+
+			if (ConvertSlot(*slot, Value::Type::Int, &newValue))
+			{
+				return newValue->AsInt();
+			}
+		}
+	}
+
+	return defaultValue;
+}
+
+bool ff::BinaryDict::GetBool(ff::StringRef name, bool defaultValue) const
+{
+	const Slot *slot = FindSlot(name);
+
+	if (slot)
+	{
+		if (slot->type == (DWORD)Value::Type::Bool)
+		{
+			return slot->_int != 0;
+		}
+		else
+		{
+			ValuePtr newValue;
+
+			if (ConvertSlot(*slot, Value::Type::Bool, &newValue))
+			{
+				return newValue->AsBool();
+			}
+		}
+	}
+
+	return defaultValue;
+}
+
+ff::RectInt ff::BinaryDict::GetRect(ff::StringRef name, RectInt defaultValue) const
+{
+	const Slot *slot = FindSlot(name);
+	const BYTE *bytes = (slot && slot->type == (DWORD)Value::Type::Rect)
+		? GetBytes(slot->_range.offset, 1, sizeof(RectInt))
+		: nullptr;
+
+	if (bytes)
+	{
+		std::memcpy(&defaultValue, bytes, sizeof(RectInt));
+	}
+
+	return defaultValue;
+}
+
+ff::RectFloat ff::BinaryDict::GetRectF(ff::StringRef name, RectFloat defaultValue) const
+{
+	const Slot *slot = FindSlot(name);
+	const BYTE *bytes = (slot && slot->type == (DWORD)Value::Type::RectF)
+		? GetBytes(slot->_range.offset, 1, sizeof(RectFloat))
+		: nullptr;
+
+	if (bytes)
+	{
+		std::memcpy(&defaultValue, bytes, sizeof(RectFloat));
+	}
+
+	return defaultValue;
+}
+
+float ff::BinaryDict::GetFloat(ff::StringRef name, float defaultValue) const
+{
+	const Slot *slot = FindSlot(name);
+
+	if (slot)
+	{
+		if (slot->type == (DWORD)Value::Type::Float)
+		{
+			return slot->_float;
+		}
+		else
+		{
+			ValuePtr newValue;
+
+			if (ConvertSlot(*slot, Value::Type::Float, &newValue))
+			{
+				return newValue->AsFloat();
+			}
+		}
+	}
+
+	return defaultValue;
+}
+
+double ff::BinaryDict::GetDouble(ff::StringRef name, double defaultValue) const
+{
+	const Slot *slot = FindSlot(name);
+
+	if (slot)
+	{
+		if (slot->type == (DWORD)Value::Type::Double)
+		{
+			return slot->_double;
+		}
+		else
+		{
+			ValuePtr newValue;
+
+			if (ConvertSlot(*slot, Value::Type::Double, &newValue))
+			{
+				return newValue->AsDouble();
+			}
+		}
+	}
+
+	return defaultValue;
+}
+
+ff::PointInt ff::BinaryDict::GetPoint(ff::StringRef name, PointInt defaultValue) const
+{
+	const Slot *slot = FindSlot(name);
+
+	if (slot && slot->type == (DWORD)Value::Type::Point)
+	{
+		return PointInt(slot->_point[0], slot->_point[1]);
+	}
+
+	return defaultValue;
+}
+
+ff::PointFloat ff::BinaryDict::GetPointF(ff::StringRef name, PointFloat defaultValue) const
+{
+	const Slot *slot = FindSlot(name);
+
+	if (slot && slot->type == (DWORD)Value::Type::PointF)
+	{
+		return PointFloat(slot->_pointF[0], slot->_pointF[1]);
+	}
+
+	return defaultValue;
+}
+
+ff::String ff::BinaryDict::GetString(ff::StringRef name, String defaultValue) const
+{
+	const Slot *slot = FindSlot(name);
+
+	if (slot)
+	{
+		size_t count = 0;
+		const wchar_t *chars = (slot->type == (DWORD)Value::Type::String)
+			? GetText(slot->_range.offset, count)
+			: nullptr;
+
+		if (chars)
+		{
+			return String(chars, count);
+		}
+		else
+		{
+			ValuePtr newValue;
+
+			if (ConvertSlot(*slot, Value::Type::String, &newValue))
+			{
+				return newValue->AsString();
+			}
+		}
+	}
+
+	return defaultValue;
+}
+
+GUID ff::BinaryDict::GetGuid(ff::StringRef name, REFGUID defaultValue) const
+{
+	const Slot *slot = FindSlot(name);
+
+	if (slot)
+	{
+		const BYTE *bytes = (slot->type == (DWORD)Value::Type::Guid)
+			? GetBytes(slot->_range.offset, 1, sizeof(GUID))
+			: nullptr;
+
+		if (bytes)
+		{
+			GUID guid;
+			std::memcpy(&guid, bytes, sizeof(GUID));
+			return guid;
+		}
+		else
+		{
+			ValuePtr newValue;
+
+			if (ConvertSlot(*slot, Value::Type::Guid, &newValue))
+			{
+				return newValue->AsGuid();
+			}
+		}
+	}
+
+	return defaultValue;
+}
+
+bool ff::BinaryDict::GetData(ff::StringRef name, IData **data) const
+{
+	assertRetVal(data, false);
+	*data = nullptr;
+
+	const Slot *slot = FindSlot(name);
+	noAssertRetVal(slot && slot->type == (DWORD)Value::Type::Data, false);
+	assertRetVal(GetBytes(slot->_range.offset, slot->_range.count, 1), false);
+
+	return CreateDataInData(_data, slot->_range.offset, slot->_range.count, data);
+}
+
+ff::BinaryDict ff::BinaryDict::GetDict(ff::StringRef name) const
+{
+	BinaryDict dict;
+	const Slot *slot = FindSlot(name);
+
+	if (slot && slot->type == (DWORD)Value::Type::Dict)
+	{
+		dict.InternalOpen(_data, _size, slot->_range.offset);
+	}
+
+	return dict;
+}
+
+const wchar_t *ff::BinaryDict::GetChars(ff::StringRef name, size_t &count) const
+{
+	count = 0;
+
+	const Slot *slot = FindSlot(name);
+	noAssertRetVal(slot && slot->type == (DWORD)Value::Type::String, nullptr);
+
+	const wchar_t *chars = GetText(slot->_range.offset, count);
+	assertRetVal(chars, nullptr);
+
+	return chars;
+}
+
+const int *ff::BinaryDict::GetInts(ff::StringRef name, size_t &count) const
+{
+	count = 0;
+
+	const Slot *slot = FindSlot(name);
+	noAssertRetVal(slot && slot->type == (DWORD)Value::Type::IntVector, nullptr);
+
+	const int *ints = reinterpret_cast<const int *>(GetBytes(slot->_range.offset, slot->_range.count, sizeof(int)));
+	assertRetVal(ints, nullptr);
+
+	count = slot->_range.count;
+	return ints;
+}
+
+const float *ff::BinaryDict::GetFloats(ff::StringRef name, size_t &count) const
+{
+	count = 0;
+
+	const Slot *slot = FindSlot(name);
+	noAssertRetVal(slot && slot->type == (DWORD)Value::Type::FloatVector, nullptr);
+
+	const float *floats = reinterpret_cast<const float *>(GetBytes(slot->_range.offset, slot->_range.count, sizeof(float)));
+	assertRetVal(floats, nullptr);
+
+	count = slot->_range.count;
+	return floats;
+}
+
+const double *ff::BinaryDict::GetDoubles(ff::StringRef name, size_t &count) const
+{
+	count = 0;
+
+	const Slot *slot = FindSlot(name);
+	noAssertRetVal(slot && slot->type == (DWORD)Value::Type::DoubleVector, nullptr);
+
+	const double *doubles = reinterpret_cast<const double *>(GetBytes(slot->_range.offset, slot->_range.count, sizeof(double)));
+	assertRetVal(doubles, nullptr);
+
+	count = slot->_range.count;
+	return doubles;
+}
+
+bool ff::BinaryDict::ToDict(Dict &dict) const
+{
+	assertRetVal(IsValid(), false);
+	dict.Reserve(_count);
+
+	for (size_t i = 0; i < _count; i++)
+	{
+		ValueHandle value;
+		assertRetVal(CreateHandle(_slots[i], value), false);
+
+		dict.SetHandle(KeyAt(i), std::move(value));
+	}
+
+	return true;
+}
+
+const ff::BinaryDict::Slot *ff::BinaryDict::SlotAt(size_t index) const
+{
+	assertRetVal(index < _count, nullptr);
+	return &_slots[index];
+}
+
+const ff::BinaryDict::Slot *ff::BinaryDict::FindSlot(ff::StringRef name) const
+{
+	size_t index = IndexOf(name);
+	return (index != INVALID_SIZE) ? &_slots[index] : nullptr;
+}
+
+// Returns null unless all of the items fit in the data and are aligned
+const BYTE *ff::BinaryDict::GetBytes(size_t offset, size_t count, size_t size) const
+{
+	if (offset > _size ||
+		offset % std::min(size, BINARY_DICT_ALIGN) ||
+		count > (_size - offset) / size)
+	{
+		return nullptr;
+	}
+
+	return _mem + offset;
+}
+
+// Text is a DWORD length and then null terminated chars
+const wchar_t *ff::BinaryDict::GetText(size_t offset, size_t &count) const
+{
+	const DWORD *size = reinterpret_cast<const DWORD *>(GetBytes(offset, 1, sizeof(DWORD)));
+	const wchar_t *chars = size ? reinterpret_cast<const wchar_t *>(GetBytes(offset + sizeof(DWORD), (size_t)*size + 1, sizeof(wchar_t))) : nullptr;
+	noAssertRetVal(chars && !chars[*size], nullptr);
+
+	count = *size;
+	return chars;
+}
+
+bool ff::BinaryDict::ConvertSlot(const Slot &slot, Value::Type type, Value **value) const
+{
+	ValuePtr slotValue;
+	return CreateValue(slot, &slotValue) && slotValue->Convert(type, value);
+}
+
+// Scalars become inline handles, only the other types need a Value
+bool ff::BinaryDict::CreateHandle(const Slot &slot, ValueHandle &handle) const
+{
+	switch ((Value::Type)slot.type)
+	{
+	case Value::Type::Null:
+		handle = ValueHandle::Null();
+		break;
+
+	case Value::Type::Bool:
+		handle = ValueHandle(slot._int != 0);
+		break;
+
+	case Value::Type::Double:
+		handle = ValueHandle(slot._double);
+		break;
+
+	case Value::Type::Float:
+		handle = ValueHandle(slot._float);
+		break;
+
+	case Value::Type::Int:
+		handle = ValueHandle(slot._int);
+		break;
+
+	case Value::Type::Point:
+		handle = ValueHandle(PointInt(slot._point[0], slot._point[1]));
+		break;
+
+	case Value::Type::PointF:
+		handle = ValueHandle(PointFloat(slot._pointF[0], slot._pointF[1]));
+		break;
+
+	default:
+		{
+			ValuePtr value;
+			assertRetVal(CreateValue(slot, &value), false);
+			handle = ValueHandle(value);
+		}
+		break;
+	}
+
+	return true;
+}
+
+bool ff::BinaryDict::CreateValue(const Slot &slot, Value **value) const
+{
+	assertRetVal(value, false);
+	*value = nullptr;
+
+	// Nested values must come after their slot, or bad data could make this loop forever
+	size_t slotOffset = reinterpret_cast<const BYTE *>(&slot) - _mem;
+	const BinaryDictRange &range = slot._range;
+
+	switch ((Value::Type)slot.type)
+	{
+	default:
+		assertRetVal(false, false);
+
+	case Value::Type::Null:
+		assertRetVal(Value::CreateNull(value), false);
+		break;
+
+	case Value::Type::Bool:
+		assertRetVal(Value::CreateBool(slot._int != 0, value), false);
+		break;
+
+	case Value::Type::Double:
+		assertRetVal(Value::CreateDouble(slot._double, value), false);
+		break;
+
+	case Value::Type::Float:
+		assertRetVal(Value::CreateFloat(slot._float, value), false);
+		break;
+
+	case Value::Type::Int:
+		assertRetVal(Value::CreateInt(slot._int, value), false);
+		break;
+
+	case Value::Type::Point:
+		assertRetVal(Value::CreatePoint(PointInt(slot._point[0], slot._point[1]), value), false);
+		break;
+
+	case Value::Type::PointF:
+		assertRetVal(Value::CreatePointF(PointFloat(slot._pointF[0], slot._pointF[1]), value), false);
+		break;
+
+	case Value::Type::Rect:
+		{
+			const BYTE *bytes = GetBytes(range.offset, 1, sizeof(RectInt));
+			assertRetVal(bytes, false);
+
+			RectInt rect(0, 0, 0, 0);
+			std::memcpy(&rect, bytes, sizeof(rect));
+			assertRetVal(Value::CreateRect(rect, value), false);
+		}
+		break;
+
+	case Value::Type::RectF:
+		{
+			const BYTE *bytes = GetBytes(range.offset, 1, sizeof(RectFloat));
+			assertRetVal(bytes, false);
+
+			RectFloat rect(0, 0, 0, 0);
+			std::memcpy(&rect, bytes, sizeof(rect));
+			assertRetVal(Value::CreateRectF(rect, value), false);
+		}
+		break;
+
+	case Value::Type::Guid:
+		{
+			const BYTE *bytes = GetBytes(range.offset, 1, sizeof(GUID));
+			assertRetVal(bytes, false);
+
+			GUID guid;
+			std::memcpy(&guid, bytes, sizeof(guid));
+			assertRetVal(Value::CreateGuid(guid, value), false);
+		}
+		break;
+
+	case Value::Type::String:
+		{
+			size_t count = 0;
+			const wchar_t *chars = GetText(range.offset, count);
+			assertRetVal(chars, false);
+			assertRetVal(Value::CreateString(String(chars, count), value), false);
+		}
+		break;
+
+	case Value::Type::Data:
+		{
+			ComPtr<IData> data;
+			assertRetVal(GetBytes(range.offset, range.count, 1), false);
+			assertRetVal(CreateDataInData(_data, range.offset, range.count, &data), false);
+			assertRetVal(Value::CreateData(data, value), false);
+		}
+		break;
+
+	case Value::Type::Dict:
+		{
+			assertRetVal(range.offset > slotOffset, false);
+
+			BinaryDict nestedView;
+			assertRetVal(nestedView.InternalOpen(_data, _size, range.offset), false);
+
+			Dict nestedDict;
+			assertRetVal(nestedView.ToDict(nestedDict), false);
+			assertRetVal(Value::CreateDict(std::move(nestedDict), value), false);
+		}
+		break;
+
+	case Value::Type::DoubleVector:
+		{
+			const double *doubles = reinterpret_cast<const double *>(GetBytes(range.offset, range.count, sizeof(double)));
+			assertRetVal(doubles, false);
+			assertRetVal(Value::CreateDoubleVector(value), false);
+			(*value)->AsDoubleVector().Push(doubles, range.count);
+		}
+		break;
+
+	case Value::Type::FloatVector:
+		{
+			const float *floats = reinterpret_cast<const float *>(GetBytes(range.offset, range.count, sizeof(float)));
+			assertRetVal(floats, false);
+			assertRetVal(Value::CreateFloatVector(value), false);
+			(*value)->AsFloatVector().Push(floats, range.count);
+		}
+		break;
+
+	case Value::Type::IntVector:
+		{
+			const int *ints = reinterpret_cast<const int *>(GetBytes(range.offset, range.count, sizeof(int)));
+			assertRetVal(ints, false);
+			assertRetVal(Value::CreateIntVector(value), false);
+			(*value)->AsIntVector().Push(ints, range.count);
+		}
+		break;
+
+	case Value::Type::DataVector:
+		{
+			const BinaryDictRange *ranges = reinterpret_cast<const BinaryDictRange *>(GetBytes(range.offset, range.count, sizeof(BinaryDictRange)));
+			assertRetVal(ranges, false);
+
+			ValuePtr newValue;
+			assertRetVal(Value::CreateDataVector(&newValue), false);
+			newValue->AsDataVector().Reserve(range.count);
+
+			for (size_t i = 0; i < range.count; i++)
+			{
+				ComPtr<IData> data;
+				assertRetVal(GetBytes(ranges[i].offset, ranges[i].count, 1), false);
+				assertRetVal(CreateDataInData(_data, ranges[i].offset, ranges[i].count, &data), false);
+				newValue->AsDataVector().Push(data);
+			}
+
+			*value = newValue.Detach();
+		}
+		break;
+
+	case Value::Type::StringVector:
+		{
+			const DWORD *texts = reinterpret_cast<const DWORD *>(GetBytes(range.offset, range.count, sizeof(DWORD)));
+			assertRetVal(texts, false);
+
+			ValuePtr newValue;
+			assertRetVal(Value::CreateStringVector(&newValue), false);
+			newValue->AsStringVector().Reserve(range.count);
+
+			for (size_t i = 0; i < range.count; i++)
+			{
+				size_t count = 0;
+				const wchar_t *chars = GetText(texts[i], count);
+				assertRetVal(chars, false);
+
+				newValue->AsStringVector().Push(String(chars, count));
+			}
+
+			*value = newValue.Detach();
+		}
+		break;
+
+	case Value::Type::ValueVector:
+		{
+			assertRetVal(range.offset > slotOffset, false);
+
+			const Slot *slots = reinterpret_cast<const Slot *>(GetBytes(range.offset, range.count, sizeof(Slot)));
+			assertRetVal(slots, false);
+
+			Vector<ValuePtr> values;
+			values.Reserve(range.count);
+
+			for (size_t i = 0; i < range.count; i++)
+			{
+				ValuePtr nestedValue;
+				assertRetVal(CreateValue(slots[i], &nestedValue), false);
+				values.Push(nestedValue);
+			}
+
+			assertRetVal(Value::CreateValueVector(std::move(values), value), false);
+		}
+		break;
+	}
+
+	return true;
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "Dict/Value.h"
+
+namespace ff
+{
+	class Dict;
+	class IData;
+	class ValueHandle;
+
+	namespace details
+	{
+		struct BinaryDictSlot;
+	}
+
+	// Saves a dict in a layout that BinaryDict can read in place, without loading it first.
+	// Unlike SaveDict, nested dicts are saved inline instead of as separate blobs.
+	// A perfect hash index makes lookups faster, see FrozenDict.
+	UTIL_API bool SaveBinaryDict(const Dict &dict, bool chain, bool nameHashOnly, bool perfectHash, IData **data);
+
+	// A read-only view of a dict saved with SaveBinaryDict. Opening only checks the header,
+	// values are read straight out of the data when they are asked for, so it's meant to
+	// be opened over CreateDataInMemMappedFile. Nested dicts are views of the same data.
+	//
+	// Layout, all offsets are from the start of the data and everything is 8 byte aligned:
+	// Header: magic, version, size, root table offset
+	// Table: count, index offset, key hashes sorted, then one 16 byte slot per key in the same order
+	// Index: optional minimal perfect hash for the table, a seed per bucket, then a table index per position
+	// Slot: type, name offset (zero for hash only), then the value for small types, or
+	//       an offset and count for everything else (chars, bytes, arrays, slots, or a table)
+	class BinaryDict
+	{
+	public:
+		UTIL_API BinaryDict();
+		UTIL_API BinaryDict(const BinaryDict &rhs);
+		UTIL_API BinaryDict(BinaryDict &&rhs);
+		UTIL_API ~BinaryDict();
+
+		UTIL_API const BinaryDict &operator=(const BinaryDict &rhs);
+
+		UTIL_API bool Open(IData *data);
+		UTIL_API void Close();
+		UTIL_API bool IsValid() const;
+		UTIL_API bool IsEmpty() const;
+		UTIL_API size_t Size() const;
+		UTIL_API bool IsIndexed() const;
+		UTIL_API IData *GetData() const;
+
+		// Keys are in hash order
+		UTIL_API hash_t KeyHashAt(size_t index) const;
+		UTIL_API String KeyAt(size_t index) const;
+		UTIL_API Value::Type TypeAt(size_t index) const;
+		UTIL_API size_t IndexOf(ff::StringRef name) const;
+		UTIL_API size_t IndexOfHash(hash_t hash) const;
+		UTIL_API Vector<String> GetAllNames(bool sorted) const;
+
+		// Creates a new value, nothing is cached
+		UTIL_API bool GetValueAt(size_t index, Value **value) const;
+		UTIL_API ValuePtr GetValue(ff::StringRef name) const;
+
+		// Option getters. Like Dict, the number, bool, string, and GUID getters convert other
+		// types with Value::Convert, but points and rects must be saved with the same type.
+		UTIL_API int GetInt(ff::StringRef name, int defaultValue = 0) const;
+		UTIL_API bool GetBool(ff::StringRef name, bool defaultValue = false) const;
+		UTIL_API RectInt GetRect(ff::StringRef name, RectInt defaultValue = RectInt(0, 0, 0, 0)) const;
+		UTIL_API RectFloat GetRectF(ff::StringRef name, RectFloat defaultValue = RectFloat(0, 0, 0, 0)) const;
+		UTIL_API float GetFloat(ff::StringRef name, float defaultValue = 0.0f) const;
+		UTIL_API double GetDouble(ff::StringRef name, double defaultValue = 0.0) const;
+		UTIL_API PointInt GetPoint(ff::StringRef name, PointInt defaultValue = PointInt(0, 0)) const;
+		UTIL_API PointFloat GetPointF(ff::StringRef name, PointFloat defaultValue = PointFloat(0, 0)) const;
+		UTIL_API String GetString(ff::StringRef name, String defaultValue = String()) const;
+		UTIL_API GUID GetGuid(ff::StringRef name, REFGUID defaultValue = GUID_NULL) const;
+		UTIL_API bool GetData(ff::StringRef name, IData **data) const; // part of the same data, not a copy
+		UTIL_API BinaryDict GetDict(ff::StringRef name) const; // not valid if there is no dict
+
+		// These point into the data, so they are only good while the data is alive.
+		// Chars are null terminated. Null is returned for other types.
+		UTIL_API const wchar_t *GetChars(ff::StringRef name, size_t &count) const;
+		UTIL_API const int *GetInts(ff::StringRef name, size_t &count) const;
+		UTIL_API const float *GetFloats(ff::StringRef name, size_t &count) const;
+		UTIL_API const double *GetDoubles(ff::StringRef name, size_t &count) const;
+
+		// Loads everything, like LoadDict
+		UTIL_API bool ToDict(Dict &dict) const;
+
+	private:
+		typedef details::BinaryDictSlot Slot;
+
+		const Slot *SlotAt(size_t index) const;
+		const Slot *FindSlot(ff::StringRef name) const;
+		const BYTE *GetBytes(size_t offset, size_t count, size_t size) const;
+		const wchar_t *GetText(size_t offset, size_t &count) const;
+		bool ConvertSlot(const Slot &slot, Value::Type type, Value **value) const;
+		bool CreateHandle(const Slot &slot, ValueHandle &handle) const;
+		bool CreateValue(const Slot &slot, Value **value) const;
+		bool InternalOpen(IData *data, size_t size, DWORD table);
+		bool InternalOpenIndex(DWORD index);
+
+		ComPtr<IData> _data;
+		const BYTE *_mem;
+		size_t _size;
+		const hash_t *_hashes;
+		const Slot *_slots;
+		size_t _count;
+		const DWORD *_indexSeeds;
+		const DWORD *_indexPositions;
+		size_t _indexBuckets;
+	};
+}
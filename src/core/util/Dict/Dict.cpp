@@ -4,8 +4,18 @@
 #include "Globals/ProcessGlobals.h"
 #include "String/StringUtil.h"
 
+// The same at every SimdLevel, so a dict doesn't change shape when tests switch levels.
+// Check it against RunSmallDictThresholdPerf in DictPerf.cpp before changing it.
 static const size_t MAX_SMALL_DICT = 128;
 
+// Inline scalars are converted from a copy of their handle, so the dict doesn't keep a Value for them
+static bool ConvertHandle(const ff::ValueHandle &handle, ff::Value::Type type, ff::Value **value)
+{
+	ff::ValueHandle copy(handle);
+	ff::Value *realValue = copy.GetValue();
+	return realValue && realValue->Convert(type, value);
+}
+
 ff::StaticString ff::OPTION_APP_USE_DIRECT3D(L"App.UseDirect3d");
 ff::StaticString ff::OPTION_APP_USE_JOYSTICKS(L"App.UseJoysticks");
 ff::StaticString ff::OPTION_APP_USE_MAIN_WINDOW_KEYBOARD(L"App.UseMainWindowKeyboard");
@@ -35,15 +45,162 @@ ff::StaticString ff::OPTION_WINDOW_MAXIMIZED(L"Window.Maximized");
 ff::StaticString ff::OPTION_WINDOW_PADDING(L"Window.Padding");
 ff::StaticString ff::OPTION_WINDOW_POSITION(L"Window.Position");
 
+// STATIC_DATA(pod)
+static long long s_lastGeneration = 0;
+
+// Unique in the whole process, so a new dict that reuses the memory of a deleted one never
+// looks like it's in an old chain cache
+static long long NewGeneration()
+{
+	return ::InterlockedIncrement64(&s_lastGeneration);
+}
+
+// Every value in a dict and its parents, found with one search. The snapshot remembers the
+// generation of each dict in the chain, so lookups check that nothing changed by walking the
+// parents without locking. Dicts don't know which caches include them, so they can be moved
+// around in memory like any other dict.
+class ff::Dict::ChainCache
+{
+public:
+	ChainCache();
+	~ChainCache();
+
+	// Returns false when the cache can't be used, because the chain has legacy values
+	bool GetHandleWithHash(const Dict *dict, hash_t hash, const ValueHandle **value);
+
+private:
+	struct ChainLink
+	{
+		const Dict *dict; // only compared, it may not exist anymore
+		long long generation;
+	};
+
+	// Never changes once it's published
+	struct Snapshot
+	{
+		FlatHashMap<hash_t, const ValueHandle *, NonHasher<hash_t>> handles;
+		Vector<ChainLink, 4> chain;
+		bool hasLegacyValues;
+	};
+
+	static bool IsCurrent(const Snapshot *snapshot, const Dict *dict);
+	Snapshot *Rebuild(const Dict *dict);
+
+	Snapshot * volatile _snapshot;
+	Snapshot *_retired;
+};
+
+ff::Dict::ChainCache::ChainCache()
+	: _snapshot(nullptr)
+	, _retired(nullptr)
+{
+}
+
+ff::Dict::ChainCache::~ChainCache()
+{
+	delete _snapshot;
+	delete _retired;
+}
+
+bool ff::Dict::ChainCache::GetHandleWithHash(const Dict *dict, hash_t hash, const ValueHandle **value)
+{
+	Snapshot *snapshot = _snapshot;
+
+	if (!IsCurrent(snapshot, dict))
+	{
+		snapshot = Rebuild(dict);
+	}
+
+	// The cache only knows real name hashes
+	noAssertRetVal(!snapshot->hasLegacyValues, false);
+
+	BucketIter iter = snapshot->handles.GetWithHash(hash, hash);
+	*value = (iter != INVALID_ITER) ? snapshot->handles.ValueAt(iter) : nullptr;
+
+	return true;
+}
+
+bool ff::Dict::ChainCache::IsCurrent(const Snapshot *snapshot, const Dict *dict)
+{
+	noAssertRetVal(snapshot, false);
+
+	for (const ChainLink &link: snapshot->chain)
+	{
+		noAssertRetVal(link.dict == dict && link.generation == dict->_generation, false);
+		dict = dict->_parent;
+	}
+
+	return !dict;
+}
+
+ff::Dict::ChainCache::Snapshot *ff::Dict::ChainCache::Rebuild(const Dict *dict)
+{
+	LockMutex lock(GCS_DICT_CHAIN);
+
+	// Other threads may have been waiting to rebuild too
+	Snapshot *snapshot = _snapshot;
+	if (IsCurrent(snapshot, dict))
+	{
+		return snapshot;
+	}
+
+	std::unique_ptr<Snapshot> newSnapshot(new Snapshot());
+	newSnapshot->hasLegacyValues = dict->HasLegacyValues(true);
+	size_t count = 0;
+
+	for (; dict; dict = dict->_parent)
+	{
+		ChainLink link = { dict, dict->_generation };
+		newSnapshot->chain.Push(link);
+		count += dict->Size(false);
+	}
+
+	newSnapshot->handles.SetBucketCount(count, true);
+
+	// Parents go first, so that children replace their values
+	for (size_t i = PreviousSize(newSnapshot->chain.Size()); i != INVALID_SIZE; i = PreviousSize(i))
+	{
+		const Dict *chainDict = newSnapshot->chain[i].dict;
+
+		if (chainDict->_propsLarge != nullptr)
+		{
+			for (const auto &iter: *chainDict->_propsLarge)
+			{
+				newSnapshot->handles.SetKey(iter.GetKey(), &iter.GetValue());
+			}
+		}
+		else
+		{
+			for (size_t h = 0; h < chainDict->_propsSmall.Size(); h++)
+			{
+				newSnapshot->handles.SetKey(chainDict->_propsSmall.KeyHashAt(h), &chainDict->_propsSmall.HandleAt(h));
+			}
+		}
+	}
+
+	// Other threads may still be checking the old snapshot. Dicts can't change while their chain
+	// is being read, so nobody can still be using the one before it.
+	delete _retired;
+	_retired = snapshot;
+
+	// Readers don't lock, so the snapshot has to be complete before they can see it
+	snapshot = newSnapshot.release();
+	::InterlockedExchangePointer(reinterpret_cast<void * volatile *>(&_snapshot), snapshot);
+
+	return snapshot;
+}
+
 ff::Dict::Dict(const Dict *parent)
 	: _parent(parent)
 	, _atomizer(ProcessGlobals::Get()->GetStringCache())
+	, _generation(NewGeneration())
 {
 }
 
 ff::Dict::Dict(const Dict &rhs)
 	: _parent(nullptr)
 	, _atomizer(rhs._atomizer)
+	, _generation(NewGeneration())
 {
 	*this = rhs;
 }
@@ -52,14 +209,20 @@ ff::Dict::Dict(Dict &&rhs)
 	: _parent(rhs._parent)
 	, _atomizer(rhs._atomizer)
 	, _propsLarge(std::move(rhs._propsLarge))
+	, _propsLegacy(std::move(rhs._propsLegacy))
+	, _chainCache(rhs._chainCache != nullptr ? new ChainCache() : nullptr)
+	, _generation(NewGeneration())
 	, _propsSmall(std::move(rhs._propsSmall))
 {
 	rhs._parent = nullptr;
+	rhs._chainCache.reset();
+	rhs.Changed();
 }
 
 ff::Dict::Dict(const SmallDict &rhs)
 	: _parent(nullptr)
 	, _atomizer(ProcessGlobals::Get()->GetStringCache())
+	, _generation(NewGeneration())
 {
 	*this = rhs;
 }
@@ -67,6 +230,7 @@ ff::Dict::Dict(const SmallDict &rhs)
 ff::Dict::Dict(SmallDict &&rhs)
 	: _parent(nullptr)
 	, _atomizer(ProcessGlobals::Get()->GetStringCache())
+	, _generation(NewGeneration())
 	, _propsSmall(std::move(rhs))
 {
 }
@@ -86,6 +250,13 @@ const ff::Dict &ff::Dict::operator=(const Dict &rhs)
 		{
 			_propsLarge.reset(new PropsMap(*rhs._propsLarge));
 		}
+
+		if (rhs._propsLegacy != nullptr)
+		{
+			_propsLegacy.reset(new PropsMap(*rhs._propsLegacy));
+		}
+
+		SetChainCache(rhs.HasChainCache());
 	}
 
 	return *this;
@@ -120,6 +291,7 @@ void ff::Dict::SetParent(const Dict *parent)
 	}
 
 	_parent = parent;
+	Changed();
 }
 
 const ff::Dict *ff::Dict::GetParent() const
@@ -127,10 +299,29 @@ const ff::Dict *ff::Dict::GetParent() const
 	return _parent;
 }
 
+void ff::Dict::SetChainCache(bool enabled)
+{
+	if (!enabled)
+	{
+		_chainCache.reset();
+	}
+	else if (_chainCache == nullptr)
+	{
+		_chainCache.reset(new ChainCache());
+	}
+}
+
+bool ff::Dict::HasChainCache() const
+{
+	return _chainCache != nullptr;
+}
+
 void ff::Dict::Clear()
 {
 	_propsSmall.Clear();
 	_propsLarge.reset();
+	_propsLegacy.reset();
+	Changed();
 }
 
 void ff::Dict::Add(const Dict &rhs, bool chain)
@@ -139,8 +330,16 @@ void ff::Dict::Add(const Dict &rhs, bool chain)
 
 	for (const String &name: names)
 	{
-		Value *value = rhs.GetValue(name, chain);
-		SetValue(name, value);
+		// Copying handles keeps inline values inline
+		const ValueHandle *value = rhs.GetHandle(name, chain);
+		SetHandle(name, ValueHandle(*value));
+	}
+
+	Vector<hash_t> legacyHashes = rhs.GetLegacyHashes(chain);
+
+	for (hash_t legacyHash: legacyHashes)
+	{
+		SetLegacyValue(legacyHash, rhs.GetLegacyValue(legacyHash, chain));
 	}
 }
 
@@ -149,6 +348,7 @@ void ff::Dict::Reserve(size_t count)
 	if (_propsLarge == nullptr)
 	{
 		_propsSmall.Reserve(count, false);
+		Changed();
 	}
 }
 
@@ -165,6 +365,11 @@ bool ff::Dict::IsEmpty(bool chain) const
 		empty = false;
 	}
 
+	if (_propsLegacy != nullptr && !_propsLegacy->IsEmpty())
+	{
+		empty = false;
+	}
+
 	if (empty)
 	{
 		return !chain || !_parent || _parent->IsEmpty(true);
@@ -186,6 +391,11 @@ size_t ff::Dict::Size(bool chain) const
 		size = _propsSmall.Size();
 	}
 
+	if (_propsLegacy != nullptr)
+	{
+		size += _propsLegacy->Size();
+	}
+
 	if (chain && _parent)
 	{
 		size += _parent->Size(true);
@@ -198,22 +408,36 @@ void ff::Dict::Add(const SmallDict &rhs)
 {
 	for (size_t i = 0; i < rhs.Size(); i++)
 	{
-		SetValue(rhs.KeyAt(i), rhs.ValueAt(i));
+		SetHandle(rhs.KeyAt(i), ValueHandle(rhs.HandleAt(i)));
 	}
 }
 
 void ff::Dict::SetValue(ff::StringRef name, ff::Value *value)
 {
-	if (value)
+	SetHandle(name, ValueHandle(value));
+}
+
+void ff::Dict::SetHandle(ff::StringRef name, ValueHandle &&value)
+{
+	Changed();
+
+	if (_propsLegacy != nullptr)
+	{
+		// The real name replaces the legacy one
+		hash_t legacyHash = HashBytesLegacy(name.c_str(), name.size() * sizeof(wchar_t));
+		_propsLegacy->DeleteKey(legacyHash);
+	}
+
+	if (value.IsValid())
 	{
 		if (_propsLarge != nullptr)
 		{
 			hash_t hash = _atomizer->CacheString(name);
-			_propsLarge->SetKey(hash, value);
+			_propsLarge->SetKey(std::move(hash), std::move(value));
 		}
 		else
 		{
-			_propsSmall.Set(name, value);
+			_propsSmall.Set(name, std::move(value));
 			CheckSize();
 		}
 	}
@@ -233,45 +457,147 @@ void ff::Dict::SetValue(ff::StringRef name, ff::Value *value)
 
 ff::Value *ff::Dict::GetValue(ff::StringRef name, bool chain) const
 {
-	Value *value = nullptr;
+	const ValueHandle *value = GetHandle(name, chain);
+	return value ? value->GetValue() : nullptr;
+}
+
+void ff::Dict::SetLegacyValue(hash_t legacyHash, Value *value)
+{
+	Changed();
+
+	if (value)
+	{
+		if (_propsLegacy == nullptr)
+		{
+			_propsLegacy.reset(new PropsMap());
+		}
+
+		_propsLegacy->SetKey(std::move(legacyHash), ValueHandle(value));
+	}
+	else if (_propsLegacy != nullptr)
+	{
+		_propsLegacy->DeleteKey(legacyHash);
+	}
+}
+
+ff::Value *ff::Dict::GetLegacyValue(hash_t legacyHash, bool chain) const
+{
+	for (const Dict *dict = this; dict; dict = chain ? dict->_parent : nullptr)
+	{
+		if (dict->_propsLegacy != nullptr)
+		{
+			BucketIter iter = dict->_propsLegacy->GetWithHash(legacyHash, legacyHash);
+
+			if (iter != INVALID_ITER)
+			{
+				return dict->_propsLegacy->ValueAt(iter).GetValue();
+			}
+		}
+	}
+
+	return nullptr;
+}
+
+ff::Vector<ff::hash_t> ff::Dict::GetLegacyHashes(bool chain) const
+{
+	Vector<hash_t> legacyHashes;
+	String name;
+
+	for (const Dict *dict = this; dict; dict = chain ? dict->_parent : nullptr)
+	{
+		if (dict->_propsLegacy != nullptr)
+		{
+			for (const auto &iter: *dict->_propsLegacy)
+			{
+				hash_t legacyHash = iter.GetKey();
+
+				if (!dict->_atomizer->FindLegacyString(legacyHash, name) && legacyHashes.Find(legacyHash) == INVALID_SIZE)
+				{
+					legacyHashes.Push(legacyHash);
+				}
+			}
+		}
+	}
+
+	return legacyHashes;
+}
+
+const ff::ValueHandle *ff::Dict::GetHandle(ff::StringRef name, bool chain) const
+{
+	// The hash doesn't depend on the atomizer, so it's only computed once for the whole chain
+	return GetHandleWithHash(_atomizer->GetHash(name), name, chain);
+}
+
+const ff::ValueHandle *ff::Dict::GetHandleWithHash(hash_t hash, ff::StringRef name, bool chain) const
+{
+	const ValueHandle *value = nullptr;
+
+	if (chain && _parent && _chainCache != nullptr && _chainCache->GetHandleWithHash(this, hash, &value))
+	{
+		return value;
+	}
 
 	if (_propsLarge != nullptr)
 	{
-		hash_t hash = _atomizer->GetHash(name);
-		BucketIter iter = _propsLarge->Get(hash);
+		BucketIter iter = _propsLarge->GetWithHash(hash, hash);
 
 		if (iter != INVALID_ITER)
 		{
-			value = _propsLarge->ValueAt(iter);
+			value = &_propsLarge->ValueAt(iter);
 		}
 	}
 	else
 	{
-		value = _propsSmall.GetValue(name);
+		size_t index = _propsSmall.IndexOfHash(hash);
+
+		if (index != INVALID_SIZE)
+		{
+			value = &_propsSmall.HandleAt(index);
+		}
+	}
+
+	if (!value && _propsLegacy != nullptr)
+	{
+		value = GetLegacyHandle(name);
 	}
 
 	if (!value && chain && _parent)
 	{
-		value = _parent->GetValue(name, chain);
+		value = _parent->GetHandleWithHash(hash, name, chain);
 	}
 
 	return value;
 }
 
-void ff::Dict::SetInt(ff::StringRef name, int value)
+const ff::ValueHandle *ff::Dict::GetLegacyHandle(ff::StringRef name) const
 {
-	ValuePtr newValue;
-	assertRet(Value::CreateInt(value, &newValue));
+	hash_t legacyHash = HashBytesLegacy(name.c_str(), name.size() * sizeof(wchar_t));
+	BucketIter iter = _propsLegacy->GetWithHash(legacyHash, legacyHash);
 
-	SetValue(name, newValue);
+	return iter != INVALID_ITER ? &_propsLegacy->ValueAt(iter) : nullptr;
 }
 
-void ff::Dict::SetBool(ff::StringRef name, bool value)
+bool ff::Dict::HasLegacyValues(bool chain) const
 {
-	ValuePtr newValue;
-	assertRet(Value::CreateBool(value, &newValue));
+	for (const Dict *dict = this; dict; dict = chain ? dict->_parent : nullptr)
+	{
+		if (dict->_propsLegacy != nullptr && !dict->_propsLegacy->IsEmpty())
+		{
+			return true;
+		}
+	}
 
-	SetValue(name, newValue);
+	return false;
+}
+
+void ff::Dict::SetInt(ff::StringRef name, int value)
+{
+	SetHandle(name, ValueHandle(value));
+}
+
+void ff::Dict::SetBool(ff::StringRef name, bool value)
+{
+	SetHandle(name, ValueHandle(value));
 }
 
 void ff::Dict::SetRect(ff::StringRef name, RectInt value)
@@ -292,34 +618,22 @@ void ff::Dict::SetRectF(ff::StringRef name, RectFloat value)
 
 void ff::Dict::SetPoint(ff::StringRef name, PointInt value)
 {
-	ValuePtr newValue;
-	assertRet(Value::CreatePoint(value, &newValue));
-
-	SetValue(name, newValue);
+	SetHandle(name, ValueHandle(value));
 }
 
 void ff::Dict::SetPointF(ff::StringRef name, PointFloat value)
 {
-	ValuePtr newValue;
-	assertRet(Value::CreatePointF(value, &newValue));
-
-	SetValue(name, newValue);
+	SetHandle(name, ValueHandle(value));
 }
 
 void ff::Dict::SetFloat(ff::StringRef name, float value)
 {
-	ValuePtr newValue;
-	assertRet(Value::CreateFloat(value, &newValue));
-
-	SetValue(name, newValue);
+	SetHandle(name, ValueHandle(value));
 }
 
 void ff::Dict::SetDouble(ff::StringRef name, double value)
 {
-	ValuePtr newValue;
-	assertRet(Value::CreateDouble(value, &newValue));
-
-	SetValue(name, newValue);
+	SetHandle(name, ValueHandle(value));
 }
 
 void ff::Dict::SetString(ff::StringRef name, String value)
@@ -348,7 +662,7 @@ void ff::Dict::SetData(ff::StringRef name, IData* value)
 
 int ff::Dict::GetInt(ff::StringRef name, int defaultValue, bool chain) const
 {
-	Value *value = GetValue(name, chain);
+	const ValueHandle *value = GetHandle(name, chain);
 
 	if (value)
 	{
@@ -360,7 +674,7 @@ int ff::Dict::GetInt(ff::StringRef name, int defaultValue, bool chain) const
 		{
 			ValuePtr newValue;
 
-			if (value->Convert(Value::Type::Int, &newValue))
+			if (ConvertHandle(*value, Value::Type::Int, &newValue))
 			{
 				return newValue->AsInt();
 			}
@@ -372,7 +686,7 @@ int ff::Dict::GetInt(ff::StringRef name, int defaultValue, bool chain) const
 
 bool ff::Dict::GetBool(ff::StringRef name, bool defaultValue, bool chain) const
 {
-	Value *value = GetValue(name, chain);
+	const ValueHandle *value = GetHandle(name, chain);
 
 	if (value)
 	{
@@ -384,7 +698,7 @@ bool ff::Dict::GetBool(ff::StringRef name, bool defaultValue, bool chain) const
 		{
 			ValuePtr newValue;
 
-			if (value->Convert(Value::Type::Bool, &newValue))
+			if (ConvertHandle(*value, Value::Type::Bool, &newValue))
 			{
 				return newValue->AsBool();
 			}
@@ -396,11 +710,11 @@ bool ff::Dict::GetBool(ff::StringRef name, bool defaultValue, bool chain) const
 
 ff::RectInt ff::Dict::GetRect(ff::StringRef name, RectInt defaultValue, bool chain) const
 {
-	Value *value = GetValue(name, chain);
+	const ValueHandle *value = GetHandle(name, chain);
 
 	if (value && value->IsType(Value::Type::Rect))
 	{
-		return value->AsRect();
+		return value->GetValue()->AsRect();
 	}
 
 	return defaultValue;
@@ -408,11 +722,11 @@ ff::RectInt ff::Dict::GetRect(ff::StringRef name, RectInt defaultValue, bool cha
 
 ff::RectFloat ff::Dict::GetRectF(ff::StringRef name, RectFloat defaultValue, bool chain) const
 {
-	Value *value = GetValue(name, chain);
+	const ValueHandle *value = GetHandle(name, chain);
 
 	if (value && value->IsType(Value::Type::RectF))
 	{
-		return value->AsRectF();
+		return value->GetValue()->AsRectF();
 	}
 
 	return defaultValue;
@@ -420,7 +734,7 @@ ff::RectFloat ff::Dict::GetRectF(ff::StringRef name, RectFloat defaultValue, boo
 
 float ff::Dict::GetFloat(ff::StringRef name, float defaultValue, bool chain) const
 {
-	Value *value = GetValue(name, chain);
+	const ValueHandle *value = GetHandle(name, chain);
 
 	if (value)
 	{
@@ -432,7 +746,7 @@ float ff::Dict::GetFloat(ff::StringRef name, float defaultValue, bool chain) con
 		{
 			ValuePtr newValue;
 
-			if (value->Convert(Value::Type::Float, &newValue))
+			if (ConvertHandle(*value, Value::Type::Float, &newValue))
 			{
 				return newValue->AsFloat();
 			}
@@ -444,7 +758,7 @@ float ff::Dict::GetFloat(ff::StringRef name, float defaultValue, bool chain) con
 
 double ff::Dict::GetDouble(ff::StringRef name, double defaultValue, bool chain) const
 {
-	Value *value = GetValue(name, chain);
+	const ValueHandle *value = GetHandle(name, chain);
 
 	if (value)
 	{
@@ -456,7 +770,7 @@ double ff::Dict::GetDouble(ff::StringRef name, double defaultValue, bool chain)
 		{
 			ValuePtr newValue;
 
-			if (value->Convert(Value::Type::Double, &newValue))
+			if (ConvertHandle(*value, Value::Type::Double, &newValue))
 			{
 				return newValue->AsDouble();
 			}
@@ -468,7 +782,7 @@ double ff::Dict::GetDouble(ff::StringRef name, double defaultValue, bool chain)
 
 ff::PointInt ff::Dict::GetPoint(ff::StringRef name, PointInt defaultValue, bool chain) const
 {
-	Value *value = GetValue(name, chain);
+	const ValueHandle *value = GetHandle(name, chain);
 
 	if (value && value->IsType(Value::Type::Point))
 	{
@@ -480,7 +794,7 @@ ff::PointInt ff::Dict::GetPoint(ff::StringRef name, PointInt defaultValue, bool
 
 ff::PointFloat ff::Dict::GetPointF(ff::StringRef name, PointFloat defaultValue, bool chain) const
 {
-	Value *value = GetValue(name, chain);
+	const ValueHandle *value = GetHandle(name, chain);
 
 	if (value && value->IsType(Value::Type::PointF))
 	{
@@ -492,19 +806,19 @@ ff::PointFloat ff::Dict::GetPointF(ff::StringRef name, PointFloat defaultValue,
 
 ff::String ff::Dict::GetString(ff::StringRef name, String defaultValue, bool chain) const
 {
-	Value *value = GetValue(name, chain);
+	const ValueHandle *value = GetHandle(name, chain);
 
 	if (value)
 	{
 		if (value->IsType(Value::Type::String))
 		{
-			return value->AsString();
+			return value->GetValue()->AsString();
 		}
 		else
 		{
 			ValuePtr newValue;
 
-			if (value->Convert(Value::Type::String, &newValue))
+			if (ConvertHandle(*value, Value::Type::String, &newValue))
 			{
 				return newValue->AsString();
 			}
@@ -516,19 +830,19 @@ ff::String ff::Dict::GetString(ff::StringRef name, String defaultValue, bool cha
 
 GUID ff::Dict::GetGuid(ff::StringRef name, REFGUID defaultValue, bool chain) const
 {
-	Value *value = GetValue(name, chain);
+	const ValueHandle *value = GetHandle(name, chain);
 
 	if (value)
 	{
 		if (value->IsType(Value::Type::Guid))
 		{
-			return value->AsGuid();
+			return value->GetValue()->AsGuid();
 		}
 		else
 		{
 			ValuePtr newValue;
 
-			if (value->Convert(Value::Type::Guid, &newValue))
+			if (ConvertHandle(*value, Value::Type::Guid, &newValue))
 			{
 				return newValue->AsGuid();
 			}
@@ -540,11 +854,11 @@ GUID ff::Dict::GetGuid(ff::StringRef name, REFGUID defaultValue, bool chain) con
 
 ff::IData *ff::Dict::GetData(ff::StringRef name, bool chain) const
 {
-	Value *value = GetValue(name, chain);
+	const ValueHandle *value = GetHandle(name, chain);
 
 	if (value && value->IsType(Value::Type::Data))
 	{
-		return value->AsData();
+		return value->GetValue()->AsData();
 	}
 
 	return nullptr;
@@ -571,8 +885,6 @@ ff::Vector<ff::String> ff::Dict::GetAllNames(bool chain, bool sorted, bool nameH
 
 void ff::Dict::InternalGetAllNames(Set<String> &names, bool chain, bool nameHashOnly) const
 {
-	StringCache emptyCache;
-
 	if (chain && _parent)
 	{
 		_parent->InternalGetAllNames(names, chain, nameHashOnly);
@@ -583,7 +895,7 @@ void ff::Dict::InternalGetAllNames(Set<String> &names, bool chain, bool nameHash
 		for (const auto &iter: *_propsLarge)
 		{
 			hash_t hash = iter.GetKey();
-			String name = nameHashOnly ? emptyCache.GetString(hash) : _atomizer->GetString(hash);
+			String name = nameHashOnly ? StringCache::HashToString(hash) : _atomizer->GetString(hash);
 			names.SetKey(name);
 		}
 	}
@@ -591,10 +903,24 @@ void ff::Dict::InternalGetAllNames(Set<String> &names, bool chain, bool nameHash
 	{
 		for (size_t i = 0; i < _propsSmall.Size(); i++)
 		{
-			String name = nameHashOnly ? emptyCache.GetString(_propsSmall.KeyHashAt(i)) : _propsSmall.KeyAt(i);
+			String name = nameHashOnly ? StringCache::HashToString(_propsSmall.KeyHashAt(i)) : _propsSmall.KeyAt(i);
 			names.SetKey(name);
 		}
 	}
+
+	if (_propsLegacy != nullptr)
+	{
+		// Only legacy values with known names can be listed, GetLegacyHashes returns the rest
+		String name;
+
+		for (const auto &iter: *_propsLegacy)
+		{
+			if (_atomizer->FindLegacyString(iter.GetKey(), name))
+			{
+				names.SetKey(nameHashOnly ? StringCache::HashToString(StringCache::HashString(name)) : name);
+			}
+		}
+	}
 }
 
 void ff::Dict::DebugDump() const
@@ -617,6 +943,13 @@ void ff::Dict::DebugDump() const
 #endif
 }
 
+// Any change to the values or the parent, so that chain caches get rebuilt
+void ff::Dict::Changed()
+{
+	// Caches that include this dict get rebuilt by their next lookup
+	_generation = NewGeneration();
+}
+
 void ff::Dict::CheckSize()
 {
 	if (_propsSmall.Size() > MAX_SMALL_DICT)
@@ -28,6 +28,12 @@ namespace ff
 		UTIL_API void SetParent(const Dict *parent);
 		UTIL_API const Dict *GetParent() const;
 
+		// Chained lookups can use a flattened copy of the parent chain, so they only search once.
+		// It's rebuilt by the next lookup after any dict in the chain changes, so it's only worth
+		// it for dicts that are read a lot more than they change, like templates.
+		UTIL_API void SetChainCache(bool enabled);
+		UTIL_API bool HasChainCache() const;
+
 		// Operations
 		UTIL_API void Clear();
 		UTIL_API Vector<String> GetAllNames(bool chain, bool sorted, bool nameHashOnly) const;
@@ -36,6 +42,17 @@ namespace ff
 		UTIL_API void SetValue(ff::StringRef name, Value *value);
 		UTIL_API Value *GetValue(ff::StringRef name, bool chain) const;
 
+		// Handles keep scalars inline, so loading and saving them never creates a Value.
+		// An invalid handle removes the value, just like a null Value.
+		UTIL_API void SetHandle(ff::StringRef name, ValueHandle &&value);
+		UTIL_API const ValueHandle *GetHandle(ff::StringRef name, bool chain) const;
+
+		// Values loaded from version 1 saves whose names were never cached only have the HashBytesLegacy
+		// hash of their name. They're still found by the real name, which also lets them be saved with it.
+		UTIL_API void SetLegacyValue(hash_t legacyHash, Value *value);
+		UTIL_API Value *GetLegacyValue(hash_t legacyHash, bool chain) const;
+		UTIL_API Vector<hash_t> GetLegacyHashes(bool chain) const; // only the ones with an unknown name
+
 		// Option setters
 		UTIL_API void SetInt(ff::StringRef name, int value);
 		UTIL_API void SetBool(ff::StringRef name, bool value);
@@ -80,13 +97,21 @@ namespace ff
 
 	private:
 		void InternalGetAllNames(Set<String> &names, bool chain, bool nameHashOnly) const;
+		const ValueHandle *GetHandleWithHash(hash_t hash, ff::StringRef name, bool chain) const;
+		const ValueHandle *GetLegacyHandle(ff::StringRef name) const;
+		bool HasLegacyValues(bool chain) const;
 		void CheckSize();
+		void Changed();
 
-		typedef Map<hash_t, ValuePtr, NonHasher<hash_t>> PropsMap;
+		class ChainCache;
+		typedef IndexMap<hash_t, ValueHandle, NonHasher<hash_t>> PropsMap;
 
 		const Dict *_parent;
 		StringCache *_atomizer;
 		std::unique_ptr<PropsMap> _propsLarge;
+		std::unique_ptr<PropsMap> _propsLegacy;
+		std::unique_ptr<ChainCache> _chainCache;
+		long long _generation; // changes with every value and parent, for chain caches
 		SmallDict _propsSmall;
 	};
 
@@ -7,9 +7,23 @@
 #include "Dict/Dict.h"
 #include "Dict/DictPersist.h"
 #include "Dict/Value.h"
+#include "Globals/ProcessGlobals.h"
 #include "Module/Module.h"
 #include "Module/ModuleFactory.h"
+#include "String/StringBuilder.h"
 #include "String/StringCache.h"
+#include "String/StringFormat.h"
+
+// Saved dict versions:
+// 0: names are saved as strings
+// 1: names are saved as hashes from HashBytesLegacy
+// 2: names are saved as hashes from HashBytes
+// Any version can have DICT_VERSION_LEGACY_VALUES, then the values are followed by values that
+// only have a HashBytesLegacy hash, because their real names weren't known yet (see Dict::SetLegacyValue)
+static const DWORD DICT_VERSION_NAMES = 0;
+static const DWORD DICT_VERSION_LEGACY_HASHES = 1;
+static const DWORD DICT_VERSION_HASHES = 2;
+static const DWORD DICT_VERSION_LEGACY_VALUES = 0x10000;
 
 static bool CanSaveValue(ff::Value *value)
 {
@@ -49,6 +63,7 @@ static bool CanSaveValue(ff::Value *value)
 
 static bool InternalSaveDict(const ff::Dict &dict, bool chain, bool nameHashOnly, ff::IData **data);
 static bool InternalLoadDict(ff::IDataReader *reader, ff::Dict &dict);
+static bool InternalLoadValue(ff::IDataReader *reader, ff::Value **value);
 
 static bool InternalSaveValue(ff::Value *value, ff::IDataWriter *writer, bool nameHashOnly)
 {
@@ -225,14 +240,60 @@ static bool InternalSaveValue(ff::Value *value, ff::IDataWriter *writer, bool na
 	return true;
 }
 
-static bool InternalLoadValue(ff::IDataReader *reader, ff::Value **value)
+// Inline scalars are written straight from the handle, asking for their Value would create one
+// that the dict keeps forever. The saved data is the same as InternalSaveValue's.
+static bool InternalSaveHandle(const ff::ValueHandle *handle, ff::IDataWriter *writer, bool nameHashOnly)
 {
-	assertRetVal(reader && value, false);
+	assertRetVal(handle && handle->IsValid() && writer, false);
 
-	DWORD type = 0;
-	assertRetVal(ff::LoadData(reader, type), false);
+	if (!handle->IsInline())
+	{
+		return InternalSaveValue(handle->GetValue(), writer, nameHashOnly);
+	}
+
+	DWORD type = (DWORD)handle->GetType();
+	assertRetVal(ff::SaveData(writer, type), false);
+
+	switch (handle->GetType())
+	{
+	default:
+		assertRetVal(false, false);
+
+	case ff::Value::Type::Null:
+		break;
+
+	case ff::Value::Type::Bool:
+		assertRetVal(ff::SaveData(writer, handle->AsBool()), false);
+		break;
+
+	case ff::Value::Type::Double:
+		assertRetVal(ff::SaveData(writer, handle->AsDouble()), false);
+		break;
+
+	case ff::Value::Type::Float:
+		assertRetVal(ff::SaveData(writer, handle->AsFloat()), false);
+		break;
+
+	case ff::Value::Type::Int:
+		assertRetVal(ff::SaveData(writer, handle->AsInt()), false);
+		break;
+
+	case ff::Value::Type::Point:
+		assertRetVal(ff::SaveData(writer, handle->AsPoint()), false);
+		break;
+
+	case ff::Value::Type::PointF:
+		assertRetVal(ff::SaveData(writer, handle->AsPointF()), false);
+		break;
+	}
+
+	return true;
+}
+
+static bool InternalLoadTypedValue(ff::IDataReader *reader, ff::Value::Type valueType, ff::Value **value)
+{
+	assertRetVal(reader && value, false);
 
-	ff::Value::Type valueType = (ff::Value::Type)type;
 	switch (valueType)
 	{
 	default:
@@ -461,6 +522,91 @@ static bool InternalLoadValue(ff::IDataReader *reader, ff::Value **value)
 	return true;
 }
 
+static bool InternalLoadValue(ff::IDataReader *reader, ff::Value **value)
+{
+	assertRetVal(reader && value, false);
+
+	DWORD type = 0;
+	assertRetVal(ff::LoadData(reader, type), false);
+
+	return InternalLoadTypedValue(reader, (ff::Value::Type)type, value);
+}
+
+// Scalars are loaded into inline handles, only the other types need a Value
+static bool InternalLoadHandle(ff::IDataReader *reader, ff::ValueHandle &handle)
+{
+	assertRetVal(reader, false);
+
+	DWORD type = 0;
+	assertRetVal(ff::LoadData(reader, type), false);
+
+	ff::Value::Type valueType = (ff::Value::Type)type;
+	switch (valueType)
+	{
+	case ff::Value::Type::Null:
+		handle = ff::ValueHandle::Null();
+		break;
+
+	case ff::Value::Type::Bool:
+		{
+			bool val = false;
+			assertRetVal(ff::LoadData(reader, val), false);
+			handle = ff::ValueHandle(val);
+		}
+		break;
+
+	case ff::Value::Type::Double:
+		{
+			double val = 0;
+			assertRetVal(ff::LoadData(reader, val), false);
+			handle = ff::ValueHandle(val);
+		}
+		break;
+
+	case ff::Value::Type::Float:
+		{
+			float val = 0;
+			assertRetVal(ff::LoadData(reader, val), false);
+			handle = ff::ValueHandle(val);
+		}
+		break;
+
+	case ff::Value::Type::Int:
+		{
+			int val = 0;
+			assertRetVal(ff::LoadData(reader, val), false);
+			handle = ff::ValueHandle(val);
+		}
+		break;
+
+	case ff::Value::Type::Point:
+		{
+			ff::PointInt val(0, 0);
+			assertRetVal(ff::LoadData(reader, val), false);
+			handle = ff::ValueHandle(val);
+		}
+		break;
+
+	case ff::Value::Type::PointF:
+		{
+			ff::PointFloat val(0, 0);
+			assertRetVal(ff::LoadData(reader, val), false);
+			handle = ff::ValueHandle(val);
+		}
+		break;
+
+	default:
+		{
+			ff::ValuePtr value;
+			assertRetVal(InternalLoadTypedValue(reader, valueType, &value), false);
+			handle = ff::ValueHandle(value);
+		}
+		break;
+	}
+
+	return true;
+}
+
 static bool InternalSaveDict(const ff::Dict &dict, bool chain, bool nameHashOnly, ff::IData **data)
 {
 	assertRetVal(data, false);
@@ -470,10 +616,16 @@ static bool InternalSaveDict(const ff::Dict &dict, bool chain, bool nameHashOnly
 	ff::ComPtr<ff::IDataWriter> writer;
 	assertRetVal(CreateDataWriter(&dataVector, &writer), false);
 
-	ff::Vector<ff::String> names = dict.GetAllNames(chain, false, nameHashOnly);
+	// Real names are needed to find legacy values, they only get hashed when they're written
+	ff::Vector<ff::String> names = dict.GetAllNames(chain, false, false);
+	ff::Vector<ff::hash_t> legacyHashes = dict.GetLegacyHashes(chain);
 	DWORD count = (DWORD)names.Size();
-	DWORD version = nameHashOnly ? 1 : 0;
-	ff::StringCache emptyCache;
+	DWORD version = nameHashOnly ? DICT_VERSION_HASHES : DICT_VERSION_NAMES;
+
+	if (legacyHashes.Size())
+	{
+		version |= DICT_VERSION_LEGACY_VALUES;
+	}
 
 	assertRetVal(ff::SaveData(writer, version), false);
 	assertRetVal(ff::SaveData(writer, count), false);
@@ -482,7 +634,7 @@ static bool InternalSaveDict(const ff::Dict &dict, bool chain, bool nameHashOnly
 	{
 		if (nameHashOnly)
 		{
-			ff::hash_t hash = emptyCache.GetHash(name);
+			ff::hash_t hash = ff::StringCache::HashString(name);
 			assertRetVal(ff::SaveData(writer, hash), false);
 		}
 		else
@@ -490,8 +642,21 @@ static bool InternalSaveDict(const ff::Dict &dict, bool chain, bool nameHashOnly
 			assertRetVal(ff::SaveData(writer, name), false);
 		}
 
-		ff::Value *value = dict.GetValue(name, chain);
-		assertRetVal(InternalSaveValue(value, writer, nameHashOnly), false);
+		const ff::ValueHandle *value = dict.GetHandle(name, chain);
+		assertRetVal(InternalSaveHandle(value, writer, nameHashOnly), false);
+	}
+
+	if (legacyHashes.Size())
+	{
+		DWORD legacyCount = (DWORD)legacyHashes.Size();
+		assertRetVal(ff::SaveData(writer, legacyCount), false);
+
+		for (ff::hash_t legacyHash: legacyHashes)
+		{
+			ff::Value *value = dict.GetLegacyValue(legacyHash, chain);
+			assertRetVal(ff::SaveData(writer, legacyHash), false);
+			assertRetVal(InternalSaveValue(value, writer, nameHashOnly), false);
+		}
 	}
 
 	*data = dataVector.Detach();
@@ -503,6 +668,22 @@ bool ff::SaveDict(const ff::Dict &dict, bool chain, bool nameHashOnly, ff::IData
 	return InternalSaveDict(dict, chain, nameHashOnly, data);
 }
 
+static void SetLoadedLegacyValue(ff::Dict &dict, ff::hash_t legacyHash, ff::ValueHandle &&value)
+{
+	ff::String name;
+
+	// Old hashes can only be converted when the real name is known, otherwise the dict
+	// keeps the old hash until the value is looked up with its real name.
+	if (ff::ProcessGlobals::Get()->GetStringCache()->FindLegacyString(legacyHash, name))
+	{
+		dict.SetHandle(name, std::move(value));
+	}
+	else
+	{
+		dict.SetLegacyValue(legacyHash, value.GetValue());
+	}
+}
+
 static bool InternalLoadDict(ff::IDataReader *reader, ff::Dict &dict)
 {
 	assertRetVal(reader, false);
@@ -510,32 +691,63 @@ static bool InternalLoadDict(ff::IDataReader *reader, ff::Dict &dict)
 	DWORD version = 0;
 	DWORD count = 0;
 
-	assertRetVal(ff::LoadData(reader, version) && version <= 1, false);
+	assertRetVal(ff::LoadData(reader, version), false);
+	bool hasLegacyValues = (version & DICT_VERSION_LEGACY_VALUES) != 0;
+	version &= ~DICT_VERSION_LEGACY_VALUES;
+
+	assertRetVal(version <= DICT_VERSION_HASHES, false);
 	assertRetVal(ff::LoadData(reader, count), false);
 	dict.Reserve(count);
 
-	bool nameHashOnly = (version == 1);
-	ff::StringCache emptyCache;
+	bool nameHashOnly = (version != DICT_VERSION_NAMES);
 
 	for (size_t i = 0; i < count; i++)
 	{
 		ff::String name;
+		ff::hash_t hash = 0;
 
 		if (nameHashOnly)
 		{
-			ff::hash_t hash;
 			assertRetVal(ff::LoadData(reader, hash), false);
-			name = emptyCache.GetString(hash);
+
+			if (version != DICT_VERSION_LEGACY_HASHES)
+			{
+				name = ff::StringCache::HashToString(hash);
+			}
 		}
 		else
 		{
 			assertRetVal(ff::LoadData(reader, name), false);
 		}
 
-		ff::ValuePtr value;
-		assertRetVal(InternalLoadValue(reader, &value), false);
+		ff::ValueHandle value;
+		assertRetVal(InternalLoadHandle(reader, value), false);
+
+		if (version == DICT_VERSION_LEGACY_HASHES)
+		{
+			SetLoadedLegacyValue(dict, hash, std::move(value));
+		}
+		else
+		{
+			dict.SetHandle(name, std::move(value));
+		}
+	}
+
+	if (hasLegacyValues)
+	{
+		DWORD legacyCount = 0;
+		assertRetVal(ff::LoadData(reader, legacyCount), false);
 
-		dict.SetValue(name, value);
+		for (size_t i = 0; i < legacyCount; i++)
+		{
+			ff::hash_t legacyHash;
+			assertRetVal(ff::LoadData(reader, legacyHash), false);
+
+			ff::ValueHandle value;
+			assertRetVal(InternalLoadHandle(reader, value), false);
+
+			SetLoadedLegacyValue(dict, legacyHash, std::move(value));
+		}
 	}
 
 	return true;
@@ -556,20 +768,29 @@ void ff::DumpDict(ff::StringRef name, const Dict &dict, Log *log, bool chain, bo
 	Log extraLog;
 	Log &realLog = log ? *log : extraLog;
 
-	realLog.TraceF(L"+- Options for: %s --\r\n", name.c_str());
+	// Big dicts are traced all at once, instead of taking the log lock for every line
+	StringBuilder text;
+	text.Append(L"+- Options for: ");
+	text.Append(name);
+	text.Append(L" --\r\n");
 
 	Vector<String> names = dict.GetAllNames(chain, true, false);
 	for (const String &key: names)
 	{
-		Value *value = dict.GetValue(key, chain);
+		// Only a copy of the handle gets a Value, so the dict doesn't keep one for each scalar
+		ValueHandle handle(*dict.GetHandle(key, chain));
+		Value *value = handle.GetValue();
 		assert(value);
 
-		String valueString;
+		text.Append(L"| ");
+		text.Append(key);
+		text.Append(L": ");
+
 		ValuePtr convertedValue;
 
 		if (value->Convert(ff::Value::Type::String, &convertedValue))
 		{
-			valueString = convertedValue->AsString();
+			text.Append(convertedValue->AsString());
 		}
 		else if (value->Convert(ff::Value::Type::StringVector, &convertedValue))
 		{
@@ -577,20 +798,22 @@ void ff::DumpDict(ff::StringRef name, const Dict &dict, Log *log, bool chain, bo
 
 			for (size_t i = 0; i < strs.Size(); i++)
 			{
-				valueString += String::format_new(L"\r\n|    [%lu]: %s", i, strs[i].c_str());
+				text.Append(FF_FORMAT(L"\r\n|    [{}]: ", i));
+				text.Append(strs[i]);
 			}
 		}
 		else if (value->Convert(ff::Value::Type::Data, &convertedValue))
 		{
-			valueString.format(L"<data[%lu]>", convertedValue->AsData()->GetSize());
+			text.Append(FF_FORMAT(L"<data[{}]>", convertedValue->AsData()->GetSize()));
 		}
 		else
 		{
-			valueString = L"<data>";
+			text.Append(L"<data>");
 		}
 
-		realLog.TraceF(L"| %s: %s\r\n", key.c_str(), valueString.c_str());
+		text.Append(L"\r\n");
 	}
 
-	realLog.Trace(L"+- Done --\r\n");
+	text.Append(L"+- Done --\r\n");
+	realLog.Trace(text.ToString().c_str());
 }
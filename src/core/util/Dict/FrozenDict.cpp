@@ -0,0 +1,57 @@
+#include "pch.h"
+#include "Data/Data.h"
+#include "Dict/Dict.h"
+#include "Dict/FrozenDict.h"
+
+ff::FrozenDict::FrozenDict()
+{
+}
+
+ff::FrozenDict::FrozenDict(const Dict &dict)
+{
+	Freeze(dict);
+}
+
+ff::FrozenDict::FrozenDict(const FrozenDict &rhs)
+	: BinaryDict(rhs)
+{
+}
+
+ff::FrozenDict::FrozenDict(FrozenDict &&rhs)
+	: BinaryDict(std::move(rhs))
+{
+}
+
+ff::FrozenDict::~FrozenDict()
+{
+}
+
+const ff::FrozenDict &ff::FrozenDict::operator=(const FrozenDict &rhs)
+{
+	BinaryDict::operator=(rhs);
+	return *this;
+}
+
+bool ff::FrozenDict::Freeze(const Dict &dict)
+{
+	Close();
+
+	ComPtr<IData> data;
+	assertRetVal(SaveBinaryDict(dict, true, false, true, &data), false);
+	assertRetVal(Open(data), false);
+
+	return true;
+}
+
+bool ff::FrozenDict::Open(IData *data)
+{
+	noAssertRetVal(BinaryDict::Open(data), false);
+
+	if (!IsIndexed())
+	{
+		Close();
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "Dict/BinaryDict.h"
+
+namespace ff
+{
+	class Dict;
+
+	// A read-only copy of a dict, for settings that are read all the time. Freezing flattens
+	// the parent chain into one BinaryDict where every table (including nested dicts) has a
+	// minimal perfect hash index, so finding a key takes a few reads with no searching, no locks,
+	// and no ref counts. Small values are read straight from the slots that hold them.
+	//
+	// GetData() can be saved as-is, then opened later over CreateDataInMemMappedFile.
+	class FrozenDict : public BinaryDict
+	{
+	public:
+		UTIL_API FrozenDict();
+		UTIL_API explicit FrozenDict(const Dict &dict);
+		UTIL_API FrozenDict(const FrozenDict &rhs);
+		UTIL_API FrozenDict(FrozenDict &&rhs);
+		UTIL_API ~FrozenDict();
+
+		UTIL_API const FrozenDict &operator=(const FrozenDict &rhs);
+
+		UTIL_API bool Freeze(const Dict &dict);
+		UTIL_API bool Open(IData *data); // fails for binary dicts that weren't frozen
+	};
+}
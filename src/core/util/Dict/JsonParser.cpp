@@ -0,0 +1,1058 @@
+#include "pch.h"
+#include "Data/Data.h"
+#include "Data/DataWriterReader.h"
+#include "Dict/JsonParser.h"
+#include "Dict/Value.h"
+#include "String/NumberConvert.h"
+#include "String/StringConvert.h"
+#include "String/StringSearch.h"
+
+#if defined(_M_IX86) || defined(_M_X64)
+#define JSON_PARSER_SIMD 1
+#include <immintrin.h>
+#else
+#define JSON_PARSER_SIMD 0
+#endif
+
+// The wide char kernels compare 16-bit chars
+#define JSON_PARSER_WIDE_SIMD (JSON_PARSER_SIMD && WCHAR_MAX == 0xFFFF)
+
+static const size_t JSON_READ_CHUNK_SIZE = 64 * 1024;
+static const size_t JSON_BLOCK_CHARS = 64;
+static const size_t JSON_BATCH_BLOCKS = 64;
+
+// One bit for each of 64 chars in a row, set by the first pass over the text
+struct JsonCharBlock
+{
+	uint64_t spaces;
+	uint64_t stringStops; // quotes, backslashes, and control chars
+};
+
+template<typename CharT>
+static void PlainIndexBlock(const CharT *text, size_t count, JsonCharBlock &block)
+{
+	typedef typename std::make_unsigned<CharT>::type UnitT;
+
+	block.spaces = 0;
+	block.stringStops = 0;
+
+	for (size_t i = 0; i < count; i++)
+	{
+		CharT ch = text[i];
+		uint64_t bit = static_cast<uint64_t>(1) << i;
+
+		if (ch == ' ' || (ch >= '\t' && ch <= '\r'))
+		{
+			block.spaces |= bit;
+		}
+
+		if (ch == '\"' || ch == '\\' || static_cast<UnitT>(ch) < ' ')
+		{
+			block.stringStops |= bit;
+		}
+	}
+}
+
+template<typename CharT>
+static void PlainIndexBlocks(const CharT *text, size_t blockCount, JsonCharBlock *blocks)
+{
+	for (size_t i = 0; i < blockCount; i++, text += JSON_BLOCK_CHARS)
+	{
+		PlainIndexBlock(text, JSON_BLOCK_CHARS, blocks[i]);
+	}
+}
+
+#if JSON_PARSER_SIMD
+
+// Each Mask call covers COUNT chars from two compare results
+struct Sse2JsonBytes
+{
+	typedef char CharT;
+	typedef __m128i Vec;
+	static const size_t COUNT = 32;
+
+	static Vec Load(const char *text) { return _mm_loadu_si128(reinterpret_cast<const __m128i *>(text)); }
+	static Vec Set(int ch) { return _mm_set1_epi8(static_cast<char>(ch)); }
+	static Vec Equal(Vec a, Vec b) { return _mm_cmpeq_epi8(a, b); }
+	static Vec Greater(Vec a, Vec b) { return _mm_cmpgt_epi8(a, b); }
+	static Vec And(Vec a, Vec b) { return _mm_and_si128(a, b); }
+	static Vec Or(Vec a, Vec b) { return _mm_or_si128(a, b); }
+
+	static uint64_t Mask(Vec a, Vec b)
+	{
+		return static_cast<unsigned int>(_mm_movemask_epi8(a)) | (static_cast<uint64_t>(static_cast<unsigned int>(_mm_movemask_epi8(b))) << 16);
+	}
+};
+
+struct Avx2JsonBytes
+{
+	typedef char CharT;
+	typedef __m256i Vec;
+	static const size_t COUNT = 64;
+
+	static Vec Load(const char *text) { return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(text)); }
+	static Vec Set(int ch) { return _mm256_set1_epi8(static_cast<char>(ch)); }
+	static Vec Equal(Vec a, Vec b) { return _mm256_cmpeq_epi8(a, b); }
+	static Vec Greater(Vec a, Vec b) { return _mm256_cmpgt_epi8(a, b); }
+	static Vec And(Vec a, Vec b) { return _mm256_and_si256(a, b); }
+	static Vec Or(Vec a, Vec b) { return _mm256_or_si256(a, b); }
+
+	static uint64_t Mask(Vec a, Vec b)
+	{
+		return static_cast<unsigned int>(_mm256_movemask_epi8(a)) | (static_cast<uint64_t>(static_cast<unsigned int>(_mm256_movemask_epi8(b))) << 32);
+	}
+};
+
+#if JSON_PARSER_WIDE_SIMD
+
+struct Sse2JsonChars
+{
+	typedef wchar_t CharT;
+	typedef __m128i Vec;
+	static const size_t COUNT = 16;
+
+	static Vec Load(const wchar_t *text) { return _mm_loadu_si128(reinterpret_cast<const __m128i *>(text)); }
+	static Vec Set(int ch) { return _mm_set1_epi16(static_cast<short>(ch)); }
+	static Vec Equal(Vec a, Vec b) { return _mm_cmpeq_epi16(a, b); }
+	static Vec Greater(Vec a, Vec b) { return _mm_cmpgt_epi16(a, b); }
+	static Vec And(Vec a, Vec b) { return _mm_and_si128(a, b); }
+	static Vec Or(Vec a, Vec b) { return _mm_or_si128(a, b); }
+
+	static uint64_t Mask(Vec a, Vec b)
+	{
+		return static_cast<unsigned int>(_mm_movemask_epi8(_mm_packs_epi16(a, b)));
+	}
+};
+
+struct Avx2JsonChars
+{
+	typedef wchar_t CharT;
+	typedef __m256i Vec;
+	static const size_t COUNT = 32;
+
+	static Vec Load(const wchar_t *text) { return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(text)); }
+	static Vec Set(int ch) { return _mm256_set1_epi16(static_cast<short>(ch)); }
+	static Vec Equal(Vec a, Vec b) { return _mm256_cmpeq_epi16(a, b); }
+	static Vec Greater(Vec a, Vec b) { return _mm256_cmpgt_epi16(a, b); }
+	static Vec And(Vec a, Vec b) { return _mm256_and_si256(a, b); }
+	static Vec Or(Vec a, Vec b) { return _mm256_or_si256(a, b); }
+
+	// packs works within each 128-bit lane, so the middle quarters need to swap
+	static uint64_t Mask(Vec a, Vec b)
+	{
+		return static_cast<unsigned int>(_mm256_movemask_epi8(_mm256_permute4x64_epi64(_mm256_packs_epi16(a, b), 0xD8)));
+	}
+};
+
+#endif
+
+template<typename Chars>
+static typename Chars::Vec SpaceChars(typename Chars::Vec chars)
+{
+	// Signed compares, so UTF-8 bytes and chars at 0x8000 and up are never between tab and CR
+	return Chars::Or(
+		Chars::Equal(chars, Chars::Set(' ')),
+		Chars::And(Chars::Greater(chars, Chars::Set('\t' - 1)), Chars::Greater(Chars::Set('\r' + 1), chars)));
+}
+
+template<typename Chars>
+static typename Chars::Vec StringStopChars(typename Chars::Vec chars)
+{
+	typedef typename Chars::Vec Vec;
+
+	Vec controls = Chars::Equal(Chars::And(chars, Chars::Set(0xFFE0)), Chars::Set(0));
+	Vec quotes = Chars::Equal(chars, Chars::Set('\"'));
+	Vec backslashes = Chars::Equal(chars, Chars::Set('\\'));
+
+	return Chars::Or(controls, Chars::Or(quotes, backslashes));
+}
+
+template<typename Chars>
+static void SimdIndexBlocks(const typename Chars::CharT *text, size_t blockCount, JsonCharBlock *blocks)
+{
+	typedef typename Chars::Vec Vec;
+	const size_t vecChars = Chars::COUNT / 2;
+
+	for (size_t i = 0; i < blockCount; i++)
+	{
+		JsonCharBlock &block = blocks[i];
+		block.spaces = 0;
+		block.stringStops = 0;
+
+		for (size_t h = 0; h < JSON_BLOCK_CHARS; h += Chars::COUNT, text += Chars::COUNT)
+		{
+			Vec a = Chars::Load(text);
+			Vec b = Chars::Load(text + vecChars);
+
+			block.spaces |= Chars::Mask(SpaceChars<Chars>(a), SpaceChars<Chars>(b)) << h;
+			block.stringStops |= Chars::Mask(StringStopChars<Chars>(a), StringStopChars<Chars>(b)) << h;
+		}
+	}
+}
+
+#endif
+
+static void IndexBlocks(const char *text, size_t blockCount, JsonCharBlock *blocks)
+{
+	switch (ff::GetSimdLevel())
+	{
+#if JSON_PARSER_SIMD
+	case ff::SimdLevel::Avx2:
+		SimdIndexBlocks<Avx2JsonBytes>(text, blockCount, blocks);
+		break;
+
+	case ff::SimdLevel::Sse2:
+		SimdIndexBlocks<Sse2JsonBytes>(text, blockCount, blocks);
+		break;
+#endif
+
+	default:
+		PlainIndexBlocks(text, blockCount, blocks);
+		break;
+	}
+}
+
+static void IndexBlocks(const wchar_t *text, size_t blockCount, JsonCharBlock *blocks)
+{
+	switch (ff::GetSimdLevel())
+	{
+#if JSON_PARSER_WIDE_SIMD
+	case ff::SimdLevel::Avx2:
+		SimdIndexBlocks<Avx2JsonChars>(text, blockCount, blocks);
+		break;
+
+	case ff::SimdLevel::Sse2:
+		SimdIndexBlocks<Sse2JsonChars>(text, blockCount, blocks);
+		break;
+#endif
+
+	default:
+		PlainIndexBlocks(text, blockCount, blocks);
+		break;
+	}
+}
+
+static size_t LowestBit(uint64_t mask)
+{
+	assert(mask);
+	DWORD bit;
+
+	if (_BitScanForward(&bit, static_cast<DWORD>(mask)))
+	{
+		return bit;
+	}
+
+	_BitScanForward(&bit, static_cast<DWORD>(mask >> 32));
+	return bit + 32;
+}
+
+// Walks over wide chars or UTF-8 bytes. Input from a reader comes in one chunk at a time,
+// so a run from GetRun is only valid until the next Skip or Advance.
+//
+// The first pass uses SSE2 or AVX2 (see SimdLevel in StringSearch.h) to find spaces and the
+// chars that end a plain run in a string, one batch of blocks at a time. The parser skips
+// over them by looking for bits in those blocks instead of at each char.
+template<typename CharT>
+class JsonSource
+{
+public:
+	JsonSource(const CharT *text, size_t size)
+		: _reader(nullptr)
+		, _start(text)
+		, _cur(text)
+		, _end(text + size)
+		, _offset(0)
+		, _remaining(0)
+		, _firstBlock(0)
+		, _blockCount(0)
+	{
+	}
+
+	JsonSource(ff::IDataReader *reader)
+		: _reader(reader)
+		, _start(nullptr)
+		, _cur(nullptr)
+		, _end(nullptr)
+		, _offset(0)
+		, _remaining(reader->GetSize() - reader->GetPos())
+		, _firstBlock(0)
+		, _blockCount(0)
+	{
+		Refill();
+	}
+
+	// Zero means the end of the text
+	CharT Get() const
+	{
+		return (_cur != _end) ? *_cur : 0;
+	}
+
+	void Advance()
+	{
+		if (_cur != _end && ++_cur == _end)
+		{
+			Refill();
+		}
+	}
+
+	// Count can't be more than what's left in the current run
+	void Skip(size_t count)
+	{
+		_cur += count;
+
+		if (_cur == _end)
+		{
+			Refill();
+		}
+	}
+
+	const CharT *GetRun(size_t &count) const
+	{
+		count = _end - _cur;
+		return _cur;
+	}
+
+	size_t GetPos() const
+	{
+		return _offset + (_cur - _start);
+	}
+
+	// How many ASCII spaces are in a row, up to the end of the current run
+	size_t CountSpaces()
+	{
+		size_t pos = _cur - _start;
+		size_t size = _end - _start;
+
+		while (pos < size)
+		{
+			// Chars past the end of the run are never spaces, so this stops there
+			uint64_t notSpaces = ~GetBlock(pos / JSON_BLOCK_CHARS).spaces >> (pos % JSON_BLOCK_CHARS);
+			if (notSpaces)
+			{
+				return std::min(pos + LowestBit(notSpaces), size) - (_cur - _start);
+			}
+
+			pos = (pos / JSON_BLOCK_CHARS + 1) * JSON_BLOCK_CHARS;
+		}
+
+		return size - (_cur - _start);
+	}
+
+	// How many chars in a row can be copied into a string, up to the end of the current run
+	size_t CountPlainChars()
+	{
+		size_t pos = _cur - _start;
+		size_t size = _end - _start;
+
+		while (pos < size)
+		{
+			uint64_t stops = GetBlock(pos / JSON_BLOCK_CHARS).stringStops >> (pos % JSON_BLOCK_CHARS);
+			if (stops)
+			{
+				return pos + LowestBit(stops) - (_cur - _start);
+			}
+
+			pos = (pos / JSON_BLOCK_CHARS + 1) * JSON_BLOCK_CHARS;
+		}
+
+		return size - (_cur - _start);
+	}
+
+private:
+	// The first pass runs over a batch of blocks at a time, so the index never uses much memory
+	const JsonCharBlock &GetBlock(size_t block)
+	{
+		if (block - _firstBlock >= _blockCount)
+		{
+			size_t start = block * JSON_BLOCK_CHARS;
+			size_t count = std::min<size_t>(_end - _start - start, JSON_BATCH_BLOCKS * JSON_BLOCK_CHARS);
+			size_t fullBlocks = count / JSON_BLOCK_CHARS;
+
+			IndexBlocks(_start + start, fullBlocks, _blocks);
+
+			if (count % JSON_BLOCK_CHARS)
+			{
+				PlainIndexBlock(_start + start + fullBlocks * JSON_BLOCK_CHARS, count % JSON_BLOCK_CHARS, _blocks[fullBlocks]);
+			}
+
+			_firstBlock = block;
+			_blockCount = (count + JSON_BLOCK_CHARS - 1) / JSON_BLOCK_CHARS;
+		}
+
+		return _blocks[block - _firstBlock];
+	}
+
+	void Refill()
+	{
+		if (_reader && _remaining)
+		{
+			size_t size = std::min(_remaining, JSON_READ_CHUNK_SIZE);
+			const CharT *chunk = reinterpret_cast<const CharT *>(_reader->Read(size));
+			assertRet(chunk);
+
+			_offset += _end - _start;
+			_start = chunk;
+			_cur = chunk;
+			_end = chunk + size;
+			_remaining -= size;
+			_blockCount = 0;
+		}
+	}
+
+	ff::IDataReader *_reader;
+	const CharT *_start;
+	const CharT *_cur;
+	const CharT *_end;
+	size_t _offset;
+	size_t _remaining;
+	size_t _firstBlock;
+	size_t _blockCount;
+	JsonCharBlock _blocks[JSON_BATCH_BLOCKS];
+};
+
+static unsigned HexDigitValue(unsigned ch)
+{
+	if (ch >= '0' && ch <= '9')
+	{
+		return ch - '0';
+	}
+	else if (ch >= 'a' && ch <= 'f')
+	{
+		return ch - 'a' + 10;
+	}
+	else if (ch >= 'A' && ch <= 'F')
+	{
+		return ch - 'A' + 10;
+	}
+
+	return 16;
+}
+
+static size_t GetByteOrderMarkSize(const wchar_t *text, size_t count)
+{
+	return (count >= 1 && text[0] == 0xFEFF) ? 1 : 0;
+}
+
+static size_t GetByteOrderMarkSize(const char *text, size_t count)
+{
+	return (count >= 3 && !std::memcmp(text, "\xEF\xBB\xBF", 3)) ? 3 : 0;
+}
+
+// Recursive descent parser that accepts the same JSON as JsonTokenizer,
+// but calls the handler for each value instead of building tokens.
+template<typename CharT>
+class JsonSaxParser
+{
+public:
+	JsonSaxParser(JsonSource<CharT> &source, ff::IJsonHandler &handler)
+		: _source(source)
+		, _handler(handler)
+		, _errorPos(ff::INVALID_SIZE)
+	{
+	}
+
+	bool Parse(size_t *errorPos)
+	{
+		size_t count;
+		const CharT *run = _source.GetRun(count);
+		_source.Skip(GetByteOrderMarkSize(run, count));
+
+		bool status = ParseValue(SkipSpacesAndComments());
+		assert(status || _errorPos != ff::INVALID_SIZE);
+
+		if (errorPos)
+		{
+			*errorPos = status ? ff::INVALID_SIZE : _errorPos;
+		}
+
+		return status;
+	}
+
+private:
+	typedef typename std::make_unsigned<CharT>::type UnitT;
+
+	// Only the first error is kept, the callers that unwind after it don't change it
+	bool Fail(size_t pos)
+	{
+		if (_errorPos == ff::INVALID_SIZE)
+		{
+			_errorPos = pos;
+		}
+
+		return false;
+	}
+
+	bool ParseValue(CharT ch)
+	{
+		size_t pos = _source.GetPos();
+
+		switch (ch)
+		{
+		case '{':
+			return ParseObject();
+
+		case '[':
+			return ParseArray();
+
+		case '\"':
+			return ParseString() && (_handler.OnString(GetChars(), _chars.Size()) || Fail(pos));
+
+		case 't':
+		case 'f':
+		case 'n':
+			return ParseIdentifier();
+
+		case '-':
+		case '0':
+		case '1':
+		case '2':
+		case '3':
+		case '4':
+		case '5':
+		case '6':
+		case '7':
+		case '8':
+		case '9':
+			return ParseNumber();
+
+		default:
+			return Fail(pos);
+		}
+	}
+
+	bool ParseObject()
+	{
+		size_t pos = _source.GetPos();
+		_source.Advance();
+
+		if (!_handler.OnStartObject())
+		{
+			return Fail(pos);
+		}
+
+		for (CharT ch = SkipSpacesAndComments(); ch != '}'; )
+		{
+			// Pair name is first
+			pos = _source.GetPos();
+			if (ch != '\"' || !ParseString())
+			{
+				return Fail(pos);
+			}
+
+			if (!_handler.OnKey(GetChars(), _chars.Size()))
+			{
+				return Fail(pos);
+			}
+
+			// Colon must be after name
+			if (SkipSpacesAndComments() != ':')
+			{
+				return Fail(_source.GetPos());
+			}
+
+			_source.Advance();
+
+			if (!ParseValue(SkipSpacesAndComments()))
+			{
+				return false;
+			}
+
+			ch = SkipSpacesAndComments();
+			if (ch == ',')
+			{
+				_source.Advance();
+				ch = SkipSpacesAndComments();
+			}
+			else if (ch != '}')
+			{
+				return Fail(_source.GetPos());
+			}
+		}
+
+		pos = _source.GetPos();
+		_source.Advance();
+
+		return _handler.OnEndObject() || Fail(pos);
+	}
+
+	bool ParseArray()
+	{
+		size_t pos = _source.GetPos();
+		_source.Advance();
+
+		if (!_handler.OnStartArray())
+		{
+			return Fail(pos);
+		}
+
+		for (CharT ch = SkipSpacesAndComments(); ch != ']'; )
+		{
+			if (!ParseValue(ch))
+			{
+				return false;
+			}
+
+			ch = SkipSpacesAndComments();
+			if (ch == ',')
+			{
+				_source.Advance();
+				ch = SkipSpacesAndComments();
+			}
+			else if (ch != ']')
+			{
+				return Fail(_source.GetPos());
+			}
+		}
+
+		pos = _source.GetPos();
+		_source.Advance();
+
+		return _handler.OnEndArray() || Fail(pos);
+	}
+
+	// Leaves the decoded string in _chars. Plain runs are copied all at once.
+	bool ParseString()
+	{
+		size_t pos = _source.GetPos();
+		_source.Advance();
+		_chars.Clear();
+
+		while (true)
+		{
+			size_t count;
+			const CharT *run = _source.GetRun(count);
+			if (!count)
+			{
+				return Fail(pos);
+			}
+
+			// Jump right to the next quote, backslash, or control char
+			size_t i = _source.CountPlainChars();
+			AppendChars(run, i);
+			_source.Skip(i);
+
+			if (i == count)
+			{
+				// Keep going in the next chunk
+				continue;
+			}
+			else if (run[i] == '\"')
+			{
+				_source.Advance();
+				FlushUtf8();
+				return true;
+			}
+			else if (run[i] != '\\' || !ParseEscape())
+			{
+				return Fail(pos);
+			}
+		}
+	}
+
+	bool ParseEscape()
+	{
+		_source.Advance();
+		CharT ch = _source.Get();
+		_source.Advance();
+
+		wchar_t decoded = 0;
+
+		switch (ch)
+		{
+		case '\"':
+		case '\\':
+		case '/':
+			decoded = static_cast<wchar_t>(ch);
+			break;
+
+		case 'b':
+			decoded = '\b';
+			break;
+
+		case 'f':
+			decoded = '\f';
+			break;
+
+		case 'n':
+			decoded = '\n';
+			break;
+
+		case 'r':
+			decoded = '\r';
+			break;
+
+		case 't':
+			decoded = '\t';
+			break;
+
+		case 'u':
+			for (size_t i = 0; i < 4; i++, _source.Advance())
+			{
+				unsigned digit = HexDigitValue(static_cast<UnitT>(_source.Get()));
+				if (digit > 15)
+				{
+					return false;
+				}
+
+				decoded = static_cast<wchar_t>(decoded * 16 + digit);
+			}
+			break;
+
+		default:
+			return false;
+		}
+
+		FlushUtf8();
+		_chars.Push(decoded);
+		return true;
+	}
+
+	bool ParseNumber()
+	{
+		size_t pos = _source.GetPos();
+		CharT ch = _source.Get();
+		_number.Clear();
+
+		if (ch == '-')
+		{
+			ch = PushNumberChar(ch);
+		}
+
+		if (!ParseDigits(ch))
+		{
+			return Fail(pos);
+		}
+
+		if (ch == '.')
+		{
+			ch = PushNumberChar(ch);
+
+			if (!ParseDigits(ch))
+			{
+				return Fail(pos);
+			}
+		}
+
+		if (ch == 'e' || ch == 'E')
+		{
+			ch = PushNumberChar(ch);
+
+			if (ch == '-' || ch == '+')
+			{
+				ch = PushNumberChar(ch);
+			}
+
+			if (!ParseDigits(ch))
+			{
+				return Fail(pos);
+			}
+		}
+
+		double value;
+		if (ff::ParseDouble(_number.ConstData(), _number.Size(), value) != _number.Size())
+		{
+			return Fail(pos);
+		}
+
+		bool status = (std::floor(value) == value && value >= INT_MIN && value <= INT_MAX)
+			? _handler.OnInt(static_cast<int>(value))
+			: _handler.OnDouble(value);
+
+		return status || Fail(pos);
+	}
+
+	bool ParseDigits(CharT &ch)
+	{
+		if (ch < '0' || ch > '9')
+		{
+			return false;
+		}
+
+		do
+		{
+			ch = PushNumberChar(ch);
+		}
+		while (ch >= '0' && ch <= '9');
+
+		return true;
+	}
+
+	CharT PushNumberChar(CharT ch)
+	{
+		_number.Push(static_cast<char>(ch));
+		_source.Advance();
+		return _source.Get();
+	}
+
+	bool ParseIdentifier()
+	{
+		size_t pos = _source.GetPos();
+		char name[6];
+		size_t size = 0;
+
+		for (CharT ch = _source.Get();
+			(ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || (ch >= '0' && ch <= '9');
+			_source.Advance(), ch = _source.Get())
+		{
+			if (size < _countof(name))
+			{
+				name[size] = static_cast<char>(ch);
+			}
+
+			size++;
+		}
+
+		bool status;
+
+		if (size == 4 && !std::memcmp(name, "true", 4))
+		{
+			status = _handler.OnBool(true);
+		}
+		else if (size == 5 && !std::memcmp(name, "false", 5))
+		{
+			status = _handler.OnBool(false);
+		}
+		else if (size == 4 && !std::memcmp(name, "null", 4))
+		{
+			status = _handler.OnNull();
+		}
+		else
+		{
+			status = false;
+		}
+
+		return status || Fail(pos);
+	}
+
+	// Returns zero for a comment with no end
+	CharT SkipSpacesAndComments()
+	{
+		CharT ch = _source.Get();
+
+		while (true)
+		{
+			if (ch == ' ' || (ch >= '\t' && ch <= '\r'))
+			{
+				// Jump over the whole run of spaces
+				_source.Skip(_source.CountSpaces());
+				ch = _source.Get();
+			}
+			else if (ch == '/')
+			{
+				size_t pos = _source.GetPos();
+				_source.Advance();
+				ch = _source.Get();
+
+				if (ch == '/')
+				{
+					while (ch && ch != '\r' && ch != '\n')
+					{
+						_source.Advance();
+						ch = _source.Get();
+					}
+				}
+				else if (ch == '*')
+				{
+					_source.Advance();
+
+					for (CharT prev = 0; ; prev = ch)
+					{
+						ch = _source.Get();
+						if (!ch)
+						{
+							Fail(pos);
+							return 0;
+						}
+
+						_source.Advance();
+
+						if (prev == '*' && ch == '/')
+						{
+							break;
+						}
+					}
+
+					ch = _source.Get();
+				}
+				else
+				{
+					Fail(pos);
+					return 0;
+				}
+			}
+			else
+			{
+				return ch;
+			}
+		}
+	}
+
+	void AppendChars(const wchar_t *chars, size_t count)
+	{
+		_chars.Push(chars, count);
+	}
+
+	// UTF-8 bytes wait until the end of the string or an escape, since a char can be split between chunks
+	void AppendChars(const char *chars, size_t count)
+	{
+		_utf8.Push(chars, count);
+	}
+
+	void FlushUtf8()
+	{
+		size_t count = _utf8.Size();
+		if (count)
+		{
+			size_t size = _chars.Size();
+			_chars.Resize(size + count);
+			_chars.Resize(size + ff::Utf8ToUtf16(_utf8.ConstData(), count, _chars.Data() + size));
+			_utf8.Clear();
+		}
+	}
+
+	const wchar_t *GetChars() const
+	{
+		return _chars.Size() ? _chars.ConstData() : L"";
+	}
+
+	JsonSource<CharT> &_source;
+	ff::IJsonHandler &_handler;
+	ff::Vector<wchar_t, 256> _chars;
+	ff::Vector<char, 256> _utf8;
+	ff::Vector<char, 64> _number;
+	size_t _errorPos;
+};
+
+ff::JsonDictHandler::JsonDictHandler()
+{
+}
+
+ff::JsonDictHandler::~JsonDictHandler()
+{
+}
+
+ff::Dict ff::JsonDictHandler::TakeDict()
+{
+	return _frames.Size() ? std::move(_frames[0].dict) : Dict();
+}
+
+bool ff::JsonDictHandler::OnStartObject()
+{
+	_frames.Push(Frame());
+	return true;
+}
+
+bool ff::JsonDictHandler::OnEndObject()
+{
+	assertRetVal(_frames.Size() && !_frames.GetLast().array, false);
+
+	// The root object stays around for TakeDict
+	noAssertRetVal(_frames.Size() > 1, true);
+
+	ValuePtr value;
+	bool status = Value::CreateDict(std::move(_frames.GetLast().dict), &value);
+	_frames.Delete(_frames.Size() - 1);
+
+	return status && AddValue(ValueHandle(value));
+}
+
+bool ff::JsonDictHandler::OnStartArray()
+{
+	// The root has to be an object
+	noAssertRetVal(_frames.Size(), false);
+
+	_frames.Push(Frame());
+	_frames.GetLast().array = true;
+	return true;
+}
+
+bool ff::JsonDictHandler::OnEndArray()
+{
+	assertRetVal(_frames.Size() > 1 && _frames.GetLast().array, false);
+
+	ValuePtr value;
+	bool status = Value::CreateValueVector(std::move(_frames.GetLast().values), &value);
+	_frames.Delete(_frames.Size() - 1);
+
+	return status && AddValue(ValueHandle(value));
+}
+
+bool ff::JsonDictHandler::OnKey(const wchar_t *key, size_t size)
+{
+	assertRetVal(_frames.Size() && !_frames.GetLast().array, false);
+	_frames.GetLast().key.assign(key, size);
+	return true;
+}
+
+bool ff::JsonDictHandler::OnString(const wchar_t *str, size_t size)
+{
+	ValuePtr value;
+	return Value::CreateString(String(str, size), &value) && AddValue(ValueHandle(value));
+}
+
+bool ff::JsonDictHandler::OnInt(int val)
+{
+	return AddValue(ValueHandle(val));
+}
+
+bool ff::JsonDictHandler::OnDouble(double val)
+{
+	return AddValue(ValueHandle(val));
+}
+
+bool ff::JsonDictHandler::OnBool(bool val)
+{
+	return AddValue(ValueHandle(val));
+}
+
+bool ff::JsonDictHandler::OnNull()
+{
+	return AddValue(ValueHandle::Null());
+}
+
+bool ff::JsonDictHandler::AddValue(ValueHandle &&value)
+{
+	// The root has to be an object
+	noAssertRetVal(_frames.Size(), false);
+
+	Frame &frame = _frames.GetLast();
+	if (frame.array)
+	{
+		// Vectors only hold real values
+		Value *realValue = value.GetValue();
+		assertRetVal(realValue, false);
+		frame.values.Push(realValue);
+	}
+	else
+	{
+		frame.dict.SetHandle(frame.key, std::move(value));
+	}
+
+	return true;
+}
+
+bool ff::JsonSaxParse(StringRef text, IJsonHandler &handler, size_t *errorPos)
+{
+	JsonSource<wchar_t> source(text.c_str(), text.size());
+	return JsonSaxParser<wchar_t>(source, handler).Parse(errorPos);
+}
+
+bool ff::JsonSaxParse(const char *text, size_t size, IJsonHandler &handler, size_t *errorPos)
+{
+	JsonSource<char> source(text, size);
+	return JsonSaxParser<char>(source, handler).Parse(errorPos);
+}
+
+bool ff::JsonSaxParse(IData *data, IJsonHandler &handler, size_t *errorPos)
+{
+	assertRetVal(data, false);
+	return JsonSaxParse(reinterpret_cast<const char *>(data->GetMem()), data->GetSize(), handler, errorPos);
+}
+
+bool ff::JsonSaxParse(IDataReader *reader, IJsonHandler &handler, size_t *errorPos)
+{
+	assertRetVal(reader, false);
+
+	JsonSource<char> source(reader);
+	return JsonSaxParser<char>(source, handler).Parse(errorPos);
+}
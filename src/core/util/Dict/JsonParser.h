@@ -0,0 +1,75 @@
+#pragma once
+
+#include "Dict/Dict.h"
+
+namespace ff
+{
+	class IData;
+	class IDataReader;
+
+	/// Gets called by JsonSaxParse for each part of the JSON text, in order.
+	///
+	/// Chars passed to OnKey and OnString are only valid during the call. Return false from
+	/// any callback to stop parsing, the error position will be the start of that value.
+	class IJsonHandler
+	{
+	public:
+		virtual bool OnStartObject() = 0;
+		virtual bool OnEndObject() = 0;
+		virtual bool OnStartArray() = 0;
+		virtual bool OnEndArray() = 0;
+		virtual bool OnKey(const wchar_t *key, size_t size) = 0;
+		virtual bool OnString(const wchar_t *str, size_t size) = 0;
+		virtual bool OnInt(int value) = 0;
+		virtual bool OnDouble(double value) = 0;
+		virtual bool OnBool(bool value) = 0;
+		virtual bool OnNull() = 0;
+	};
+
+	/// Builds a Dict out of a JSON root object, this is what JsonParse uses
+	class JsonDictHandler : public IJsonHandler
+	{
+	public:
+		UTIL_API JsonDictHandler();
+		UTIL_API ~JsonDictHandler();
+
+		// The root object. After an error, it only has the values that were done before the error.
+		UTIL_API Dict TakeDict();
+
+		UTIL_API virtual bool OnStartObject() override;
+		UTIL_API virtual bool OnEndObject() override;
+		UTIL_API virtual bool OnStartArray() override;
+		UTIL_API virtual bool OnEndArray() override;
+		UTIL_API virtual bool OnKey(const wchar_t *key, size_t size) override;
+		UTIL_API virtual bool OnString(const wchar_t *str, size_t size) override;
+		UTIL_API virtual bool OnInt(int value) override;
+		UTIL_API virtual bool OnDouble(double value) override;
+		UTIL_API virtual bool OnBool(bool value) override;
+		UTIL_API virtual bool OnNull() override;
+
+	private:
+		JsonDictHandler(const JsonDictHandler &rhs) = delete;
+		JsonDictHandler &operator=(const JsonDictHandler &rhs) = delete;
+
+		bool AddValue(ValueHandle &&value);
+
+		struct Frame
+		{
+			Dict dict;
+			Vector<ValuePtr> values;
+			String key;
+			bool array;
+		};
+
+		Vector<Frame> _frames;
+	};
+
+	// Comments and trailing commas are allowed. For wide text, errorPos is a char index.
+	UTIL_API bool JsonSaxParse(StringRef text, IJsonHandler &handler, size_t *errorPos = nullptr);
+
+	// UTF-8 text is never converted as a whole, only each string or key as it's reached.
+	// For these, errorPos is a byte offset.
+	UTIL_API bool JsonSaxParse(const char *text, size_t size, IJsonHandler &handler, size_t *errorPos = nullptr);
+	UTIL_API bool JsonSaxParse(IData *data, IJsonHandler &handler, size_t *errorPos = nullptr);
+	UTIL_API bool JsonSaxParse(IDataReader *reader, IJsonHandler &handler, size_t *errorPos = nullptr); // reads in chunks until the end
+}
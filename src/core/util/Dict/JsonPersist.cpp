@@ -1,263 +1,237 @@
 #include "pch.h"
 #include "Dict/Dict.h"
+#include "Dict/JsonParser.h"
 #include "Dict/JsonPersist.h"
-#include "Dict/JsonTokenizer.h"
 #include "Dict/Value.h"
+#include "String/NumberConvert.h"
+#include "String/StringBuilder.h"
 
 static const size_t INDENT_SPACES = 2;
 
-static bool JsonWriteValue(ff::Value *value, size_t spaces, ff::String &output);
-static void JsonWriteObject(const ff::Dict &dict, size_t spaces, ff::String &output);
-static ff::Dict ParseObject(ff::JsonTokenizer &tokenizer, const wchar_t **errorPos);
-static ff::Vector<ff::ValuePtr> ParseArray(ff::JsonTokenizer &tokenizer, const wchar_t **errorPos);
+static bool JsonWriteValue(ff::Value *value, size_t spaces, ff::StringBuilder &output);
+static void JsonWriteObject(const ff::Dict &dict, size_t spaces, ff::StringBuilder &output);
 
-static ff::ValuePtr ParseValue(ff::JsonTokenizer &tokenizer, ff::JsonToken *firstToken, const wchar_t **errorPos)
+ff::Dict ff::JsonParse(StringRef text, size_t *errorPos)
 {
-	ff::ValuePtr value;
-	ff::JsonToken token = firstToken ? *firstToken : tokenizer.NextToken();
-
-	if (!token.GetValue(&value))
-	{
-		if (token._type == ff::JsonTokenType::OpenCurly)
-		{
-			// Nested object
-			ff::Dict valueDict = ParseObject(tokenizer, errorPos);
-			if (!*errorPos && !ff::Value::CreateDict(std::move(valueDict), &value))
-			{
-				*errorPos = token._start;
-			}
-		}
-		else if (token._type == ff::JsonTokenType::OpenBracket)
-		{
-			// Array
-			ff::Vector<ff::ValuePtr> valueVector = ParseArray(tokenizer, errorPos);
-			if (!*errorPos && !ff::Value::CreateValueVector(std::move(valueVector), &value))
-			{
-				*errorPos = token._start;
-			}
-		}
-	}
+	JsonDictHandler handler;
+	JsonSaxParse(text, handler, errorPos);
+	return handler.TakeDict();
+}
 
-	if (!*errorPos && !value)
-	{
-		*errorPos = token._start;
-	}
+ff::Dict ff::JsonParse(IData *data, size_t *errorPos)
+{
+	JsonDictHandler handler;
+	JsonSaxParse(data, handler, errorPos);
+	return handler.TakeDict();
+}
 
-	return value;
+ff::Dict ff::JsonParse(IDataReader *reader, size_t *errorPos)
+{
+	JsonDictHandler handler;
+	JsonSaxParse(reader, handler, errorPos);
+	return handler.TakeDict();
 }
 
-static ff::Vector<ff::ValuePtr> ParseArray(ff::JsonTokenizer &tokenizer, const wchar_t **errorPos)
+// Plain runs of chars get appended all at once, only the escaped chars are one at a time
+static void JsonEncode(ff::StringRef value, ff::StringBuilder &output)
 {
-	ff::Vector<ff::ValuePtr> values;
+	const wchar_t *start = value.c_str();
+	output.Append(L'\"');
 
-	for (ff::JsonToken token = tokenizer.NextToken(); token._type != ff::JsonTokenType::CloseBracket; )
+	for (const wchar_t *ch = start; ; ch++)
 	{
-		ff::ValuePtr value = ParseValue(tokenizer, &token, errorPos);
-		if (*errorPos)
+		const wchar_t *escape = nullptr;
+
+		switch (*ch)
 		{
+		case '\"':
+			escape = L"\\\"";
 			break;
-		}
 
-		values.Push(value);
+		case '\\':
+			escape = L"\\\\";
+			break;
 
-		token = tokenizer.NextToken();
-		if (token._type != ff::JsonTokenType::Comma &&
-			token._type != ff::JsonTokenType::CloseBracket)
-		{
-			*errorPos = token._start;
+		case '\b':
+			escape = L"\\b";
 			break;
-		}
 
-		if (token._type == ff::JsonTokenType::Comma)
-		{
-			token = tokenizer.NextToken();
-		}
-	}
+		case '\f':
+			escape = L"\\f";
+			break;
 
-	return values;
-}
+		case '\n':
+			escape = L"\\n";
+			break;
 
-static ff::Dict ParseObject(ff::JsonTokenizer &tokenizer, const wchar_t **errorPos)
-{
-	ff::Dict dict;
+		case '\r':
+			escape = L"\\r";
+			break;
 
-	for (ff::JsonToken token = tokenizer.NextToken(); token._type != ff::JsonTokenType::CloseCurly; )
-	{
-		// Pair name is first
-		if (token._type != ff::JsonTokenType::String)
-		{
-			*errorPos = token._start;
+		case '\t':
+			escape = L"\\t";
 			break;
-		}
 
-		// Get string from token
-		ff::ValuePtr key;
-		if (!token.GetValue(&key))
-		{
-			*errorPos = token._start;
+		default:
+			if (*ch >= ' ')
+			{
+				continue;
+			}
 			break;
 		}
 
-		// Colon must be after name
-		token = tokenizer.NextToken();
-		if (token._type != ff::JsonTokenType::Colon)
+		output.Append(start, ch - start);
+		start = ch + 1;
+
+		if (escape)
 		{
-			*errorPos = token._start;
-			break;
+			output.Append(escape, 2);
 		}
-
-		ff::ValuePtr value = ParseValue(tokenizer, nullptr, errorPos);
-		if (*errorPos)
+		else if (!*ch)
 		{
 			break;
 		}
+	}
 
-		dict.SetValue(key->AsString(), value);
+	output.Append(L'\"');
+}
 
-		token = tokenizer.NextToken();
-		if (token._type != ff::JsonTokenType::Comma &&
-			token._type != ff::JsonTokenType::CloseCurly)
-		{
-			*errorPos = token._start;
-			break;
-		}
+static void JsonWriteArray(const ff::Vector<ff::ValuePtr> &values, size_t spaces, ff::StringBuilder &output)
+{
+	output.Append(L'[');
+	
+	size_t size = values.Size();
+	if (size)
+	{
+		output.Append(L"\r\n", 2);
 
-		if (token._type == ff::JsonTokenType::Comma)
+		for (size_t i = 0; i < size; i++)
 		{
-			token = tokenizer.NextToken();
+			// Indent
+			output.Append(spaces + INDENT_SPACES, ' ');
+
+			JsonWriteValue(values[i], spaces + INDENT_SPACES, output);
+
+			if (i + 1 < size)
+			{
+				output.Append(L',');
+			}
+
+			output.Append(L"\r\n", 2);
 		}
+
+		output.Append(spaces, ' ');
 	}
 
-	return dict;
+	output.Append(L']');
 }
 
-static ff::Dict ParseRootObject(ff::JsonTokenizer &tokenizer, const wchar_t **errorPos)
+// JSON has no infinity or NaN, so they're written as null like JavaScript does
+static void JsonWriteNumber(double value, ff::StringBuilder &output)
 {
-	ff::JsonToken token = tokenizer.NextToken();
-	if (token._type == ff::JsonTokenType::OpenCurly)
+	if (!std::isfinite(value))
 	{
-		return ParseObject(tokenizer, errorPos);
+		output.Append(L"null", 4);
+		return;
 	}
 
-	*errorPos = token._start;
-	return ff::Dict();
+	wchar_t buf[ff::MAX_NUMBER_CHARS];
+	output.Append(buf, ff::FormatDouble(value, buf));
 }
 
-ff::Dict ff::JsonParse(StringRef text, size_t *errorPos)
+static void JsonWriteNumber(float value, ff::StringBuilder &output)
 {
-	JsonTokenizer tokenizer(text);
-
-	const wchar_t *myErrorPos = nullptr;
-	Dict dict = ParseRootObject(tokenizer, &myErrorPos);
-
-	if (errorPos)
+	if (!std::isfinite(value))
 	{
-		*errorPos = myErrorPos ? (myErrorPos - text.c_str()) : ff::INVALID_SIZE;
+		output.Append(L"null", 4);
+		return;
 	}
 
-	return dict;
+	wchar_t buf[ff::MAX_NUMBER_CHARS];
+	output.Append(buf, ff::FormatFloat(value, buf));
 }
 
-static ff::String JsonEncode(ff::StringRef value)
+static void JsonWriteNumber(int value, ff::StringBuilder &output)
 {
-	ff::String output;
-	output.reserve(value.size() + 2);
-	output.append(1, '\"');
+	JsonWriteNumber(static_cast<double>(value), output);
+}
 
-	for (const wchar_t *ch = value.c_str(); *ch; ch++)
+// Arrays that aren't empty start on their own line
+static void JsonWriteArrayBreak(size_t size, size_t spaces, ff::StringBuilder &output)
+{
+	if (size)
 	{
-		switch (*ch)
-		{
-		case '\"':
-			output.append(L"\\\"", 2);
-			break;
-
-		case '\\':
-			output.append(L"\\\\", 2);
-			break;
-
-		case '\b':
-			output.append(L"\\b", 2);
-			break;
-
-		case '\f':
-			output.append(L"\\f", 2);
-			break;
-
-		case '\n':
-			output.append(L"\\n", 2);
-			break;
-
-		case '\r':
-			output.append(L"\\r", 2);
-			break;
-
-		case '\t':
-			output.append(L"\\t", 2);
-			break;
-
-		default:
-			if (*ch >= ' ')
-			{
-				output.append(1, *ch);
-			}
-			break;
-		}
+		output.Append(L"\r\n", 2);
+		output.Append(spaces, ' ');
+	}
+	else
+	{
+		output.Append(L' ');
 	}
-
-	output.append(1, '\"');
-	return output;
 }
 
-static void JsonWriteArray(const ff::Vector<ff::ValuePtr> &values, size_t spaces, ff::String &output)
+// DoubleVector, FloatVector, and IntVector values are written just like a ValueVector of numbers
+template<typename T>
+static void JsonWriteNumberArray(const ff::Vector<T> &values, size_t spaces, ff::StringBuilder &output)
 {
-	output.append(1, '[');
-	
+	output.Append(L'[');
+
 	size_t size = values.Size();
 	if (size)
 	{
-		output.append(L"\r\n", 2);
+		output.Append(L"\r\n", 2);
 
 		for (size_t i = 0; i < size; i++)
 		{
-			// Indent
-			output.append(spaces + INDENT_SPACES, ' ');
-
-			JsonWriteValue(values[i], spaces + INDENT_SPACES, output);
+			output.Append(spaces + INDENT_SPACES + 1, ' ');
+			JsonWriteNumber(values[i], output);
 
 			if (i + 1 < size)
 			{
-				output.append(1, ',');
+				output.Append(L',');
 			}
 
-			output.append(L"\r\n", 2);
+			output.Append(L"\r\n", 2);
 		}
 
-		output.append(spaces, ' ');
+		output.Append(spaces, ' ');
 	}
 
-	output.append(1, ']');
+	output.Append(L']');
 }
 
-static bool JsonWriteValue(ff::Value *value, size_t spaces, ff::String &output)
+static bool JsonWriteValue(ff::Value *value, size_t spaces, ff::StringBuilder &output)
 {
 	switch (value->GetType())
 	{
 	case ff::Value::Type::String:
-		output.append(1, ' ');
-		output += JsonEncode(value->AsString());
+		output.Append(L' ');
+		JsonEncode(value->AsString(), output);
 		break;
 
-	case ff::Value::Type::Bool:
-	case ff::Value::Type::Null:
 	case ff::Value::Type::Double:
+		output.Append(L' ');
+		JsonWriteNumber(value->AsDouble(), output);
+		break;
+
+	case ff::Value::Type::Float:
+		output.Append(L' ');
+		JsonWriteNumber(value->AsFloat(), output);
+		break;
+
 	case ff::Value::Type::Int:
+		output.Append(L' ');
+		JsonWriteNumber(value->AsInt(), output);
+		break;
+
+	case ff::Value::Type::Bool:
+	case ff::Value::Type::Null:
 		{
 			ff::ValuePtr strValue;
 			if (value->Convert(ff::Value::Type::String, &strValue))
 			{
-				output.append(1, ' ');
-				output += strValue->AsString();
+				output.Append(L' ');
+				output.Append(strValue->AsString());
 			}
 		}
 		break;
@@ -265,31 +239,37 @@ static bool JsonWriteValue(ff::Value *value, size_t spaces, ff::String &output)
 	case ff::Value::Type::Dict:
 		if (!value->AsDict().IsEmpty(true))
 		{
-			output.append(L"\r\n", 2);
-			output.append(spaces, ' ');
+			output.Append(L"\r\n", 2);
+			output.Append(spaces, ' ');
 		}
 		else
 		{
-			output.append(1, ' ');
+			output.Append(L' ');
 		}
 
 		JsonWriteObject(value->AsDict(), spaces, output);
 		break;
 
 	case ff::Value::Type::ValueVector:
-		if (value->AsValueVector().Size())
-		{
-			output.append(L"\r\n", 2);
-			output.append(spaces, ' ');
-		}
-		else
-		{
-			output.append(1, ' ');
-		}
-
+		JsonWriteArrayBreak(value->AsValueVector().Size(), spaces, output);
 		JsonWriteArray(value->AsValueVector(), spaces, output);
 		break;
 
+	case ff::Value::Type::DoubleVector:
+		JsonWriteArrayBreak(value->AsDoubleVector().Size(), spaces, output);
+		JsonWriteNumberArray(value->AsDoubleVector(), spaces, output);
+		break;
+
+	case ff::Value::Type::FloatVector:
+		JsonWriteArrayBreak(value->AsFloatVector().Size(), spaces, output);
+		JsonWriteNumberArray(value->AsFloatVector(), spaces, output);
+		break;
+
+	case ff::Value::Type::IntVector:
+		JsonWriteArrayBreak(value->AsIntVector().Size(), spaces, output);
+		JsonWriteNumberArray(value->AsIntVector(), spaces, output);
+		break;
+
 	default:
 		assertRetVal(false, false);
 	}
@@ -297,43 +277,91 @@ static bool JsonWriteValue(ff::Value *value, size_t spaces, ff::String &output)
 	return true;
 }
 
-static void JsonWriteObject(const ff::Dict &dict, size_t spaces, ff::String &output)
+// Inline scalars are written straight from the handle, asking for their Value would create one
+// that the dict keeps forever
+static bool JsonWriteHandle(const ff::ValueHandle *handle, size_t spaces, ff::StringBuilder &output)
 {
-	output.append(1, '{');
+	assertRetVal(handle && handle->IsValid(), false);
+
+	if (!handle->IsInline())
+	{
+		return JsonWriteValue(handle->GetValue(), spaces, output);
+	}
+
+	switch (handle->GetType())
+	{
+	case ff::Value::Type::Double:
+		output.Append(L' ');
+		JsonWriteNumber(handle->AsDouble(), output);
+		break;
+
+	case ff::Value::Type::Float:
+		output.Append(L' ');
+		JsonWriteNumber(handle->AsFloat(), output);
+		break;
+
+	case ff::Value::Type::Int:
+		output.Append(L' ');
+		JsonWriteNumber(handle->AsInt(), output);
+		break;
+
+	case ff::Value::Type::Bool:
+		output.Append(handle->AsBool() ? L" true" : L" false");
+		break;
+
+	case ff::Value::Type::Null:
+		output.Append(L" null", 5);
+		break;
+
+	default:
+		assertRetVal(false, false);
+	}
+
+	return true;
+}
+
+static void JsonWriteObject(const ff::Dict &dict, size_t spaces, ff::StringBuilder &output)
+{
+	output.Append(L'{');
 
 	ff::Vector<ff::String> names = dict.GetAllNames(true, true, false);
 	if (names.Size())
 	{
-		output.append(L"\r\n", 2);
+		output.Append(L"\r\n", 2);
 
 		for (size_t i = 0; i < names.Size(); i++)
 		{
 			// Indent
-			output.append(spaces + INDENT_SPACES, ' ');
+			output.Append(spaces + INDENT_SPACES, ' ');
 
 			// "key": value,
 			ff::StringRef name = names[i];
-			output.append(JsonEncode(name));
-			output.append(1, ':');
-			JsonWriteValue(dict.GetValue(name, true), spaces + INDENT_SPACES, output);
+			JsonEncode(name, output);
+			output.Append(L':');
+			JsonWriteHandle(dict.GetHandle(name, true), spaces + INDENT_SPACES, output);
 
 			if (i + 1 < names.Size())
 			{
-				output.append(1, ',');
+				output.Append(L',');
 			}
 
-			output.append(L"\r\n", 2);
+			output.Append(L"\r\n", 2);
 		}
 
-		output.append(spaces, ' ');
+		output.Append(spaces, ' ');
 	}
 
-	output.append(1, '}');
+	output.Append(L'}');
 }
 
 ff::String ff::JsonWrite(const Dict &dict)
 {
-	String output;
+	StringBuilder output;
+	JsonWriteObject(dict, 0, output);
+	return output.ToString();
+}
+
+void ff::JsonWrite(const Dict &dict, StringBuilder &output)
+{
 	JsonWriteObject(dict, 0, output);
-	return output;
 }
@@ -4,6 +4,13 @@
 
 namespace ff
 {
+	class IData;
+	class IDataReader;
+	class StringBuilder;
+
 	UTIL_API Dict JsonParse(StringRef text, size_t *errorPos = nullptr);
+	UTIL_API Dict JsonParse(IData *data, size_t *errorPos = nullptr); // UTF-8, errorPos is a byte offset
+	UTIL_API Dict JsonParse(IDataReader *reader, size_t *errorPos = nullptr); // UTF-8 from the current position to the end
 	UTIL_API String JsonWrite(const Dict &dict);
+	UTIL_API void JsonWrite(const Dict &dict, StringBuilder &output); // for big output, can be written straight to a file
 }
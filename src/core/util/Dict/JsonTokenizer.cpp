@@ -1,6 +1,7 @@
 #include "pch.h"
 #include "Dict/JsonTokenizer.h"
 #include "Dict/Value.h"
+#include "String/NumberConvert.h"
 
 bool ff::JsonToken::GetValue(Value **value) const
 {
@@ -23,10 +24,8 @@ bool ff::JsonToken::GetValue(Value **value) const
 
 	case JsonTokenType::Number:
 		{
-			wchar_t *end = nullptr;
-			double val = wcstod(_start, &end);
-
-			if (end == _start + _length)
+			double val;
+			if (ParseDouble(_start, _length, val) == _length)
 			{
 				if (std::floor(val) == val && val >= INT_MIN && val <= INT_MAX)
 				{
@@ -123,8 +122,8 @@ bool ff::JsonToken::GetValue(Value **value) const
 
 ff::JsonTokenizer::JsonTokenizer(StringRef text)
 	: _text(text)
-	, _pos(text.c_str())
-	, _end(text.c_str() + text.size())
+	, _pos(_text.c_str())
+	, _end(_text.c_str() + _text.size())
 {
 }
 
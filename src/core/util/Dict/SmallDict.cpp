@@ -2,6 +2,90 @@
 #include "Dict/SmallDict.h"
 #include "Dict/Value.h"
 #include "Globals/ProcessGlobals.h"
+#include "String/StringSearch.h"
+
+#if defined(_M_IX86) || defined(_M_X64)
+#define SMALL_DICT_SIMD 1
+#include <immintrin.h>
+#else
+#define SMALL_DICT_SIMD 0
+#endif
+
+// The hashes start 32 bytes in, right after the header, so every four hashes that AVX2
+// loads at once are 32 byte aligned and never straddle a 64 byte cache line
+static const size_t DATA_ALIGN = 32;
+static const size_t DATA_HEADER_SIZE = 32;
+
+// Smaller dicts are searched with a plain loop, it isn't worth checking the CPU
+static const size_t MIN_SIMD_SEARCH = 4;
+
+static size_t PlainIndexOfHash(const ff::hash_t *hashes, size_t count, ff::hash_t hash)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		if (hashes[i] == hash)
+		{
+			return i;
+		}
+	}
+
+	return ff::INVALID_SIZE;
+}
+
+#if SMALL_DICT_SIMD
+
+static size_t LowestBit(int mask)
+{
+	assert(mask);
+	DWORD bit;
+	_BitScanForward(&bit, static_cast<DWORD>(mask));
+	return bit;
+}
+
+// There's no 64-bit compare in SSE2, so both halves of each hash have to match
+static size_t Sse2IndexOfHash(const ff::hash_t *hashes, size_t count, ff::hash_t hash)
+{
+	__m128i find = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(&hash));
+	find = _mm_unpacklo_epi64(find, find);
+
+	size_t i = 0;
+	for (; i + 2 <= count; i += 2)
+	{
+		__m128i found = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(hashes + i)), find);
+		found = _mm_and_si128(found, _mm_shuffle_epi32(found, _MM_SHUFFLE(2, 3, 0, 1)));
+
+		int mask = _mm_movemask_pd(_mm_castsi128_pd(found));
+		if (mask)
+		{
+			return i + LowestBit(mask);
+		}
+	}
+
+	size_t rest = PlainIndexOfHash(hashes + i, count - i, hash);
+	return (rest != ff::INVALID_SIZE) ? i + rest : rest;
+}
+
+static size_t Avx2IndexOfHash(const ff::hash_t *hashes, size_t count, ff::hash_t hash)
+{
+	__m256i find = _mm256_broadcastq_epi64(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(&hash)));
+
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		__m256i found = _mm256_cmpeq_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(hashes + i)), find);
+
+		int mask = _mm256_movemask_pd(_mm256_castsi256_pd(found));
+		if (mask)
+		{
+			return i + LowestBit(mask);
+		}
+	}
+
+	size_t rest = PlainIndexOfHash(hashes + i, count - i, hash);
+	return (rest != ff::INVALID_SIZE) ? i + rest : rest;
+}
+
+#endif
 
 ff::SmallDict::SmallDict()
 	: _data(nullptr)
@@ -38,11 +122,14 @@ const ff::SmallDict &ff::SmallDict::operator=(const SmallDict &rhs)
 			_data->size = size;
 			_data->atomizer = rhs._data->atomizer;
 
-			::memcpy(_data->entries, rhs._data->entries, size * sizeof(Entry));
+			::memcpy(Hashes(), rhs.Hashes(), size * sizeof(hash_t));
+
+			ValueHandle *values = Values();
+			ValueHandle *rhsValues = rhs.Values();
 
 			for (size_t i = 0; i < size; i++)
 			{
-				_data->entries[i].value->AddRef();
+				::new(values + i) ValueHandle(rhsValues[i]);
 			}
 		}
 	}
@@ -64,65 +151,109 @@ ff::String ff::SmallDict::KeyAt(size_t index) const
 {
 	assertRetVal(index < Size(), ff::GetEmptyString());
 
-	hash_t hash = _data->entries[index].hash;
-	return _data->atomizer->GetString(hash);
+	return _data->atomizer->GetString(Hashes()[index]);
 }
 
 ff::hash_t ff::SmallDict::KeyHashAt(size_t index) const
 {
 	assertRetVal(index < Size(), 0);
-	return _data->entries[index].hash;
+	return Hashes()[index];
 }
 
 ff::Value *ff::SmallDict::ValueAt(size_t index) const
 {
 	assertRetVal(index < Size(), nullptr);
-	return _data->entries[index].value;
+	return Values()[index].GetValue();
+}
+
+const ff::ValueHandle &ff::SmallDict::HandleAt(size_t index) const
+{
+	static const ValueHandle s_emptyHandle; // STATIC_DATA (object)
+	assertRetVal(index < Size(), s_emptyHandle);
+	return Values()[index];
 }
 
 ff::Value *ff::SmallDict::GetValue(ff::StringRef key) const
 {
 	size_t i = IndexOf(key);
-	return (i != INVALID_SIZE) ? _data->entries[i].value : nullptr;
+	return (i != INVALID_SIZE) ? Values()[i].GetValue() : nullptr;
 }
 
 size_t ff::SmallDict::IndexOf(ff::StringRef key) const
+{
+	noAssertRetVal(Size(), INVALID_SIZE);
+
+	return IndexOfHash(_data->atomizer->GetHash(key));
+}
+
+size_t ff::SmallDict::IndexOfHash(hash_t hash) const
 {
 	size_t size = Size();
 	noAssertRetVal(size, INVALID_SIZE);
 
-	hash_t hash = _data->atomizer->GetHash(key);
-	Entry *end = _data->entries + size;
-
-	for (Entry *entry = _data->entries; entry != end; entry++)
+#if SMALL_DICT_SIMD
+	if (size >= MIN_SIMD_SEARCH)
 	{
-		if (entry->hash == hash)
+		switch (GetSimdLevel())
 		{
-			return entry - _data->entries;
+		case SimdLevel::Avx2:
+			return Avx2IndexOfHash(Hashes(), size, hash);
+
+		case SimdLevel::Sse2:
+			return Sse2IndexOfHash(Hashes(), size, hash);
 		}
 	}
+#endif
 
-	return INVALID_SIZE;
+	return PlainIndexOfHash(Hashes(), size, hash);
 }
 
 void ff::SmallDict::Add(ff::StringRef key, Value *value)
 {
 	assertRet(value);
-	value->AddRef();
+	Add(key, ValueHandle(value));
+}
+
+void ff::SmallDict::Set(ff::StringRef key, Value *value)
+{
+	if (value == nullptr)
+	{
+		Remove(key);
+		return;
+	}
+
+	Set(key, ValueHandle(value));
+}
+
+void ff::SmallDict::SetAt(size_t index, Value *value)
+{
+	if (value)
+	{
+		SetAt(index, ValueHandle(value));
+	}
+	else
+	{
+		RemoveAt(index);
+	}
+}
+
+void ff::SmallDict::Add(ff::StringRef key, ValueHandle &&value)
+{
+	assertRet(value.IsValid());
 
 	size_t size = Size();
 	Reserve(size + 1);
 
 	hash_t hash = _data->atomizer->CacheString(key);
 
-	_data->entries[size].hash = hash;
-	_data->entries[size].value = value;
+	Hashes()[size] = hash;
+	::new(Values() + size) ValueHandle(std::move(value));
 	_data->size++;
 }
 
-void ff::SmallDict::Set(ff::StringRef key, Value *value)
+void ff::SmallDict::Set(ff::StringRef key, ValueHandle &&value)
 {
-	if (value == nullptr)
+	if (!value.IsValid())
 	{
 		Remove(key);
 		return;
@@ -131,21 +262,19 @@ void ff::SmallDict::Set(ff::StringRef key, Value *value)
 	size_t index = IndexOf(key);
 	if (index != INVALID_SIZE)
 	{
-		SetAt(index, value);
+		SetAt(index, std::move(value));
 		return;
 	}
 
-	Add(key, value);
+	Add(key, std::move(value));
 }
 
-void ff::SmallDict::SetAt(size_t index, Value *value)
+void ff::SmallDict::SetAt(size_t index, ValueHandle &&value)
 {
 	assertRet(index < Size());
-	if (value)
+	if (value.IsValid())
 	{
-		value->AddRef();
-		_data->entries[index].value->Release();
-		_data->entries[index].value = value;
+		Values()[index] = std::move(value);
 	}
 	else
 	{
@@ -162,7 +291,7 @@ void ff::SmallDict::Remove(ff::StringRef key)
 
 		for (size_t i = PreviousSize(size); i != INVALID_SIZE; i = PreviousSize(i))
 		{
-			if (_data->entries[i].hash == hash)
+			if (Hashes()[i] == hash)
 			{
 				RemoveAt(i);
 			}
@@ -175,8 +304,12 @@ void ff::SmallDict::RemoveAt(size_t index)
 	size_t size = Size();
 	assertRet(index < size);
 
-	_data->entries[index].value->Release();
-	::memmove(_data->entries + index, _data->entries + index + 1, (size - index - 1) * sizeof(Entry));
+	hash_t *hashes = Hashes();
+	ValueHandle *values = Values();
+
+	values[index].~ValueHandle();
+	::memmove(hashes + index, hashes + index + 1, (size - index - 1) * sizeof(hash_t));
+	::memmove(values + index, values + index + 1, (size - index - 1) * sizeof(ValueHandle));
 	_data->size--;
 }
 
@@ -190,8 +323,15 @@ void ff::SmallDict::Reserve(size_t newAllocated, bool allowEmptySpace)
 			newAllocated = std::max<size_t>(NearestPowerOfTwo(newAllocated), 4);
 		}
 
-		size_t byteSize = sizeof(Data) + newAllocated * sizeof(Entry) - sizeof(Entry);
-		_data = (Data *)_aligned_realloc(_data, byteSize, __alignof(Data));
+		size_t byteSize = DATA_HEADER_SIZE + newAllocated * (sizeof(hash_t) + sizeof(ValueHandle));
+		_data = (Data *)_aligned_realloc(_data, byteSize, DATA_ALIGN);
+
+		if (oldAllocated)
+		{
+			// The values need to move out of the way of the new hashes
+			::memmove(Hashes() + newAllocated, Hashes() + oldAllocated, _data->size * sizeof(ValueHandle));
+		}
+
 		_data->allocated = newAllocated;
 		_data->size = oldAllocated ? _data->size : 0;
 		_data->atomizer = oldAllocated ? _data->atomizer : ProcessGlobals::Get()->GetStringCache();
@@ -201,11 +341,26 @@ void ff::SmallDict::Reserve(size_t newAllocated, bool allowEmptySpace)
 void ff::SmallDict::Clear()
 {
 	size_t size = Size();
+	ValueHandle *values = size ? Values() : nullptr;
+
 	for (size_t i = 0; i < size; i++)
 	{
-		_data->entries[i].value->Release();
+		values[i].~ValueHandle();
 	}
 
 	_aligned_free(_data);
 	_data = nullptr;
 }
+
+ff::hash_t *ff::SmallDict::Hashes() const
+{
+	static_assert(sizeof(Data) <= DATA_HEADER_SIZE, "The header would overlap the hashes");
+	return reinterpret_cast<hash_t *>(reinterpret_cast<BYTE *>(_data) + DATA_HEADER_SIZE);
+}
+
+ff::ValueHandle *ff::SmallDict::Values() const
+{
+	return reinterpret_cast<ValueHandle *>(Hashes() + _data->allocated);
+}
+
+static_assert(sizeof(ff::SmallDict) == sizeof(void *), "SmallDict should only be a pointer");
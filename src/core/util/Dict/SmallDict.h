@@ -1,12 +1,14 @@
 #pragma once
 
+#include "Dict/ValueHandle.h"
+
 namespace ff
 {
 	class StringCache;
-	class Value;
 
-	// Implements a key/value dictionary using a simple single array. It's faster
-	// than a hash table for "small" dictionaries.
+	// Implements a key/value dictionary using simple arrays. It's faster than a hash
+	// table for "small" dictionaries. Hashes are searched with SSE2 or AVX2 when the
+	// CPU has it (see SimdLevel in StringSearch.h).
 	class SmallDict
 	{
 	public:
@@ -22,32 +24,36 @@ namespace ff
 		UTIL_API String KeyAt(size_t index) const;
 		UTIL_API hash_t KeyHashAt(size_t index) const;
 		UTIL_API Value *ValueAt(size_t index) const;
+		UTIL_API const ValueHandle &HandleAt(size_t index) const;
 		UTIL_API Value *GetValue(ff::StringRef key) const;
 		UTIL_API size_t IndexOf(ff::StringRef key) const;
+		UTIL_API size_t IndexOfHash(hash_t hash) const;
 
 		UTIL_API void Add(ff::StringRef key, Value *value); // super fast, no dupe check
 		UTIL_API void Set(ff::StringRef key, Value *value);
 		UTIL_API void SetAt(size_t index, Value *value);
+		UTIL_API void Add(ff::StringRef key, ValueHandle &&value);
+		UTIL_API void Set(ff::StringRef key, ValueHandle &&value);
+		UTIL_API void SetAt(size_t index, ValueHandle &&value);
 		UTIL_API void Remove(ff::StringRef key);
 		UTIL_API void RemoveAt(size_t index);
 		UTIL_API void Reserve(size_t newAllocated, bool allowEmptySpace = true);
 		UTIL_API void Clear();
 
 	private:
-		struct Entry
-		{
-			hash_t hash;
-			Value *value;
-		};
-
+		// Followed by hash_t hashes[allocated] and then ValueHandle values[allocated], so that
+		// searching only touches the hashes. Values are moved around with realloc and memmove,
+		// which is fine for a ValueHandle.
 		struct Data
 		{
 			size_t allocated;
 			size_t size;
 			StringCache *atomizer;
-			Entry entries[1];
 		};
 
+		hash_t *Hashes() const;
+		ValueHandle *Values() const;
+
 		Data *_data;
 	};
 }
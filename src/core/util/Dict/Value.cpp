@@ -2,10 +2,10 @@
 #include "Data/Data.h"
 #include "Dict/Dict.h"
 #include "Dict/Value.h"
+#include "String/NumberConvert.h"
 #include "String/StringUtil.h"
+#include "Types/SlabAllocator.h"
 
-struct FakeVector { size_t fake[4]; };
-static ff::PoolAllocator<FakeVector> s_fakeVectorPool;
 static ff::PoolAllocator<ff::Value> s_valuePool;
 
 class ScopeStaticValueAlloc
@@ -21,10 +21,8 @@ private:
 template<typename T>
 static T *NewFakeVector()
 {
-	assert(sizeof(FakeVector) >= sizeof(T));
-
-	FakeVector *pFake = s_fakeVectorPool.New();
-	T *pVector = ::new((void*)pFake) T;
+	void *mem = ff::GetSlabAllocator().Alloc(sizeof(T));
+	T *pVector = ::new(mem) T;
 
 	return pVector;
 }
@@ -32,10 +30,8 @@ static T *NewFakeVector()
 template<typename T>
 static T *NewFakeVector(T &&value)
 {
-	assert(sizeof(FakeVector) >= sizeof(T));
-
-	FakeVector *pFake = s_fakeVectorPool.New();
-	T *pVector = ::new((void*)pFake) T(std::move(value));
+	void *mem = ff::GetSlabAllocator().Alloc(sizeof(T));
+	T *pVector = ::new(mem) T(std::move(value));
 
 	return pVector;
 }
@@ -46,9 +42,7 @@ static void DeleteFakeVector(T *pVector)
 	if (pVector)
 	{
 		pVector->~T();
-
-		FakeVector *pFake = (FakeVector*)pVector;
-		s_fakeVectorPool.Delete(pFake);
+		ff::GetSlabAllocator().Free(pVector);
 	}
 }
 
@@ -69,10 +63,7 @@ ff::Value::~Value()
 			break;
 
 		case Type::String:
-			if (_string.str)
-			{
-				InternalGetString().~String();
-			}
+			InternalGetString().~String();
 			break;
 
 		case Type::Dict:
@@ -855,8 +846,8 @@ ff::RectFloat &ff::Value::InternalGetRectF() const
 
 ff::String &ff::Value::InternalGetString() const
 {
-	assert(sizeof(_string.str) == sizeof(String));
-	return *(String*)&_string.str;
+	assert(sizeof(_string) >= sizeof(String));
+	return *(String*)&_string;
 }
 
 ff::Dict *ff::Value::SDict::AsDict() const
@@ -883,6 +874,36 @@ ff::Dict &ff::Value::AsDict() const
 	return *_dict.AsDict();
 }
 
+// Anything ParseDouble doesn't handle, like "inf" or leading spaces, still goes to wcstod
+static bool StringToDouble(ff::StringRef str, double &value)
+{
+	if (!str.empty() && ff::ParseDouble(str.c_str(), str.size(), value) == str.size())
+	{
+		return true;
+	}
+
+	const wchar_t *start = str.c_str();
+	wchar_t *end = nullptr;
+	value = wcstod(start, &end);
+
+	return end > start && !*end;
+}
+
+// Like "(1.5,2)"
+static ff::String FloatsToString(const float *floats, size_t count)
+{
+	wchar_t buf[ff::MAX_NUMBER_CHARS];
+	ff::String str(L"(");
+
+	for (size_t i = 0; i < count; i++)
+	{
+		str.append(buf, ff::FormatFloat(floats[i], buf));
+		str.append(1, (i + 1 < count) ? L',' : L')');
+	}
+
+	return str;
+}
+
 bool ff::Value::Convert(Type type, Value **ppValue)
 {
 	assertRetVal(ppValue, false);
@@ -944,8 +965,7 @@ bool ff::Value::Convert(Type type, Value **ppValue)
 			break;
 
 		case Type::String:
-			_snwprintf_s(buf, _countof(buf), _TRUNCATE, L"%g", AsDouble());
-			CreateString(String(buf), ppValue);
+			CreateString(String(buf, FormatDouble(AsDouble(), buf)), ppValue);
 			break;
 		}
 		break;
@@ -966,8 +986,7 @@ bool ff::Value::Convert(Type type, Value **ppValue)
 			break;
 
 		case Type::String:
-			_snwprintf_s(buf, _countof(buf), _TRUNCATE, L"%g", AsFloat());
-			CreateString(String(buf), ppValue);
+			CreateString(String(buf, FormatFloat(AsFloat(), buf)), ppValue);
 			break;
 		}
 		break;
@@ -1008,8 +1027,10 @@ bool ff::Value::Convert(Type type, Value **ppValue)
 		switch (type)
 		{
 		case Type::String:
-			_snwprintf_s(buf, _countof(buf), _TRUNCATE, L"(%g,%g)", AsPointF().x, AsPointF().y);
-			CreateString(String(buf), ppValue);
+			{
+				const float floats[] = { AsPointF().x, AsPointF().y };
+				CreateString(FloatsToString(floats, _countof(floats)), ppValue);
+			}
 			break;
 		}
 		break;
@@ -1029,9 +1050,10 @@ bool ff::Value::Convert(Type type, Value **ppValue)
 		switch (type)
 		{
 		case Type::String:
-			_snwprintf_s(buf, _countof(buf), _TRUNCATE, L"(%g,%g,%g,%g)",
-				AsRectF().left, AsRectF().top, AsRectF().right, AsRectF().bottom);
-			CreateString(String(buf), ppValue);
+			{
+				const float floats[] = { AsRectF().left, AsRectF().top, AsRectF().right, AsRectF().bottom };
+				CreateString(FloatsToString(floats, _countof(floats)), ppValue);
+			}
 			break;
 		}
 		break;
@@ -1057,11 +1079,8 @@ bool ff::Value::Convert(Type type, Value **ppValue)
 
 		case Type::Double:
 			{
-				const wchar_t *start = AsString().c_str();
-				wchar_t *end = nullptr;
-				double val = wcstod(start, &end);
-
-				if (end > start && !*end)
+				double val;
+				if (StringToDouble(AsString(), val))
 				{
 					CreateDouble(val, ppValue);
 				}
@@ -1069,11 +1088,8 @@ bool ff::Value::Convert(Type type, Value **ppValue)
 
 		case Type::Float:
 			{
-				const wchar_t *start = AsString().c_str();
-				wchar_t *end = nullptr;
-				double val = wcstod(start, &end);
-
-				if (end > start && !*end)
+				double val;
+				if (StringToDouble(AsString(), val))
 				{
 					CreateFloat((float)val, ppValue);
 				}
@@ -124,7 +124,7 @@ namespace ff
 		struct SRect { int rect[4]; };
 		struct SPointF { float pt[2]; };
 		struct SRectF { float rect[4]; };
-		struct SString { void *str; };
+		struct SString { void *data[4]; };
 		struct SDict { size_t data[4]; ff::Dict *AsDict() const; };
 		struct StaticValue { size_t data[6]; Value *AsValue(); };
 
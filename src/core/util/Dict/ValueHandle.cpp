@@ -0,0 +1,253 @@
+#include "pch.h"
+#include "Dict/ValueHandle.h"
+
+static const UINT_PTR INLINE_BIT = 1;
+
+static bool IsInlineBits(void *value)
+{
+	return (reinterpret_cast<UINT_PTR>(value) & INLINE_BIT) != 0;
+}
+
+static ff::Value::Type GetInlineType(void *value)
+{
+	return static_cast<ff::Value::Type>(reinterpret_cast<UINT_PTR>(value) >> 1);
+}
+
+ff::ValueHandle::ValueHandle()
+	: _value(nullptr)
+	, _bits(0)
+{
+}
+
+ff::ValueHandle::ValueHandle(Value *value)
+	: _value(value)
+	, _bits(0)
+{
+	if (value)
+	{
+		value->AddRef();
+	}
+}
+
+ff::ValueHandle::ValueHandle(bool value)
+	: _bits(0)
+{
+	SetInline(Value::Type::Bool);
+	_bool = value;
+}
+
+ff::ValueHandle::ValueHandle(int value)
+	: _bits(0)
+{
+	SetInline(Value::Type::Int);
+	_int = value;
+}
+
+ff::ValueHandle::ValueHandle(float value)
+	: _bits(0)
+{
+	SetInline(Value::Type::Float);
+	_float = value;
+}
+
+ff::ValueHandle::ValueHandle(double value)
+	: _double(value)
+{
+	SetInline(Value::Type::Double);
+}
+
+ff::ValueHandle::ValueHandle(const PointInt &value)
+{
+	SetInline(Value::Type::Point);
+	_point[0] = value.x;
+	_point[1] = value.y;
+}
+
+ff::ValueHandle::ValueHandle(const PointFloat &value)
+{
+	SetInline(Value::Type::PointF);
+	_pointF[0] = value.x;
+	_pointF[1] = value.y;
+}
+
+ff::ValueHandle::ValueHandle(const ValueHandle &rhs)
+	: _value(nullptr)
+	, _bits(0)
+{
+	*this = rhs;
+}
+
+ff::ValueHandle::ValueHandle(ValueHandle &&rhs)
+	: _value(rhs._value)
+	, _bits(rhs._bits)
+{
+	rhs._value = nullptr;
+}
+
+ff::ValueHandle::~ValueHandle()
+{
+	Reset();
+}
+
+ff::ValueHandle ff::ValueHandle::Null()
+{
+	ValueHandle handle;
+	handle.SetInline(Value::Type::Null);
+	return handle;
+}
+
+const ff::ValueHandle &ff::ValueHandle::operator=(const ValueHandle &rhs)
+{
+	if (this != &rhs)
+	{
+		// Read once, another thread could be creating a Value for it
+		void *value = rhs._value;
+
+		if (value && !IsInlineBits(value))
+		{
+			static_cast<Value *>(value)->AddRef();
+		}
+
+		Reset();
+		_value = value;
+		_bits = rhs._bits;
+	}
+
+	return *this;
+}
+
+const ff::ValueHandle &ff::ValueHandle::operator=(ValueHandle &&rhs)
+{
+	if (this != &rhs)
+	{
+		Reset();
+		_value = rhs._value;
+		_bits = rhs._bits;
+		rhs._value = nullptr;
+	}
+
+	return *this;
+}
+
+bool ff::ValueHandle::IsValid() const
+{
+	return _value != nullptr;
+}
+
+bool ff::ValueHandle::IsInline() const
+{
+	return IsInlineBits(_value);
+}
+
+ff::Value::Type ff::ValueHandle::GetType() const
+{
+	void *value = _value;
+	assertRetVal(value, Value::Type::Null);
+
+	return IsInlineBits(value)
+		? GetInlineType(value)
+		: static_cast<Value *>(value)->GetType();
+}
+
+bool ff::ValueHandle::IsType(Value::Type type) const
+{
+	return _value && GetType() == type;
+}
+
+ff::Value *ff::ValueHandle::GetValue() const
+{
+	void *value = _value;
+
+	if (IsInlineBits(value))
+	{
+		ValuePtr newValue;
+		assertRetVal(CreateValue(GetInlineType(value), &newValue), nullptr);
+
+		void *oldValue = ::InterlockedCompareExchangePointer(&_value, newValue.Interface(), value);
+		if (oldValue == value)
+		{
+			return newValue.Detach();
+		}
+
+		// Another thread got there first, so use its Value and let this one go
+		value = oldValue;
+	}
+
+	return static_cast<Value *>(value);
+}
+
+bool ff::ValueHandle::AsBool() const
+{
+	return IsInline() ? _bool : static_cast<Value *>(_value)->AsBool();
+}
+
+int ff::ValueHandle::AsInt() const
+{
+	return IsInline() ? _int : static_cast<Value *>(_value)->AsInt();
+}
+
+float ff::ValueHandle::AsFloat() const
+{
+	return IsInline() ? _float : static_cast<Value *>(_value)->AsFloat();
+}
+
+double ff::ValueHandle::AsDouble() const
+{
+	return IsInline() ? _double : static_cast<Value *>(_value)->AsDouble();
+}
+
+ff::PointInt ff::ValueHandle::AsPoint() const
+{
+	return IsInline() ? PointInt(_point[0], _point[1]) : static_cast<Value *>(_value)->AsPoint();
+}
+
+ff::PointFloat ff::ValueHandle::AsPointF() const
+{
+	return IsInline() ? PointFloat(_pointF[0], _pointF[1]) : static_cast<Value *>(_value)->AsPointF();
+}
+
+void ff::ValueHandle::SetInline(Value::Type type)
+{
+	_value = reinterpret_cast<void *>((static_cast<UINT_PTR>(type) << 1) | INLINE_BIT);
+}
+
+bool ff::ValueHandle::CreateValue(Value::Type type, Value **value) const
+{
+	switch (type)
+	{
+	case Value::Type::Null:
+		return Value::CreateNull(value);
+
+	case Value::Type::Bool:
+		return Value::CreateBool(_bool, value);
+
+	case Value::Type::Int:
+		return Value::CreateInt(_int, value);
+
+	case Value::Type::Float:
+		return Value::CreateFloat(_float, value);
+
+	case Value::Type::Double:
+		return Value::CreateDouble(_double, value);
+
+	case Value::Type::Point:
+		return Value::CreatePoint(PointInt(_point[0], _point[1]), value);
+
+	case Value::Type::PointF:
+		return Value::CreatePointF(PointFloat(_pointF[0], _pointF[1]), value);
+
+	default:
+		assertSz(false, L"Not an inline value type");
+		return false;
+	}
+}
+
+void ff::ValueHandle::Reset()
+{
+	if (_value && !IsInlineBits(_value))
+	{
+		static_cast<Value *>(_value)->Release();
+	}
+
+	_value = nullptr;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "Dict/Value.h"
+
+namespace ff
+{
+	// How a Dict holds on to its values. Scalars (null, bool, int, float, double, point, pointF)
+	// are stored inline, so setting or getting them doesn't allocate or touch a ref count.
+	// Everything else is a ref-counted Value, same as before.
+	//
+	// A real Value for an inline scalar is only created when someone asks for one with GetValue,
+	// then the handle keeps it alive so that it can be returned without a reference, just like
+	// any other value in a Dict.
+	class ValueHandle
+	{
+	public:
+		UTIL_API ValueHandle();
+		UTIL_API explicit ValueHandle(Value *value);
+		UTIL_API explicit ValueHandle(bool value);
+		UTIL_API explicit ValueHandle(int value);
+		UTIL_API explicit ValueHandle(float value);
+		UTIL_API explicit ValueHandle(double value);
+		UTIL_API explicit ValueHandle(const PointInt &value);
+		UTIL_API explicit ValueHandle(const PointFloat &value);
+		UTIL_API ValueHandle(const ValueHandle &rhs);
+		UTIL_API ValueHandle(ValueHandle &&rhs);
+		UTIL_API ~ValueHandle();
+
+		UTIL_API static ValueHandle Null();
+
+		UTIL_API const ValueHandle &operator=(const ValueHandle &rhs);
+		UTIL_API const ValueHandle &operator=(ValueHandle &&rhs);
+
+		UTIL_API bool IsValid() const;
+		UTIL_API bool IsInline() const;
+		UTIL_API Value::Type GetType() const;
+		UTIL_API bool IsType(Value::Type type) const;
+
+		// Creates a Value the first time for inline scalars, the handle owns it
+		UTIL_API Value *GetValue() const;
+
+		// Only for the matching type, these don't create a Value.
+		// Inline data never changes, so it's still good after a Value was created for it.
+		UTIL_API bool AsBool() const;
+		UTIL_API int AsInt() const;
+		UTIL_API float AsFloat() const;
+		UTIL_API double AsDouble() const;
+		UTIL_API PointInt AsPoint() const;
+		UTIL_API PointFloat AsPointF() const;
+
+	private:
+		void SetInline(Value::Type type);
+		bool CreateValue(Value::Type type, Value **value) const;
+		void Reset();
+
+		// Null when empty, a Value that this owns a reference to, or for inline scalars,
+		// the type shifted up with the low bit set (values are never at an odd address).
+		// It only changes from inline to a Value (with an interlocked exchange) while const,
+		// so it can be read by many threads, just like the rest of a const Dict.
+		mutable void * volatile _value;
+
+		union
+		{
+			bool _bool;
+			int _int;
+			float _float;
+			double _double;
+			int _point[2];
+			float _pointF[2];
+			uint64_t _bits;
+		};
+	};
+}
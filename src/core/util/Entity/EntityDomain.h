@@ -151,7 +151,7 @@ namespace ff
 			String _name;
 			uint64_t _componentBits;
 			ComponentFactoryEntries _components;
-			Map<Entity, EntityEntryBase *> _entities;
+			IndexMap<Entity, EntityEntryBase *> _entities;
 			bool _valid;
 		};
 
@@ -58,7 +58,7 @@ namespace ff
 
 			Vector<std::unique_ptr<ComponentBucket>, 8> _components;
 			Vector<size_t> _freeComponents;
-			Map<Entity, size_t> _usedComponents;
+			FlatHashMap<Entity, size_t> _usedComponents;
 		};
 	}
 }
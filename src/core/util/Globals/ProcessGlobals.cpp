@@ -133,6 +133,11 @@ ff::StringManager &ff::ProcessGlobals::GetStringManager()
 	return _stringManager;
 }
 
+ff::SlabAllocator &ff::ProcessGlobals::GetSlabAllocator()
+{
+	return ff::GetSlabAllocator();
+}
+
 ff::StringCache *ff::ProcessGlobals::GetStringCache()
 {
 	return &_stringCache;
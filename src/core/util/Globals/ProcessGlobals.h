@@ -5,6 +5,7 @@
 #include "Module/Modules.h"
 #include "String/StringCache.h"
 #include "String/StringManager.h"
+#include "Types/SlabAllocator.h"
 
 namespace ff
 {
@@ -31,6 +32,7 @@ namespace ff
 		UTIL_API Log &GetLog();
 		UTIL_API Modules &GetModules();
 		UTIL_API StringManager &GetStringManager();
+		UTIL_API SlabAllocator &GetSlabAllocator();
 		UTIL_API StringCache *GetStringCache();
 
 		UTIL_API IAsyncDataLoader *GetAsyncDataLoader();
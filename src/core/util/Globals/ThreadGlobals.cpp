@@ -10,12 +10,16 @@ ff::ThreadGlobals::ThreadGlobals()
 {
 	assert(s_threadGlobals == nullptr);
 	s_threadGlobals = this;
+
+	BeginBiasedRefThread();
 }
 
 ff::ThreadGlobals::~ThreadGlobals()
 {
 	assert(s_threadGlobals == this && IsShuttingDown());
 	s_threadGlobals = nullptr;
+
+	EndBiasedRefThread();
 }
 
 ff::ThreadGlobals *ff::ThreadGlobals::Get()
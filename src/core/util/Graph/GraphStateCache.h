@@ -28,9 +28,9 @@ namespace ff
 	private:
 		IGraphDevice *_device;
 
-		Map<D3D11_BLEND_DESC, ComPtr<ID3D11BlendState>> _blendStates;
-		Map<D3D11_DEPTH_STENCIL_DESC, ComPtr<ID3D11DepthStencilState>> _depthStates;
-		Map<D3D11_RASTERIZER_DESC, ComPtr<ID3D11RasterizerState>> _rasterStates;
-		Map<D3D11_SAMPLER_DESC, ComPtr<ID3D11SamplerState>> _samplerStates;
+		FlatMap<D3D11_BLEND_DESC, ComPtr<ID3D11BlendState>> _blendStates;
+		FlatMap<D3D11_DEPTH_STENCIL_DESC, ComPtr<ID3D11DepthStencilState>> _depthStates;
+		FlatMap<D3D11_RASTERIZER_DESC, ComPtr<ID3D11RasterizerState>> _rasterStates;
+		FlatMap<D3D11_SAMPLER_DESC, ComPtr<ID3D11SamplerState>> _samplerStates;
 	};
 }
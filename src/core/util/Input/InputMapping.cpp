@@ -76,8 +76,8 @@ namespace ff
 		Vector<InputValueMapping> _valueMappings;
 		Vector<InputEvent> _currentEvents;
 
-		Map<Atom, size_t> _eventToInfo;
-		Map<Atom, size_t> _valueToInfo;
+		FlatMap<Atom, size_t> _eventToInfo;
+		FlatMap<Atom, size_t> _valueToInfo;
 
 		typedef Vector<ComPtr<IInputEventListener>> ListenerVector;
 		typedef SharedObject<ListenerVector> SharedListenerVector;
@@ -170,7 +170,7 @@ const ff::ModuleClassInfo *ff::Module::GetClassInfo(StringRef name) const
 	BucketIter iter = _classesByName.Get(name);
 	if (iter != INVALID_ITER)
 	{
-		return &_classesByName.ValueAt(iter);
+		return _classesByName.ValueAt(iter);
 	}
 
 	return nullptr;
@@ -183,7 +183,7 @@ const ff::ModuleClassInfo *ff::Module::GetClassInfo(REFGUID classId) const
 	BucketIter iter = _classesById.Get(classId);
 	if (iter != INVALID_ITER)
 	{
-		return &_classesById.ValueAt(iter);
+		return _classesById.ValueAt(iter);
 	}
 
 	return nullptr;
@@ -196,7 +196,7 @@ const ff::ModuleClassInfo *ff::Module::GetClassInfoForInterface(REFGUID mainInte
 	BucketIter iter = _classesByIid.Get(mainInterfaceId);
 	if (iter != INVALID_ITER)
 	{
-		return &_classesByIid.ValueAt(iter);
+		return _classesByIid.ValueAt(iter);
 	}
 
 	return nullptr;
@@ -207,7 +207,7 @@ const ff::ModuleInterfaceInfo *ff::Module::GetInterfaceInfo(REFGUID interfaceId)
 	BucketIter iter = _interfacesById.Get(interfaceId);
 	if (iter != INVALID_ITER)
 	{
-		return &_interfacesById.ValueAt(iter);
+		return _interfacesById.ValueAt(iter);
 	}
 
 	return nullptr;
@@ -220,7 +220,7 @@ const ff::ModuleCategoryInfo *ff::Module::GetCategoryInfo(StringRef name) const
 	BucketIter iter = _categoriesByName.Get(name);
 	if (iter != INVALID_ITER)
 	{
-		return &_categoriesByName.ValueAt(iter);
+		return _categoriesByName.ValueAt(iter);
 	}
 
 	return nullptr;
@@ -233,7 +233,7 @@ const ff::ModuleCategoryInfo *ff::Module::GetCategoryInfo(REFGUID categoryId) co
 	BucketIter iter = _categoriesById.Get(categoryId);
 	if (iter != INVALID_ITER)
 	{
-		return &_categoriesById.ValueAt(iter);
+		return _categoriesById.ValueAt(iter);
 	}
 
 	return nullptr;
@@ -246,7 +246,7 @@ const ff::ModuleCreatorInfo *ff::Module::GetCreatorInfo(StringRef name) const
 	BucketIter iter = _creatorsByName.Get(name);
 	if (iter != INVALID_ITER)
 	{
-		return &_creatorsByName.ValueAt(iter);
+		return _creatorsByName.ValueAt(iter);
 	}
 
 	return nullptr;
@@ -259,7 +259,7 @@ const ff::ModuleCreatorInfo *ff::Module::GetCreatorInfo(REFGUID creatorId) const
 	BucketIter iter = _creatorsById.Get(creatorId);
 	if (iter != INVALID_ITER)
 	{
-		return &_creatorsById.ValueAt(iter);
+		return _creatorsById.ValueAt(iter);
 	}
 
 	return nullptr;
@@ -357,7 +357,7 @@ void ff::Module::RegisterClass(
 {
 	assertRet(name.size() && classId != GUID_NULL);
 
-	ModuleClassInfo info;
+	ModuleClassInfo &info = _classes.Insert();
 	info._name = name;
 	info._classId = classId;
 	info._mainInterfaceId = mainInterfaceId;
@@ -365,17 +365,17 @@ void ff::Module::RegisterClass(
 	info._factory = factory;
 	info._module = this;
 
-	_classesByName.Insert(name, info);
-	_classesById.Insert(classId, info);
+	_classesByName.Insert(name, &info);
+	_classesById.Insert(classId, &info);
 
 	if (mainInterfaceId != GUID_NULL)
 	{
-		_classesByIid.Insert(mainInterfaceId, info);
+		_classesByIid.Insert(mainInterfaceId, &info);
 	}
 
 	if (categoryId != GUID_NULL)
 	{
-		_classesByCatId.Insert(categoryId, info);
+		_classesByCatId.Insert(categoryId, &info);
 	}
 }
 
@@ -385,15 +385,16 @@ void ff::Module::RegisterInterface(
 {
 	assertRet(interfaceId != GUID_NULL);
 
-	ModuleInterfaceInfo info;
+	ModuleInterfaceInfo &info = _interfaces.Insert();
 	info._interfaceId = interfaceId;
 	info._categoryId = categoryId;
+	info._module = this;
 
-	_interfacesById.Insert(interfaceId, info);
+	_interfacesById.Insert(interfaceId, &info);
 
 	if (categoryId != GUID_NULL)
 	{
-		_interfacesByCatId.Insert(categoryId, info);
+		_interfacesByCatId.Insert(categoryId, &info);
 	}
 }
 
@@ -404,14 +405,14 @@ void ff::Module::RegisterCategory(
 {
 	assertRet(name.size() && categoryId != GUID_NULL);
 
-	ModuleCategoryInfo info;
+	ModuleCategoryInfo &info = _categories.Insert();
 	info._name = name;
 	info._categoryId = categoryId;
 	info._parentObjectFactory = parentObjectFactory;
 	info._module = this;
 
-	_categoriesByName.Insert(name, info);
-	_categoriesById.Insert(categoryId, info);
+	_categoriesByName.Insert(name, &info);
+	_categoriesById.Insert(categoryId, &info);
 }
 
 void ff::Module::RegisterCreator(
@@ -421,12 +422,12 @@ void ff::Module::RegisterCreator(
 {
 	assertRet(name.size() && creatorId != GUID_NULL && classId != GUID_NULL);
 
-	ModuleCreatorInfo info;
+	ModuleCreatorInfo &info = _creators.Insert();
 	info._name = name;
 	info._creatorClassId = creatorId;
 	info._classId = classId;
 	info._module = this;
 
-	_creatorsByName.Insert(name, info);
-	_creatorsById.Insert(creatorId, info);
+	_creatorsByName.Insert(name, &info);
+	_creatorsById.Insert(creatorId, &info);
 }
@@ -129,16 +129,22 @@ namespace ff
 		HINSTANCE _instance;
 		Vector<ComPtr<ITypeLib>> _typeLibs;
 
-		Map<String, ModuleClassInfo> _classesByName;
-		Map<GUID, ModuleClassInfo> _classesById;
-		Map<GUID, ModuleClassInfo> _classesByIid;
-		Map<GUID, ModuleClassInfo> _classesByCatId;
-		Map<GUID, ModuleInterfaceInfo> _interfacesById;
-		Map<GUID, ModuleInterfaceInfo> _interfacesByCatId;
-		Map<String, ModuleCategoryInfo> _categoriesByName;
-		Map<GUID, ModuleCategoryInfo> _categoriesById;
-		Map<String, ModuleCreatorInfo> _creatorsByName;
-		Map<GUID, ModuleCreatorInfo> _creatorsById;
+		// Actual storage, so that info pointers stay valid while more types are registered
+		List<ModuleClassInfo> _classes;
+		List<ModuleInterfaceInfo> _interfaces;
+		List<ModuleCategoryInfo> _categories;
+		List<ModuleCreatorInfo> _creators;
+
+		Map<String, const ModuleClassInfo *> _classesByName;
+		FlatMap<GUID, const ModuleClassInfo *> _classesById;
+		FlatMap<GUID, const ModuleClassInfo *> _classesByIid;
+		FlatMap<GUID, const ModuleClassInfo *> _classesByCatId;
+		FlatMap<GUID, const ModuleInterfaceInfo *> _interfacesById;
+		FlatMap<GUID, const ModuleInterfaceInfo *> _interfacesByCatId;
+		Map<String, const ModuleCategoryInfo *> _categoriesByName;
+		FlatMap<GUID, const ModuleCategoryInfo *> _categoriesById;
+		Map<String, const ModuleCreatorInfo *> _creatorsByName;
+		FlatMap<GUID, const ModuleCreatorInfo *> _creatorsById;
 	};
 
 	const Module &GetThisModule();
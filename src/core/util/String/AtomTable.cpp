@@ -0,0 +1,245 @@
+#include "pch.h"
+#include "Data/DataPersist.h"
+#include "Data/DataWriterReader.h"
+#include "String/AtomTable.h"
+
+static const size_t ATOM_BLOCK_SIZE = 16 * 1024;
+static const size_t ATOM_ALIGN = __alignof(ff::details::AtomEntry);
+static const DWORD ATOM_FILE_MAGIC = 'MOTA';
+static const DWORD ATOM_FILE_VERSION = 1;
+
+typedef ff::SharedStringVectorAllocator::SharedStringVector SharedStringVector;
+static const size_t ATOM_STRING_SIZE = (sizeof(SharedStringVector) + ATOM_ALIGN - 1) & ~(ATOM_ALIGN - 1);
+static_assert(__alignof(SharedStringVector) <= ATOM_ALIGN, "The shared string in front of an entry must be aligned");
+
+struct AtomFileHeader
+{
+	DWORD magic;
+	DWORD version;
+	uint64_t count;
+	uint64_t bytes; // all of the entries that follow, each one aligned to ATOM_ALIGN
+};
+
+static size_t GetEntrySize(size_t len)
+{
+	size_t size = offsetof(ff::details::AtomEntry, chars) + (len + 1) * sizeof(wchar_t);
+	return (size + ATOM_ALIGN - 1) & ~(ATOM_ALIGN - 1);
+}
+
+static SharedStringVector *GetEntryString(const ff::details::AtomEntry *entry)
+{
+	return reinterpret_cast<SharedStringVector *>(reinterpret_cast<BYTE *>(const_cast<ff::details::AtomEntry *>(entry)) - ATOM_STRING_SIZE);
+}
+
+ff::String ff::StringAtom::ToString() const
+{
+	String str;
+
+	if (size() < String::SMALL_SIZE)
+	{
+		str.assign(c_str(), size());
+	}
+	else
+	{
+		// The shared string never counts references or gets freed, it belongs to the table
+		str.set_long(GetEntryString(_entry));
+	}
+
+	return str;
+}
+
+ff::AtomTable::AtomTable(bool threadSafe)
+	: _atoms(threadSafe)
+	, _cur(nullptr)
+	, _end(nullptr)
+	, _blockLock(threadSafe)
+{
+}
+
+ff::AtomTable::~AtomTable()
+{
+	for (BYTE *block: _blocks)
+	{
+		_aligned_free(block);
+	}
+}
+
+ff::StringAtom ff::AtomTable::Intern(StringRef str)
+{
+	return Intern(str.c_str(), str.size(), HashFunc(str));
+}
+
+ff::StringAtom ff::AtomTable::Intern(const wchar_t *str, size_t len, hash_t hash)
+{
+	StringAtom atom = Find(hash);
+	if (!atom.IsNull())
+	{
+		return atom;
+	}
+
+	details::AtomEntry *entry = InitEntry(Alloc(GetAllocSize(len)), len);
+	entry->hash = hash;
+	entry->size = static_cast<DWORD>(len);
+	std::memcpy(entry->chars, str, len * sizeof(wchar_t));
+	entry->chars[len] = 0;
+
+	// If another thread added the same string first, this copy is wasted but harmless
+	return _atoms.TryAddWithHash(hash, hash, entry) ? StringAtom(entry) : Find(hash);
+}
+
+ff::StringAtom ff::AtomTable::Find(hash_t hash) const
+{
+	const details::AtomEntry *entry;
+	return _atoms.GetWithHash(hash, hash, entry) ? StringAtom(entry) : StringAtom();
+}
+
+size_t ff::AtomTable::Size() const
+{
+	return _atoms.Size();
+}
+
+void ff::AtomTable::Clear()
+{
+	_atoms.Clear();
+}
+
+bool ff::AtomTable::Save(IDataWriter *writer) const
+{
+	Vector<const details::AtomEntry *> entries;
+	entries.Reserve(_atoms.Size());
+
+	_atoms.ForEach([&entries](hash_t hash, const details::AtomEntry *entry)
+	{
+		entries.Push(entry);
+	});
+
+	AtomFileHeader header;
+	header.magic = ATOM_FILE_MAGIC;
+	header.version = ATOM_FILE_VERSION;
+	header.count = entries.Size();
+	header.bytes = 0;
+
+	for (const details::AtomEntry *entry: entries)
+	{
+		header.bytes += GetEntrySize(entry->size);
+	}
+
+	assertRetVal(SaveData(writer, header), false);
+
+	// The padding at the end of each entry is never written to in memory, so zeros get saved instead
+	const BYTE padding[ATOM_ALIGN] = { 0 };
+
+	for (const details::AtomEntry *entry: entries)
+	{
+		size_t usedSize = offsetof(details::AtomEntry, chars) + (entry->size + 1) * sizeof(wchar_t);
+		size_t entrySize = GetEntrySize(entry->size);
+
+		assertRetVal(writer->Write(entry, usedSize), false);
+		assertRetVal(usedSize == entrySize || writer->Write(padding, entrySize - usedSize), false);
+	}
+
+	return true;
+}
+
+bool ff::AtomTable::Load(IDataReader *reader)
+{
+	AtomFileHeader header;
+	assertRetVal(LoadData(reader, header), false);
+	// A preload file from an older build isn't a bug, it just gets ignored
+	noAssertRetVal(header.magic == ATOM_FILE_MAGIC && header.version == ATOM_FILE_VERSION, false);
+	assertRetVal(header.bytes % ATOM_ALIGN == 0 && header.bytes <= reader->GetSize() - reader->GetPos(), false);
+
+	size_t bytes = static_cast<size_t>(header.bytes);
+	noAssertRetVal(bytes, true);
+
+	const BYTE *fileData = LoadBytes(reader, bytes);
+	assertRetVal(fileData, false);
+
+	// Check every entry before anything is added, and find out how much memory they all need
+	size_t allocSize = 0;
+	size_t count = 0;
+
+	for (size_t pos = 0; pos < bytes; count++)
+	{
+		const details::AtomEntry *entry = reinterpret_cast<const details::AtomEntry *>(fileData + pos);
+		assertRetVal(count < header.count && bytes - pos >= GetEntrySize(0), false);
+
+		size_t entrySize = GetEntrySize(entry->size);
+		assertRetVal(entrySize <= bytes - pos && !entry->chars[entry->size], false);
+
+		allocSize += GetAllocSize(entry->size);
+		pos += entrySize;
+	}
+
+	assertRetVal(count == header.count, false);
+
+	// All of the strings are copied into memory at once, and then only the lookup gets filled in
+	BYTE *data = Alloc(allocSize);
+
+	for (size_t pos = 0; pos < bytes; )
+	{
+		const details::AtomEntry *fileEntry = reinterpret_cast<const details::AtomEntry *>(fileData + pos);
+		size_t entrySize = GetEntrySize(fileEntry->size);
+
+		details::AtomEntry *entry = InitEntry(data, fileEntry->size);
+		std::memcpy(entry, fileEntry, entrySize);
+
+		// The saved hash isn't trusted, the file could be from a build that hashed strings differently
+		entry->hash = HashBytes(entry->chars, entry->size * sizeof(wchar_t));
+		_atoms.TryAddWithHash(entry->hash, entry->hash, entry);
+
+		data += GetAllocSize(entry->size);
+		pos += entrySize;
+	}
+
+	return true;
+}
+
+size_t ff::AtomTable::GetAllocSize(size_t len)
+{
+	return GetEntrySize(len) + (len < String::SMALL_SIZE ? 0 : ATOM_STRING_SIZE);
+}
+
+ff::details::AtomEntry *ff::AtomTable::InitEntry(BYTE *data, size_t len)
+{
+	if (len < String::SMALL_SIZE)
+	{
+		return reinterpret_cast<details::AtomEntry *>(data);
+	}
+
+	// Long strings get a shared string in front of them, so StringAtom::ToString never allocates.
+	// Like StaticString, it points at chars that it doesn't own and it never gets destroyed.
+	details::AtomEntry *entry = reinterpret_cast<details::AtomEntry *>(data + ATOM_STRING_SIZE);
+	SharedStringVector *str = ::new(data) SharedStringVector();
+	str->DisableRefs();
+	str->SetStaticData(entry->chars, len + 1);
+
+	return entry;
+}
+
+BYTE *ff::AtomTable::Alloc(size_t bytes)
+{
+	LockMutex lock(_blockLock);
+
+	if (bytes > static_cast<size_t>(_end - _cur))
+	{
+		ScopeStaticMemAlloc staticAlloc;
+
+		size_t blockSize = std::max(bytes, ATOM_BLOCK_SIZE);
+		BYTE *block = reinterpret_cast<BYTE *>(_aligned_malloc(blockSize, ATOM_ALIGN));
+		_blocks.Push(block);
+
+		// A big block is only used once, the current block still has room for small strings
+		if (blockSize > ATOM_BLOCK_SIZE)
+		{
+			return block;
+		}
+
+		_cur = block;
+		_end = block + blockSize;
+	}
+
+	BYTE *data = _cur;
+	_cur += bytes;
+	return data;
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "Types/ConcurrentMap.h"
+
+namespace ff
+{
+	class IDataReader;
+	class IDataWriter;
+
+	namespace details
+	{
+		// Saved files use this same layout, so loading one doesn't touch each string
+		struct AtomEntry
+		{
+			hash_t hash;
+			DWORD size;
+			wchar_t chars[1]; // null terminated
+		};
+	}
+
+	/// Handle to a string that was interned in an AtomTable.
+	///
+	/// It's only a pointer, so copying it, comparing it, and getting its chars never locks
+	/// anything or touches a reference count. Two atoms from the same table are equal only
+	/// if they point to the same string. ToString() doesn't allocate either: long strings
+	/// share a buffer that the table keeps in front of the chars, so those Strings must not
+	/// outlive the table. Copy the chars into a new String to keep one longer.
+	class StringAtom
+	{
+	public:
+		StringAtom() : _entry(nullptr) { }
+		explicit StringAtom(const details::AtomEntry *entry) : _entry(entry) { }
+
+		bool operator==(const StringAtom &rhs) const { return _entry == rhs._entry; }
+		bool operator!=(const StringAtom &rhs) const { return _entry != rhs._entry; }
+		operator const wchar_t *() const { return c_str(); }
+
+		const wchar_t *c_str() const { return _entry ? _entry->chars : L""; }
+		size_t size() const { return _entry ? _entry->size : 0; }
+		bool empty() const { return !size(); }
+		bool IsNull() const { return !_entry; }
+		hash_t GetHash() const { return _entry ? _entry->hash : 0; }
+		UTIL_API String ToString() const; // the String is only valid while the table is alive
+
+	private:
+		const details::AtomEntry *_entry;
+	};
+
+	template<>
+	inline hash_t HashFunc<StringAtom>(const StringAtom &val)
+	{
+		return val.GetHash();
+	}
+
+	/// Stores each interned string once, in big blocks that are never moved or freed until
+	/// the table is destroyed. That's what keeps StringAtom pointers valid.
+	///
+	/// Strings are looked up by hash, just like StringCache. A table can be saved to a file
+	/// and loaded at startup, which is one read and no allocations per string. Hashes are
+	/// computed again when loading, so an old file can't put strings under the wrong hash.
+	class AtomTable
+	{
+	public:
+		UTIL_API AtomTable(bool threadSafe = true);
+		UTIL_API ~AtomTable();
+
+		UTIL_API StringAtom Intern(StringRef str);
+		UTIL_API StringAtom Intern(const wchar_t *str, size_t len, hash_t hash);
+		UTIL_API StringAtom Find(hash_t hash) const; // returns a null atom if it was never interned
+		UTIL_API size_t Size() const;
+		UTIL_API void Clear(); // forgets all strings, but atoms stay valid until the table is destroyed
+
+		UTIL_API bool Save(IDataWriter *writer) const;
+		UTIL_API bool Load(IDataReader *reader); // adds to the strings that are already there
+
+		template<typename Func> void ForEach(Func func) const; // func(StringAtom)
+
+	private:
+		AtomTable(const AtomTable &rhs) = delete;
+		AtomTable &operator=(const AtomTable &rhs) = delete;
+
+		static size_t GetAllocSize(size_t len);
+		static details::AtomEntry *InitEntry(BYTE *data, size_t len);
+		BYTE *Alloc(size_t bytes);
+
+		ConcurrentMap<hash_t, const details::AtomEntry *, NonHasher<hash_t>> _atoms;
+		Vector<BYTE *> _blocks;
+		BYTE *_cur;
+		BYTE *_end;
+		Mutex _blockLock;
+	};
+}
+
+template<typename Func>
+void ff::AtomTable::ForEach(Func func) const
+{
+	_atoms.ForEach([&func](hash_t hash, const details::AtomEntry *entry)
+	{
+		func(StringAtom(entry));
+	});
+}
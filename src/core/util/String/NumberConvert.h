@@ -0,0 +1,24 @@
+#pragma once
+
+namespace ff
+{
+	/// Converts between doubles and decimal text without going through the CRT.
+	///
+	/// ParseDouble is exact (it rounds like strtod). Most numbers are done with the Eisel-Lemire
+	/// algorithm and a table of 128-bit powers of ten. The rare ones it can't decide, like halfway
+	/// cases with over 19 digits, subnormals, and overflow, fall back to strtod.
+	///
+	/// FormatDouble and FormatFloat write the shortest digits that parse back to the same value
+	/// (Ryu). They switch to an exponent like %g does, but only when the exponent is under -4
+	/// or over 16, so "0.1", "123456789.5", "1e-08", and "-9.876e+55" are all possible outputs.
+	static const size_t MAX_NUMBER_CHARS = 32;
+
+	// Text is [+-]digits[.digits][(e|E)[+-]digits], returns how many chars that took, or zero if it's not a number.
+	// There can be other chars after the number, like strtod.
+	UTIL_API size_t ParseDouble(const wchar_t *text, size_t count, double &value);
+	UTIL_API size_t ParseDouble(const char *text, size_t count, double &value);
+
+	// Output needs room for MAX_NUMBER_CHARS, and doesn't get a null char. Returns how many chars were written.
+	UTIL_API size_t FormatDouble(double value, wchar_t *output);
+	UTIL_API size_t FormatFloat(float value, wchar_t *output);
+}
@@ -1,25 +1,7 @@
 #include "pch.h"
+#include "String/StringSearch.h"
 #include "String/StringUtil.h"
 
-namespace ff
-{
-	namespace details
-	{
-		class EmptyString : public SharedStringVectorAllocator::SharedStringVector
-		{
-		public:
-			EmptyString()
-			{
-				DisableRefs();
-				Push(L'\0');
-			}
-		};
-	}
-}
-
-// STATIC_DATA (object)
-static ff::details::EmptyString s_empty;
-
 ff::StringRef ff::GetEmptyString()
 {
 	// STATIC_DATA (object)
@@ -29,49 +11,56 @@ ff::StringRef ff::GetEmptyString()
 }
 
 ff::String::String()
-	: _str(&s_empty)
 {
+	set_small_size(0);
 }
 
 ff::String::String(const String &rhs)
-	: _str(rhs._str)
 {
-	_str->AddRef();
+	std::memcpy(_small, rhs._small, sizeof(_small));
+
+	if (!is_small())
+	{
+		_str->AddRef();
+	}
 }
 
 ff::String::String(const String &rhs, size_t pos, size_t count)
-	: _str(&s_empty)
 {
+	set_small_size(0);
 	assign(rhs, pos, count);
 }
 
 ff::String::String(String &&rhs)
-	: _str(rhs._str)
 {
-	rhs._str = &s_empty;
+	std::memcpy(_small, rhs._small, sizeof(_small));
+	rhs.set_small_size(0);
 }
 
 ff::String::String(const wchar_t *rhs, size_t count)
-	: _str(&s_empty)
 {
+	set_small_size(0);
 	assign(rhs, count);
 }
 
 ff::String::String(size_t count, wchar_t ch)
-	: _str(&s_empty)
 {
+	set_small_size(0);
 	assign(count, ch);
 }
 
 ff::String::String(const wchar_t *start, const wchar_t *end)
-	: _str(&s_empty)
 {
+	set_small_size(0);
 	assign(start, end);
 }
 
 ff::String::~String()
 {
-	_str->Release();
+	if (!is_small())
+	{
+		_str->Release();
+	}
 }
 
 ff::String &ff::String::operator=(const String &rhs)
@@ -239,7 +228,7 @@ ff::String &ff::String::assign(const String &rhs, size_t pos, size_t count)
 
 ff::String &ff::String::assign(String &&rhs)
 {
-	std::swap(_str, rhs._str);
+	swap(rhs);
 	rhs.clear();
 	return *this;
 }
@@ -370,20 +359,11 @@ ff::String &ff::String::replace(size_t pos, size_t count, const wchar_t *rhs, si
 		count = 0;
 	}
 
-	make_editable();
-
-	if (rhs_count > count)
-	{
-		_str->InsertDefault(pos, rhs_count - count);
-	}
-	else if (count > rhs_count)
-	{
-		_str->Delete(pos, count - rhs_count);
-	}
+	wchar_t *data = make_space(pos, count, rhs_count);
 
 	if (rhs_count > 0)
 	{
-		memcpy(_str->Data(pos), rhs, rhs_count * sizeof(wchar_t));
+		memcpy(data + pos, rhs, rhs_count * sizeof(wchar_t));
 	}
 
 	return *this;
@@ -405,9 +385,8 @@ ff::String &ff::String::replace(size_t pos, size_t count, const String &rhs, siz
 	{
 		if (this != &rhs)
 		{
-			_str->Release();
-			_str = rhs._str;
-			_str->AddRef();
+			String copy(rhs);
+			swap(copy);
 		}
 
 		return *this;
@@ -425,20 +404,11 @@ ff::String &ff::String::replace(size_t pos, size_t count, size_t ch_count, wchar
 
 	if (count > 0 || ch_count > 0)
 	{
-		make_editable();
-
-		if (ch_count > count)
-		{
-			_str->InsertDefault(pos, ch_count - count);
-		}
-		else if (count > ch_count)
-		{
-			_str->Delete(pos, count - ch_count);
-		}
+		wchar_t *data = make_space(pos, count, ch_count);
 
 		for (size_t i = 0; i < ch_count; i++)
 		{
-			_str->SetAt(pos + i, ch);
+			data[pos + i] = ch;
 		}
 	}
 
@@ -467,135 +437,131 @@ ff::String &ff::String::replace(const wchar_t *start, const wchar_t *end, const
 
 ff::String::iterator ff::String::begin()
 {
-	make_editable();
-	return _str->begin();
+	return iterator(editable_data());
 }
 
 ff::String::const_iterator ff::String::begin() const
 {
-	return _str->cbegin();
+	return const_iterator(c_str());
 }
 
 ff::String::const_iterator ff::String::cbegin() const
 {
-	return _str->cbegin();
+	return const_iterator(c_str());
 }
 
 ff::String::iterator ff::String::end()
 {
-	make_editable();
-	return _str->end();
+	return iterator(editable_data() + size() + 1);
 }
 
 ff::String::const_iterator ff::String::end() const
 {
-	return _str->cend();
+	return const_iterator(c_str() + size() + 1);
 }
 
 ff::String::const_iterator ff::String::cend() const
 {
-	return _str->cend();
+	return const_iterator(c_str() + size() + 1);
 }
 
 ff::String::reverse_iterator ff::String::rbegin()
 {
-	make_editable();
-	return _str->rbegin();
+	return reverse_iterator(end());
 }
 
 ff::String::const_reverse_iterator ff::String::rbegin() const
 {
-	return _str->crbegin();
+	return const_reverse_iterator(cend());
 }
 
 ff::String::const_reverse_iterator ff::String::crbegin() const
 {
-	return _str->crbegin();
+	return const_reverse_iterator(cend());
 }
 
 ff::String::reverse_iterator ff::String::rend()
 {
-	make_editable();
-	return _str->rend();
+	return reverse_iterator(begin());
 }
 
 ff::String::const_reverse_iterator ff::String::rend() const
 {
-	return _str->crend();
+	return const_reverse_iterator(cbegin());
 }
 
 ff::String::const_reverse_iterator ff::String::crend() const
 {
-	return _str->crend();
+	return const_reverse_iterator(cbegin());
 }
 
 wchar_t &ff::String::front()
 {
-	make_editable();
-	return _str->GetAt(0);
+	return at(0);
 }
 
 const wchar_t &ff::String::front() const
 {
-	return _str->GetAt(0);
+	return at(0);
 }
 
 wchar_t &ff::String::back()
 {
-	make_editable();
-	return _str->GetAt(size() - 1);
+	return at(size() - 1);
 }
 
 const wchar_t &ff::String::back() const
 {
-	return _str->GetAt(size() - 1);
+	return at(size() - 1);
 }
 
 wchar_t &ff::String::at(size_t pos)
 {
-	make_editable();
-	return _str->GetAt(pos);
+	assert(pos <= size());
+	return editable_data()[pos];
 }
 
 const wchar_t &ff::String::at(size_t pos) const
 {
-	return _str->GetAt(pos);
+	assert(pos <= size());
+	return c_str()[pos];
 }
 
 wchar_t &ff::String::operator[](size_t pos)
 {
-	make_editable();
-	return _str->GetAt(pos);
+	return at(pos);
 }
 
 const wchar_t &ff::String::operator[](size_t pos) const
 {
-	return _str->GetAt(pos);
+	return at(pos);
 }
 
 const wchar_t *ff::String::c_str() const
 {
-	return _str->ConstData();
+	return is_small() ? _small : _str->ConstData();
 }
 
 const wchar_t *ff::String::data() const
 {
-	return _str->ConstData();
+	return c_str();
 }
 
 size_t ff::String::length() const
 {
-	return _str->Size() - 1; // don't include null char
+	return size();
 }
 
 size_t ff::String::size() const
 {
-	return _str->Size() - 1; // don't include null char
+	return is_small()
+		? SMALL_SIZE - 1 - _small[SMALL_SIZE - 1]
+		: _str->Size() - 1; // don't include null char
 }
 
 bool ff::String::empty() const
 {
-	return _str->Size() == 1;
+	return !size();
 }
 
 size_t ff::String::max_size() const
@@ -606,24 +572,24 @@ size_t ff::String::max_size() const
 
 size_t ff::String::capacity() const
 {
-	return _str->Allocated() - 1;
+	return is_small() ? SMALL_SIZE - 1 : _str->Allocated() - 1;
 }
 
 void ff::String::clear()
 {
-	if (_str != &s_empty)
+	if (!is_small())
 	{
 		_str->Release();
-		_str = &s_empty;
 	}
+
+	set_small_size(0);
 }
 
 void ff::String::resize(size_t count)
 {
 	if (count > size())
 	{
-		make_editable();
-		_str->InsertDefault(size(), count - size());
+		make_space(size(), 0, count - size());
 	}
 	else if (count < size())
 	{
@@ -645,14 +611,29 @@ void ff::String::resize(size_t count, wchar_t ch)
 
 void ff::String::reserve(size_t alloc)
 {
-	make_editable();
-	_str->Reserve(alloc + 1);
+	if (alloc >= SMALL_SIZE)
+	{
+		make_long();
+		make_editable();
+		_str->Reserve(alloc + 1);
+	}
 }
 
 void ff::String::shrink_to_fit()
 {
-	make_editable();
-	_str->Reduce();
+	if (!is_small())
+	{
+		if (size() < SMALL_SIZE)
+		{
+			String copy(c_str(), size());
+			swap(copy);
+		}
+		else
+		{
+			make_editable();
+			_str->Reduce();
+		}
+	}
 }
 
 size_t ff::String::copy(wchar_t * out, size_t count, size_t pos)
@@ -668,7 +649,7 @@ size_t ff::String::copy(wchar_t * out, size_t count, size_t pos)
 
 void ff::String::swap(String &rhs)
 {
-	std::swap(_str, rhs._str);
+	std::swap(_small, rhs._small);
 }
 
 ff::String ff::String::substr(size_t pos, size_t count) const
@@ -729,8 +710,24 @@ ff::String ff::String::from_static(const wchar_t *str, size_t len)
 	assertRetVal(str, result);
 	noAssertRetVal(*str, result);
 
-	result.make_editable();
-	result._str->SetStaticData(str, ((len == npos) ? wcslen(str) : len) + 1);
+	if (len == npos)
+	{
+		len = wcslen(str);
+	}
+
+	if (len < SMALL_SIZE)
+	{
+		// copying is cheaper than pointing to the static data
+		result.assign(str, len);
+	}
+	else
+	{
+		SharedStringVector *data = nullptr;
+		SharedStringVector::GetUnshared(&data);
+		data->SetStaticData(str, len + 1);
+		result.set_long(data);
+	}
+
 	return result;
 }
 
@@ -766,24 +763,12 @@ size_t ff::String::find(const wchar_t *rhs, size_t pos, size_t count) const
 		count = wcslen(rhs);
 	}
 
-	if (count > 0 && count <= size())
+	if (count > 0 && count <= size() && pos <= size() - count)
 	{
-		const wchar_t *lhs = c_str() + pos;
-		for (size_t last = size() - count; pos <= last; pos++, lhs++)
+		size_t found = SearchChars(c_str() + pos, size() - pos, rhs, count);
+		if (found != INVALID_SIZE)
 		{
-			size_t i = 0;
-			for (; i < count; i++)
-			{
-				if (lhs[i] != rhs[i])
-				{
-					break;
-				}
-			}
-
-			if (i == count)
-			{
-				return pos;
-			}
+			return pos + found;
 		}
 	}
 
@@ -792,7 +777,16 @@ size_t ff::String::find(const wchar_t *rhs, size_t pos, size_t count) const
 
 size_t ff::String::find(wchar_t ch, size_t pos) const
 {
-	return find(&ch, pos, 1);
+	if (pos < size())
+	{
+		size_t found = SearchChar(c_str() + pos, size() - pos, ch);
+		if (found != INVALID_SIZE)
+		{
+			return pos + found;
+		}
+	}
+
+	return INVALID_SIZE;
 }
 
 size_t ff::String::rfind(const String &rhs, size_t pos) const
@@ -861,15 +855,12 @@ size_t ff::String::find_first_of(const wchar_t *rhs, size_t pos, size_t count) c
 		count = wcslen(rhs);
 	}
 
-	const wchar_t *lhs = c_str() + pos;
-	for (size_t endPos = size(); pos < endPos; pos++, lhs++)
+	if (pos < size())
 	{
-		for (size_t i = 0; i < count; i++)
+		size_t found = SearchCharOf(c_str() + pos, size() - pos, rhs, count);
+		if (found != INVALID_SIZE)
 		{
-			if (*lhs == rhs[i])
-			{
-				return pos;
-			}
+			return pos + found;
 		}
 	}
 
@@ -933,21 +924,12 @@ size_t ff::String::find_first_not_of(const wchar_t *rhs, size_t pos, size_t coun
 		count = wcslen(rhs);
 	}
 
-	const wchar_t *lhs = c_str() + pos;
-	for (size_t endPos = size(); pos < endPos; pos++, lhs++)
+	if (pos < size())
 	{
-		size_t i = 0;
-		for (; i < count; i++)
-		{
-			if (*lhs == rhs[i])
-			{
-				break;
-			}
-		}
-
-		if (i == count)
+		size_t found = SearchCharNotOf(c_str() + pos, size() - pos, rhs, count);
+		if (found != INVALID_SIZE)
 		{
-			return pos;
+			return pos + found;
 		}
 	}
 
@@ -1052,9 +1034,91 @@ int ff::String::compare(size_t pos, size_t count, const wchar_t *rhs, size_t rhs
 	return static_cast<int>(count) - static_cast<int>(rhs_count);
 }
 
+bool ff::String::is_small() const
+{
+	return _small[SMALL_SIZE - 1] != LONG_TAG;
+}
+
+void ff::String::set_small_size(size_t size)
+{
+	assert(size < SMALL_SIZE);
+	_small[size] = L'\0';
+	_small[SMALL_SIZE - 1] = static_cast<wchar_t>(SMALL_SIZE - 1 - size);
+}
+
+void ff::String::set_long(SharedStringVector *str)
+{
+	_str = str;
+	_small[SMALL_SIZE - 1] = LONG_TAG;
+}
+
+void ff::String::make_long()
+{
+	if (is_small())
+	{
+		SharedStringVector *str = nullptr;
+		SharedStringVector::GetUnshared(&str);
+		str->Push(_small, size() + 1);
+		set_long(str);
+	}
+}
+
 void ff::String::make_editable()
 {
-	SharedStringVectorAllocator::SharedStringVector::GetUnshared(&_str);
+	if (!is_small())
+	{
+		SharedStringVector::GetUnshared(&_str);
+	}
+}
+
+wchar_t *ff::String::editable_data()
+{
+	make_editable();
+	return is_small() ? _small : _str->Data();
+}
+
+// Replaces count characters at pos with new_count uninitialized characters, returns the start of the string
+wchar_t *ff::String::make_space(size_t pos, size_t count, size_t new_count)
+{
+	size_t old_size = size();
+	size_t new_size = old_size - count + new_count;
+	size_t tail = old_size - pos - count;
+
+	if (new_size < SMALL_SIZE)
+	{
+		if (is_small())
+		{
+			std::memmove(_small + pos + new_count, _small + pos + count, tail * sizeof(wchar_t));
+			set_small_size(new_size);
+			return _small;
+		}
+
+		if (_str->IsShared())
+		{
+			// Moving inside is cheaper than making a copy of the shared buffer
+			SharedStringVector *str = _str;
+			const wchar_t *data = str->ConstData();
+			std::memcpy(_small, data, pos * sizeof(wchar_t));
+			std::memcpy(_small + pos + new_count, data + pos + count, tail * sizeof(wchar_t));
+			set_small_size(new_size);
+			str->Release();
+			return _small;
+		}
+	}
+
+	make_long();
+	make_editable();
+
+	if (new_count > count)
+	{
+		_str->InsertDefault(pos, new_count - count);
+	}
+	else if (count > new_count)
+	{
+		_str->Delete(pos, count - new_count);
+	}
+
+	return _str->Data();
 }
 
 ff::StaticString::StaticString(const wchar_t *sz, size_t len)
@@ -1064,7 +1128,7 @@ ff::StaticString::StaticString(const wchar_t *sz, size_t len)
 
 const ff::StringRef ff::StaticString::GetString() const
 {
-	return *(String *)&_str;
+	return _str;
 }
 
 ff::StaticString::operator ff::StringRef() const
@@ -1076,7 +1140,15 @@ void ff::StaticString::Initialize(const wchar_t *sz, size_t lenWithNull)
 {
 	assert(lenWithNull > 0 && !sz[lenWithNull - 1]);
 
-	_str = &_data;
 	_data.DisableRefs();
-	_data.SetStaticData(sz, lenWithNull);
+
+	if (lenWithNull > String::SMALL_SIZE)
+	{
+		_data.SetStaticData(sz, lenWithNull);
+		_str.set_long(&_data);
+	}
+	else
+	{
+		_str.assign(sz, lenWithNull - 1);
+	}
 }
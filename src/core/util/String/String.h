@@ -11,6 +11,10 @@ namespace ff
 
 	/// Ref-counted string class that acts mostly like std::string (but with copy-on-write).
 	///
+	/// Short strings (15 characters on 64-bit) are stored inside the String itself, so they
+	/// never allocate and copying them is just copying the bytes. Longer strings share a
+	/// ref-counted buffer.
+	///
 	/// The string can be read on multiple threads, as long as none of them modify it.
 	/// That's not safe, even with the copy-on-write design. Getting that to work isn't worth it.
 	class UTIL_API String
@@ -189,9 +193,28 @@ namespace ff
 		int compare(size_t pos, size_t count, const wchar_t *rhs, size_t rhs_count = npos) const;
 
 	private:
+		friend class StaticString;
+		friend class StringAtom;
+		friend class AtomTable;
+		typedef SharedStringVectorAllocator::SharedStringVector SharedStringVector;
+
+		// The last character of a short string is its unused length, so it's also the null when full
+		static const size_t SMALL_SIZE = 4 * sizeof(void *) / sizeof(wchar_t);
+		static const wchar_t LONG_TAG = static_cast<wchar_t>(-1);
+
+		bool is_small() const;
+		void set_small_size(size_t size);
+		void set_long(SharedStringVector *str);
+		void make_long();
 		void make_editable();
+		wchar_t *editable_data();
+		wchar_t *make_space(size_t pos, size_t count, size_t new_count);
 
-		SharedStringVectorAllocator::SharedStringVector *_str;
+		union
+		{
+			SharedStringVector *_str; // when _small[SMALL_SIZE - 1] == LONG_TAG
+			wchar_t _small[SMALL_SIZE];
+		};
 	};
 
 	class StaticString
@@ -211,8 +234,8 @@ namespace ff
 	private:
 		UTIL_API void Initialize(const wchar_t *sz, size_t lenWithNull);
 
-		SharedStringVectorAllocator::SharedStringVector *_str;
 		SharedStringVectorAllocator::SharedStringVector _data;
+		String _str;
 	};
 
 	template<>
@@ -220,4 +243,26 @@ namespace ff
 	{
 		return HashBytes(val.c_str(), val.size() * sizeof(wchar_t));
 	}
+
+	/// Borrowed characters that hash and compare like a String, so they can be looked up
+	/// in a Map or Set of String without copying them (see GetWithHash).
+	struct StringView
+	{
+		StringView(const wchar_t *data, size_t size) : data(data), size(size) { }
+		StringView(StringRef str) : data(str.c_str()), size(str.size()) { }
+
+		const wchar_t *data;
+		size_t size;
+	};
+
+	template<>
+	inline hash_t HashFunc<StringView>(const StringView &val)
+	{
+		return HashBytes(val.data, val.size * sizeof(wchar_t));
+	}
+
+	inline bool KeyEquals(const String &key, const StringView &keyView)
+	{
+		return key.size() == keyView.size && !std::memcmp(key.c_str(), keyView.data, keyView.size * sizeof(wchar_t));
+	}
 }
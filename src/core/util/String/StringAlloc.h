@@ -39,8 +39,9 @@ namespace ff
 	/// It is not safe to use this allocator until the program has initialized the ProcessGlobals.
 	struct SharedStringVectorAllocator
 	{
-		// Strings can store 15 characters (+null) before needing to allocate extra memory
-		typedef Vector<wchar_t, 16, StringAllocator> StringVector;
+		// Strings that are too long to fit inside a String can store 31 characters (+null)
+		// before needing to allocate extra memory
+		typedef Vector<wchar_t, 32, StringAllocator> StringVector;
 		typedef SharedObject<StringVector, SharedStringVectorAllocator> SharedStringVector;
 
 		SharedStringVector *NewOne()
@@ -0,0 +1,159 @@
+#include "pch.h"
+#include "Data/DataWriterReader.h"
+#include "String/StringBuilder.h"
+
+static const size_t MIN_CHUNK_SIZE = 256;
+static const size_t MAX_CHUNK_SIZE = 64 * 1024;
+
+ff::StringBuilder::StringBuilder()
+	: _cur(nullptr)
+	, _end(nullptr)
+	, _fullChunkChars(0)
+{
+}
+
+ff::StringBuilder::StringBuilder(StringBuilder &&rhs)
+	: _chunks(std::move(rhs._chunks))
+	, _cur(rhs._cur)
+	, _end(rhs._end)
+	, _fullChunkChars(rhs._fullChunkChars)
+{
+	rhs._chunks.Clear();
+	rhs._cur = nullptr;
+	rhs._end = nullptr;
+	rhs._fullChunkChars = 0;
+}
+
+ff::StringBuilder::~StringBuilder()
+{
+	FreeChunks(0);
+}
+
+ff::StringBuilder &ff::StringBuilder::operator=(StringBuilder &&rhs)
+{
+	if (this != &rhs)
+	{
+		FreeChunks(0);
+		std::swap(_chunks, rhs._chunks);
+		std::swap(_cur, rhs._cur);
+		std::swap(_end, rhs._end);
+		std::swap(_fullChunkChars, rhs._fullChunkChars);
+	}
+
+	return *this;
+}
+
+void ff::StringBuilder::Append(const wchar_t *text, size_t count)
+{
+	while (count)
+	{
+		if (_cur == _end)
+		{
+			AddChunk(count);
+		}
+
+		size_t copy = std::min(count, static_cast<size_t>(_end - _cur));
+		std::memcpy(_cur, text, copy * sizeof(wchar_t));
+
+		_cur += copy;
+		text += copy;
+		count -= copy;
+	}
+}
+
+void ff::StringBuilder::Append(size_t count, wchar_t ch)
+{
+	while (count)
+	{
+		if (_cur == _end)
+		{
+			AddChunk(count);
+		}
+
+		size_t copy = std::min(count, static_cast<size_t>(_end - _cur));
+		std::fill(_cur, _cur + copy, ch);
+
+		_cur += copy;
+		count -= copy;
+	}
+}
+
+void ff::StringBuilder::Clear()
+{
+	FreeChunks(1);
+}
+
+ff::String ff::StringBuilder::ToString() const
+{
+	String text;
+	text.reserve(GetSize());
+
+	for (size_t i = 0; i < _chunks.Size(); i++)
+	{
+		const Chunk &chunk = _chunks[i];
+		size_t count = (i + 1 < _chunks.Size()) ? chunk._size : _cur - chunk._data;
+		text.append(chunk._data, count);
+	}
+
+	return text;
+}
+
+bool ff::StringBuilder::Write(IDataWriter *writer) const
+{
+	assertRetVal(writer, false);
+
+	for (size_t i = 0; i < _chunks.Size(); i++)
+	{
+		const Chunk &chunk = _chunks[i];
+		size_t count = (i + 1 < _chunks.Size()) ? chunk._size : _cur - chunk._data;
+
+		if (count)
+		{
+			assertRetVal(writer->Write(chunk._data, count * sizeof(wchar_t)), false);
+		}
+	}
+
+	return true;
+}
+
+bool ff::StringBuilder::Flush(IDataWriter *writer)
+{
+	assertRetVal(Write(writer), false);
+	Clear();
+	return true;
+}
+
+void ff::StringBuilder::AddChunk(size_t minSize)
+{
+	if (_chunks.Size())
+	{
+		_fullChunkChars += _cur - _chunks.GetLast()._data;
+	}
+
+	size_t size = _chunks.Size() ? std::min(_chunks.GetLast()._size * 2, MAX_CHUNK_SIZE) : MIN_CHUNK_SIZE;
+
+	Chunk chunk;
+	chunk._size = std::max(size, minSize);
+	chunk._data = reinterpret_cast<wchar_t *>(_aligned_malloc(chunk._size * sizeof(wchar_t), __alignof(wchar_t)));
+	_chunks.Push(chunk);
+
+	_cur = chunk._data;
+	_end = chunk._data + chunk._size;
+}
+
+void ff::StringBuilder::FreeChunks(size_t keepCount)
+{
+	for (size_t i = keepCount; i < _chunks.Size(); i++)
+	{
+		_aligned_free(_chunks[i]._data);
+	}
+
+	if (keepCount < _chunks.Size())
+	{
+		_chunks.Delete(keepCount, _chunks.Size() - keepCount);
+	}
+
+	_cur = _chunks.Size() ? _chunks[0]._data : nullptr;
+	_end = _chunks.Size() ? _chunks[0]._data + _chunks[0]._size : nullptr;
+	_fullChunkChars = 0;
+}
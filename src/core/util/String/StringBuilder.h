@@ -0,0 +1,64 @@
+#pragma once
+
+namespace ff
+{
+	class IDataWriter;
+
+	/// Builds big text one piece at a time, like JSON output or logs.
+	///
+	/// Text is appended into a chain of chunks that double in size as the text grows, so the
+	/// text that's already there never gets copied again. Use ToString() to copy it all into
+	/// a String with one allocation, or Write() to send each chunk straight to a writer.
+	class StringBuilder
+	{
+	public:
+		UTIL_API StringBuilder();
+		UTIL_API StringBuilder(StringBuilder &&rhs);
+		UTIL_API ~StringBuilder();
+
+		UTIL_API StringBuilder &operator=(StringBuilder &&rhs);
+		StringBuilder &operator+=(wchar_t ch) { Append(ch); return *this; }
+		StringBuilder &operator+=(StringRef text) { Append(text); return *this; }
+
+		void Append(wchar_t ch)
+		{
+			if (_cur == _end)
+			{
+				AddChunk(1);
+			}
+
+			*_cur++ = ch;
+		}
+
+		void Append(StringRef text) { Append(text.c_str(), text.size()); }
+		void Append(const wchar_t *text) { Append(text, wcslen(text)); }
+		UTIL_API void Append(const wchar_t *text, size_t count);
+		UTIL_API void Append(size_t count, wchar_t ch);
+
+		size_t GetSize() const { return _fullChunkChars + (_chunks.Size() ? _cur - _chunks.GetLast()._data : 0); }
+		bool IsEmpty() const { return !GetSize(); }
+		UTIL_API void Clear(); // keeps the first chunk around for more text
+
+		UTIL_API String ToString() const;
+		UTIL_API bool Write(IDataWriter *writer) const;
+		UTIL_API bool Flush(IDataWriter *writer); // writes and then clears
+
+	private:
+		StringBuilder(const StringBuilder &rhs) = delete;
+		StringBuilder &operator=(const StringBuilder &rhs) = delete;
+
+		struct Chunk
+		{
+			wchar_t *_data;
+			size_t _size;
+		};
+
+		void AddChunk(size_t minSize);
+		void FreeChunks(size_t keepCount);
+
+		Vector<Chunk, 4> _chunks;
+		wchar_t *_cur;
+		wchar_t *_end;
+		size_t _fullChunkChars; // chars in chunks before the last one, which are always full
+	};
+}
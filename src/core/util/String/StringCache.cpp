@@ -17,13 +17,9 @@ static ff::hash_t ParseHash(ff::StringRef key)
 	return hash;
 }
 
-static ff::String HashToString(ff::hash_t hash)
-{
-	return ff::String::format_new(L"#x%016I64x", hash);
-}
-
 ff::StringCache::StringCache(bool threadSafe)
-	: _lock(threadSafe)
+	: _atoms(threadSafe)
+	, _legacyAtoms(threadSafe)
 {
 }
 
@@ -48,26 +44,15 @@ ff::hash_t ff::StringCache::InternalGetHash(ff::StringRef str, bool cacheString)
 	if (hash)
 	{
 		// No need to cache these, they aren't the original string that produced the hash
-		cacheString = false;
-	}
-	else
-	{
-		hash = ff::HashFunc(str);
+		return hash;
 	}
 
-	if (cacheString)
-	{
-		bool exists;
-		{
-			ff::LockReader crit(_lock);
-			exists = _atomToString.Exists(hash);
-		}
+	hash = ff::HashFunc(str);
 
-		if (!exists)
-		{
-			ff::LockWriter crit(_lock);
-			_atomToString.SetKey(hash, str);
-		}
+	if (cacheString && _atoms.Find(hash).IsNull())
+	{
+		// Only new strings need a legacy hash, so caching a known string stays one lookup
+		AddLegacyAtom(_atoms.Intern(str.c_str(), str.size(), hash));
 	}
 
 	return hash;
@@ -75,22 +60,61 @@ ff::hash_t ff::StringCache::InternalGetHash(ff::StringRef str, bool cacheString)
 
 ff::String ff::StringCache::GetString(ff::hash_t hash) const
 {
-	// See if I've ever cached the real string before
+	// See if I've ever cached the real string before, it shares the atom's memory
+	ff::StringAtom atom = _atoms.Find(hash);
+	if (!atom.IsNull())
 	{
-		ff::LockReader crit(_lock);
-		ff::BucketIter iter = _atomToString.Get(hash);
-
-		if (iter != INVALID_ITER)
-		{
-			return _atomToString.ValueAt(iter);
-		}
+		return atom.ToString();
 	}
 
 	return HashToString(hash);
 }
 
+const ff::AtomTable &ff::StringCache::GetAtoms() const
+{
+	return _atoms;
+}
+
+bool ff::StringCache::LoadAtoms(ff::IDataReader *reader)
+{
+	assertRetVal(_atoms.Load(reader), false);
+
+	// Loaded strings didn't go through CacheString, so they still need their legacy hashes
+	_atoms.ForEach([this](ff::StringAtom atom)
+	{
+		AddLegacyAtom(atom);
+	});
+
+	return true;
+}
+
+bool ff::StringCache::FindLegacyString(ff::hash_t legacyHash, ff::String &str) const
+{
+	ff::StringAtom atom;
+	noAssertRetVal(_legacyAtoms.Get(legacyHash, atom), false);
+
+	str = atom.ToString();
+	return true;
+}
+
 void ff::StringCache::Clear()
 {
-	ff::LockWriter lock(_lock);
-	_atomToString.Clear();
+	_atoms.Clear();
+	_legacyAtoms.Clear();
+}
+
+ff::hash_t ff::StringCache::HashString(ff::StringRef str)
+{
+	ff::hash_t hash = ParseHash(str);
+	return hash ? hash : ff::HashFunc(str);
+}
+
+ff::String ff::StringCache::HashToString(ff::hash_t hash)
+{
+	return ff::String::format_new(L"#x%016I64x", hash);
+}
+
+void ff::StringCache::AddLegacyAtom(ff::StringAtom atom)
+{
+	_legacyAtoms.TryAdd(ff::HashBytesLegacy(atom.c_str(), atom.size() * sizeof(wchar_t)), atom);
 }
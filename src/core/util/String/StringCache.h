@@ -1,5 +1,7 @@
 #pragma once
 
+#include "String/AtomTable.h"
+
 namespace ff
 {
 	class StringCache
@@ -10,15 +12,27 @@ namespace ff
 
 		UTIL_API ff::hash_t GetHash(ff::StringRef str);
 		UTIL_API ff::hash_t CacheString(ff::StringRef str);
+
+		// Cached strings never allocate. Long ones share the cache's memory, so they must not
+		// outlive the cache (the process-wide cache is never destroyed).
 		UTIL_API ff::String GetString(ff::hash_t hash) const;
+
+		UTIL_API const ff::AtomTable &GetAtoms() const; // for saving strings
+		UTIL_API bool LoadAtoms(ff::IDataReader *reader); // preloads strings that AtomTable saved
+		UTIL_API bool FindLegacyString(ff::hash_t legacyHash, ff::String &str) const; // see HashBytesLegacy
 		UTIL_API void Clear();
 
+		// Same as GetHash and GetString for a string that was never cached, without needing a cache
+		UTIL_API static ff::hash_t HashString(ff::StringRef str);
+		UTIL_API static ff::String HashToString(ff::hash_t hash);
+
 	protected:
-		ff::Map<ff::hash_t, ff::String, ff::NonHasher<ff::hash_t>> _atomToString;
-		ReaderWriterLock _lock;
+		ff::AtomTable _atoms;
+		ff::ConcurrentMap<ff::hash_t, ff::StringAtom, ff::NonHasher<ff::hash_t>> _legacyAtoms;
 
 	private:
 		ff::hash_t InternalGetHash(ff::StringRef str, bool cacheString);
+		void AddLegacyAtom(ff::StringAtom atom);
 
 		// not allowed
 		StringCache(const StringCache &r);
@@ -0,0 +1,475 @@
+#include "pch.h"
+#include "Data/DataWriterReader.h"
+#include "String/StringConvert.h"
+#include "String/StringSearch.h"
+
+// The vector code writes 16-bit chars
+#if (defined(_M_IX86) || defined(_M_X64)) && WCHAR_MAX == 0xFFFF
+#define STRING_CONVERT_SIMD 1
+#include <immintrin.h>
+#else
+#define STRING_CONVERT_SIMD 0
+#endif
+
+static const size_t READ_UTF8_CHUNK_SIZE = 64 * 1024;
+static const wchar_t REPLACEMENT_CHAR = 0xFFFD;
+
+static size_t PlainAsciiSize(const char *text, size_t count)
+{
+	size_t i = 0;
+	while (i < count && !(text[i] & 0x80))
+	{
+		i++;
+	}
+
+	return i;
+}
+
+static size_t PlainWidenAscii(const char *text, size_t count, wchar_t *output)
+{
+	size_t i = 0;
+	for (; i < count && !(text[i] & 0x80); i++)
+	{
+		output[i] = static_cast<wchar_t>(text[i]);
+	}
+
+	return i;
+}
+
+static size_t PlainNarrowAscii(const wchar_t *text, size_t count, char *output)
+{
+	size_t i = 0;
+	for (; i < count && text[i] < 0x80; i++)
+	{
+		output[i] = static_cast<char>(text[i]);
+	}
+
+	return i;
+}
+
+#if STRING_CONVERT_SIMD
+
+struct Sse2Ascii
+{
+	static const size_t COUNT = 16;
+
+	static bool IsAscii(const char *text)
+	{
+		return !_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(text)));
+	}
+
+	static bool Widen(const char *text, wchar_t *output)
+	{
+		__m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text));
+		if (_mm_movemask_epi8(chars))
+		{
+			return false;
+		}
+
+		__m128i zero = _mm_setzero_si128();
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(output), _mm_unpacklo_epi8(chars, zero));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(output + 8), _mm_unpackhi_epi8(chars, zero));
+		return true;
+	}
+
+	static bool Narrow(const wchar_t *text, char *output)
+	{
+		__m128i chars1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text));
+		__m128i chars2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + 8));
+		__m128i high = _mm_and_si128(_mm_or_si128(chars1, chars2), _mm_set1_epi16(static_cast<short>(0xFF80)));
+		if (_mm_movemask_epi8(_mm_cmpeq_epi16(high, _mm_setzero_si128())) != 0xFFFF)
+		{
+			return false;
+		}
+
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(output), _mm_packus_epi16(chars1, chars2));
+		return true;
+	}
+};
+
+struct Avx2Ascii
+{
+	static const size_t COUNT = 32;
+
+	static bool IsAscii(const char *text)
+	{
+		return !_mm256_movemask_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(text)));
+	}
+
+	static bool Widen(const char *text, wchar_t *output)
+	{
+		__m256i chars = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(text));
+		if (_mm256_movemask_epi8(chars))
+		{
+			return false;
+		}
+
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(output), _mm256_cvtepu8_epi16(_mm256_castsi256_si128(chars)));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(output + 16), _mm256_cvtepu8_epi16(_mm256_extracti128_si256(chars, 1)));
+		return true;
+	}
+
+	static bool Narrow(const wchar_t *text, char *output)
+	{
+		__m256i chars1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(text));
+		__m256i chars2 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(text + 16));
+		__m256i high = _mm256_and_si256(_mm256_or_si256(chars1, chars2), _mm256_set1_epi16(static_cast<short>(0xFF80)));
+		if (static_cast<unsigned int>(_mm256_movemask_epi8(_mm256_cmpeq_epi16(high, _mm256_setzero_si256()))) != 0xFFFFFFFF)
+		{
+			return false;
+		}
+
+		// packus works within each 128-bit lane, so the middle quarters need to swap
+		__m256i packed = _mm256_packus_epi16(chars1, chars2);
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(output), _mm256_permute4x64_epi64(packed, 0xD8));
+		return true;
+	}
+};
+
+template<typename Ascii>
+static size_t SimdAsciiSize(const char *text, size_t count)
+{
+	size_t i = 0;
+	while (i + Ascii::COUNT <= count && Ascii::IsAscii(text + i))
+	{
+		i += Ascii::COUNT;
+	}
+
+	return i + PlainAsciiSize(text + i, count - i);
+}
+
+template<typename Ascii>
+static size_t SimdWidenAscii(const char *text, size_t count, wchar_t *output)
+{
+	size_t i = 0;
+	while (i + Ascii::COUNT <= count && Ascii::Widen(text + i, output + i))
+	{
+		i += Ascii::COUNT;
+	}
+
+	return i + PlainWidenAscii(text + i, count - i, output + i);
+}
+
+template<typename Ascii>
+static size_t SimdNarrowAscii(const wchar_t *text, size_t count, char *output)
+{
+	size_t i = 0;
+	while (i + Ascii::COUNT <= count && Ascii::Narrow(text + i, output + i))
+	{
+		i += Ascii::COUNT;
+	}
+
+	return i + PlainNarrowAscii(text + i, count - i, output + i);
+}
+
+#endif
+
+struct StringConvertFuncs
+{
+	size_t (*asciiSize)(const char *text, size_t count);
+	size_t (*widenAscii)(const char *text, size_t count, wchar_t *output);
+	size_t (*narrowAscii)(const wchar_t *text, size_t count, char *output);
+};
+
+// STATIC_DATA (pod)
+static const StringConvertFuncs s_plainFuncs =
+{
+	PlainAsciiSize,
+	PlainWidenAscii,
+	PlainNarrowAscii,
+};
+
+#if STRING_CONVERT_SIMD
+// STATIC_DATA (pod)
+static const StringConvertFuncs s_sse2Funcs =
+{
+	SimdAsciiSize<Sse2Ascii>,
+	SimdWidenAscii<Sse2Ascii>,
+	SimdNarrowAscii<Sse2Ascii>,
+};
+
+// STATIC_DATA (pod)
+static const StringConvertFuncs s_avx2Funcs =
+{
+	SimdAsciiSize<Avx2Ascii>,
+	SimdWidenAscii<Avx2Ascii>,
+	SimdNarrowAscii<Avx2Ascii>,
+};
+#endif
+
+static const StringConvertFuncs &GetFuncs()
+{
+	switch (ff::GetSimdLevel())
+	{
+#if STRING_CONVERT_SIMD
+	case ff::SimdLevel::Avx2:
+		return s_avx2Funcs;
+
+	case ff::SimdLevel::Sse2:
+		return s_sse2Funcs;
+#endif
+
+	default:
+		return s_plainFuncs;
+	}
+}
+
+// Decodes one char that starts with a non-ASCII byte, into one or two wide chars.
+// Bad sequences become one U+FFFD for the longest valid start of a sequence (Unicode's
+// "maximal subpart" rule), and the next char starts at the byte that didn't fit.
+static size_t DecodeUtf8Char(const unsigned char *text, size_t count, wchar_t *output, size_t &outputCount, bool &valid)
+{
+	unsigned int ch = text[0];
+	unsigned int low = 0x80;
+	unsigned int high = 0xBF;
+	size_t size;
+
+	if (ch >= 0xC2 && ch <= 0xDF)
+	{
+		size = 2;
+		ch &= 0x1F;
+	}
+	else if (ch >= 0xE0 && ch <= 0xEF)
+	{
+		size = 3;
+		low = (ch == 0xE0) ? 0xA0 : low; // overlong
+		high = (ch == 0xED) ? 0x9F : high; // surrogates
+		ch &= 0x0F;
+	}
+	else if (ch >= 0xF0 && ch <= 0xF4)
+	{
+		size = 4;
+		low = (ch == 0xF0) ? 0x90 : low; // overlong
+		high = (ch == 0xF4) ? 0x8F : high; // above U+10FFFF
+		ch &= 0x07;
+	}
+	else
+	{
+		output[0] = REPLACEMENT_CHAR;
+		outputCount = 1;
+		valid = false;
+		return 1;
+	}
+
+	for (size_t i = 1; i < size; i++)
+	{
+		if (i >= count || text[i] < low || text[i] > high)
+		{
+			output[0] = REPLACEMENT_CHAR;
+			outputCount = 1;
+			valid = false;
+			return i;
+		}
+
+		ch = (ch << 6) | (text[i] & 0x3F);
+		low = 0x80;
+		high = 0xBF;
+	}
+
+	if (ch >= 0x10000)
+	{
+		ch -= 0x10000;
+		output[0] = static_cast<wchar_t>(0xD800 + (ch >> 10));
+		output[1] = static_cast<wchar_t>(0xDC00 + (ch & 0x3FF));
+		outputCount = 2;
+	}
+	else
+	{
+		output[0] = static_cast<wchar_t>(ch);
+		outputCount = 1;
+	}
+
+	return size;
+}
+
+// Encodes one wide char that isn't ASCII, or a surrogate pair
+static size_t EncodeUtf8Char(const wchar_t *text, size_t count, char *output, size_t &outputCount, bool &valid)
+{
+	unsigned int ch = text[0];
+	size_t size = 1;
+
+	if (ch >= 0xD800 && ch <= 0xDBFF && count > 1 && text[1] >= 0xDC00 && text[1] <= 0xDFFF)
+	{
+		ch = 0x10000 + ((ch - 0xD800) << 10) + (text[1] - 0xDC00);
+		size = 2;
+	}
+	else if ((ch >= 0xD800 && ch <= 0xDFFF) || ch > 0xFFFF)
+	{
+		ch = REPLACEMENT_CHAR;
+		valid = false;
+	}
+
+	if (ch < 0x800)
+	{
+		output[0] = static_cast<char>(0xC0 | (ch >> 6));
+		output[1] = static_cast<char>(0x80 | (ch & 0x3F));
+		outputCount = 2;
+	}
+	else if (ch < 0x10000)
+	{
+		output[0] = static_cast<char>(0xE0 | (ch >> 12));
+		output[1] = static_cast<char>(0x80 | ((ch >> 6) & 0x3F));
+		output[2] = static_cast<char>(0x80 | (ch & 0x3F));
+		outputCount = 3;
+	}
+	else
+	{
+		output[0] = static_cast<char>(0xF0 | (ch >> 18));
+		output[1] = static_cast<char>(0x80 | ((ch >> 12) & 0x3F));
+		output[2] = static_cast<char>(0x80 | ((ch >> 6) & 0x3F));
+		output[3] = static_cast<char>(0x80 | (ch & 0x3F));
+		outputCount = 4;
+	}
+
+	return size;
+}
+
+// Bytes at the end that start a sequence which isn't finished yet
+static size_t GetUnfinishedUtf8Size(const char *text, size_t count)
+{
+	for (size_t i = 1; i <= 3 && i <= count; i++)
+	{
+		unsigned char ch = static_cast<unsigned char>(text[count - i]);
+		if ((ch & 0xC0) != 0x80)
+		{
+			size_t size = (ch >= 0xF0) ? 4 : (ch >= 0xE0) ? 3 : (ch >= 0xC0) ? 2 : 1;
+			return (size > i) ? i : 0;
+		}
+	}
+
+	return 0;
+}
+
+size_t ff::Utf8ToUtf16(const char *text, size_t count, wchar_t *output, bool *valid)
+{
+	const StringConvertFuncs &funcs = GetFuncs();
+	const unsigned char *bytes = reinterpret_cast<const unsigned char *>(text);
+	bool allValid = true;
+	size_t pos = 0;
+	size_t outputPos = 0;
+
+	while (pos < count)
+	{
+		size_t ascii = funcs.widenAscii(text + pos, count - pos, output + outputPos);
+		pos += ascii;
+		outputPos += ascii;
+
+		// Text that isn't ASCII tends to stay that way, so don't go back to vectors for every char
+		while (pos < count && (bytes[pos] & 0x80))
+		{
+			size_t outputCount;
+			pos += DecodeUtf8Char(bytes + pos, count - pos, output + outputPos, outputCount, allValid);
+			outputPos += outputCount;
+		}
+	}
+
+	if (valid)
+	{
+		*valid = allValid;
+	}
+
+	return outputPos;
+}
+
+size_t ff::Utf16ToUtf8(const wchar_t *text, size_t count, char *output, bool *valid)
+{
+	const StringConvertFuncs &funcs = GetFuncs();
+	bool allValid = true;
+	size_t pos = 0;
+	size_t outputPos = 0;
+
+	while (pos < count)
+	{
+		size_t ascii = funcs.narrowAscii(text + pos, count - pos, output + outputPos);
+		pos += ascii;
+		outputPos += ascii;
+
+		while (pos < count && text[pos] >= 0x80)
+		{
+			size_t outputCount;
+			pos += EncodeUtf8Char(text + pos, count - pos, output + outputPos, outputCount, allValid);
+			outputPos += outputCount;
+		}
+	}
+
+	if (valid)
+	{
+		*valid = allValid;
+	}
+
+	return outputPos;
+}
+
+bool ff::IsValidUtf8(const char *text, size_t count)
+{
+	const StringConvertFuncs &funcs = GetFuncs();
+	const unsigned char *bytes = reinterpret_cast<const unsigned char *>(text);
+	bool valid = true;
+
+	for (size_t pos = 0; pos < count && valid; )
+	{
+		pos += funcs.asciiSize(text + pos, count - pos);
+
+		while (pos < count && (bytes[pos] & 0x80) && valid)
+		{
+			wchar_t chars[2];
+			size_t charCount;
+			pos += DecodeUtf8Char(bytes + pos, count - pos, chars, charCount, valid);
+		}
+	}
+
+	return valid;
+}
+
+size_t ff::WidenAscii(const char *text, size_t count, wchar_t *output)
+{
+	return GetFuncs().widenAscii(text, count, output);
+}
+
+size_t ff::NarrowAscii(const wchar_t *text, size_t count, char *output)
+{
+	return GetFuncs().narrowAscii(text, count, output);
+}
+
+bool ff::ReadUtf8(IDataReader *reader, size_t size, String &output, bool *valid)
+{
+	assertRetVal(reader, false);
+
+	size_t pos = reader->GetPos();
+	size = (size == INVALID_SIZE) ? reader->GetSize() - pos : size;
+	assertRetVal(size <= reader->GetSize() - pos, false);
+
+	bool allValid = true;
+	size_t end = pos + size;
+	output.reserve(output.size() + size);
+
+	while (pos < end)
+	{
+		size_t chunkSize = std::min(end - pos, READ_UTF8_CHUNK_SIZE);
+		const char *chunk = reinterpret_cast<const char *>(reader->Read(chunkSize));
+		assertRetVal(chunk, false);
+
+		// A char split between chunks gets read again with the next chunk
+		size_t unfinished = (pos + chunkSize < end) ? GetUnfinishedUtf8Size(chunk, chunkSize) : 0;
+		if (unfinished && unfinished < chunkSize)
+		{
+			chunkSize -= unfinished;
+			assertRetVal(reader->SetPos(pos + chunkSize), false);
+		}
+
+		bool chunkValid;
+		size_t outputSize = output.size();
+		output.resize(outputSize + chunkSize);
+		output.resize(outputSize + Utf8ToUtf16(chunk, chunkSize, &output[outputSize], &chunkValid));
+
+		allValid &= chunkValid;
+		pos += chunkSize;
+	}
+
+	if (valid)
+	{
+		*valid = allValid;
+	}
+
+	return true;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+namespace ff
+{
+	class IDataReader;
+
+	/// Converts between UTF-8 bytes and UTF-16 wide chars.
+	///
+	/// Runs of ASCII are copied with SSE2 or AVX2 (see SimdLevel in StringSearch.h), the rest
+	/// is converted one char at a time. Malformed input (bad bytes, overlong or truncated
+	/// sequences, lone surrogates) turns into U+FFFD the same way MultiByteToWideChar does it,
+	/// and sets *valid to false.
+	UTIL_API size_t Utf8ToUtf16(const char *text, size_t count, wchar_t *output, bool *valid = nullptr); // output needs room for count chars
+	UTIL_API size_t Utf16ToUtf8(const wchar_t *text, size_t count, char *output, bool *valid = nullptr); // output needs room for count * 3 bytes
+	UTIL_API bool IsValidUtf8(const char *text, size_t count);
+
+	// Both stop at the first non-ASCII char and return how many chars were copied
+	UTIL_API size_t WidenAscii(const char *text, size_t count, wchar_t *output);
+	UTIL_API size_t NarrowAscii(const wchar_t *text, size_t count, char *output);
+
+	// Converts in chunks while reading, the whole UTF-8 source is never in memory at once
+	UTIL_API bool ReadUtf8(IDataReader *reader, size_t size, String &output, bool *valid = nullptr);
+}
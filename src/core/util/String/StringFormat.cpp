@@ -0,0 +1,319 @@
+#include "pch.h"
+#include "Data/DataWriterReader.h"
+#include "String/NumberConvert.h"
+#include "String/StringFormat.h"
+
+// STATIC_DATA (pod)
+static const char s_digitPairs[] =
+	"00010203040506070809"
+	"10111213141516171819"
+	"20212223242526272829"
+	"30313233343536373839"
+	"40414243444546474849"
+	"50515253545556575859"
+	"60616263646566676869"
+	"70717273747576777879"
+	"80818283848586878889"
+	"90919293949596979899";
+
+// Writes digits backwards from the end of a buffer, returns the first one
+static wchar_t *FormatDecimal(wchar_t *end, uint64_t value)
+{
+	while (value >= 100)
+	{
+		const char *pair = s_digitPairs + (value % 100) * 2;
+		value /= 100;
+		*--end = pair[1];
+		*--end = pair[0];
+	}
+
+	if (value >= 10)
+	{
+		const char *pair = s_digitPairs + value * 2;
+		*--end = pair[1];
+		*--end = pair[0];
+	}
+	else
+	{
+		*--end = static_cast<wchar_t>(L'0' + value);
+	}
+
+	return end;
+}
+
+static wchar_t *FormatHex(wchar_t *end, uint64_t value, bool upper)
+{
+	const wchar_t *digits = upper ? L"0123456789ABCDEF" : L"0123456789abcdef";
+
+	do
+	{
+		*--end = digits[value & 0xF];
+		value >>= 4;
+	}
+	while (value);
+
+	return end;
+}
+
+static void FormatInteger(ff::FormatOutput &out, uint64_t value, bool negative, const ff::FormatSpec &spec)
+{
+	wchar_t buffer[32];
+	wchar_t *end = buffer + _countof(buffer);
+	wchar_t *start = (spec.type == L'x' || spec.type == L'X')
+		? FormatHex(end, value, spec.type == L'X')
+		: FormatDecimal(end, value);
+
+	if (negative)
+	{
+		if (spec.fill == L'0' && !spec.left && spec.width > static_cast<size_t>(end - start) + 1)
+		{
+			// Zeros go between the sign and the digits
+			wchar_t sign = L'-';
+			out.Append(&sign, 1);
+
+			ff::FormatSpec digitSpec = spec;
+			digitSpec.width--;
+			out.AppendValue(start, end - start, digitSpec);
+			return;
+		}
+
+		*--start = L'-';
+	}
+
+	out.AppendValue(start, end - start, spec);
+}
+
+void ff::FormatOutput::AppendValue(const wchar_t *chars, size_t count, const FormatSpec &spec)
+{
+	if (spec.width > count)
+	{
+		wchar_t fill[16];
+		size_t fillCount = spec.width - count;
+		std::fill_n(fill, std::min(fillCount, _countof(fill)), spec.fill);
+
+		if (spec.left)
+		{
+			Append(chars, count);
+		}
+
+		for (size_t i = 0; i < fillCount; i += _countof(fill))
+		{
+			Append(fill, std::min(fillCount - i, _countof(fill)));
+		}
+
+		if (!spec.left)
+		{
+			Append(chars, count);
+		}
+	}
+	else
+	{
+		Append(chars, count);
+	}
+}
+
+void ff::FormatValue(FormatOutput &out, int64_t value, const FormatSpec &spec)
+{
+	// Negate as unsigned, so the smallest value doesn't overflow
+	uint64_t absValue = (value < 0) ? 0 - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+	::FormatInteger(out, absValue, value < 0, spec);
+}
+
+void ff::FormatValue(FormatOutput &out, uint64_t value, const FormatSpec &spec)
+{
+	::FormatInteger(out, value, false, spec);
+}
+
+// Only a precision or a type needs printf, otherwise the shortest digits are written
+static bool IsShortestFloatSpec(const ff::FormatSpec &spec)
+{
+	return !spec.type && spec.precision == ff::INVALID_SIZE;
+}
+
+void ff::FormatValue(FormatOutput &out, double value, const FormatSpec &spec)
+{
+	if (::IsShortestFloatSpec(spec))
+	{
+		if (value == std::floor(value) && std::fabs(value) < 9007199254740992.0)
+		{
+			// Whole numbers (most numbers in JSON) are written as integers, which is even faster
+			FormatValue(out, static_cast<int64_t>(value), spec);
+		}
+		else
+		{
+			wchar_t buffer[MAX_NUMBER_CHARS];
+			out.AppendValue(buffer, FormatDouble(value, buffer), spec);
+		}
+
+		return;
+	}
+
+	// Hex floats use %a, printf's %x would read the double as an integer. Without a precision they
+	// get every digit, a negative precision is the same as leaving it out.
+	bool hex = (spec.type == L'x' || spec.type == L'X');
+	wchar_t format[8] = L"%.*";
+	format[3] = hex ? (spec.type == L'X' ? L'A' : L'a') : (spec.type ? spec.type : L'f');
+
+	wchar_t buffer[64];
+	int precision = (spec.precision != INVALID_SIZE) ? static_cast<int>(std::min<size_t>(spec.precision, 32)) : (hex ? -1 : 6);
+	int count = _snwprintf_s(buffer, _countof(buffer), _TRUNCATE, format, precision, value);
+	assertRet(count >= 0);
+
+	out.AppendValue(buffer, count, spec);
+}
+
+void ff::FormatValue(FormatOutput &out, float value, const FormatSpec &spec)
+{
+	if (::IsShortestFloatSpec(spec))
+	{
+		// Shortest digits for the float itself, so 0.1f isn't written as 0.10000000149011612
+		wchar_t buffer[MAX_NUMBER_CHARS];
+		out.AppendValue(buffer, FormatFloat(value, buffer), spec);
+		return;
+	}
+
+	FormatValue(out, static_cast<double>(value), spec);
+}
+
+void ff::FormatValue(FormatOutput &out, bool value, const FormatSpec &spec)
+{
+	out.AppendValue(value ? L"true" : L"false", value ? 4 : 5, spec);
+}
+
+void ff::FormatValue(FormatOutput &out, wchar_t value, const FormatSpec &spec)
+{
+	out.AppendValue(&value, 1, spec);
+}
+
+void ff::FormatValue(FormatOutput &out, const wchar_t *value, const FormatSpec &spec)
+{
+	if (!value)
+	{
+		value = L"";
+	}
+
+	out.AppendValue(value, wcslen(value), spec);
+}
+
+void ff::FormatValue(FormatOutput &out, StringRef value, const FormatSpec &spec)
+{
+	out.AppendValue(value.c_str(), value.size(), spec);
+}
+
+void ff::FormatValue(FormatOutput &out, const void *value, const FormatSpec &spec)
+{
+	wchar_t buffer[32];
+	wchar_t *end = buffer + _countof(buffer);
+	wchar_t *start = FormatHex(end, reinterpret_cast<size_t>(value), spec.type == L'X');
+	*--start = L'x';
+	*--start = L'0';
+
+	out.AppendValue(start, end - start, spec);
+}
+
+// Parses what's after the colon in {:<08.3x}
+static bool ParseFormatSpec(const wchar_t *&format, ff::FormatSpec &spec)
+{
+	if (*format == L'<' || *format == L'>')
+	{
+		spec.left = (*format++ == L'<');
+	}
+
+	if (*format == L'0')
+	{
+		spec.fill = L'0';
+		format++;
+	}
+
+	for (; *format >= L'0' && *format <= L'9'; format++)
+	{
+		spec.width = spec.width * 10 + (*format - L'0');
+	}
+
+	if (*format == L'.')
+	{
+		spec.precision = 0;
+
+		for (format++; *format >= L'0' && *format <= L'9'; format++)
+		{
+			spec.precision = spec.precision * 10 + (*format - L'0');
+		}
+	}
+
+	switch (*format)
+	{
+	case L'x': case L'X': case L'f': case L'e': case L'g':
+		spec.type = *format++;
+		break;
+	}
+
+	return *format == L'}';
+}
+
+bool ff::details::FormatArgs(FormatOutput &out, const wchar_t *format, const FormatArg *args, size_t count)
+{
+	assertRetVal(format, false);
+
+	size_t index = 0;
+
+	for (const wchar_t *start = format; ; )
+	{
+		const wchar_t *cur = start;
+		while (*cur && *cur != L'{' && *cur != L'}')
+		{
+			cur++;
+		}
+
+		if (cur != start)
+		{
+			out.Append(start, cur - start);
+		}
+
+		if (!*cur)
+		{
+			break;
+		}
+
+		if (cur[0] == cur[1])
+		{
+			// {{ or }}
+			out.Append(cur, 1);
+			start = cur + 2;
+			continue;
+		}
+
+		assertRetVal(*cur == L'{', false);
+
+		FormatSpec spec = { 0, INVALID_SIZE, L'\0', L' ', false };
+		cur++;
+
+		if (*cur == L':')
+		{
+			cur++;
+			assertRetVal(::ParseFormatSpec(cur, spec), false);
+		}
+
+		assertRetVal(*cur == L'}' && index < count, false);
+
+		args[index].func(out, args[index].value, spec);
+		index++;
+		start = cur + 1;
+	}
+
+	assert(index == count);
+	return true;
+}
+
+ff::details::WriterFormatOutput::WriterFormatOutput(IDataWriter *writer)
+	: _writer(writer)
+	, _valid(writer != nullptr)
+{
+}
+
+void ff::details::WriterFormatOutput::Append(const wchar_t *chars, size_t count)
+{
+	if (_valid && count)
+	{
+		_valid = _writer->Write(chars, count * sizeof(wchar_t));
+	}
+}
@@ -0,0 +1,249 @@
+#pragma once
+
+namespace ff
+{
+	class IDataWriter;
+
+	/// Type-safe replacement for String::format and friends, using {} instead of printf codes.
+	///
+	/// Each {} is replaced by the next argument, whatever its type is. Inside the braces
+	/// there can be a spec after a colon: {:8} pads to 8 chars, {:08} pads with zeros,
+	/// {:<8} pads on the right, {:x} or {:X} is hex and {:.3} is the precision of a float.
+	/// Negative numbers keep their sign in hex, so {:x} of -255 is -ff. Hex floats are like printf's %a.
+	/// Floats without a precision or type get the shortest digits that read back the same (see FormatDouble).
+	/// Use {{ and }} for braces.
+	///
+	/// Use the FF_FORMAT macros with literal format strings, so that the braces are counted
+	/// at compile time and compared to the number of arguments.
+	///
+	/// Add support for other types with a FormatValue(FormatOutput &, const T &, const FormatSpec &)
+	/// overload in the same namespace as the type.
+	struct FormatSpec
+	{
+		size_t width;
+		size_t precision;
+		wchar_t type; // 0 for default, or x, X, f, e, g
+		wchar_t fill;
+		bool left;
+	};
+
+	class FormatOutput
+	{
+	public:
+		virtual void Append(const wchar_t *chars, size_t count) = 0;
+
+		// Appends a formatted value, padded to the width of the spec
+		UTIL_API void AppendValue(const wchar_t *chars, size_t count, const FormatSpec &spec);
+	};
+
+	UTIL_API void FormatValue(FormatOutput &out, int64_t value, const FormatSpec &spec);
+	UTIL_API void FormatValue(FormatOutput &out, uint64_t value, const FormatSpec &spec);
+	UTIL_API void FormatValue(FormatOutput &out, double value, const FormatSpec &spec);
+	UTIL_API void FormatValue(FormatOutput &out, float value, const FormatSpec &spec);
+	UTIL_API void FormatValue(FormatOutput &out, bool value, const FormatSpec &spec);
+	UTIL_API void FormatValue(FormatOutput &out, wchar_t value, const FormatSpec &spec);
+	UTIL_API void FormatValue(FormatOutput &out, const wchar_t *value, const FormatSpec &spec);
+	UTIL_API void FormatValue(FormatOutput &out, StringRef value, const FormatSpec &spec);
+	UTIL_API void FormatValue(FormatOutput &out, const void *value, const FormatSpec &spec);
+
+	inline void FormatValue(FormatOutput &out, wchar_t *value, const FormatSpec &spec)
+	{
+		FormatValue(out, static_cast<const wchar_t *>(value), spec);
+	}
+
+	template<typename T>
+	typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value>::type
+		FormatValue(FormatOutput &out, T value, const FormatSpec &spec)
+	{
+		FormatValue(out, static_cast<int64_t>(value), spec);
+	}
+
+	template<typename T>
+	typename std::enable_if<std::is_integral<T>::value && !std::is_signed<T>::value>::type
+		FormatValue(FormatOutput &out, T value, const FormatSpec &spec)
+	{
+		FormatValue(out, static_cast<uint64_t>(value), spec);
+	}
+
+	namespace details
+	{
+		struct FormatArg
+		{
+			const void *value;
+			void (*func)(FormatOutput &out, const void *value, const FormatSpec &spec);
+		};
+
+		template<typename T>
+		void FormatArgFunc(FormatOutput &out, const void *value, const FormatSpec &spec)
+		{
+			FormatValue(out, *static_cast<const T *>(value), spec);
+		}
+
+		template<typename T>
+		FormatArg MakeFormatArg(const T &value)
+		{
+			FormatArg arg = { &value, &FormatArgFunc<T> };
+			return arg;
+		}
+
+		// Arrays are string literals, so the arg points right at the chars
+		inline void FormatCharsArgFunc(FormatOutput &out, const void *value, const FormatSpec &spec)
+		{
+			FormatValue(out, static_cast<const wchar_t *>(value), spec);
+		}
+
+		template<size_t N>
+		FormatArg MakeFormatArg(const wchar_t (&value)[N])
+		{
+			FormatArg arg = { value, &FormatCharsArgFunc };
+			return arg;
+		}
+
+		template<size_t N>
+		FormatArg MakeFormatArg(wchar_t (&value)[N])
+		{
+			return MakeFormatArg(const_cast<const wchar_t (&)[N]>(value));
+		}
+
+		UTIL_API bool FormatArgs(FormatOutput &out, const wchar_t *format, const FormatArg *args, size_t count);
+
+		// Compile-time parsing, with one level of recursion per char (C++11 constexpr rules)
+		constexpr const wchar_t *SkipFormatSpec(const wchar_t *format)
+		{
+			return !*format ? nullptr
+				: (*format == L'{') ? nullptr
+				: (*format == L'}') ? format + 1
+				: SkipFormatSpec(format + 1);
+		}
+
+		constexpr size_t CountFormatArgs(const wchar_t *format, size_t count = 0)
+		{
+			return !format ? INVALID_SIZE
+				: !*format ? count
+				: (*format == L'{' && format[1] == L'{') ? CountFormatArgs(format + 2, count)
+				: (*format == L'}' && format[1] == L'}') ? CountFormatArgs(format + 2, count)
+				: (*format == L'{') ? CountFormatArgs(SkipFormatSpec(format + 1), count + 1)
+				: (*format == L'}') ? INVALID_SIZE
+				: CountFormatArgs(format + 1, count);
+		}
+
+		template<typename... Args>
+		bool FormatTo(FormatOutput &out, const wchar_t *format, const Args &... args)
+		{
+			// One extra, since arrays can't be empty
+			const FormatArg argArray[sizeof...(Args) + 1] = { MakeFormatArg(args)..., FormatArg() };
+			return FormatArgs(out, format, argArray, sizeof...(Args));
+		}
+
+		// Small pieces are collected on the stack, since each String append has to check for sharing and space
+		class StringFormatOutput : public FormatOutput
+		{
+		public:
+			StringFormatOutput(String &str) : _str(str), _size(0) { }
+			~StringFormatOutput() { Flush(); }
+
+			virtual void Append(const wchar_t *chars, size_t count) override
+			{
+				if (_size + count > _countof(_buffer))
+				{
+					Flush();
+
+					if (count > _countof(_buffer))
+					{
+						_str.append(chars, count);
+						return;
+					}
+				}
+
+				std::memcpy(_buffer + _size, chars, count * sizeof(wchar_t));
+				_size += count;
+			}
+
+			void Flush()
+			{
+				if (_size)
+				{
+					_str.append(_buffer, _size);
+					_size = 0;
+				}
+			}
+
+		private:
+			String &_str;
+			size_t _size;
+			wchar_t _buffer[128];
+		};
+
+		class WriterFormatOutput : public FormatOutput
+		{
+		public:
+			UTIL_API WriterFormatOutput(IDataWriter *writer);
+			UTIL_API virtual void Append(const wchar_t *chars, size_t count) override;
+			bool IsValid() const { return _valid; }
+
+		private:
+			IDataWriter *_writer;
+			bool _valid;
+		};
+	}
+
+	template<typename... Args>
+	bool FormatAppend(String &str, const wchar_t *format, const Args &... args)
+	{
+		details::StringFormatOutput out(str);
+		bool valid = details::FormatTo(out, format, args...);
+		out.Flush();
+
+		return valid;
+	}
+
+	template<typename... Args>
+	String Format(const wchar_t *format, const Args &... args)
+	{
+		String str;
+		FormatAppend(str, format, args...);
+		return str;
+	}
+
+	// Writes wide chars, like a Unicode text file
+	template<typename... Args>
+	bool FormatWrite(IDataWriter *writer, const wchar_t *format, const Args &... args)
+	{
+		details::WriterFormatOutput out(writer);
+		return details::FormatTo(out, format, args...) && out.IsValid();
+	}
+
+	namespace details
+	{
+		template<size_t ArgCount>
+		struct CheckedFormat
+		{
+			static_assert(ArgCount != INVALID_SIZE, "Format string has unmatched braces");
+
+			template<typename... Args>
+			static String Format(const wchar_t *format, const Args &... args)
+			{
+				static_assert(ArgCount == sizeof...(Args), "Format string doesn't match the number of arguments");
+				return ff::Format(format, args...);
+			}
+
+			template<typename... Args>
+			static bool Append(String &str, const wchar_t *format, const Args &... args)
+			{
+				static_assert(ArgCount == sizeof...(Args), "Format string doesn't match the number of arguments");
+				return ff::FormatAppend(str, format, args...);
+			}
+
+			template<typename... Args>
+			static bool Write(IDataWriter *writer, const wchar_t *format, const Args &... args)
+			{
+				static_assert(ArgCount == sizeof...(Args), "Format string doesn't match the number of arguments");
+				return ff::FormatWrite(writer, format, args...);
+			}
+		};
+	}
+}
+
+#define FF_FORMAT(format, ...) ff::details::CheckedFormat<ff::details::CountFormatArgs(format)>::Format(format, __VA_ARGS__)
+#define FF_FORMAT_APPEND(str, format, ...) ff::details::CheckedFormat<ff::details::CountFormatArgs(format)>::Append(str, format, __VA_ARGS__)
+#define FF_FORMAT_WRITE(writer, format, ...) ff::details::CheckedFormat<ff::details::CountFormatArgs(format)>::Write(writer, format, __VA_ARGS__)
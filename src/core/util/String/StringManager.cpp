@@ -1,6 +1,7 @@
 #include "pch.h"
 #include "App/Log.h"
 #include "String/StringManager.h"
+#include "Types/SlabAllocator.h"
 
 // #define TRACK_STRINGS
 #if defined(_DEBUG) && defined(TRACK_STRINGS)
@@ -8,9 +9,6 @@ static Vector<wchar_t *> s_allStrings;
 #endif
 
 ff::StringManager::StringManager()
-	: _numLargeStringAlloc(0)
-	, _curLargeStringAlloc(0)
-	, _maxLargeStringAlloc(0)
 {
 }
 
@@ -24,51 +22,12 @@ ff::StringManager::~StringManager()
 	}
 #endif
 
-	assert(_curLargeStringAlloc == 0);
-
 	DebugDump();
 }
 
 wchar_t *ff::StringManager::New(size_t count)
 {
-	wchar_t * str = nullptr;
-
-	if(count > 256)
-	{
-		// Need room before the actual string to store a null IPoolAllocator
-		BYTE *mem = new BYTE[sizeof(wchar_t) * count + sizeof(IPoolAllocator*)];
-		*reinterpret_cast<IPoolAllocator **>(mem) = nullptr;
-		str = reinterpret_cast<wchar_t *>(mem + sizeof(IPoolAllocator*));
-
-		LockMutex crit(_mutex);
-		_numLargeStringAlloc++;
-		_curLargeStringAlloc++;
-		_maxLargeStringAlloc = std::max(_curLargeStringAlloc, _maxLargeStringAlloc);
-	}
-	else if(count > 128)
-	{
-		auto mem = _pool_256.New();
-		mem->_pool = &_pool_256;
-		str = mem->_str.data();
-	}
-	else if(count > 64)
-	{
-		auto mem = _pool_128.New();
-		mem->_pool = &_pool_128;
-		str = mem->_str.data();
-	}
-	else if(count > 32)
-	{
-		auto mem = _pool_64.New();
-		mem->_pool = &_pool_64;
-		str = mem->_str.data();
-	}
-	else
-	{
-		auto mem = _pool_32.New();
-		mem->_pool = &_pool_32;
-		str = mem->_str.data();
-	}
+	wchar_t * str = reinterpret_cast<wchar_t *>(GetSlabAllocator().Alloc(sizeof(wchar_t) * count));
 
 #if defined(_DEBUG) && defined(TRACK_STRINGS)
 	s_allStrings.Push(str);
@@ -83,22 +42,7 @@ void ff::StringManager::Delete(wchar_t * str)
 	s_allStrings.Delete(s_allStrings.Find(str));
 #endif
 
-	IPoolAllocator **afterPool = reinterpret_cast<IPoolAllocator **>(str);
-	IPoolAllocator *pool = *(afterPool - 1);
-	BYTE *structStart = reinterpret_cast<BYTE *>(afterPool - 1);
-
-	if (pool == nullptr)
-	{
-		assert(_curLargeStringAlloc > 0);
-		delete[] structStart;
-
-		LockMutex lock(_mutex);
-		_curLargeStringAlloc--;
-	}
-	else
-	{
-		pool->DeleteVoid(structStart);
-	}
+	GetSlabAllocator().Free(str);
 }
 
 ff::StringManager::SharedStringVector *ff::StringManager::NewVector()
@@ -125,18 +69,10 @@ void ff::StringManager::DebugDump()
 {
 #ifdef _DEBUG
 	Log::DebugTraceF(L"- DUMPING STRING ALLOCATION STATS ---------------------\n");
-	Log::DebugTraceF(L"    Number of allocated  32  char strings: %d\n", _pool_32.GetTotalAlloc());
-	Log::DebugTraceF(L"    Maximum simultaneous 32  char strings: %d\n", _pool_32.GetMaxAlloc());
-	Log::DebugTraceF(L"    Number of allocated  64  char strings: %d\n", _pool_64.GetTotalAlloc());
-	Log::DebugTraceF(L"    Maximum simultaneous 64  char strings: %d\n", _pool_64.GetMaxAlloc());
-	Log::DebugTraceF(L"    Number of allocated  128 char strings: %d\n", _pool_128.GetTotalAlloc());
-	Log::DebugTraceF(L"    Maximum simultaneous 128 char strings: %d\n", _pool_128.GetMaxAlloc());
-	Log::DebugTraceF(L"    Number of allocated  256 char strings: %d\n", _pool_256.GetTotalAlloc());
-	Log::DebugTraceF(L"    Maximum simultaneous 256 char strings: %d\n", _pool_256.GetMaxAlloc());
-	Log::DebugTraceF(L"    Number of allocated  large strings:    %d\n", _numLargeStringAlloc);
-	Log::DebugTraceF(L"    Maximum simultaneous large strings:    %d\n", _maxLargeStringAlloc);
 	Log::DebugTraceF(L"    Number of allocated vectors:           %d\n", _vectorPool.GetTotalAlloc());
 	Log::DebugTraceF(L"    Maximum simultaneous vectors:          %d\n", _vectorPool.GetMaxAlloc());
 	Log::DebugTraceF(L"- completed string dumping ----------------------------\n\n");
+
+	GetSlabAllocator().DebugDump();
 #endif
 }
@@ -28,22 +28,7 @@ namespace ff
 	private:
 		void DebugDump();
 
-		template<size_t N>
-		struct Chars
-		{
-			IPoolAllocator *_pool;
-			std::array<wchar_t, N> _str;
-		};
-
-		Mutex _mutex;
-		long _numLargeStringAlloc;
-		long _curLargeStringAlloc;
-		long _maxLargeStringAlloc;
-
-		PoolAllocator<Chars<32>>  _pool_32;
-		PoolAllocator<Chars<64>>  _pool_64;
-		PoolAllocator<Chars<128>> _pool_128;
-		PoolAllocator<Chars<256>> _pool_256;
+		// String buffers come from the shared SlabAllocator
 		PoolAllocator<SharedStringVector> _vectorPool;
 	};
 }
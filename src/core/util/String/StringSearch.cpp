@@ -0,0 +1,443 @@
+#include "pch.h"
+#include "String/StringSearch.h"
+
+// The vector code compares 16-bit chars
+#if (defined(_M_IX86) || defined(_M_X64)) && WCHAR_MAX == 0xFFFF
+#define STRING_SEARCH_SIMD 1
+#include <immintrin.h>
+#else
+#define STRING_SEARCH_SIMD 0
+#endif
+
+// Sets bigger than this are searched with plain loops, since each char costs a compare
+static const size_t MAX_SIMD_SET = 16;
+
+static size_t PlainSearchChar(const wchar_t *text, size_t count, wchar_t ch)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		if (text[i] == ch)
+		{
+			return i;
+		}
+	}
+
+	return ff::INVALID_SIZE;
+}
+
+static size_t PlainSearchChars(const wchar_t *text, size_t count, const wchar_t *find, size_t findCount)
+{
+	if (!findCount)
+	{
+		return 0;
+	}
+
+	if (findCount <= count)
+	{
+		for (size_t i = 0, last = count - findCount; i <= last; i++)
+		{
+			if (text[i] == find[0] && !std::memcmp(text + i + 1, find + 1, (findCount - 1) * sizeof(wchar_t)))
+			{
+				return i;
+			}
+		}
+	}
+
+	return ff::INVALID_SIZE;
+}
+
+static size_t PlainSearchCharOf(const wchar_t *text, size_t count, const wchar_t *set, size_t setCount, bool match)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		size_t h = 0;
+		while (h < setCount && text[i] != set[h])
+		{
+			h++;
+		}
+
+		if ((h < setCount) == match)
+		{
+			return i;
+		}
+	}
+
+	return ff::INVALID_SIZE;
+}
+
+static void PlainReplaceChar(wchar_t *text, size_t count, wchar_t find, wchar_t replace)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		if (text[i] == find)
+		{
+			text[i] = replace;
+		}
+	}
+}
+
+static void PlainChangeCase(wchar_t *text, size_t count, bool upper, bool crt)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		wchar_t ch = text[i];
+
+		if (crt)
+		{
+			text[i] = static_cast<wchar_t>(upper ? toupper(ch) : tolower(ch));
+		}
+		else if (upper ? (ch >= L'a' && ch <= L'z') : (ch >= L'A' && ch <= L'Z'))
+		{
+			text[i] = static_cast<wchar_t>(upper ? ch - (L'a' - L'A') : ch + (L'a' - L'A'));
+		}
+	}
+}
+
+#if STRING_SEARCH_SIMD
+
+struct Sse2Chars
+{
+	typedef __m128i Vec;
+	static const size_t COUNT = 8;
+	static const unsigned int ALL = 0xFFFF;
+
+	static Vec Load(const wchar_t *text) { return _mm_loadu_si128(reinterpret_cast<const __m128i *>(text)); }
+	static void Store(wchar_t *text, Vec vec) { _mm_storeu_si128(reinterpret_cast<__m128i *>(text), vec); }
+	static Vec Set(wchar_t ch) { return _mm_set1_epi16(static_cast<short>(ch)); }
+	static Vec Equal(Vec a, Vec b) { return _mm_cmpeq_epi16(a, b); }
+	static Vec Greater(Vec a, Vec b) { return _mm_cmpgt_epi16(a, b); } // signed
+	static Vec And(Vec a, Vec b) { return _mm_and_si128(a, b); }
+	static Vec AndNot(Vec a, Vec b) { return _mm_andnot_si128(a, b); } // ~a & b
+	static Vec Or(Vec a, Vec b) { return _mm_or_si128(a, b); }
+	static Vec Add(Vec a, Vec b) { return _mm_add_epi16(a, b); }
+	static Vec Sub(Vec a, Vec b) { return _mm_sub_epi16(a, b); }
+	static unsigned int Mask(Vec vec) { return static_cast<unsigned int>(_mm_movemask_epi8(vec)); } // two bits per char
+};
+
+struct Avx2Chars
+{
+	typedef __m256i Vec;
+	static const size_t COUNT = 16;
+	static const unsigned int ALL = 0xFFFFFFFF;
+
+	static Vec Load(const wchar_t *text) { return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(text)); }
+	static void Store(wchar_t *text, Vec vec) { _mm256_storeu_si256(reinterpret_cast<__m256i *>(text), vec); }
+	static Vec Set(wchar_t ch) { return _mm256_set1_epi16(static_cast<short>(ch)); }
+	static Vec Equal(Vec a, Vec b) { return _mm256_cmpeq_epi16(a, b); }
+	static Vec Greater(Vec a, Vec b) { return _mm256_cmpgt_epi16(a, b); }
+	static Vec And(Vec a, Vec b) { return _mm256_and_si256(a, b); }
+	static Vec AndNot(Vec a, Vec b) { return _mm256_andnot_si256(a, b); }
+	static Vec Or(Vec a, Vec b) { return _mm256_or_si256(a, b); }
+	static Vec Add(Vec a, Vec b) { return _mm256_add_epi16(a, b); }
+	static Vec Sub(Vec a, Vec b) { return _mm256_sub_epi16(a, b); }
+	static unsigned int Mask(Vec vec) { return static_cast<unsigned int>(_mm256_movemask_epi8(vec)); }
+};
+
+static size_t FirstCharInMask(unsigned int mask)
+{
+	unsigned long bit;
+	_BitScanForward(&bit, mask);
+	return bit / 2;
+}
+
+template<typename Chars>
+static size_t SimdSearchChar(const wchar_t *text, size_t count, wchar_t ch)
+{
+	typename Chars::Vec find = Chars::Set(ch);
+	size_t i = 0;
+
+	for (; i + Chars::COUNT <= count; i += Chars::COUNT)
+	{
+		unsigned int mask = Chars::Mask(Chars::Equal(Chars::Load(text + i), find));
+		if (mask)
+		{
+			return i + FirstCharInMask(mask);
+		}
+	}
+
+	size_t found = PlainSearchChar(text + i, count - i, ch);
+	return (found != ff::INVALID_SIZE) ? i + found : ff::INVALID_SIZE;
+}
+
+// Only positions where both the first and last chars match get compared
+template<typename Chars>
+static size_t SimdSearchChars(const wchar_t *text, size_t count, const wchar_t *find, size_t findCount)
+{
+	if (findCount < 2 || findCount > count)
+	{
+		return PlainSearchChars(text, count, find, findCount);
+	}
+
+	typename Chars::Vec first = Chars::Set(find[0]);
+	typename Chars::Vec last = Chars::Set(find[findCount - 1]);
+	size_t starts = count - findCount + 1;
+	size_t i = 0;
+
+	for (; i + Chars::COUNT <= starts; i += Chars::COUNT)
+	{
+		unsigned int mask = Chars::Mask(Chars::And(
+			Chars::Equal(Chars::Load(text + i), first),
+			Chars::Equal(Chars::Load(text + i + findCount - 1), last)));
+
+		while (mask)
+		{
+			size_t pos = FirstCharInMask(mask);
+			if (!std::memcmp(text + i + pos + 1, find + 1, (findCount - 2) * sizeof(wchar_t)))
+			{
+				return i + pos;
+			}
+
+			mask &= ~(3u << (pos * 2));
+		}
+	}
+
+	size_t found = PlainSearchChars(text + i, count - i, find, findCount);
+	return (found != ff::INVALID_SIZE) ? i + found : ff::INVALID_SIZE;
+}
+
+template<typename Chars>
+static size_t SimdSearchCharOf(const wchar_t *text, size_t count, const wchar_t *set, size_t setCount, bool match)
+{
+	if (!setCount || setCount > MAX_SIMD_SET)
+	{
+		return PlainSearchCharOf(text, count, set, setCount, match);
+	}
+
+	typename Chars::Vec sets[MAX_SIMD_SET];
+	for (size_t h = 0; h < setCount; h++)
+	{
+		sets[h] = Chars::Set(set[h]);
+	}
+
+	size_t i = 0;
+	for (; i + Chars::COUNT <= count; i += Chars::COUNT)
+	{
+		typename Chars::Vec chars = Chars::Load(text + i);
+		typename Chars::Vec found = Chars::Equal(chars, sets[0]);
+
+		for (size_t h = 1; h < setCount; h++)
+		{
+			found = Chars::Or(found, Chars::Equal(chars, sets[h]));
+		}
+
+		unsigned int mask = match ? Chars::Mask(found) : (~Chars::Mask(found) & Chars::ALL);
+		if (mask)
+		{
+			return i + FirstCharInMask(mask);
+		}
+	}
+
+	size_t found = PlainSearchCharOf(text + i, count - i, set, setCount, match);
+	return (found != ff::INVALID_SIZE) ? i + found : ff::INVALID_SIZE;
+}
+
+template<typename Chars>
+static void SimdReplaceChar(wchar_t *text, size_t count, wchar_t find, wchar_t replace)
+{
+	typename Chars::Vec findVec = Chars::Set(find);
+	typename Chars::Vec replaceVec = Chars::Set(replace);
+	size_t i = 0;
+
+	for (; i + Chars::COUNT <= count; i += Chars::COUNT)
+	{
+		typename Chars::Vec chars = Chars::Load(text + i);
+		typename Chars::Vec found = Chars::Equal(chars, findVec);
+
+		// Most text doesn't change, so don't write it back
+		if (Chars::Mask(found))
+		{
+			Chars::Store(text + i, Chars::Or(Chars::And(found, replaceVec), Chars::AndNot(found, chars)));
+		}
+	}
+
+	PlainReplaceChar(text + i, count - i, find, replace);
+}
+
+// Runs of ASCII get changed with vectors, the CRT only needs to see the rest
+template<typename Chars>
+static void SimdChangeCase(wchar_t *text, size_t count, bool upper, bool crt)
+{
+	typename Chars::Vec after = Chars::Set(upper ? L'a' - 1 : L'A' - 1);
+	typename Chars::Vec before = Chars::Set(upper ? L'z' + 1 : L'Z' + 1);
+	typename Chars::Vec diff = Chars::Set(L'a' - L'A');
+	typename Chars::Vec nonAscii = Chars::Set(static_cast<wchar_t>(0xFF80));
+	typename Chars::Vec zero = Chars::Set(0);
+	size_t i = 0;
+
+	for (; i + Chars::COUNT <= count; i += Chars::COUNT)
+	{
+		typename Chars::Vec chars = Chars::Load(text + i);
+
+		if (crt && Chars::Mask(Chars::Equal(Chars::And(chars, nonAscii), zero)) != Chars::ALL)
+		{
+			PlainChangeCase(text + i, Chars::COUNT, upper, crt);
+			continue;
+		}
+
+		// Chars above 0x7FFF are negative, so they aren't in range either
+		typename Chars::Vec inRange = Chars::And(Chars::Greater(chars, after), Chars::Greater(before, chars));
+		if (Chars::Mask(inRange))
+		{
+			typename Chars::Vec change = Chars::And(inRange, diff);
+			Chars::Store(text + i, upper ? Chars::Sub(chars, change) : Chars::Add(chars, change));
+		}
+	}
+
+	PlainChangeCase(text + i, count - i, upper, crt);
+}
+
+static ff::SimdLevel GetCpuSimdLevel()
+{
+	int info[4];
+	__cpuid(info, 0);
+	int maxLeaf = info[0];
+
+	__cpuid(info, 1);
+	bool sse2 = (info[3] & (1 << 26)) != 0;
+	bool avx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6; // OSXSAVE, AVX, OS saves YMM
+
+	bool avx2 = false;
+	if (avx && maxLeaf >= 7)
+	{
+		__cpuidex(info, 7, 0);
+		avx2 = (info[1] & (1 << 5)) != 0;
+	}
+
+	return avx2 ? ff::SimdLevel::Avx2 : (sse2 ? ff::SimdLevel::Sse2 : ff::SimdLevel::None);
+}
+
+#else
+
+static ff::SimdLevel GetCpuSimdLevel()
+{
+	return ff::SimdLevel::None;
+}
+
+#endif
+
+struct StringSearchFuncs
+{
+	size_t (*searchChar)(const wchar_t *text, size_t count, wchar_t ch);
+	size_t (*searchChars)(const wchar_t *text, size_t count, const wchar_t *find, size_t findCount);
+	size_t (*searchCharOf)(const wchar_t *text, size_t count, const wchar_t *set, size_t setCount, bool match);
+	void (*replaceChar)(wchar_t *text, size_t count, wchar_t find, wchar_t replace);
+	void (*changeCase)(wchar_t *text, size_t count, bool upper, bool crt);
+};
+
+// STATIC_DATA (pod)
+static const StringSearchFuncs s_plainFuncs =
+{
+	PlainSearchChar,
+	PlainSearchChars,
+	PlainSearchCharOf,
+	PlainReplaceChar,
+	PlainChangeCase,
+};
+
+#if STRING_SEARCH_SIMD
+// STATIC_DATA (pod)
+static const StringSearchFuncs s_sse2Funcs =
+{
+	SimdSearchChar<Sse2Chars>,
+	SimdSearchChars<Sse2Chars>,
+	SimdSearchCharOf<Sse2Chars>,
+	SimdReplaceChar<Sse2Chars>,
+	SimdChangeCase<Sse2Chars>,
+};
+
+// STATIC_DATA (pod)
+static const StringSearchFuncs s_avx2Funcs =
+{
+	SimdSearchChar<Avx2Chars>,
+	SimdSearchChars<Avx2Chars>,
+	SimdSearchCharOf<Avx2Chars>,
+	SimdReplaceChar<Avx2Chars>,
+	SimdChangeCase<Avx2Chars>,
+};
+#endif
+
+// STATIC_DATA (pod)
+static ff::SimdLevel s_cpuSimdLevel;
+static ff::SimdLevel s_simdLevel;
+static const StringSearchFuncs *s_funcs = nullptr;
+
+static void SetSimdFuncs(ff::SimdLevel level)
+{
+	s_simdLevel = level;
+
+	switch (level)
+	{
+#if STRING_SEARCH_SIMD
+	case ff::SimdLevel::Avx2:
+		s_funcs = &s_avx2Funcs;
+		break;
+
+	case ff::SimdLevel::Sse2:
+		s_funcs = &s_sse2Funcs;
+		break;
+#endif
+
+	default:
+		s_funcs = &s_plainFuncs;
+		break;
+	}
+}
+
+// Every thread finds the same answer, so it doesn't matter which one gets here first
+static const StringSearchFuncs &GetFuncs()
+{
+	if (!s_funcs)
+	{
+		s_cpuSimdLevel = GetCpuSimdLevel();
+		SetSimdFuncs(s_cpuSimdLevel);
+	}
+
+	return *s_funcs;
+}
+
+ff::SimdLevel ff::GetSimdLevel()
+{
+	GetFuncs();
+	return s_simdLevel;
+}
+
+void ff::SetSimdLevel(SimdLevel level)
+{
+	GetFuncs();
+	SetSimdFuncs(std::min(level, s_cpuSimdLevel));
+}
+
+size_t ff::SearchChar(const wchar_t *text, size_t count, wchar_t ch)
+{
+	return GetFuncs().searchChar(text, count, ch);
+}
+
+size_t ff::SearchChars(const wchar_t *text, size_t count, const wchar_t *find, size_t findCount)
+{
+	return GetFuncs().searchChars(text, count, find, findCount);
+}
+
+size_t ff::SearchCharOf(const wchar_t *text, size_t count, const wchar_t *set, size_t setCount)
+{
+	return GetFuncs().searchCharOf(text, count, set, setCount, true);
+}
+
+size_t ff::SearchCharNotOf(const wchar_t *text, size_t count, const wchar_t *set, size_t setCount)
+{
+	return GetFuncs().searchCharOf(text, count, set, setCount, false);
+}
+
+void ff::ReplaceChar(wchar_t *text, size_t count, wchar_t find, wchar_t replace)
+{
+	GetFuncs().replaceChar(text, count, find, replace);
+}
+
+void ff::ChangeCaseAscii(wchar_t *text, size_t count, bool upper)
+{
+	GetFuncs().changeCase(text, count, upper, false);
+}
+
+void ff::ChangeCaseCrt(wchar_t *text, size_t count, bool upper)
+{
+	GetFuncs().changeCase(text, count, upper, true);
+}
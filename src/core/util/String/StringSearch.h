@@ -0,0 +1,28 @@
+#pragma once
+
+namespace ff
+{
+	/// Vectorized loops over wide chars, used by String and StringUtil for big text blobs.
+	///
+	/// Each one uses AVX2 or SSE2 when the CPU has it (checked once, the first time any of
+	/// them is called), or plain loops otherwise. Results are always the same as the plain
+	/// loops. All of them return INVALID_SIZE when nothing is found.
+	enum class SimdLevel
+	{
+		None,
+		Sse2,
+		Avx2,
+	};
+
+	UTIL_API SimdLevel GetSimdLevel();
+	UTIL_API void SetSimdLevel(SimdLevel level); // for tests and benchmarks, can't go above what the CPU has
+
+	UTIL_API size_t SearchChar(const wchar_t *text, size_t count, wchar_t ch);
+	UTIL_API size_t SearchChars(const wchar_t *text, size_t count, const wchar_t *find, size_t findCount);
+	UTIL_API size_t SearchCharOf(const wchar_t *text, size_t count, const wchar_t *set, size_t setCount);
+	UTIL_API size_t SearchCharNotOf(const wchar_t *text, size_t count, const wchar_t *set, size_t setCount);
+
+	UTIL_API void ReplaceChar(wchar_t *text, size_t count, wchar_t find, wchar_t replace);
+	UTIL_API void ChangeCaseAscii(wchar_t *text, size_t count, bool upper); // only A-Z and a-z change
+	UTIL_API void ChangeCaseCrt(wchar_t *text, size_t count, bool upper); // same as tolower/toupper on each char
+}
@@ -1,6 +1,8 @@
 #include "pch.h"
 #include "Globals/ProcessGlobals.h"
 #include "Module/Module.h"
+#include "String/StringConvert.h"
+#include "String/StringSearch.h"
 #include "String/StringUtil.h"
 #include "Windows/FileUtil.h"
 
@@ -54,21 +56,27 @@ BSTR ff::LoadBSTR(HINSTANCE hInstance, UINT nID)
 ff::String &ff::ReplaceAll(String &szText, StringRef szFind, StringRef szReplace)
 {
 	size_t pos = szText.find(szFind);
-	size_t len = szFind.size();
-	size_t newLen = szReplace.size();
 
-	while (pos != INVALID_SIZE)
+	if (pos != INVALID_SIZE)
 	{
-		szText.replace(pos, len, szReplace);
+		// Build the new text in one pass, instead of moving the tail after each replace
+		String newText;
+		newText.reserve(szText.size());
 
-		if (pos + newLen < szText.size())
+		for (size_t start = 0; ; pos = szText.find(szFind, start))
 		{
-			pos = szText.find(szFind, pos + newLen);
-		}
-		else
-		{
-			pos = INVALID_SIZE;
+			if (pos == INVALID_SIZE)
+			{
+				newText.append(szText, start);
+				break;
+			}
+
+			newText.append(szText, start, pos - start);
+			newText.append(szReplace);
+			start = pos + szFind.size();
 		}
+
+		szText = std::move(newText);
 	}
 
 	return szText;
@@ -76,12 +84,11 @@ ff::String &ff::ReplaceAll(String &szText, StringRef szFind, StringRef szReplace
 
 ff::String &ff::ReplaceAll(String &szText, wchar_t chFind, wchar_t chReplace)
 {
-	for (auto ch = szText.begin(); ch != szText.end(); ch++)
+	size_t pos = szText.find(chFind);
+
+	if (pos != INVALID_SIZE)
 	{
-		if (*ch == chFind)
-		{
-			*ch = chReplace;
-		}
+		ReplaceChar(&szText[pos], szText.size() - pos, chFind, chReplace);
 	}
 
 	return szText;
@@ -90,24 +97,38 @@ ff::String &ff::ReplaceAll(String &szText, wchar_t chFind, wchar_t chReplace)
 ff::String &ff::StripSpaces(String &szText, bool bStart, bool bEnd)
 {
 	const wchar_t *szSpaces = L" \t\r\n";
-	size_t nFirstNonSpace = szText.find_first_not_of(szSpaces);
+	const wchar_t *chars = szText.c_str();
+	size_t size = szText.size();
 
-	if (nFirstNonSpace != INVALID_SIZE && nFirstNonSpace)
+	// The vectorized search also finds out if it's all spaces, without looking at the end
+	size_t start = SearchCharNotOf(chars, size, szSpaces, 4);
+
+	if (start == INVALID_SIZE)
 	{
-		szText.erase(0, nFirstNonSpace);
+		if (bStart || bEnd)
+		{
+			szText.clear();
+		}
+
+		return szText;
 	}
 
-	size_t nLastNonSpace = szText.find_last_not_of(szSpaces);
+	// Trailing spaces are usually just a line break, too few for vectors to help
+	size_t end = size;
+
+	while (bEnd && end > start && wcschr(szSpaces, chars[end - 1]))
+	{
+		end--;
+	}
 
-	if (nLastNonSpace != INVALID_SIZE && nLastNonSpace + 1 < szText.size())
+	if (end < size)
 	{
-		szText.erase(nLastNonSpace + 1);
+		szText.erase(end);
 	}
 
-	if (szText.size() && wcschr(szSpaces, szText[0]))
+	if (bStart && start)
 	{
-		// it was all spaces
-		szText.clear();
+		szText.erase(0, start);
 	}
 
 	return szText;
@@ -117,15 +138,18 @@ ff::Vector<ff::String> ff::SplitString(StringRef text, StringRef splitChars, boo
 {
 	Vector<String> split;
 
-	const wchar_t *cur = text.c_str();
-	for (const wchar_t *start = cur; *cur; cur = *cur ? cur + 1 : cur, start = cur)
+	const wchar_t *chars = text.c_str();
+	for (size_t start = 0, size = text.size(); start < size; )
 	{
-		cur += wcscspn(cur, splitChars.c_str());
+		size_t found = SearchCharOf(chars + start, size - start, splitChars.c_str(), splitChars.size());
+		size_t end = (found != INVALID_SIZE) ? start + found : size;
 
-		if (cur > start || (*cur && bKeepEmpty))
+		if (end > start || (end < size && bKeepEmpty))
 		{
-			split.Push(String(start, cur));
+			split.Push(String(chars + start, chars + end));
 		}
+
+		start = end + 1;
 	}
 
 	return split;
@@ -162,28 +186,25 @@ ff::String ff::CanonicalizeString(StringRef text)
 
 void ff::CanonicalizeStringInPlace(String &text)
 {
-	for (auto ch = text.begin(); ch != text.end(); ch++)
+	if (!text.empty())
 	{
-		if (*ch >= 'A' && *ch <= 'Z')
-		{
-			*ch += 'a' - 'A';
-		}
+		ChangeCaseAscii(&text[0], text.size(), false);
 	}
 }
 
 void ff::LowerCaseInPlace(String &text)
 {
-	for (auto ch = text.begin(); ch != text.end(); ch++)
+	if (!text.empty())
 	{
-		*ch = tolower(*ch);
+		ChangeCaseCrt(&text[0], text.size(), false);
 	}
 }
 
 void ff::UpperCaseInPlace(String &text)
 {
-	for (auto ch = text.begin(); ch != text.end(); ch++)
+	if (!text.empty())
 	{
-		*ch = toupper(*ch);
+		ChangeCaseCrt(&text[0], text.size(), true);
 	}
 }
 
@@ -202,28 +223,42 @@ ff::String ff::StringFromACP(const char *text, size_t len)
 		return tstr;
 	}
 
-	int bytes = (len == INVALID_SIZE) ? (int)strlen(text) : (int)len;
-	tstr.resize(MultiByteToWideChar(CP_ACP, 0, text, bytes, nullptr, 0));
-	MultiByteToWideChar(CP_ACP, 0, text, bytes, &tstr[0], (int)tstr.size());
+	size_t bytes = (len == INVALID_SIZE) ? strlen(text) : len;
+	tstr.resize(bytes);
+
+	// Every code page starts with ASCII, and DBCS lead bytes are never ASCII
+	size_t ascii = WidenAscii(text, bytes, &tstr[0]);
+	if (ascii < bytes)
+	{
+		int count = MultiByteToWideChar(CP_ACP, 0, text + ascii, (int)(bytes - ascii), nullptr, 0);
+		tstr.resize(ascii + count);
+		MultiByteToWideChar(CP_ACP, 0, text + ascii, (int)(bytes - ascii), &tstr[ascii], count);
+	}
 
 	return tstr;
 }
 
 ff::String ff::StringFromUTF8(const char *text, size_t len)
 {
+	String tstr;
+
 	if (!text || !*text || !len)
 	{
-		return String();
+		return tstr;
 	}
 
-	int bytes = (len == INVALID_SIZE) ? (int)strlen(text) : (int)len;
-
-	Vector<wchar_t> wbuf;
-	wbuf.Resize(MultiByteToWideChar(CP_UTF8, 0, text, bytes, nullptr, 0) + 1);
+	size_t bytes = (len == INVALID_SIZE) ? strlen(text) : len;
+	tstr.resize(bytes);
+	tstr.resize(Utf8ToUtf16(text, bytes, &tstr[0]));
 
-	MultiByteToWideChar(CP_UTF8, 0, text, bytes, &wbuf[0], (int)wbuf.Size());
+	return tstr;
+}
 
-	return String(wbuf.Data());
+ff::String ff::StringFromUTF8(IDataReader *reader, size_t len)
+{
+	String tstr;
+	assertRetVal(ReadUtf8(reader, len, tstr), String());
+	return tstr;
 }
 
 BSTR ff::StringToBSTR(StringRef text)
@@ -233,10 +268,23 @@ BSTR ff::StringToBSTR(StringRef text)
 
 ff::Vector<char> ff::StringToACP(StringRef text)
 {
-	int len = (int)text.size();
 	Vector<char> acpText;
-	acpText.Resize(WideCharToMultiByte(CP_ACP, 0, text.c_str(), len, nullptr, 0, nullptr, nullptr));
-	WideCharToMultiByte(CP_ACP, 0, text.c_str(), len, acpText.Data(), (int)acpText.Size(), nullptr, nullptr);
+	if (text.empty())
+	{
+		return acpText;
+	}
+
+	acpText.Resize(text.size());
+
+	size_t ascii = NarrowAscii(text.c_str(), text.size(), acpText.Data());
+	if (ascii < text.size())
+	{
+		int len = (int)(text.size() - ascii);
+		int count = WideCharToMultiByte(CP_ACP, 0, text.c_str() + ascii, len, nullptr, 0, nullptr, nullptr);
+		acpText.Resize(ascii + count);
+		WideCharToMultiByte(CP_ACP, 0, text.c_str() + ascii, len, acpText.Data() + ascii, count, nullptr, nullptr);
+	}
+
 	return acpText;
 }
 
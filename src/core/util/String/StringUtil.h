@@ -2,6 +2,8 @@
 
 namespace ff
 {
+	class IDataReader;
+
 	UTIL_API String LoadString(HINSTANCE hInstance, UINT nID); // from resource
 	UTIL_API BSTR LoadBSTR(HINSTANCE hInstance, UINT nID); // never returns nullptr
 
@@ -21,6 +23,7 @@ namespace ff
 	UTIL_API String StringFromBSTR(BSTR szText);
 	UTIL_API String StringFromACP(const char *text, size_t len = INVALID_SIZE);
 	UTIL_API String StringFromUTF8(const char *text, size_t len = INVALID_SIZE);
+	UTIL_API String StringFromUTF8(IDataReader *reader, size_t len = INVALID_SIZE); // reads from the current pos
 	UTIL_API BSTR StringToBSTR(StringRef text);
 	UTIL_API Vector<char> StringToACP(StringRef text);
 
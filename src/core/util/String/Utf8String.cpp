@@ -0,0 +1,625 @@
+#include "pch.h"
+#include "Data/Data.h"
+#include "String/StringConvert.h"
+#include "String/Utf8String.h"
+
+namespace ff
+{
+	namespace details
+	{
+		struct Utf8Buffer
+		{
+			Vector<char, 64> _chars; // always ends with a null
+			ComPtr<IData> _data; // when _chars is static data inside of it
+		};
+	}
+}
+
+ff::Utf8String::Utf8String()
+{
+	set_small_size(0);
+}
+
+ff::Utf8String::Utf8String(const Utf8String &rhs)
+{
+	std::memcpy(_small, rhs._small, sizeof(_small));
+
+	if (!is_small())
+	{
+		_str->AddRef();
+	}
+}
+
+ff::Utf8String::Utf8String(Utf8String &&rhs)
+{
+	std::memcpy(_small, rhs._small, sizeof(_small));
+	rhs.set_small_size(0);
+}
+
+ff::Utf8String::Utf8String(const char *rhs, size_t count)
+{
+	set_small_size(0);
+	assign(rhs, count);
+}
+
+ff::Utf8String::Utf8String(StringRef rhs)
+{
+	set_small_size(0);
+
+	if (rhs.size())
+	{
+		char *data = make_space(0, 0, rhs.size() * 3);
+		resize(Utf16ToUtf8(rhs.c_str(), rhs.size(), data));
+	}
+}
+
+ff::Utf8String::Utf8String(size_t count, char ch)
+{
+	set_small_size(0);
+	append(count, ch);
+}
+
+ff::Utf8String::~Utf8String()
+{
+	if (!is_small())
+	{
+		_str->Release();
+	}
+}
+
+ff::Utf8String ff::Utf8String::FromData(IData *data, size_t pos, size_t count)
+{
+	Utf8String ret;
+	assertRetVal(data && pos <= data->GetSize(), ret);
+
+	size_t dataSize = data->GetSize();
+	const char *chars = reinterpret_cast<const char *>(data->GetMem()) + pos;
+
+	if (count == INVALID_SIZE || pos + count > dataSize)
+	{
+		count = dataSize - pos;
+
+		if (count && !chars[count - 1])
+		{
+			// Text files loaded into memory might already have their own null
+			count--;
+		}
+	}
+
+	if (count >= SMALL_SIZE && pos + count < dataSize && !chars[count])
+	{
+		SharedUtf8Buffer *str = nullptr;
+		SharedUtf8Buffer::GetUnshared(&str);
+		str->_chars.SetStaticData(chars, count + 1);
+		str->_data = data;
+		ret.set_long(str);
+	}
+	else
+	{
+		ret.assign(chars, count);
+	}
+
+	return ret;
+}
+
+ff::String ff::Utf8String::ToWide() const
+{
+	String wide;
+
+	if (size())
+	{
+		wide.resize(size());
+		wide.resize(Utf8ToUtf16(data(), size(), &wide[0]));
+	}
+
+	return wide;
+}
+
+ff::Utf8String &ff::Utf8String::operator=(const Utf8String &rhs)
+{
+	return assign(rhs);
+}
+
+ff::Utf8String &ff::Utf8String::operator=(Utf8String &&rhs)
+{
+	if (this != &rhs)
+	{
+		clear();
+		swap(rhs);
+	}
+
+	return *this;
+}
+
+ff::Utf8String &ff::Utf8String::operator=(const char *rhs)
+{
+	return assign(rhs);
+}
+
+ff::Utf8String ff::Utf8String::operator+(const Utf8String &rhs) const
+{
+	Utf8String ret = *this;
+	ret.append(rhs);
+	return ret;
+}
+
+ff::Utf8String ff::Utf8String::operator+(const char *rhs) const
+{
+	Utf8String ret = *this;
+	ret.append(rhs);
+	return ret;
+}
+
+ff::Utf8String &ff::Utf8String::operator+=(const Utf8String &rhs)
+{
+	return append(rhs);
+}
+
+ff::Utf8String &ff::Utf8String::operator+=(const char *rhs)
+{
+	return append(rhs);
+}
+
+ff::Utf8String &ff::Utf8String::operator+=(char ch)
+{
+	return append(1, ch);
+}
+
+bool ff::Utf8String::operator==(const Utf8String &rhs) const
+{
+	return size() == rhs.size() && !std::memcmp(c_str(), rhs.c_str(), size());
+}
+
+bool ff::Utf8String::operator==(const char *rhs) const
+{
+	return !compare(rhs);
+}
+
+bool ff::Utf8String::operator!=(const Utf8String &rhs) const
+{
+	return !(*this == rhs);
+}
+
+bool ff::Utf8String::operator!=(const char *rhs) const
+{
+	return !(*this == rhs);
+}
+
+bool ff::Utf8String::operator<(const Utf8String &rhs) const
+{
+	return compare(rhs) < 0;
+}
+
+ff::Utf8String &ff::Utf8String::assign(const Utf8String &rhs, size_t pos, size_t count)
+{
+	if (count == INVALID_SIZE || pos + count > rhs.size())
+	{
+		count = rhs.size() - pos;
+	}
+
+	if (pos == 0 && count == rhs.size())
+	{
+		if (this != &rhs)
+		{
+			Utf8String copy(rhs);
+			swap(copy);
+		}
+
+		return *this;
+	}
+
+	return replace(0, size(), rhs.c_str() + pos, count);
+}
+
+ff::Utf8String &ff::Utf8String::assign(const char *rhs, size_t count)
+{
+	return replace(0, size(), rhs, count);
+}
+
+ff::Utf8String &ff::Utf8String::append(const Utf8String &rhs, size_t pos, size_t count)
+{
+	if (count == INVALID_SIZE || pos + count > rhs.size())
+	{
+		count = rhs.size() - pos;
+	}
+
+	if (empty() && pos == 0 && count == rhs.size())
+	{
+		return assign(rhs);
+	}
+
+	return replace(size(), 0, rhs.c_str() + pos, count);
+}
+
+ff::Utf8String &ff::Utf8String::append(const char *rhs, size_t count)
+{
+	return replace(size(), 0, rhs, count);
+}
+
+ff::Utf8String &ff::Utf8String::append(size_t count, char ch)
+{
+	if (count > 0)
+	{
+		size_t pos = size();
+		char *data = make_space(pos, 0, count);
+		std::memset(data + pos, ch, count);
+	}
+
+	return *this;
+}
+
+ff::Utf8String &ff::Utf8String::insert(size_t pos, const char *rhs, size_t count)
+{
+	return replace(pos, 0, rhs, count);
+}
+
+ff::Utf8String &ff::Utf8String::erase(size_t pos, size_t count)
+{
+	return replace(pos, count, "", 0);
+}
+
+ff::Utf8String &ff::Utf8String::replace(size_t pos, size_t count, const char *rhs, size_t rhs_count)
+{
+	assert(pos <= size());
+
+	if (rhs == nullptr)
+	{
+		rhs = "";
+	}
+
+	if (rhs_count == INVALID_SIZE)
+	{
+		rhs_count = std::strlen(rhs);
+	}
+
+	if (rhs_count > 0 && rhs < c_str() + size() && rhs + rhs_count > c_str())
+	{
+		// copying chars from INSIDE this string
+		Utf8String copy(rhs, rhs_count);
+		return replace(pos, count, copy.c_str(), rhs_count);
+	}
+
+	if (count == INVALID_SIZE || pos + count > size())
+	{
+		count = size() - pos;
+	}
+
+	if (pos == 0 && count == size())
+	{
+		// special case when the whole string is replaced, no need to clone the storage
+		clear();
+		count = 0;
+	}
+
+	if (count > 0 || rhs_count > 0)
+	{
+		char *data = make_space(pos, count, rhs_count);
+		std::memcpy(data + pos, rhs, rhs_count);
+	}
+
+	return *this;
+}
+
+void ff::Utf8String::push_back(char ch)
+{
+	append(1, ch);
+}
+
+void ff::Utf8String::pop_back()
+{
+	assertRet(!empty());
+	erase(size() - 1, 1);
+}
+
+const char *ff::Utf8String::begin() const
+{
+	return c_str();
+}
+
+const char *ff::Utf8String::end() const
+{
+	return c_str() + size();
+}
+
+char &ff::Utf8String::front()
+{
+	return editable_data()[0];
+}
+
+const char &ff::Utf8String::front() const
+{
+	return c_str()[0];
+}
+
+char &ff::Utf8String::back()
+{
+	assert(!empty());
+	return editable_data()[size() - 1];
+}
+
+const char &ff::Utf8String::back() const
+{
+	assert(!empty());
+	return c_str()[size() - 1];
+}
+
+char &ff::Utf8String::at(size_t pos)
+{
+	assert(pos <= size());
+	return editable_data()[pos];
+}
+
+const char &ff::Utf8String::at(size_t pos) const
+{
+	assert(pos <= size());
+	return c_str()[pos];
+}
+
+char &ff::Utf8String::operator[](size_t pos)
+{
+	return at(pos);
+}
+
+const char &ff::Utf8String::operator[](size_t pos) const
+{
+	return at(pos);
+}
+
+const char *ff::Utf8String::c_str() const
+{
+	return is_small() ? _small : _str->_chars.ConstData();
+}
+
+const char *ff::Utf8String::data() const
+{
+	return c_str();
+}
+
+size_t ff::Utf8String::length() const
+{
+	return size();
+}
+
+size_t ff::Utf8String::size() const
+{
+	return is_small()
+		? SMALL_SIZE - 1 - static_cast<BYTE>(_small[SMALL_SIZE - 1])
+		: _str->_chars.Size() - 1;
+}
+
+bool ff::Utf8String::empty() const
+{
+	return !size();
+}
+
+size_t ff::Utf8String::capacity() const
+{
+	// Shared file data has nothing allocated, but can still hold its own size
+	return is_small() ? SMALL_SIZE - 1 : std::max(_str->_chars.Allocated(), _str->_chars.Size()) - 1;
+}
+
+void ff::Utf8String::clear()
+{
+	if (!is_small())
+	{
+		_str->Release();
+	}
+
+	set_small_size(0);
+}
+
+void ff::Utf8String::resize(size_t count, char ch)
+{
+	if (count > size())
+	{
+		append(count - size(), ch);
+	}
+	else if (count < size())
+	{
+		erase(count);
+	}
+}
+
+void ff::Utf8String::reserve(size_t alloc)
+{
+	if (alloc >= SMALL_SIZE)
+	{
+		make_long();
+		make_editable();
+		_str->_chars.Reserve(alloc + 1);
+	}
+}
+
+void ff::Utf8String::swap(Utf8String &rhs)
+{
+	std::swap(_small, rhs._small);
+}
+
+ff::Utf8String ff::Utf8String::substr(size_t pos, size_t count) const
+{
+	Utf8String ret;
+	ret.assign(*this, pos, count);
+	return ret;
+}
+
+size_t ff::Utf8String::find(const Utf8String &rhs, size_t pos) const
+{
+	return find(rhs.c_str(), pos, rhs.size());
+}
+
+size_t ff::Utf8String::find(const char *rhs, size_t pos, size_t count) const
+{
+	if (count == INVALID_SIZE)
+	{
+		count = std::strlen(rhs);
+	}
+
+	if (!count)
+	{
+		return (pos <= size()) ? pos : npos;
+	}
+
+	const char *chars = c_str();
+	for (size_t last = size(); pos + count <= last; pos++)
+	{
+		// memchr skips ahead to the first byte quickly, then compare the rest
+		const char *found = static_cast<const char *>(std::memchr(chars + pos, rhs[0], last - count - pos + 1));
+		if (!found)
+		{
+			break;
+		}
+
+		pos = found - chars;
+		if (!std::memcmp(found, rhs, count))
+		{
+			return pos;
+		}
+	}
+
+	return npos;
+}
+
+size_t ff::Utf8String::find(char ch, size_t pos) const
+{
+	if (pos < size())
+	{
+		const char *found = static_cast<const char *>(std::memchr(c_str() + pos, ch, size() - pos));
+		if (found)
+		{
+			return found - c_str();
+		}
+	}
+
+	return npos;
+}
+
+size_t ff::Utf8String::rfind(char ch, size_t pos) const
+{
+	if (!empty())
+	{
+		const char *chars = c_str();
+
+		for (pos = std::min(pos, size() - 1) + 1; pos > 0; pos--)
+		{
+			if (chars[pos - 1] == ch)
+			{
+				return pos - 1;
+			}
+		}
+	}
+
+	return npos;
+}
+
+int ff::Utf8String::compare(const Utf8String &rhs) const
+{
+	return compare(rhs.c_str(), rhs.size());
+}
+
+int ff::Utf8String::compare(const char *rhs, size_t rhs_count) const
+{
+	if (rhs_count == INVALID_SIZE)
+	{
+		rhs_count = std::strlen(rhs);
+	}
+
+	int diff = std::memcmp(c_str(), rhs, std::min(size(), rhs_count));
+	if (diff != 0)
+	{
+		return diff;
+	}
+
+	return (size() < rhs_count) ? -1 : ((size() > rhs_count) ? 1 : 0);
+}
+
+bool ff::Utf8String::is_small() const
+{
+	return _small[SMALL_SIZE - 1] != LONG_TAG;
+}
+
+void ff::Utf8String::set_small_size(size_t size)
+{
+	assert(size < SMALL_SIZE);
+	_small[size] = '\0';
+	_small[SMALL_SIZE - 1] = static_cast<char>(SMALL_SIZE - 1 - size);
+}
+
+void ff::Utf8String::set_long(SharedUtf8Buffer *str)
+{
+	_str = str;
+	_small[SMALL_SIZE - 1] = LONG_TAG;
+}
+
+void ff::Utf8String::make_long()
+{
+	if (is_small())
+	{
+		SharedUtf8Buffer *str = nullptr;
+		SharedUtf8Buffer::GetUnshared(&str);
+		str->_chars.Push(_small, size() + 1);
+		set_long(str);
+	}
+}
+
+void ff::Utf8String::make_editable()
+{
+	if (!is_small() && (_str->IsShared() || _str->_data))
+	{
+		// Shared file data is read-only, so it gets copied out just like a shared buffer
+		SharedUtf8Buffer *str = nullptr;
+		SharedUtf8Buffer::GetUnshared(&str);
+		str->_chars.Push(_str->_chars.ConstData(), _str->_chars.Size());
+		_str->Release();
+		_str = str;
+	}
+}
+
+char *ff::Utf8String::editable_data()
+{
+	make_editable();
+	return is_small() ? _small : _str->_chars.Data();
+}
+
+// Replaces count bytes at pos with new_count uninitialized bytes, returns the start of the string
+char *ff::Utf8String::make_space(size_t pos, size_t count, size_t new_count)
+{
+	size_t old_size = size();
+	size_t new_size = old_size - count + new_count;
+	size_t tail = old_size - pos - count;
+
+	if (new_size < SMALL_SIZE)
+	{
+		if (is_small())
+		{
+			std::memmove(_small + pos + new_count, _small + pos + count, tail);
+			set_small_size(new_size);
+			return _small;
+		}
+
+		if (_str->IsShared() || _str->_data)
+		{
+			// Moving inside is cheaper than making a copy of the shared buffer
+			SharedUtf8Buffer *str = _str;
+			const char *data = str->_chars.ConstData();
+			std::memcpy(_small, data, pos);
+			std::memcpy(_small + pos + new_count, data + pos + count, tail);
+			set_small_size(new_size);
+			str->Release();
+			return _small;
+		}
+	}
+
+	make_long();
+	make_editable();
+
+	if (new_count > count)
+	{
+		_str->_chars.InsertDefault(pos, new_count - count);
+	}
+	else if (count > new_count)
+	{
+		_str->_chars.Delete(pos, count - new_count);
+	}
+
+	return _str->_chars.Data();
+}
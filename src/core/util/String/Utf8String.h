@@ -0,0 +1,130 @@
+#pragma once
+
+namespace ff
+{
+	class IData;
+
+	namespace details
+	{
+		struct Utf8Buffer;
+	}
+
+	/// String of UTF-8 bytes that acts mostly like String (and std::string).
+	///
+	/// Most text that gets loaded (JSON, names in a Dict) is ASCII, so it takes half the memory
+	/// of a String and no time to convert. Short strings (31 bytes on 64-bit) are stored inside
+	/// the Utf8String, longer ones share a copy-on-write buffer. FromData can even share the
+	/// bytes of a loaded file without copying them.
+	///
+	/// Sizes and positions are in bytes, not code points. Use ToWide() and the StringRef
+	/// constructor only where a wide String is needed, like calling Windows.
+	class UTIL_API Utf8String
+	{
+	public:
+		static const size_t npos = INVALID_SIZE;
+
+		Utf8String();
+		Utf8String(const Utf8String &rhs);
+		Utf8String(Utf8String &&rhs);
+		explicit Utf8String(const char *rhs, size_t count = npos);
+		explicit Utf8String(StringRef rhs);
+		Utf8String(size_t count, char ch);
+		~Utf8String();
+
+		// Shares the memory of UTF-8 data when it's null terminated, otherwise copies it
+		static Utf8String FromData(IData *data, size_t pos = 0, size_t count = npos);
+		String ToWide() const;
+
+		Utf8String &operator=(const Utf8String &rhs);
+		Utf8String &operator=(Utf8String &&rhs);
+		Utf8String &operator=(const char *rhs);
+
+		Utf8String operator+(const Utf8String &rhs) const;
+		Utf8String operator+(const char *rhs) const;
+
+		Utf8String &operator+=(const Utf8String &rhs);
+		Utf8String &operator+=(const char *rhs);
+		Utf8String &operator+=(char ch);
+
+		bool operator==(const Utf8String &rhs) const;
+		bool operator==(const char *rhs) const;
+		bool operator!=(const Utf8String &rhs) const;
+		bool operator!=(const char *rhs) const;
+		bool operator<(const Utf8String &rhs) const;
+
+		Utf8String &assign(const Utf8String &rhs, size_t pos = 0, size_t count = npos);
+		Utf8String &assign(const char *rhs, size_t count = npos);
+		Utf8String &append(const Utf8String &rhs, size_t pos = 0, size_t count = npos);
+		Utf8String &append(const char *rhs, size_t count = npos);
+		Utf8String &append(size_t count, char ch);
+		Utf8String &insert(size_t pos, const char *rhs, size_t count = npos);
+		Utf8String &erase(size_t pos = 0, size_t count = npos);
+		Utf8String &replace(size_t pos, size_t count, const char *rhs, size_t rhs_count = npos);
+
+		void push_back(char ch);
+		void pop_back();
+
+		const char *begin() const;
+		const char *end() const;
+
+		char       &front();
+		const char &front() const;
+		char       &back();
+		const char &back() const;
+
+		char       &at(size_t pos);
+		const char &at(size_t pos) const;
+
+		char       &operator[](size_t pos);
+		const char &operator[](size_t pos) const;
+
+		const char *c_str() const;
+		const char *data() const;
+		size_t length() const;
+		size_t size() const;
+		bool empty() const;
+		size_t capacity() const;
+
+		void clear();
+		void resize(size_t count, char ch = '\0');
+		void reserve(size_t alloc);
+		void swap(Utf8String &rhs);
+		Utf8String substr(size_t pos = 0, size_t count = npos) const;
+
+		size_t find(const Utf8String &rhs, size_t pos = 0) const;
+		size_t find(const char *rhs, size_t pos = 0, size_t count = npos) const;
+		size_t find(char ch, size_t pos = 0) const;
+		size_t rfind(char ch, size_t pos = npos) const;
+
+		// Byte order, which is also code point order for valid UTF-8
+		int compare(const Utf8String &rhs) const;
+		int compare(const char *rhs, size_t rhs_count = npos) const;
+
+	private:
+		typedef SharedObject<details::Utf8Buffer> SharedUtf8Buffer;
+
+		// The last byte of a short string is its unused length, so it's also the null when full
+		static const size_t SMALL_SIZE = 4 * sizeof(void *);
+		static const char LONG_TAG = static_cast<char>(-1);
+
+		bool is_small() const;
+		void set_small_size(size_t size);
+		void set_long(SharedUtf8Buffer *str);
+		void make_long();
+		void make_editable();
+		char *editable_data();
+		char *make_space(size_t pos, size_t count, size_t new_count);
+
+		union
+		{
+			SharedUtf8Buffer *_str; // when _small[SMALL_SIZE - 1] == LONG_TAG
+			char _small[SMALL_SIZE];
+		};
+	};
+
+	template<>
+	inline hash_t HashFunc<Utf8String>(const Utf8String &val)
+	{
+		return HashBytes(val.c_str(), val.size());
+	}
+}
@@ -0,0 +1,165 @@
+#include "pch.h"
+#include "App/Log.h"
+#include "App/Timer.h"
+#include "Data/Data.h"
+#include "Data/DataFile.h"
+#include "Data/DataWriterReader.h"
+#include "Dict/BinaryDict.h"
+#include "Dict/Dict.h"
+#include "Dict/DictPersist.h"
+#include "Dict/Value.h"
+#include "String/StringFormat.h"
+
+#include <iostream>
+#include <Psapi.h>
+
+static const size_t BINARY_DICT_PERF_ENTITIES = 20000;
+
+static size_t GetPrivateBytes()
+{
+	PROCESS_MEMORY_COUNTERS_EX counters;
+	counters.cb = sizeof(counters);
+
+	return ::GetProcessMemoryInfo(::GetCurrentProcess(), reinterpret_cast<PROCESS_MEMORY_COUNTERS *>(&counters), sizeof(counters))
+		? counters.PrivateUsage
+		: 0;
+}
+
+static size_t GetPrivateBytesSince(size_t before)
+{
+	size_t after = GetPrivateBytes();
+	return (after > before) ? after - before : 0;
+}
+
+// Like a level file: lots of entities that each have a few properties
+static ff::Dict CreateLevelDict()
+{
+	ff::Dict level;
+	level.Reserve(BINARY_DICT_PERF_ENTITIES);
+
+	for (size_t i = 0; i < BINARY_DICT_PERF_ENTITIES; i++)
+	{
+		ff::Dict entity;
+		entity.SetString(ff::String(L"type"), (i % 3) ? ff::String(L"enemy") : ff::String(L"pickup"));
+		entity.SetString(ff::String(L"name"), FF_FORMAT(L"Entity {}", i));
+		entity.SetPointF(ff::String(L"position"), ff::PointFloat(i * 1.5f, i * 0.5f));
+		entity.SetRectF(ff::String(L"bounds"), ff::RectFloat(-8, -8, 8, 8));
+		entity.SetDouble(ff::String(L"speed"), i / 100.0);
+		entity.SetInt(ff::String(L"health"), static_cast<int>(i % 100));
+		entity.SetBool(ff::String(L"active"), (i % 2) != 0);
+
+		ff::ValuePtr path;
+		ff::Value::CreateFloatVector(&path);
+		for (size_t h = 0; h < 32; h++)
+		{
+			path->AsFloatVector().Push(static_cast<float>(i + h));
+		}
+
+		entity.SetValue(ff::String(L"path"), path);
+
+		ff::ValuePtr entityValue;
+		ff::Value::CreateDict(std::move(entity), &entityValue);
+		level.SetValue(FF_FORMAT(L"entity-{}", i), entityValue);
+	}
+
+	return level;
+}
+
+static bool SaveToTempFile(ff::IData *data, ff::IDataFile **file)
+{
+	ff::ComPtr<ff::IDataFile> newFile;
+	ff::ComPtr<ff::IDataWriter> writer;
+	assertRetVal(ff::CreateTempDataFile(&newFile), false);
+	assertRetVal(ff::CreateDataWriter(newFile, 0, &writer), false);
+	assertRetVal(writer->Write(data->GetMem(), data->GetSize()), false);
+
+	*file = newFile.Detach();
+	return true;
+}
+
+bool BinaryDictPerfTest()
+{
+	ff::ComPtr<ff::IDataFile> savedFile;
+	ff::ComPtr<ff::IDataFile> binaryFile;
+	ff::Vector<ff::String> names;
+	size_t savedSize = 0;
+	size_t binarySize = 0;
+	{
+		ff::Dict level = CreateLevelDict();
+		names = level.GetAllNames(false, false, false);
+
+		ff::ComPtr<ff::IData> savedData;
+		ff::ComPtr<ff::IData> binaryData;
+		assertRetVal(ff::SaveDict(level, false, false, &savedData), false);
+		assertRetVal(ff::SaveBinaryDict(level, false, false, false, &binaryData), false);
+		assertRetVal(SaveToTempFile(savedData, &savedFile), false);
+		assertRetVal(SaveToTempFile(binaryData, &binaryFile), false);
+
+		savedSize = savedData->GetSize();
+		binarySize = binaryData->GetSize();
+	}
+
+	// Open both files and read one value out of each entity
+	double sum = 0;
+	size_t memoryBefore = GetPrivateBytes();
+	ff::Timer timer;
+
+	ff::ComPtr<ff::IDataReader> reader;
+	ff::Dict loadedDict;
+	assertRetVal(ff::CreateDataReader(savedFile, 0, &reader), false);
+	assertRetVal(ff::LoadDict(reader, loadedDict), false);
+
+	double loadTime = timer.Tick();
+	size_t loadMemory = GetPrivateBytesSince(memoryBefore);
+
+	for (const ff::String &name : names)
+	{
+		sum += loadedDict.GetValue(name, false)->AsDict().GetDouble(ff::String(L"speed"));
+	}
+
+	double loadReadTime = timer.Tick();
+	memoryBefore = GetPrivateBytes();
+	timer.Tick();
+
+	ff::ComPtr<ff::IData> binaryData;
+	ff::BinaryDict binaryDict;
+	assertRetVal(ff::CreateDataInMemMappedFile(binaryFile, &binaryData), false);
+	assertRetVal(binaryDict.Open(binaryData), false);
+
+	double openTime = timer.Tick();
+	size_t openMemory = GetPrivateBytesSince(memoryBefore);
+
+	for (const ff::String &name : names)
+	{
+		sum -= binaryDict.GetDict(name).GetDouble(ff::String(L"speed"));
+	}
+
+	double openReadTime = timer.Tick();
+
+	ff::Dict convertedDict;
+	assertRetVal(binaryDict.ToDict(convertedDict), false);
+
+	double convertTime = timer.Tick();
+	assertRetVal(sum == 0 && convertedDict.Size(false) == loadedDict.Size(false), false);
+
+	ff::String status = FF_FORMAT(
+		L"Dict with {} entities:\r\n"
+		L"  LoadDict: {}KB file, {}ms, {}KB private memory, read one value from each: {}ms\r\n"
+		L"  BinaryDict: {}KB file, open {}ms, {}KB private memory, read one value from each: {}ms, ToDict: {}ms\r\n",
+		names.Size(),
+		savedSize / 1024,
+		loadTime * 1000.0,
+		loadMemory / 1024,
+		loadReadTime * 1000.0,
+		binarySize / 1024,
+		openTime * 1000.0,
+		openMemory / 1024,
+		openReadTime * 1000.0,
+		convertTime * 1000.0);
+	ff::Log::DebugTrace(status.c_str());
+	std::wcout << status.c_str();
+
+	std::wcout << L"\r\n";
+
+	return true;
+}
@@ -0,0 +1,154 @@
+#include "pch.h"
+#include "Data/Data.h"
+#include "Data/DataFile.h"
+#include "Data/DataWriterReader.h"
+#include "Dict/BinaryDict.h"
+#include "Dict/Dict.h"
+#include "Dict/JsonPersist.h"
+#include "Dict/Value.h"
+#include "String/StringUtil.h"
+
+static ff::Dict CreateBinaryTestDict()
+{
+	ff::String json(
+		L"{\n"
+		L"  'foo': 'bar',\n"
+		L"  'obj' : { 'nested': { 'deep': 1 }, 'nested2': [] },\n"
+		L"  'numbers' : [ -1, 0, 8.5, -98.76e54, 1E-8 ],\n"
+		L"  'identifiers' : [ true, false, null ],\n"
+		L"  'string' : [ 'Hello', 'a\\'\\r\\u0020z' ],\n"
+		L"}\n");
+	ff::ReplaceAll(json, '\'', '\"');
+
+	ff::Dict dict = ff::JsonParse(json);
+	dict.SetInt(ff::String(L"int"), 42);
+	dict.SetBool(ff::String(L"bool"), true);
+	dict.SetFloat(ff::String(L"float"), 1.5f);
+	dict.SetDouble(ff::String(L"double"), 0.25);
+	dict.SetPoint(ff::String(L"point"), ff::PointInt(1, -2));
+	dict.SetRectF(ff::String(L"rectF"), ff::RectFloat(1, 2, 3, 4.5f));
+	dict.SetGuid(ff::String(L"guid"), __uuidof(ff::IData));
+	dict.SetString(ff::String(L"guidText"), ff::StringFromGuid(__uuidof(ff::IData)));
+
+	ff::ComPtr<ff::IData> data;
+	const char *bytes = "binary";
+	ff::CreateDataInStaticMem(reinterpret_cast<const BYTE *>(bytes), strlen(bytes), &data);
+	dict.SetData(ff::String(L"data"), data);
+
+	ff::ValuePtr ints;
+	ff::Value::CreateIntVector(&ints);
+	ints->AsIntVector().Push(3);
+	ints->AsIntVector().Push(5);
+	dict.SetValue(ff::String(L"ints"), ints);
+
+	return dict;
+}
+
+static bool BinaryDictReadTest(const ff::BinaryDict &binaryDict, const ff::Dict &dict)
+{
+	assertRetVal(binaryDict.IsValid() && binaryDict.Size() == dict.Size(true), false);
+
+	for (size_t i = 1; i < binaryDict.Size(); i++)
+	{
+		assertRetVal(binaryDict.KeyHashAt(i - 1) < binaryDict.KeyHashAt(i), false);
+	}
+
+	assertRetVal(binaryDict.GetString(ff::String(L"foo")) == L"bar", false);
+	assertRetVal(binaryDict.GetInt(ff::String(L"int")) == 42, false);
+	assertRetVal(binaryDict.GetDouble(ff::String(L"int")) == 42.0, false);
+	assertRetVal(binaryDict.GetInt(ff::String(L"missing"), 7) == 7, false);
+	assertRetVal(binaryDict.GetBool(ff::String(L"bool")), false);
+	assertRetVal(binaryDict.GetFloat(ff::String(L"float")) == 1.5f, false);
+	assertRetVal(binaryDict.GetDouble(ff::String(L"double")) == 0.25, false);
+	assertRetVal(binaryDict.GetPoint(ff::String(L"point")) == ff::PointInt(1, -2), false);
+	assertRetVal(binaryDict.GetRectF(ff::String(L"rectF")) == ff::RectFloat(1, 2, 3, 4.5f), false);
+	assertRetVal(binaryDict.GetGuid(ff::String(L"guid")) == __uuidof(ff::IData), false);
+	assertRetVal(binaryDict.GetGuid(ff::String(L"guidText")) == __uuidof(ff::IData), false);
+	assertRetVal(binaryDict.GetString(ff::String(L"guid")) == ff::StringFromGuid(__uuidof(ff::IData)), false);
+	assertRetVal(binaryDict.GetRect(ff::String(L"rectF"), ff::RectInt(1, 1, 1, 1)) == ff::RectInt(1, 1, 1, 1), false);
+	assertRetVal(binaryDict.GetPointF(ff::String(L"point"), ff::PointFloat(1, 1)) == ff::PointFloat(1, 1), false);
+	assertRetVal(binaryDict.GetDict(ff::String(L"obj")).GetDict(ff::String(L"nested")).GetInt(ff::String(L"deep")) == 1, false);
+	assertRetVal(!binaryDict.GetDict(ff::String(L"foo")).IsValid(), false);
+
+	// Arrays and data point into the saved bytes
+	size_t count = 0;
+	const int *ints = binaryDict.GetInts(ff::String(L"ints"), count);
+	assertRetVal(ints && count == 2 && ints[0] == 3 && ints[1] == 5, false);
+	assertRetVal(!binaryDict.GetDoubles(ff::String(L"ints"), count) && !count, false);
+
+	const wchar_t *chars = binaryDict.GetChars(ff::String(L"foo"), count);
+	assertRetVal(chars && count == 3 && !wcscmp(chars, L"bar"), false);
+
+	ff::ComPtr<ff::IData> data;
+	const BYTE *mem = binaryDict.GetData()->GetMem();
+	assertRetVal(binaryDict.GetData(ff::String(L"data"), &data) && data->GetSize() == 6, false);
+	assertRetVal(data->GetMem() > mem && data->GetMem() < mem + binaryDict.GetData()->GetSize(), false);
+	assertRetVal(!memcmp(data->GetMem(), "binary", 6), false);
+
+	ff::Dict loadedDict;
+	assertRetVal(binaryDict.ToDict(loadedDict), false);
+	assertRetVal(loadedDict.Size(true) == dict.Size(true), false);
+	assertRetVal(loadedDict.GetPoint(ff::String(L"point")) == ff::PointInt(1, -2), false);
+	assertRetVal(loadedDict.GetRectF(ff::String(L"rectF")) == ff::RectFloat(1, 2, 3, 4.5f), false);
+	assertRetVal(loadedDict.GetGuid(ff::String(L"guid")) == __uuidof(ff::IData), false);
+	assertRetVal(loadedDict.GetData(ff::String(L"data"))->GetSize() == 6, false);
+
+	// JSON can check everything else
+	ff::Dict jsonDict = dict;
+	const wchar_t *nonJsonNames[] = { L"point", L"rectF", L"guid", L"data" };
+
+	for (const wchar_t *name : nonJsonNames)
+	{
+		jsonDict.SetValue(ff::String(name), nullptr);
+		loadedDict.SetValue(ff::String(name), nullptr);
+	}
+
+	assertRetVal(ff::JsonWrite(loadedDict) == ff::JsonWrite(jsonDict), false);
+
+	return true;
+}
+
+bool BinaryDictTest()
+{
+	ff::Dict dict = CreateBinaryTestDict();
+
+	// In memory
+	ff::ComPtr<ff::IData> data;
+	ff::BinaryDict binaryDict;
+	assertRetVal(ff::SaveBinaryDict(dict, true, false, false, &data), false);
+	assertRetVal(binaryDict.Open(data), false);
+	assertRetVal(BinaryDictReadTest(binaryDict, dict), false);
+
+	// Memory mapped
+	ff::ComPtr<ff::IDataFile> file;
+	{
+		ff::ComPtr<ff::IDataWriter> writer;
+		assertRetVal(ff::CreateTempDataFile(&file), false);
+		assertRetVal(ff::CreateDataWriter(file, 0, &writer), false);
+		assertRetVal(writer->Write(data->GetMem(), data->GetSize()), false);
+	}
+
+	ff::ComPtr<ff::IData> fileData;
+	ff::BinaryDict fileDict;
+	assertRetVal(ff::CreateDataInMemMappedFile(file, &fileData), false);
+	assertRetVal(fileDict.Open(fileData), false);
+	assertRetVal(BinaryDictReadTest(fileDict, dict), false);
+
+	// Names saved as hashes can still be found by name
+	ff::ComPtr<ff::IData> hashedData;
+	ff::BinaryDict hashedDict;
+	assertRetVal(ff::SaveBinaryDict(dict, true, true, false, &hashedData), false);
+	assertRetVal(hashedData->GetSize() < data->GetSize(), false);
+	assertRetVal(hashedDict.Open(hashedData), false);
+	assertRetVal(hashedDict.GetString(ff::String(L"foo")) == L"bar", false);
+
+	// Bad data is rejected when it's opened
+	ff::ComPtr<ff::IData> badData;
+	ff::BinaryDict badDict;
+	assertRetVal(ff::CreateDataInData(data, 0, 12, &badData), false);
+	assertRetVal(!badDict.Open(badData) && !badDict.IsValid(), false);
+	assertRetVal(ff::CreateDataInData(data, 8, data->GetSize() - 8, &badData), false);
+	assertRetVal(!badDict.Open(badData) && !badDict.IsValid(), false);
+
+	return true;
+}
@@ -5,6 +5,8 @@
 #include "Dict/SmallDict.h"
 #include "Dict/Value.h"
 #include "Globals/ProcessGlobals.h"
+#include "String/StringFormat.h"
+#include "String/StringSearch.h"
 
 #include <iostream>
 
@@ -24,7 +26,7 @@ static bool RunDictPrefCompare(size_t entryCount)
 
 	for (size_t i = 0; i < entryCount; i++)
 	{
-		ff::String key = ff::String::format_new(L"%lu-%lu-%lu-%lu", i, i, i, i);
+		ff::String key = FF_FORMAT(L"{}-{}-{}-{}", i, i, i, i);
 		keys.Push(key);
 
 		ff::ValuePtr value;
@@ -98,6 +100,250 @@ static bool RunDictPrefCompare(size_t entryCount)
 	return true;
 }
 
+// Scalars are stored inline in the dict, compare that to setting a Value
+static bool RunDictScalarPerf(size_t entryCount)
+{
+	ff::Vector<ff::String> keys;
+	keys.Reserve(entryCount);
+
+	for (size_t i = 0; i < entryCount; i++)
+	{
+		ff::String key = FF_FORMAT(L"{}-{}-{}-{}", i, i, i, i);
+		keys.Push(key);
+
+		ff::ProcessGlobals::Get()->GetStringCache()->CacheString(key);
+	}
+
+	ff::Dict valueDict;
+	ff::Dict inlineDict;
+	ff::Timer timer;
+
+	for (size_t i = 0; i < entryCount; i++)
+	{
+		ff::ValuePtr value;
+		ff::Value::CreateDouble((double)i, &value);
+		valueDict.SetValue(keys[i], value);
+	}
+
+	double valueSetTime = timer.Tick();
+
+	for (size_t i = 0; i < entryCount; i++)
+	{
+		inlineDict.SetDouble(keys[i], (double)i);
+	}
+
+	double inlineSetTime = timer.Tick();
+	double sum = 0;
+
+	for (size_t i = 0; i < entryCount; i++)
+	{
+		sum += valueDict.GetValue(keys[i], false)->AsDouble();
+	}
+
+	double valueGetTime = timer.Tick();
+
+	for (size_t i = 0; i < entryCount; i++)
+	{
+		sum -= inlineDict.GetDouble(keys[i], 0.0, false);
+	}
+
+	double inlineGetTime = timer.Tick();
+	assertRetVal(sum == 0, false);
+
+	ff::String status = ff::String::format_new(
+		L"Dict doubles with %lu entries: SetValue:%fs, SetDouble:%fs, GetValue:%fs, GetDouble:%fs\r\n",
+		entryCount,
+		valueSetTime,
+		inlineSetTime,
+		valueGetTime,
+		inlineGetTime);
+	ff::Log::DebugTraceF(status.c_str());
+	std::wcout << status.c_str();
+
+	return true;
+}
+
+static const size_t SMALL_DICT_PERF_OPS = 1000000;
+static const size_t SMALL_DICT_PERF_GETS_PER_SET = 8;
+
+// Times how long a dict takes to set entryCount values and then read each of them a few times,
+// using a SmallDict or the map that Dict switches to when it has more than MAX_SMALL_DICT entries
+static bool RunSmallDictSearchPerf(size_t entryCount, double &smallTime, double &mapTime)
+{
+	typedef ff::IndexMap<ff::hash_t, ff::ValueHandle, ff::NonHasher<ff::hash_t>> PropsMap;
+
+	ff::StringCache *cache = ff::ProcessGlobals::Get()->GetStringCache();
+	ff::Vector<ff::String> keys;
+	ff::Vector<ff::hash_t> hashes;
+
+	for (size_t i = 0; i < entryCount; i++)
+	{
+		ff::String key = FF_FORMAT(L"{}-{}-{}-{}", i, i, i, i);
+		keys.Push(key);
+		hashes.Push(cache->CacheString(key));
+	}
+
+	size_t repeat = std::max<size_t>(SMALL_DICT_PERF_OPS / (entryCount * SMALL_DICT_PERF_GETS_PER_SET), 1);
+	size_t smallSum = 0;
+	size_t mapSum = 0;
+	ff::Timer timer;
+
+	for (size_t r = 0; r < repeat; r++)
+	{
+		ff::SmallDict smallDict;
+
+		for (size_t i = 0; i < entryCount; i++)
+		{
+			smallDict.Set(keys[i], ff::ValueHandle((int)i));
+		}
+
+		for (size_t g = 0; g < SMALL_DICT_PERF_GETS_PER_SET; g++)
+		{
+			for (ff::hash_t hash : hashes)
+			{
+				smallSum += smallDict.HandleAt(smallDict.IndexOfHash(hash)).AsInt();
+			}
+		}
+	}
+
+	smallTime = timer.Tick();
+
+	for (size_t r = 0; r < repeat; r++)
+	{
+		PropsMap map;
+
+		for (size_t i = 0; i < entryCount; i++)
+		{
+			map.SetKey(cache->CacheString(keys[i]), ff::ValueHandle((int)i));
+		}
+
+		for (size_t g = 0; g < SMALL_DICT_PERF_GETS_PER_SET; g++)
+		{
+			for (ff::hash_t hash : hashes)
+			{
+				mapSum += map.ValueAt(map.GetWithHash(hash, hash)).AsInt();
+			}
+		}
+	}
+
+	mapTime = timer.Tick();
+	assertRetVal(smallSum == mapSum, false);
+
+	return true;
+}
+
+// Finds the size where a SmallDict takes twice as long as a map, for each SimdLevel. Use it to
+// check MAX_SMALL_DICT in Dict.cpp. The map is a little faster even for tiny dicts, but a
+// SmallDict is worth that for being one allocation that's a fraction of the size.
+static bool RunSmallDictThresholdPerf()
+{
+	ff::SimdLevel oldLevel = ff::GetSimdLevel();
+
+	for (ff::SimdLevel level : { ff::SimdLevel::None, ff::SimdLevel::Sse2, ff::SimdLevel::Avx2 })
+	{
+		ff::SetSimdLevel(level);
+		if (ff::GetSimdLevel() != level)
+		{
+			// The CPU doesn't support it
+			continue;
+		}
+
+		size_t threshold = ff::INVALID_SIZE;
+
+		for (size_t entryCount = 4; entryCount <= 1024; entryCount *= 2)
+		{
+			double smallTime = 0;
+			double mapTime = 0;
+			assertRetVal(RunSmallDictSearchPerf(entryCount, smallTime, mapTime), false);
+
+			ff::String status = FF_FORMAT(
+				L"Set and get {} entries (SimdLevel {}): SmallDict:{}ms, Map:{}ms\r\n",
+				entryCount,
+				(int)level,
+				smallTime * 1000.0,
+				mapTime * 1000.0);
+			ff::Log::DebugTrace(status.c_str());
+			std::wcout << status.c_str();
+
+			if (threshold == ff::INVALID_SIZE && smallTime > mapTime * 2)
+			{
+				threshold = entryCount;
+			}
+		}
+
+		if (threshold != ff::INVALID_SIZE)
+		{
+			ff::String status = FF_FORMAT(L"SmallDict is twice as slow as a map at {} entries (SimdLevel {})\r\n", threshold, (int)level);
+			ff::Log::DebugTrace(status.c_str());
+			std::wcout << status.c_str();
+		}
+	}
+
+	ff::SetSimdLevel(oldLevel);
+	std::wcout << L"\r\n";
+
+	return true;
+}
+
+static const size_t DICT_CHAIN_PERF_READS = 1000000;
+
+// Settings and templates are read through chains of parent dicts, compare that to a chain cache
+static bool RunDictChainPerf(size_t levels, size_t entriesPerLevel)
+{
+	ff::Vector<std::unique_ptr<ff::Dict>> chain;
+	ff::Vector<ff::String> names;
+
+	for (size_t level = 0; level < levels; level++)
+	{
+		chain.Push(std::unique_ptr<ff::Dict>(new ff::Dict(level ? chain[level - 1].get() : nullptr)));
+
+		for (size_t i = 0; i < entriesPerLevel; i++)
+		{
+			ff::String name = FF_FORMAT(L"Level{}.Setting{}", level, i);
+			names.Push(name);
+			chain[level]->SetInt(name, (int)i);
+		}
+	}
+
+	ff::Dict &leaf = *chain.GetLast();
+	ff::Timer timer;
+	int chainSum = 0;
+
+	for (size_t i = 0; i < DICT_CHAIN_PERF_READS; i++)
+	{
+		chainSum += leaf.GetInt(names[i % names.Size()]);
+	}
+
+	double chainTime = timer.Tick();
+
+	leaf.SetChainCache(true);
+	leaf.GetInt(names[0]);
+
+	double rebuildTime = timer.Tick();
+	int cacheSum = 0;
+
+	for (size_t i = 0; i < DICT_CHAIN_PERF_READS; i++)
+	{
+		cacheSum += leaf.GetInt(names[i % names.Size()]);
+	}
+
+	double cacheTime = timer.Tick();
+	assertRetVal(chainSum == cacheSum, false);
+
+	ff::String status = FF_FORMAT(
+		L"{} GetInt calls through {} dicts with {} entries each: Chain:{}ms, ChainCache:{}ms (rebuild:{}ms)\r\n",
+		DICT_CHAIN_PERF_READS,
+		levels,
+		entriesPerLevel,
+		chainTime * 1000.0,
+		cacheTime * 1000.0,
+		rebuildTime * 1000.0);
+	ff::Log::DebugTrace(status.c_str());
+	std::wcout << status.c_str();
+
+	return true;
+}
+
 bool DictPerfTest()
 {
 	assertRetVal(RunDictPrefCompare(1), false);
@@ -112,5 +358,18 @@ bool DictPerfTest()
 	assertRetVal(RunDictPrefCompare(50000), false);
 	assertRetVal(RunDictPrefCompare(100000), false);
 
+	assertRetVal(RunDictScalarPerf(100), false);
+	assertRetVal(RunDictScalarPerf(1000), false);
+	assertRetVal(RunDictScalarPerf(100000), false);
+	std::wcout << L"\r\n";
+
+	assertRetVal(RunSmallDictThresholdPerf(), false);
+
+	assertRetVal(RunDictChainPerf(2, 20), false);
+	assertRetVal(RunDictChainPerf(4, 20), false);
+	assertRetVal(RunDictChainPerf(4, 200), false);
+	assertRetVal(RunDictChainPerf(8, 200), false);
+	std::wcout << L"\r\n";
+
 	return true;
 }
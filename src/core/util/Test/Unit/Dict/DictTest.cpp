@@ -0,0 +1,142 @@
+#include "pch.h"
+#include "Dict/Dict.h"
+#include "Dict/Value.h"
+
+static bool DictChainCacheTest()
+{
+	ff::Dict root;
+	root.SetInt(ff::String(L"int"), 1);
+	root.SetString(ff::String(L"rootOnly"), ff::String(L"root"));
+
+	ff::Dict middle(&root);
+	middle.SetInt(ff::String(L"int"), 2);
+	middle.SetDouble(ff::String(L"middleOnly"), 0.5);
+
+	ff::Dict leaf(&middle);
+	leaf.SetChainCache(true);
+	assertRetVal(leaf.HasChainCache() && !middle.HasChainCache(), false);
+
+	assertRetVal(leaf.GetInt(ff::String(L"int")) == 2, false);
+	assertRetVal(leaf.GetString(ff::String(L"rootOnly")) == L"root", false);
+	assertRetVal(leaf.GetDouble(ff::String(L"middleOnly")) == 0.5, false);
+	assertRetVal(leaf.GetInt(ff::String(L"missing"), 7) == 7, false);
+	assertRetVal(leaf.GetInt(ff::String(L"int"), 0, false) == 0, false);
+
+	// Changes anywhere in the chain are seen right away
+	leaf.SetInt(ff::String(L"int"), 3);
+	assertRetVal(leaf.GetInt(ff::String(L"int")) == 3, false);
+
+	root.SetInt(ff::String(L"missing"), 4);
+	assertRetVal(leaf.GetInt(ff::String(L"missing")) == 4, false);
+
+	leaf.SetValue(ff::String(L"int"), nullptr);
+	middle.SetValue(ff::String(L"int"), nullptr);
+	assertRetVal(leaf.GetInt(ff::String(L"int")) == 1, false);
+
+	// Enough values for the middle dict to switch to a map
+	for (size_t i = 0; i < 200; i++)
+	{
+		middle.SetInt(ff::String::format_new(L"Key%lu", i), (int)i);
+		assertRetVal(leaf.GetInt(ff::String::format_new(L"Key%lu", i), -1) == (int)i, false);
+	}
+
+	ff::Dict otherRoot;
+	otherRoot.SetString(ff::String(L"rootOnly"), ff::String(L"other"));
+	middle.SetParent(&otherRoot);
+	assertRetVal(leaf.GetString(ff::String(L"rootOnly")) == L"other", false);
+	assertRetVal(leaf.GetInt(ff::String(L"missing"), 5) == 5, false);
+
+	root.Clear();
+	middle.SetParent(&root);
+	assertRetVal(leaf.GetString(ff::String(L"rootOnly"), ff::String(L"none")) == L"none", false);
+
+	// Copies keep the setting, but not the cached values
+	ff::Dict copy = leaf;
+	assertRetVal(copy.HasChainCache() && copy.GetInt(ff::String(L"Key5")) == 5, false);
+
+	leaf.SetChainCache(false);
+	assertRetVal(!leaf.HasChainCache() && leaf.GetInt(ff::String(L"Key6")) == 6, false);
+
+	return true;
+}
+
+// Caches and the dicts in their chain can go away in any order
+static bool DictChainCacheLifetimeTest()
+{
+	ff::Dict root;
+	root.SetInt(ff::String(L"int"), 1);
+
+	ff::Dict leaf(&root);
+	leaf.SetChainCache(true);
+	{
+		ff::Dict middle(&root);
+		middle.SetInt(ff::String(L"int"), 2);
+		leaf.SetParent(&middle);
+		assertRetVal(leaf.GetInt(ff::String(L"int")) == 2, false);
+
+		// Other caches that include the same dicts
+		ff::Dict otherLeaf(&middle);
+		otherLeaf.SetChainCache(true);
+		assertRetVal(otherLeaf.GetInt(ff::String(L"int")) == 2, false);
+
+		leaf.SetParent(&root);
+	}
+
+	assertRetVal(leaf.GetInt(ff::String(L"int")) == 1, false);
+	root.SetInt(ff::String(L"int"), 3);
+	assertRetVal(leaf.GetInt(ff::String(L"int")) == 3, false);
+
+	// A moved dict gets its own cache
+	ff::Dict movedLeaf(std::move(leaf));
+	assertRetVal(movedLeaf.HasChainCache() && !leaf.HasChainCache(), false);
+	assertRetVal(movedLeaf.GetInt(ff::String(L"int")) == 3, false);
+	root.SetInt(ff::String(L"int"), 4);
+	assertRetVal(movedLeaf.GetInt(ff::String(L"int")) == 4, false);
+
+	// Legacy values aren't cached, but are still found through the chain
+	ff::ValuePtr legacyValue;
+	assertRetVal(ff::Value::CreateInt(5, &legacyValue), false);
+	root.SetLegacyValue(ff::HashBytesLegacy(L"legacy", 6 * sizeof(wchar_t)), legacyValue);
+	assertRetVal(movedLeaf.GetInt(ff::String(L"legacy")) == 5 && movedLeaf.GetInt(ff::String(L"int")) == 4, false);
+
+	return true;
+}
+
+static bool DictChainCacheRelocateTest()
+{
+	ff::Dict root;
+	root.SetInt(ff::String(L"int"), 1);
+
+	ff::Vector<ff::Dict> dicts;
+	dicts.Push(ff::Dict(&root));
+	dicts[0].SetChainCache(true);
+	assertRetVal(dicts[0].GetInt(ff::String(L"int")) == 1, false);
+
+	// Vectors move their items around in memory without telling them
+	const ff::Dict *oldAddress = &dicts[0];
+	while (&dicts[0] == oldAddress)
+	{
+		dicts.Push(ff::Dict(&root));
+		dicts.GetLast().SetChainCache(true);
+		assertRetVal(dicts.GetLast().GetInt(ff::String(L"int")) == 1, false);
+	}
+
+	assertRetVal(dicts[0].GetInt(ff::String(L"int")) == 1, false);
+	root.SetInt(ff::String(L"int"), 2);
+
+	for (const ff::Dict &dict: dicts)
+	{
+		assertRetVal(dict.GetInt(ff::String(L"int")) == 2, false);
+	}
+
+	return true;
+}
+
+bool DictTest()
+{
+	assertRetVal(DictChainCacheTest(), false);
+	assertRetVal(DictChainCacheLifetimeTest(), false);
+	assertRetVal(DictChainCacheRelocateTest(), false);
+
+	return true;
+}
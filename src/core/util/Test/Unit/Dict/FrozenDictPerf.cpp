@@ -0,0 +1,88 @@
+#include "pch.h"
+#include "App/Log.h"
+#include "App/Timer.h"
+#include "Data/Data.h"
+#include "Dict/Dict.h"
+#include "Dict/FrozenDict.h"
+#include "String/StringFormat.h"
+
+#include <iostream>
+
+static const size_t FROZEN_DICT_PERF_READS = 1000000;
+
+// Settings in three levels, like defaults, then the app, then the user
+static bool RunFrozenDictPerf(size_t entryCount)
+{
+	ff::Dict defaults;
+	ff::Dict app(&defaults);
+	ff::Dict user(&app);
+	ff::Vector<ff::String> names;
+
+	for (size_t i = 0; i < entryCount; i++)
+	{
+		ff::String name = FF_FORMAT(L"Section.Setting{}", i);
+		names.Push(name);
+
+		ff::Dict &dict = (i % 3 == 0) ? user : ((i % 3 == 1) ? app : defaults);
+		dict.SetInt(name, (int)i);
+	}
+
+	ff::ComPtr<ff::IData> binaryData;
+	ff::BinaryDict binaryDict;
+	assertRetVal(ff::SaveBinaryDict(user, true, false, false, &binaryData), false);
+	assertRetVal(binaryDict.Open(binaryData), false);
+
+	ff::Timer timer;
+	ff::FrozenDict frozenDict(user);
+	double freezeTime = timer.Tick();
+	int dictSum = 0;
+
+	for (size_t i = 0; i < FROZEN_DICT_PERF_READS; i++)
+	{
+		dictSum += user.GetInt(names[i % entryCount]);
+	}
+
+	double dictTime = timer.Tick();
+	int binarySum = 0;
+
+	for (size_t i = 0; i < FROZEN_DICT_PERF_READS; i++)
+	{
+		binarySum += binaryDict.GetInt(names[i % entryCount]);
+	}
+
+	double binaryTime = timer.Tick();
+	int frozenSum = 0;
+
+	for (size_t i = 0; i < FROZEN_DICT_PERF_READS; i++)
+	{
+		frozenSum += frozenDict.GetInt(names[i % entryCount]);
+	}
+
+	double frozenTime = timer.Tick();
+	assertRetVal(dictSum == binarySum && dictSum == frozenSum, false);
+
+	ff::String status = FF_FORMAT(
+		L"{} GetInt calls with {} settings in a chain: Dict:{}ms, BinaryDict:{}ms, FrozenDict:{}ms (freeze:{}ms)\r\n",
+		FROZEN_DICT_PERF_READS,
+		entryCount,
+		dictTime * 1000.0,
+		binaryTime * 1000.0,
+		frozenTime * 1000.0,
+		freezeTime * 1000.0);
+	ff::Log::DebugTrace(status.c_str());
+	std::wcout << status.c_str();
+
+	return true;
+}
+
+bool FrozenDictPerfTest()
+{
+	assertRetVal(RunFrozenDictPerf(10), false);
+	assertRetVal(RunFrozenDictPerf(100), false);
+	assertRetVal(RunFrozenDictPerf(1000), false);
+	assertRetVal(RunFrozenDictPerf(10000), false);
+
+	std::wcout << L"\r\n";
+
+	return true;
+}
@@ -0,0 +1,126 @@
+#include "pch.h"
+#include "Data/Data.h"
+#include "Data/DataFile.h"
+#include "Data/DataWriterReader.h"
+#include "Dict/Dict.h"
+#include "Dict/FrozenDict.h"
+#include "Dict/Value.h"
+
+static bool FrozenDictChainTest()
+{
+	ff::Dict parent;
+	parent.SetInt(ff::String(L"int"), 1);
+	parent.SetString(ff::String(L"parentOnly"), ff::String(L"parent"));
+	parent.SetFloat(ff::String(L"float"), 2.5f);
+
+	ff::Dict nested;
+	nested.SetInt(ff::String(L"deep"), 3);
+	nested.SetPoint(ff::String(L"point"), ff::PointInt(4, 5));
+
+	ff::Dict dict(&parent);
+	dict.SetInt(ff::String(L"int"), 10);
+	dict.SetBool(ff::String(L"bool"), true);
+	dict.SetDouble(ff::String(L"double"), 0.5);
+
+	ff::ValuePtr nestedValue;
+	ff::Value::CreateDict(std::move(nested), &nestedValue);
+	dict.SetValue(ff::String(L"nested"), nestedValue);
+
+	ff::FrozenDict frozen(dict);
+	assertRetVal(frozen.IsValid() && frozen.IsIndexed(), false);
+	assertRetVal(frozen.Size() == dict.GetAllNames(true, false, false).Size(), false);
+
+	// The parent chain is flattened, and the child wins
+	assertRetVal(frozen.GetInt(ff::String(L"int")) == 10, false);
+	assertRetVal(frozen.GetString(ff::String(L"parentOnly")) == L"parent", false);
+	assertRetVal(frozen.GetFloat(ff::String(L"float")) == 2.5f, false);
+	assertRetVal(frozen.GetBool(ff::String(L"bool")), false);
+	assertRetVal(frozen.GetDouble(ff::String(L"double")) == 0.5, false);
+	assertRetVal(frozen.GetInt(ff::String(L"missing"), 7) == 7, false);
+
+	ff::BinaryDict frozenNested = frozen.GetDict(ff::String(L"nested"));
+	assertRetVal(frozenNested.IsIndexed(), false);
+	assertRetVal(frozenNested.GetInt(ff::String(L"deep")) == 3, false);
+	assertRetVal(frozenNested.GetPoint(ff::String(L"point")) == ff::PointInt(4, 5), false);
+
+	ff::Dict thawed;
+	assertRetVal(frozen.ToDict(thawed), false);
+	assertRetVal(thawed.GetInt(ff::String(L"int")) == 10 && thawed.GetString(ff::String(L"parentOnly")) == L"parent", false);
+
+	return true;
+}
+
+static bool FrozenDictLookupTest()
+{
+	for (size_t size : { 1, 2, 5, 100, 5000 })
+	{
+		ff::Dict dict;
+
+		for (size_t i = 0; i < size; i++)
+		{
+			dict.SetInt(ff::String::format_new(L"Key%lu", i), (int)i);
+		}
+
+		ff::FrozenDict frozen(dict);
+		assertRetVal(frozen.IsIndexed() && frozen.Size() == size, false);
+
+		for (size_t i = 0; i < size; i++)
+		{
+			ff::String name = ff::String::format_new(L"Key%lu", i);
+			size_t index = frozen.IndexOf(name);
+
+			assertRetVal(index != ff::INVALID_SIZE && frozen.KeyAt(index) == name, false);
+			assertRetVal(frozen.GetInt(name, -1) == (int)i, false);
+			assertRetVal(frozen.IndexOf(ff::String::format_new(L"Missing%lu", i)) == ff::INVALID_SIZE, false);
+		}
+	}
+
+	ff::FrozenDict emptyFrozen{ ff::Dict() };
+	assertRetVal(emptyFrozen.IsValid() && emptyFrozen.IsEmpty(), false);
+	assertRetVal(emptyFrozen.IndexOf(ff::String(L"Missing")) == ff::INVALID_SIZE, false);
+
+	return true;
+}
+
+static bool FrozenDictPersistTest()
+{
+	ff::Dict dict;
+	dict.SetString(ff::String(L"name"), ff::String(L"Frozen"));
+	dict.SetRectF(ff::String(L"rect"), ff::RectFloat(1, 2, 3, 4));
+
+	ff::FrozenDict frozen(dict);
+	assertRetVal(frozen.IsValid(), false);
+
+	// Save the data and map it back in
+	ff::ComPtr<ff::IDataFile> file;
+	{
+		ff::ComPtr<ff::IDataWriter> writer;
+		assertRetVal(ff::CreateTempDataFile(&file), false);
+		assertRetVal(ff::CreateDataWriter(file, 0, &writer), false);
+		assertRetVal(writer->Write(frozen.GetData()->GetMem(), frozen.GetData()->GetSize()), false);
+	}
+
+	ff::ComPtr<ff::IData> fileData;
+	ff::FrozenDict fileFrozen;
+	assertRetVal(ff::CreateDataInMemMappedFile(file, &fileData), false);
+	assertRetVal(fileFrozen.Open(fileData), false);
+	assertRetVal(fileFrozen.GetString(ff::String(L"name")) == L"Frozen", false);
+	assertRetVal(fileFrozen.GetRectF(ff::String(L"rect")) == ff::RectFloat(1, 2, 3, 4), false);
+
+	// A binary dict without an index can't be opened as frozen
+	ff::ComPtr<ff::IData> binaryData;
+	ff::FrozenDict binaryFrozen;
+	assertRetVal(ff::SaveBinaryDict(dict, false, false, false, &binaryData), false);
+	assertRetVal(!binaryFrozen.Open(binaryData) && !binaryFrozen.IsValid(), false);
+
+	return true;
+}
+
+bool FrozenDictTest()
+{
+	assertRetVal(FrozenDictChainTest(), false);
+	assertRetVal(FrozenDictLookupTest(), false);
+	assertRetVal(FrozenDictPersistTest(), false);
+
+	return true;
+}
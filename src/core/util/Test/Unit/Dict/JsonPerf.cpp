@@ -0,0 +1,176 @@
+#include "pch.h"
+#include "App/Log.h"
+#include "App/Timer.h"
+#include "Data/Data.h"
+#include "Data/DataWriterReader.h"
+#include "Dict/JsonParser.h"
+#include "Dict/JsonPersist.h"
+#include "String/StringBuilder.h"
+#include "String/StringFormat.h"
+#include "String/StringSearch.h"
+#include "String/StringUtil.h"
+#include "String/Utf8String.h"
+
+#include <iostream>
+
+static const size_t JSON_PERF_LOADS = 5;
+
+// Only counts, so the time is all parsing
+class JsonCountHandler : public ff::IJsonHandler
+{
+public:
+	JsonCountHandler() : _count(0) { }
+
+	virtual bool OnStartObject() override { _count++; return true; }
+	virtual bool OnEndObject() override { return true; }
+	virtual bool OnStartArray() override { _count++; return true; }
+	virtual bool OnEndArray() override { return true; }
+	virtual bool OnKey(const wchar_t *key, size_t size) override { return true; }
+	virtual bool OnString(const wchar_t *str, size_t size) override { _count++; return true; }
+	virtual bool OnInt(int value) override { _count++; return true; }
+	virtual bool OnDouble(double value) override { _count++; return true; }
+	virtual bool OnBool(bool value) override { _count++; return true; }
+	virtual bool OnNull() override { _count++; return true; }
+
+	size_t _count;
+};
+
+// Like a big config file: objects with names, numbers, and arrays, some non-ASCII text
+static ff::String MakePerfJson(size_t entryCount)
+{
+	ff::StringBuilder json;
+	json.Append(L"{\r\n  \"entries\": [\r\n");
+
+	for (size_t i = 0; i < entryCount; i++)
+	{
+		json.Append(FF_FORMAT(
+			L"    {{ \"id\": {}, \"name\": \"Entry number {}\", \"label\": \"caf\x00e9 \\\"{}\\\"\", "
+			L"\"scale\": {}.25, \"enabled\": {}, \"tags\": [ \"a\", \"b\", null ], \"pos\": [ {}, -{}, 1e-3 ] }}{}\r\n",
+			i,
+			i,
+			i,
+			i % 100,
+			(i % 2) ? L"true" : L"false",
+			i * 3,
+			i * 7,
+			(i + 1 < entryCount) ? L"," : L""));
+	}
+
+	json.Append(L"  ]\r\n}\r\n");
+	return json.ToString();
+}
+
+static bool RunJsonParsePerf(size_t entryCount)
+{
+	ff::String wide = MakePerfJson(entryCount);
+	ff::Utf8String utf8(wide);
+
+	ff::ComPtr<ff::IData> data;
+	assertRetVal(ff::CreateDataInStaticMem(reinterpret_cast<const BYTE *>(utf8.c_str()), utf8.size(), &data), false);
+
+	ff::Timer timer;
+	size_t count = 0;
+
+	// How a UTF-8 file used to get loaded: convert all of it to wide chars, then parse
+	for (size_t i = 0; i < JSON_PERF_LOADS; i++)
+	{
+		ff::String text = ff::StringFromUTF8(utf8.c_str(), utf8.size());
+		count += ff::JsonParse(text).Size(false);
+	}
+
+	double wideTime = timer.Tick();
+
+	for (size_t i = 0; i < JSON_PERF_LOADS; i++)
+	{
+		count += ff::JsonParse(data).Size(false);
+	}
+
+	double dataTime = timer.Tick();
+
+	for (size_t i = 0; i < JSON_PERF_LOADS; i++)
+	{
+		ff::ComPtr<ff::IDataReader> reader;
+		assertRetVal(ff::CreateDataReader(data, 0, &reader), false);
+		count += ff::JsonParse(reader).Size(false);
+	}
+
+	double readerTime = timer.Tick();
+
+	JsonCountHandler counter;
+	for (size_t i = 0; i < JSON_PERF_LOADS; i++)
+	{
+		assertRetVal(ff::JsonSaxParse(data, counter), false);
+	}
+
+	double saxTime = timer.Tick();
+
+	assertRetVal(count == JSON_PERF_LOADS * 3, false);
+	assertRetVal(counter._count == JSON_PERF_LOADS * (2 + entryCount * 14), false);
+
+	double megabytes = utf8.size() / (1024.0 * 1024.0);
+	ff::String status = FF_FORMAT(
+		L"Parse {} entry JSON ({}MB UTF-8): StringFromUTF8+JsonParse:{}MB/s, JsonParse(IData):{}MB/s, JsonParse(IDataReader):{}MB/s, JsonSaxParse only:{}MB/s\r\n",
+		entryCount,
+		megabytes,
+		megabytes * JSON_PERF_LOADS / wideTime,
+		megabytes * JSON_PERF_LOADS / dataTime,
+		megabytes * JSON_PERF_LOADS / readerTime,
+		megabytes * JSON_PERF_LOADS / saxTime);
+	ff::Log::DebugTrace(status.c_str());
+	std::wcout << status.c_str();
+
+	return true;
+}
+
+// Only parses with a counting handler, so the time is mostly the string and space skipping at each SIMD level
+static bool RunJsonSimdPerf(size_t entryCount)
+{
+	ff::Utf8String utf8(MakePerfJson(entryCount));
+	double megabytes = utf8.size() / (1024.0 * 1024.0);
+	ff::SimdLevel oldLevel = ff::GetSimdLevel();
+	ff::SimdLevel levels[] = { ff::SimdLevel::None, ff::SimdLevel::Sse2, ff::SimdLevel::Avx2 };
+	double times[_countof(levels)];
+
+	for (size_t level = 0; level < _countof(levels); level++)
+	{
+		ff::SetSimdLevel(levels[level]);
+
+		JsonCountHandler counter;
+		ff::Timer timer;
+
+		for (size_t i = 0; i < JSON_PERF_LOADS; i++)
+		{
+			if (!ff::JsonSaxParse(utf8.c_str(), utf8.size(), counter))
+			{
+				ff::SetSimdLevel(oldLevel);
+				assertRetVal(false, false);
+			}
+		}
+
+		times[level] = timer.Tick();
+		assert(counter._count == JSON_PERF_LOADS * (2 + entryCount * 14));
+	}
+
+	ff::SetSimdLevel(oldLevel);
+
+	ff::String status = FF_FORMAT(
+		L"JsonSaxParse {} entry JSON ({}MB UTF-8): None:{}MB/s, SSE2:{}MB/s, AVX2:{}MB/s\r\n",
+		entryCount,
+		megabytes,
+		megabytes * JSON_PERF_LOADS / times[0],
+		megabytes * JSON_PERF_LOADS / times[1],
+		megabytes * JSON_PERF_LOADS / times[2]);
+	ff::Log::DebugTrace(status.c_str());
+	std::wcout << status.c_str();
+
+	return true;
+}
+
+bool JsonPerfTest()
+{
+	assertRetVal(RunJsonParsePerf(10000), false);
+	assertRetVal(RunJsonParsePerf(100000), false);
+	assertRetVal(RunJsonSimdPerf(100000), false);
+
+	return true;
+}
@@ -1,8 +1,14 @@
 #include "pch.h"
+#include "Data/Data.h"
+#include "Data/DataWriterReader.h"
+#include "Dict/JsonParser.h"
 #include "Dict/JsonPersist.h"
 #include "Dict/JsonTokenizer.h"
 #include "Dict/Value.h"
+#include "String/StringFormat.h"
+#include "String/StringSearch.h"
 #include "String/StringUtil.h"
+#include "String/Utf8String.h"
 
 bool JsonTokenizerTest()
 {
@@ -56,6 +62,31 @@ bool JsonTokenizerTest()
 		}
 	}
 
+	// Short text isn't shared between string copies, so the tokenizer must only point into its own copy
+	ff::JsonTokenizer shortTokenizer(ff::String(L"[12,7]"));
+	ff::JsonTokenType shortTypes[] =
+	{
+		ff::JsonTokenType::OpenBracket,
+		ff::JsonTokenType::Number,
+		ff::JsonTokenType::Comma,
+		ff::JsonTokenType::Number,
+		ff::JsonTokenType::CloseBracket,
+		ff::JsonTokenType::None,
+	};
+
+	for (ff::JsonTokenType type: shortTypes)
+	{
+		ff::JsonToken token = shortTokenizer.NextToken();
+		assertRetVal(token._type == type, false);
+
+		if (type == ff::JsonTokenType::Number)
+		{
+			ff::ValuePtr value;
+			assertRetVal(token.GetValue(&value) && value->IsType(ff::Value::Type::Int), false);
+			assertRetVal(value->AsInt() == 12 || value->AsInt() == 7, false);
+		}
+	}
+
 	return true;
 }
 
@@ -141,3 +172,310 @@ bool JsonPrintTest()
 
 	return true;
 }
+
+// Doubles have to come back from JsonWrite exactly, and number vectors get written as arrays
+bool JsonNumberTest()
+{
+	ff::ValuePtr curve;
+	assertRetVal(ff::Value::CreateDoubleVector(&curve), false);
+	curve->AsDoubleVector().Push(0.25);
+	curve->AsDoubleVector().Push(-1e-7);
+	curve->AsDoubleVector().Push(0.1 + 0.2);
+
+	ff::Dict dict;
+	dict.SetDouble(ff::String(L"third"), 1.0 / 3.0);
+	dict.SetDouble(ff::String(L"tiny"), 5e-324);
+	dict.SetDouble(ff::String(L"big"), -1.7976931348623157e308);
+	dict.SetFloat(ff::String(L"float"), 0.1f);
+	dict.SetValue(ff::String(L"curve"), curve);
+
+	ff::String json = ff::JsonWrite(dict);
+	assertRetVal(json.find(L"\"float\": 0.1,\r\n") != ff::INVALID_SIZE, false);
+	assertRetVal(json.find(L"\"big\": -1.7976931348623157e+308,\r\n") != ff::INVALID_SIZE, false);
+	assertRetVal(json.find(L"     -1e-07,\r\n     0.30000000000000004\r\n") != ff::INVALID_SIZE, false);
+
+	ff::Dict loaded = ff::JsonParse(json);
+	assertRetVal(loaded.GetDouble(ff::String(L"third")) == 1.0 / 3.0, false);
+	assertRetVal(loaded.GetDouble(ff::String(L"tiny")) == 5e-324, false);
+	assertRetVal(loaded.GetDouble(ff::String(L"big")) == -1.7976931348623157e308, false);
+	assertRetVal(loaded.GetFloat(ff::String(L"float")) == 0.1f, false);
+
+	ff::Value *loadedCurve = loaded.GetValue(ff::String(L"curve"), false);
+	assertRetVal(loadedCurve && loadedCurve->IsType(ff::Value::Type::ValueVector), false);
+	assertRetVal(loadedCurve->AsValueVector().Size() == curve->AsDoubleVector().Size(), false);
+
+	for (size_t i = 0; i < curve->AsDoubleVector().Size(); i++)
+	{
+		assertRetVal(loadedCurve->AsValueVector()[i]->AsDouble() == curve->AsDoubleVector()[i], false);
+	}
+
+	// JSON has no infinity or NaN, so they're written as null
+	ff::Dict nonFinite;
+	nonFinite.SetDouble(ff::String(L"inf"), std::numeric_limits<double>::infinity());
+	nonFinite.SetFloat(ff::String(L"nan"), std::numeric_limits<float>::quiet_NaN());
+	curve->AsDoubleVector().Push(-std::numeric_limits<double>::infinity());
+	nonFinite.SetValue(ff::String(L"curve"), curve);
+
+	ff::Dict nonFiniteLoaded = ff::JsonParse(ff::JsonWrite(nonFinite));
+	assertRetVal(nonFiniteLoaded.Size(false) == 3, false);
+	assertRetVal(nonFiniteLoaded.GetValue(ff::String(L"inf"), false)->IsType(ff::Value::Type::Null), false);
+	assertRetVal(nonFiniteLoaded.GetValue(ff::String(L"nan"), false)->IsType(ff::Value::Type::Null), false);
+	assertRetVal(nonFiniteLoaded.GetValue(ff::String(L"curve"), false)->AsValueVector().GetLast()->IsType(ff::Value::Type::Null), false);
+
+	// Value::Convert uses the same shortest text
+	ff::ValuePtr sum;
+	ff::ValuePtr sumText;
+	ff::ValuePtr sumBack;
+	assertRetVal(ff::Value::CreateDouble(0.1 + 0.2, &sum) && sum->Convert(ff::Value::Type::String, &sumText), false);
+	assertRetVal(sumText->AsString() == L"0.30000000000000004", false);
+	assertRetVal(sumText->Convert(ff::Value::Type::Double, &sumBack) && sumBack->AsDouble() == 0.1 + 0.2, false);
+
+	ff::ValuePtr point;
+	ff::ValuePtr pointText;
+	assertRetVal(ff::Value::CreatePointF(ff::PointFloat(1.5f, 0.1f), &point) && point->Convert(ff::Value::Type::String, &pointText), false);
+	assertRetVal(pointText->AsString() == L"(1.5,0.1)", false);
+
+	// Text that isn't a plain decimal number still converts like wcstod
+	ff::ValuePtr spaced;
+	ff::ValuePtr spacedBack;
+	assertRetVal(ff::Value::CreateString(ff::String(L" 2.5"), &spaced) && spaced->Convert(ff::Value::Type::Double, &spacedBack), false);
+	assertRetVal(spacedBack->AsDouble() == 2.5, false);
+
+	return true;
+}
+
+// Writes each callback as a short line, so two parses can be compared
+class JsonEventLog : public ff::IJsonHandler
+{
+public:
+	JsonEventLog(size_t stopAfter = ff::INVALID_SIZE)
+		: _stopAfter(stopAfter)
+	{
+	}
+
+	virtual bool OnStartObject() override { return Add(ff::String(L"{")); }
+	virtual bool OnEndObject() override { return Add(ff::String(L"}")); }
+	virtual bool OnStartArray() override { return Add(ff::String(L"[")); }
+	virtual bool OnEndArray() override { return Add(ff::String(L"]")); }
+	virtual bool OnKey(const wchar_t *key, size_t size) override { return Add(ff::String(L"k:") + ff::String(key, size)); }
+	virtual bool OnString(const wchar_t *str, size_t size) override { return Add(ff::String(L"s:") + ff::String(str, size)); }
+	virtual bool OnInt(int value) override { return Add(ff::String::format_new(L"i:%d", value)); }
+	virtual bool OnDouble(double value) override { return Add(ff::String::format_new(L"d:%g", value)); }
+	virtual bool OnBool(bool value) override { return Add(ff::String(value ? L"true" : L"false")); }
+	virtual bool OnNull() override { return Add(ff::String(L"null")); }
+
+	ff::String _log;
+
+private:
+	bool Add(ff::StringRef event)
+	{
+		noAssertRetVal(_stopAfter--, false);
+		_log.append(event);
+		_log.append(L"\n");
+		return true;
+	}
+
+	size_t _stopAfter;
+};
+
+bool JsonSaxParserTest()
+{
+	ff::String json(
+		L"{\n"
+		L"  // Test comment\n"
+		L"  /* Another test comment */\n"
+		L"  'foo': 'bar',\n"
+		L"  'obj' : { 'nested': {}, 'nested2': [] },\n"
+		L"  'numbers' : [ -1, 0, 8.5, -98.76e54, 1E-8 ],\n"
+		L"  'identifiers' : [ true, false, null ],\n"
+		L"  'string' : [ 'Hello', 'a\\'\\r\\u0020z', 'caf\\u00e9 \x00e9\x4e2d' ],\n"
+		L"}\n");
+	ff::ReplaceAll(json, '\'', '\"');
+
+	ff::String expect(
+		L"{\nk:foo\ns:bar\nk:obj\n{\nk:nested\n{\n}\nk:nested2\n[\n]\n}\n"
+		L"k:numbers\n[\ni:-1\ni:0\nd:8.5\nd:-9.876e+55\nd:1e-08\n]\n"
+		L"k:identifiers\n[\ntrue\nfalse\nnull\n]\n"
+		L"k:string\n[\ns:Hello\ns:a\"\r z\ns:caf\x00e9 \x00e9\x4e2d\n]\n}\n");
+
+	JsonEventLog wideLog;
+	size_t errorPos = 0;
+	assertRetVal(ff::JsonSaxParse(json, wideLog, &errorPos) && errorPos == ff::INVALID_SIZE, false);
+	assertRetVal(wideLog._log == expect, false);
+
+	// The same events come from UTF-8, with or without a byte order mark
+	ff::Utf8String utf8(json);
+	JsonEventLog utf8Log;
+	assertRetVal(ff::JsonSaxParse(utf8.c_str(), utf8.size(), utf8Log), false);
+	assertRetVal(utf8Log._log == expect, false);
+
+	ff::Utf8String utf8Bom = ff::Utf8String("\xEF\xBB\xBF") + utf8;
+	JsonEventLog bomLog;
+	assertRetVal(ff::JsonSaxParse(utf8Bom.c_str(), utf8Bom.size(), bomLog), false);
+	assertRetVal(bomLog._log == expect, false);
+
+	// Errors are at the start of the bad token
+	struct BadJson
+	{
+		const wchar_t *text;
+		size_t errorPos;
+	};
+
+	const BadJson badJson[] =
+	{
+		{ L"{ \"a\": 1 \"b\": 2 }", 9 },
+		{ L"{ \"a\" 1 }", 6 },
+		{ L"{ \"a\": tru }", 7 },
+		{ L"{ \"a\": 1.e5 }", 7 },
+		{ L"{ \"a\": \"\\q\" }", 7 },
+		{ L"{ \"a\": \"no end }", 7 },
+		{ L"{ \"a\": 1 /* no end }", 9 },
+		{ L"{ \"a\": [ 1, , 2 ] }", 12 },
+	};
+
+	for (const BadJson &bad : badJson)
+	{
+		JsonEventLog log;
+		assertRetVal(!ff::JsonSaxParse(ff::String(bad.text), log, &errorPos) && errorPos == bad.errorPos, false);
+
+		size_t dictErrorPos = 0;
+		ff::JsonParse(ff::String(bad.text), &dictErrorPos);
+		assertRetVal(dictErrorPos == bad.errorPos, false);
+	}
+
+	// Only a Dict needs an object at the root
+	JsonEventLog arrayLog;
+	assertRetVal(ff::JsonSaxParse(ff::String(L"[ 1, 2 ]"), arrayLog) && arrayLog._log == L"[\ni:1\ni:2\n]\n", false);
+	ff::JsonParse(ff::String(L"[ 1, 2 ]"), &errorPos);
+	assertRetVal(errorPos == 0, false);
+
+	// The handler can stop parsing
+	JsonEventLog stopLog(3);
+	assertRetVal(!ff::JsonSaxParse(json, stopLog, &errorPos), false);
+	assertRetVal(stopLog._log == L"{\nk:foo\ns:bar\n" && json[errorPos] == L'\"' && json[errorPos + 1] == L'o', false);
+
+	return true;
+}
+
+// A reader gives the parser one chunk at a time, strings and UTF-8 chars get split between them
+bool JsonReaderParserTest()
+{
+	ff::String json(L"{\r\n");
+
+	for (size_t i = 0; i < 3000; i++)
+	{
+		json.append(FF_FORMAT(L"\t\"key{}\": [ {}, \"\x00e9\x4e2d value \\\"{}\\\"\", {}.5 ],\r\n", i, i, i, i));
+	}
+
+	json.append(L"\t\"long\": \"");
+	json.append(70000, L'\x4e2d');
+	json.append(L"\"\r\n}\r\n");
+
+	ff::Dict expect = ff::JsonParse(json);
+	assertRetVal(expect.Size(false) == 3001, false);
+
+	ff::Utf8String utf8(json);
+	ff::ComPtr<ff::IData> data;
+	assertRetVal(ff::CreateDataInStaticMem(reinterpret_cast<const BYTE *>(utf8.c_str()), utf8.size(), &data), false);
+
+	size_t errorPos = 0;
+	ff::Dict dataDict = ff::JsonParse(data, &errorPos);
+	assertRetVal(errorPos == ff::INVALID_SIZE && ff::JsonWrite(dataDict) == ff::JsonWrite(expect), false);
+
+	ff::ComPtr<ff::IDataReader> reader;
+	assertRetVal(ff::CreateDataReader(data, 0, &reader), false);
+
+	ff::Dict readerDict = ff::JsonParse(reader, &errorPos);
+	assertRetVal(errorPos == ff::INVALID_SIZE && ff::JsonWrite(readerDict) == ff::JsonWrite(expect), false);
+	assertRetVal(readerDict.GetString(ff::String(L"long")).size() == 70000, false);
+
+	return true;
+}
+
+// Every SIMD level has to give the same events, even when strings, escapes, and
+// runs of spaces cross the blocks and batches of the first pass
+bool JsonSaxParserIndexTest()
+{
+	ff::String json(L"{\r\n");
+
+	for (size_t i = 0; i < 500; i++)
+	{
+		json.append(i % 70, L' ');
+		json.append(FF_FORMAT(
+			L"\"key{}\":\t[ \"{}\", \"a\\\"b\\\\c\\u00e9\x8009\xff01\x00e0/\", {}, -{}.5e{}, true, false, null ], // \"comment\" {}\r\n",
+			i,
+			ff::String(i * 13 % 200, L'x'),
+			i,
+			i,
+			i % 10,
+			i));
+
+		if (i % 50 == 0)
+		{
+			json.append(L"/* a \"quoted\" comment\r\n  that goes on */\r\n");
+		}
+	}
+
+	json.append(L"\"last\": \"");
+	json.append(5000, L'y');
+	json.append(L"\"\r\n}\r\n");
+
+	ff::Utf8String utf8(json);
+	ff::ComPtr<ff::IData> data;
+	assertRetVal(ff::CreateDataInStaticMem(reinterpret_cast<const BYTE *>(utf8.c_str()), utf8.size(), &data), false);
+
+	// A control char in a string is an error at the start of the string
+	ff::String badJson = json;
+	badJson[json.size() - 200] = L'\x1f';
+	ff::Utf8String badUtf8(badJson);
+
+	ff::SimdLevel oldLevel = ff::GetSimdLevel();
+	ff::String expect;
+
+	for (ff::SimdLevel level : { ff::SimdLevel::None, ff::SimdLevel::Sse2, ff::SimdLevel::Avx2 })
+	{
+		ff::SetSimdLevel(level);
+
+		JsonEventLog wideLog;
+		JsonEventLog utf8Log;
+		JsonEventLog readerLog;
+		ff::ComPtr<ff::IDataReader> reader;
+
+		bool status =
+			ff::JsonSaxParse(json, wideLog) &&
+			ff::JsonSaxParse(utf8.c_str(), utf8.size(), utf8Log) &&
+			ff::CreateDataReader(data, 0, &reader) &&
+			ff::JsonSaxParse(reader, readerLog);
+
+		if (level == ff::SimdLevel::None)
+		{
+			expect = wideLog._log;
+		}
+
+		size_t wideErrorPos = 0;
+		size_t utf8ErrorPos = 0;
+		JsonEventLog badLog;
+
+		status = status &&
+			wideLog._log == expect &&
+			utf8Log._log == expect &&
+			readerLog._log == expect &&
+			!ff::JsonSaxParse(badJson, badLog, &wideErrorPos) &&
+			!ff::JsonSaxParse(badUtf8.c_str(), badUtf8.size(), badLog, &utf8ErrorPos) &&
+			wideErrorPos == json.size() - 5007 &&
+			utf8ErrorPos == badUtf8.size() - 5007;
+
+		if (!status)
+		{
+			ff::SetSimdLevel(oldLevel);
+			assertRetVal(false, false);
+		}
+	}
+
+	ff::SetSimdLevel(oldLevel);
+
+	assertRetVal(expect.find(L"k:key499\n[\n") != ff::String::npos && expect.find(L"s:a\"b\\c\x00e9\x8009\xff01\x00e0/\n") != ff::String::npos, false);
+	assertRetVal(expect.find(ff::String(L"s:") + ff::String(5000, L'y') + L"\n}\n") != ff::String::npos, false);
+
+	return true;
+}
@@ -1,11 +1,81 @@
 #include "pch.h"
 #include "Data/Data.h"
+#include "Data/DataPersist.h"
 #include "Data/DataWriterReader.h"
 #include "Dict/DictPersist.h"
 #include "Dict/JsonPersist.h"
 #include "Dict/Value.h"
+#include "Globals/ProcessGlobals.h"
+#include "String/StringCache.h"
+#include "String/StringSearch.h"
 #include "String/StringUtil.h"
 
+// Checks every index, and that a hash with only its low or high half matching isn't found
+static bool CheckSmallDictSearch(const ff::SmallDict &dict, const ff::Vector<int> &values)
+{
+	assertRetVal(dict.Size() == values.Size(), false);
+
+	for (size_t i = 0; i < dict.Size(); i++)
+	{
+		ff::hash_t hash = dict.KeyHashAt(i);
+		assertRetVal(dict.IndexOfHash(hash) == i && dict.HandleAt(i).AsInt() == values[i], false);
+		assertRetVal(dict.IndexOfHash(hash ^ 0x0000000100000000ULL) == ff::INVALID_SIZE, false);
+		assertRetVal(dict.IndexOfHash(hash ^ 0x0000000000000001ULL) == ff::INVALID_SIZE, false);
+	}
+
+	return true;
+}
+
+// Every size up to a few SIMD blocks, so the tails after the last full block get searched too
+static bool SmallDictSimdSearchTest(ff::SimdLevel level)
+{
+	ff::SetSimdLevel(level);
+
+	ff::SmallDict dict;
+	ff::Vector<ff::String> keys;
+	ff::Vector<int> values;
+
+	for (size_t size = 0; size < 40; size++)
+	{
+		assertRetVal(CheckSmallDictSearch(dict, values), false);
+
+		keys.Push(ff::String::format_new(L"SmallDictSimdSearchTest%lu", size));
+		values.Push((int)size);
+		dict.Add(keys.GetLast(), ff::ValueHandle((int)size));
+
+		// Odd sizes move the values to odd spots after the hashes
+		if (size % 5 == 0)
+		{
+			dict.Reserve(dict.Allocated() + 3, false);
+		}
+	}
+
+	assertRetVal(CheckSmallDictSearch(dict, values), false);
+
+	// The first match wins
+	dict.Add(keys[37], ff::ValueHandle(-1));
+	assertRetVal(dict.IndexOf(keys[37]) == 37, false);
+	dict.RemoveAt(37);
+	assertRetVal(dict.IndexOf(keys[37]) == dict.Size() - 1 && dict.HandleAt(dict.Size() - 1).AsInt() == -1, false);
+	dict.RemoveAt(dict.Size() - 1);
+	keys.Delete(37);
+	values.Delete(37);
+
+	// Removing from the middle, the front, and the end
+	for (size_t i = 0; dict.Size(); i++)
+	{
+		size_t index = (i % 3 == 0) ? dict.Size() / 2 : ((i % 3 == 1) ? 0 : dict.Size() - 1);
+		dict.RemoveAt(index);
+		assertRetVal(dict.IndexOf(keys[index]) == ff::INVALID_SIZE, false);
+
+		keys.Delete(index);
+		values.Delete(index);
+		assertRetVal(CheckSmallDictSearch(dict, values), false);
+	}
+
+	return true;
+}
+
 bool SmallDictTest()
 {
 	ff::String foo(L"Foo");
@@ -68,6 +138,85 @@ bool SmallDictTest()
 	assertRetVal(dict.GetValue(foo) == nullptr, false);
 	assertRetVal(dict.Size() == 0, false);
 
+	ff::SimdLevel cpuLevel = ff::GetSimdLevel();
+	assertRetVal(SmallDictSimdSearchTest(ff::SimdLevel::None), false);
+	assertRetVal(SmallDictSimdSearchTest(ff::SimdLevel::Sse2), false);
+	assertRetVal(SmallDictSimdSearchTest(ff::SimdLevel::Avx2), false);
+	ff::SetSimdLevel(cpuLevel);
+
+	return true;
+}
+
+// Saves a dict like version 1 did, with legacy name hashes
+static bool SaveLegacyDict(ff::StringRef name, int value, ff::IDataVector **data)
+{
+	ff::ComPtr<ff::IDataVector> legacyData;
+	ff::ComPtr<ff::IDataWriter> legacyWriter;
+	assertRetVal(ff::CreateDataWriter(&legacyData, &legacyWriter), false);
+	assertRetVal(ff::SaveData(legacyWriter, (DWORD)1), false);
+	assertRetVal(ff::SaveData(legacyWriter, (DWORD)1), false);
+	assertRetVal(ff::SaveData(legacyWriter, ff::HashBytesLegacy(name.c_str(), name.size() * sizeof(wchar_t))), false);
+	assertRetVal(ff::SaveData(legacyWriter, (DWORD)ff::Value::Type::Int), false);
+	assertRetVal(ff::SaveData(legacyWriter, value), false);
+
+	*data = legacyData.Detach();
+	return true;
+}
+
+static bool LoadDict(ff::IData *data, ff::Dict &dict)
+{
+	ff::ComPtr<ff::IDataReader> reader;
+	assertRetVal(ff::CreateDataReader(data, 0, &reader), false);
+	assertRetVal(ff::LoadDict(reader, dict), false);
+
+	return true;
+}
+
+static bool SmallDictLegacyPersistTest()
+{
+	// Names that aren't cached yet keep their legacy hash, but can still be looked up
+	ff::String uncachedName(L"SmallDictLegacyPersistTest.Uncached");
+	ff::ComPtr<ff::IDataVector> legacyData;
+	assertRetVal(SaveLegacyDict(uncachedName, 7, &legacyData), false);
+
+	ff::Dict legacyDict;
+	assertRetVal(LoadDict(legacyData, legacyDict), false);
+	assertRetVal(legacyDict.Size(false) == 1 && legacyDict.GetLegacyHashes(false).Size() == 1, false);
+	assertRetVal(legacyDict.GetAllNames(false, false, false).IsEmpty(), false);
+	assertRetVal(legacyDict.GetInt(uncachedName) == 7, false);
+	assertRetVal(legacyDict.GetLegacyHashes(false).Size() == 1, false);
+
+	ff::ProcessGlobals::Get()->GetStringCache()->CacheString(uncachedName);
+	assertRetVal(legacyDict.GetLegacyHashes(false).IsEmpty(), false);
+	assertRetVal(legacyDict.GetAllNames(false, false, false).Size() == 1, false);
+
+	// Once the name is known, saving writes the new hash
+	ff::ComPtr<ff::IData> hashedData;
+	assertRetVal(ff::SaveDict(legacyDict, true, true, &hashedData), false);
+
+	ff::Dict hashedDict;
+	assertRetVal(LoadDict(hashedData, hashedDict), false);
+	assertRetVal(hashedDict.GetLegacyHashes(false).IsEmpty() && hashedDict.GetInt(uncachedName) == 7, false);
+
+	// Saving before the name is known keeps the legacy hash
+	ff::String unsavedName(L"SmallDictLegacyPersistTest.Unsaved");
+	ff::ComPtr<ff::IDataVector> unsavedData;
+	assertRetVal(SaveLegacyDict(unsavedName, 9, &unsavedData), false);
+
+	ff::Dict unsavedDict;
+	ff::ComPtr<ff::IData> resavedData;
+	assertRetVal(LoadDict(unsavedData, unsavedDict), false);
+	assertRetVal(ff::SaveDict(unsavedDict, true, true, &resavedData), false);
+
+	ff::Dict resavedDict;
+	assertRetVal(LoadDict(resavedData, resavedDict), false);
+	assertRetVal(resavedDict.GetLegacyHashes(false).Size() == 1, false);
+	assertRetVal(resavedDict.GetInt(unsavedName) == 9, false);
+
+	// Setting the real name replaces the legacy value
+	resavedDict.SetInt(unsavedName, 10);
+	assertRetVal(resavedDict.Size(false) == 1 && resavedDict.GetInt(unsavedName) == 10, false);
+
 	return true;
 }
 
@@ -101,5 +250,36 @@ bool SmallDictPersistTest()
 	ff::String actual = ff::JsonWrite(loadedDict);
 	assertRetVal(actual == expected, false);
 
+	// Version 1 saves used the legacy name hash, names in the string cache get converted
+	ff::String legacyName(L"LegacyName");
+	ff::ProcessGlobals::Get()->GetStringCache()->CacheString(legacyName);
+
+	ff::ComPtr<ff::IDataVector> legacyData;
+	ff::ComPtr<ff::IDataWriter> legacyWriter;
+	assertRetVal(ff::CreateDataWriter(&legacyData, &legacyWriter), false);
+	assertRetVal(ff::SaveData(legacyWriter, (DWORD)1), false);
+	assertRetVal(ff::SaveData(legacyWriter, (DWORD)1), false);
+	assertRetVal(ff::SaveData(legacyWriter, ff::HashBytesLegacy(legacyName.c_str(), legacyName.size() * sizeof(wchar_t))), false);
+	assertRetVal(ff::SaveData(legacyWriter, (DWORD)ff::Value::Type::Int), false);
+	assertRetVal(ff::SaveData(legacyWriter, 42), false);
+
+	ff::Dict legacyDict;
+	ff::ComPtr<ff::IDataReader> legacyReader;
+	assertRetVal(ff::CreateDataReader(legacyData, 0, &legacyReader), false);
+	assertRetVal(ff::LoadDict(legacyReader, legacyDict), false);
+	assertRetVal(legacyDict.GetInt(legacyName) == 42, false);
+
+	// Current saves with hashed names
+	ff::ComPtr<ff::IData> hashedData;
+	ff::ComPtr<ff::IDataReader> hashedReader;
+	assertRetVal(ff::SaveDict(dict, true, true, &hashedData), false);
+	assertRetVal(ff::CreateDataReader(hashedData, 0, &hashedReader), false);
+
+	ff::Dict hashedDict;
+	assertRetVal(ff::LoadDict(hashedReader, hashedDict), false);
+	assertRetVal(hashedDict.GetString(ff::String(L"foo")) == L"bar", false);
+
+	assertRetVal(SmallDictLegacyPersistTest(), false);
+
 	return true;
 }
@@ -0,0 +1,183 @@
+#include "pch.h"
+#include "Data/Data.h"
+#include "Data/DataWriterReader.h"
+#include "Dict/BinaryDict.h"
+#include "Dict/Dict.h"
+#include "Dict/DictPersist.h"
+#include "Dict/JsonPersist.h"
+#include "Dict/Value.h"
+#include "Dict/ValueHandle.h"
+
+static bool ValueHandleInlineTest()
+{
+	ff::ValueHandle intHandle(500);
+	assertRetVal(intHandle.IsInline() && intHandle.IsType(ff::Value::Type::Int) && intHandle.AsInt() == 500, false);
+
+	ff::ValueHandle pointHandle(ff::PointFloat(1.5f, -2));
+	assertRetVal(pointHandle.IsInline() && pointHandle.AsPointF() == ff::PointFloat(1.5f, -2), false);
+
+	ff::ValueHandle nullHandle = ff::ValueHandle::Null();
+	assertRetVal(nullHandle.IsType(ff::Value::Type::Null) && nullHandle.GetValue()->IsType(ff::Value::Type::Null), false);
+	assertRetVal(!ff::ValueHandle().IsValid(), false);
+
+	// A Value is only created once, then the handle owns it
+	ff::ValueHandle doubleHandle(0.25);
+	ff::Value *value = doubleHandle.GetValue();
+	assertRetVal(value && value->IsType(ff::Value::Type::Double) && value->AsDouble() == 0.25, false);
+	assertRetVal(!doubleHandle.IsInline() && doubleHandle.GetValue() == value && doubleHandle.AsDouble() == 0.25, false);
+
+	ff::ValueHandle copyHandle(doubleHandle);
+	assertRetVal(copyHandle.GetValue() == value, false);
+
+	ff::ValueHandle moveHandle(std::move(intHandle));
+	assertRetVal(!intHandle.IsValid() && moveHandle.AsInt() == 500, false);
+
+	// Values that are set directly are kept
+	ff::ValuePtr stringValue;
+	ff::Value::CreateString(ff::String(L"Value"), &stringValue);
+	ff::ValueHandle stringHandle(stringValue);
+	assertRetVal(!stringHandle.IsInline() && stringHandle.GetValue() == stringValue, false);
+
+	return true;
+}
+
+static bool ValueHandleDictTest()
+{
+	ff::Dict dict;
+	dict.SetInt(ff::String(L"int"), 500);
+	dict.SetBool(ff::String(L"bool"), true);
+	dict.SetFloat(ff::String(L"float"), 1.5f);
+	dict.SetDouble(ff::String(L"double"), 2.25);
+	dict.SetPoint(ff::String(L"point"), ff::PointInt(3, -4));
+	dict.SetPointF(ff::String(L"pointF"), ff::PointFloat(0.5f, -1));
+
+	assertRetVal(dict.GetInt(ff::String(L"int")) == 500, false);
+	assertRetVal(dict.GetBool(ff::String(L"bool")), false);
+	assertRetVal(dict.GetFloat(ff::String(L"float")) == 1.5f, false);
+	assertRetVal(dict.GetDouble(ff::String(L"double")) == 2.25, false);
+	assertRetVal(dict.GetPoint(ff::String(L"point")) == ff::PointInt(3, -4), false);
+	assertRetVal(dict.GetPointF(ff::String(L"pointF")) == ff::PointFloat(0.5f, -1), false);
+
+	// Conversions still work
+	assertRetVal(dict.GetInt(ff::String(L"double")) == 2, false);
+	assertRetVal(dict.GetString(ff::String(L"int")) == L"500", false);
+
+	// GetValue always returns the same Value
+	ff::Value *value = dict.GetValue(ff::String(L"int"), false);
+	assertRetVal(value && value->IsType(ff::Value::Type::Int) && value->AsInt() == 500, false);
+	assertRetVal(dict.GetValue(ff::String(L"int"), false) == value, false);
+
+	// Copies and parents, before and after the dict gets large
+	for (size_t i = 0; i < 200; i++)
+	{
+		ff::Dict child(&dict);
+		child.Add(dict, true);
+		assertRetVal(child.GetPointF(ff::String(L"pointF"), ff::PointFloat(0, 0), false) == ff::PointFloat(0.5f, -1), false);
+		assertRetVal(child.GetValue(ff::String(L"int"), false) == value, false);
+
+		ff::Dict copy = dict;
+		assertRetVal(copy.Size(false) == dict.Size(false) && copy.GetDouble(ff::String(L"double")) == 2.25, false);
+
+		dict.SetDouble(ff::String::format_new(L"%lu", i), i / 4.0);
+	}
+
+	for (size_t i = 0; i < 200; i++)
+	{
+		assertRetVal(dict.GetDouble(ff::String::format_new(L"%lu", i)) == i / 4.0, false);
+	}
+
+	// Saved and loaded like any other value
+	ff::ComPtr<ff::IData> data;
+	ff::ComPtr<ff::IDataReader> reader;
+	ff::Dict loadedDict;
+	assertRetVal(ff::SaveDict(dict, true, false, &data), false);
+	assertRetVal(ff::CreateDataReader(data, 0, &reader), false);
+	assertRetVal(ff::LoadDict(reader, loadedDict), false);
+	assertRetVal(loadedDict.Size(false) == dict.Size(false), false);
+	assertRetVal(loadedDict.GetPoint(ff::String(L"point")) == ff::PointInt(3, -4), false);
+	assertRetVal(loadedDict.GetDouble(ff::String(L"199")) == 199 / 4.0, false);
+
+	return true;
+}
+
+static bool AreScalarsInline(const ff::Dict &dict)
+{
+	const wchar_t *names[] = { L"int", L"bool", L"float", L"double", L"point", L"pointF", L"null" };
+
+	for (const wchar_t *name : names)
+	{
+		const ff::ValueHandle *handle = dict.GetHandle(ff::String(name), false);
+		assertRetVal(handle && handle->IsInline(), false);
+	}
+
+	return true;
+}
+
+// Loading scalars or saving them never creates a Value for them
+static bool ValueHandlePersistTest()
+{
+	ff::Dict dict;
+	dict.SetInt(ff::String(L"int"), 500);
+	dict.SetBool(ff::String(L"bool"), true);
+	dict.SetFloat(ff::String(L"float"), 1.5f);
+	dict.SetDouble(ff::String(L"double"), 2.25);
+	dict.SetPoint(ff::String(L"point"), ff::PointInt(3, -4));
+	dict.SetPointF(ff::String(L"pointF"), ff::PointFloat(0.5f, -1));
+	dict.SetHandle(ff::String(L"null"), ff::ValueHandle::Null());
+	dict.SetString(ff::String(L"string"), ff::String(L"Value"));
+
+	// Conversions use a copy
+	assertRetVal(dict.GetDouble(ff::String(L"int")) == 500 && dict.GetString(ff::String(L"bool")) == L"true", false);
+	assertRetVal(dict.GetRect(ff::String(L"point"), ff::RectInt(1, 2, 3, 4)) == ff::RectInt(1, 2, 3, 4), false);
+	assertRetVal(AreScalarsInline(dict), false);
+
+	ff::ComPtr<ff::IData> data;
+	ff::ComPtr<ff::IDataReader> reader;
+	ff::Dict loadedDict;
+	assertRetVal(ff::SaveDict(dict, true, false, &data), false);
+	assertRetVal(ff::CreateDataReader(data, 0, &reader), false);
+	assertRetVal(ff::LoadDict(reader, loadedDict), false);
+	assertRetVal(AreScalarsInline(dict) && AreScalarsInline(loadedDict), false);
+	assertRetVal(loadedDict.GetPointF(ff::String(L"pointF")) == ff::PointFloat(0.5f, -1), false);
+	assertRetVal(loadedDict.GetString(ff::String(L"string")) == L"Value", false);
+
+	ff::ComPtr<ff::IData> binaryData;
+	ff::BinaryDict binaryDict;
+	ff::Dict binaryLoadedDict;
+	assertRetVal(ff::SaveBinaryDict(dict, true, false, false, &binaryData), false);
+	assertRetVal(binaryDict.Open(binaryData) && binaryDict.ToDict(binaryLoadedDict), false);
+	assertRetVal(AreScalarsInline(dict) && AreScalarsInline(binaryLoadedDict), false);
+	assertRetVal(binaryLoadedDict.GetPoint(ff::String(L"point")) == ff::PointInt(3, -4), false);
+	assertRetVal(binaryLoadedDict.GetHandle(ff::String(L"null"), false)->IsType(ff::Value::Type::Null), false);
+
+	// JSON doesn't have points
+	dict.SetValue(ff::String(L"point"), nullptr);
+	dict.SetValue(ff::String(L"pointF"), nullptr);
+
+	ff::String json = ff::JsonWrite(dict);
+	assertRetVal(dict.GetHandle(ff::String(L"int"), false)->IsInline() && dict.GetHandle(ff::String(L"double"), false)->IsInline(), false);
+
+	ff::Dict jsonDict = ff::JsonParse(json);
+	assertRetVal(jsonDict.Size(false) == dict.Size(false), false);
+	assertRetVal(jsonDict.GetHandle(ff::String(L"int"), false)->IsInline() && jsonDict.GetInt(ff::String(L"int")) == 500, false);
+	assertRetVal(jsonDict.GetHandle(ff::String(L"bool"), false)->IsInline() && jsonDict.GetBool(ff::String(L"bool")), false);
+	assertRetVal(jsonDict.GetHandle(ff::String(L"double"), false)->IsInline() && jsonDict.GetDouble(ff::String(L"double")) == 2.25, false);
+	assertRetVal(jsonDict.GetHandle(ff::String(L"null"), false)->IsType(ff::Value::Type::Null), false);
+
+	// Arrays still hold real values
+	ff::Dict arrayDict = ff::JsonParse(ff::String(L"{ \"array\": [ 1, true, null ] }"));
+	ff::Value *arrayValue = arrayDict.GetValue(ff::String(L"array"), false);
+	assertRetVal(arrayValue && arrayValue->IsType(ff::Value::Type::ValueVector) && arrayValue->AsValueVector().Size() == 3, false);
+	assertRetVal(arrayValue->AsValueVector()[0]->AsInt() == 1 && arrayValue->AsValueVector()[2]->IsType(ff::Value::Type::Null), false);
+
+	return true;
+}
+
+bool ValueHandleTest()
+{
+	assertRetVal(ValueHandleInlineTest(), false);
+	assertRetVal(ValueHandleDictTest(), false);
+	assertRetVal(ValueHandlePersistTest(), false);
+
+	return true;
+}
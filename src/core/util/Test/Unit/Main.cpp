@@ -3,22 +3,57 @@
 #include "Globals/ProcessGlobals.h"
 #include "MainUtilInclude.h"
 
+bool BinaryDictPerfTest();
+bool ConcurrentMapPerfTest();
 bool DictPerfTest();
+bool FlatMapPerfTest();
+bool FrozenDictPerfTest();
+bool HashPerfTest();
+bool JsonPerfTest();
+bool MapPerfTest();
+bool NumberConvertPerfTest();
+bool StringBuilderPerfTest();
+bool StringConvertPerfTest();
+bool StringFormatPerfTest();
+bool StringSearchPerfTest();
+bool StringPerfTest();
+bool Utf8StringPerfTest();
 
+bool AtomTableTest();
+bool BinaryDictTest();
+bool ConcurrentMapTest();
+bool DictTest();
 bool EntityTest();
+bool FlatMapTest();
+bool FrameArenaTest();
+bool FrozenDictTest();
+bool JsonNumberTest();
 bool JsonParserTest();
 bool JsonPrintTest();
+bool JsonReaderParserTest();
+bool JsonSaxParserIndexTest();
+bool JsonSaxParserTest();
 bool JsonTokenizerTest();
 bool ListTest();
 bool MapTest();
+bool NumberConvertTest();
 bool PoolTest();
 bool ProcessGlobalsTest();
+bool SharedObjectTest();
+bool SlabAllocatorTest();
 bool SmallDictTest();
 bool SmallDictPersistTest();
+bool SmallStringTest();
 bool SmartPtrTest();
 bool SortTest();
+bool StringBuilderTest();
+bool StringConvertTest();
+bool StringFormatTest();
+bool StringSearchTest();
 bool StringTest();
 bool StringHashTest();
+bool Utf8StringTest();
+bool ValueHandleTest();
 bool VectorTest();
 
 int wmain(int argc, wchar_t *argv[])
@@ -33,23 +68,58 @@ int wmain(int argc, wchar_t *argv[])
 
 	if (runPerfTests)
 	{
+		assertRetVal(BinaryDictPerfTest(), 1);
+		assertRetVal(ConcurrentMapPerfTest(), 1);
 		assertRetVal(DictPerfTest(), 1);
+		assertRetVal(FlatMapPerfTest(), 1);
+		assertRetVal(FrozenDictPerfTest(), 1);
+		assertRetVal(HashPerfTest(), 1);
+		assertRetVal(JsonPerfTest(), 1);
+		assertRetVal(MapPerfTest(), 1);
+		assertRetVal(NumberConvertPerfTest(), 1);
+		assertRetVal(StringBuilderPerfTest(), 1);
+		assertRetVal(StringConvertPerfTest(), 1);
+		assertRetVal(StringFormatPerfTest(), 1);
+		assertRetVal(StringSearchPerfTest(), 1);
+		assertRetVal(StringPerfTest(), 1);
+		assertRetVal(Utf8StringPerfTest(), 1);
 	}
 	else
 	{
+		assertRetVal(AtomTableTest(), 1);
+		assertRetVal(BinaryDictTest(), 1);
+		assertRetVal(ConcurrentMapTest(), 1);
+		assertRetVal(DictTest(), 1);
 		assertRetVal(EntityTest(), 1);
+		assertRetVal(FlatMapTest(), 1);
+		assertRetVal(FrameArenaTest(), 1);
+		assertRetVal(FrozenDictTest(), 1);
+		assertRetVal(JsonNumberTest(), 1);
 		assertRetVal(JsonParserTest(), 1);
 		assertRetVal(JsonPrintTest(), 1);
+		assertRetVal(JsonReaderParserTest(), 1);
+		assertRetVal(JsonSaxParserIndexTest(), 1);
+		assertRetVal(JsonSaxParserTest(), 1);
 		assertRetVal(JsonTokenizerTest(), 1);
 		assertRetVal(ListTest(), 1);
 		assertRetVal(MapTest(), 1);
+		assertRetVal(NumberConvertTest(), 1);
 		assertRetVal(PoolTest(), 1);
+		assertRetVal(SharedObjectTest(), 1);
+		assertRetVal(SlabAllocatorTest(), 1);
 		assertRetVal(SmallDictTest(), 1);
 		assertRetVal(SmallDictPersistTest(), 1);
+		assertRetVal(SmallStringTest(), 1);
 		assertRetVal(SmartPtrTest(), 1);
 		assertRetVal(SortTest(), 1);
+		assertRetVal(StringBuilderTest(), 1);
+		assertRetVal(StringConvertTest(), 1);
+		assertRetVal(StringFormatTest(), 1);
+		assertRetVal(StringSearchTest(), 1);
 		assertRetVal(StringTest(), 1);
 		assertRetVal(StringHashTest(), 1);
+		assertRetVal(Utf8StringTest(), 1);
+		assertRetVal(ValueHandleTest(), 1);
 		assertRetVal(VectorTest(), 1);
 	}
 
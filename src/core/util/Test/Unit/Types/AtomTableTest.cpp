@@ -0,0 +1,195 @@
+#include "pch.h"
+#include "Data/Data.h"
+#include "Data/DataWriterReader.h"
+#include "String/AtomTable.h"
+#include "String/StringCache.h"
+#include "String/StringFormat.h"
+
+#include <thread>
+
+static bool BasicAtomTableTest()
+{
+	ff::AtomTable table;
+	ff::String name(L"Some name that's too long to be a small string");
+
+	ff::StringAtom atom = table.Intern(name);
+	assertRetVal(!atom.IsNull() && atom.size() == name.size() && atom.ToString() == name, false);
+	assertRetVal(atom.GetHash() == ff::HashFunc(name) && ff::HashFunc(atom) == atom.GetHash(), false);
+
+	// The same string always gets the same pointer back
+	ff::StringAtom atom2 = table.Intern(ff::String(name));
+	assertRetVal(atom2 == atom && atom2.c_str() == atom.c_str(), false);
+	assertRetVal(table.Find(ff::HashFunc(name)) == atom, false);
+	assertRetVal(table.Find(ff::HashFunc(ff::String(L"missing"))).IsNull(), false);
+
+	ff::StringAtom empty = table.Intern(ff::String());
+	assertRetVal(!empty.IsNull() && empty.empty() && !*empty.c_str() && empty != atom, false);
+	assertRetVal(ff::StringAtom().IsNull() && !wcscmp(ff::StringAtom(), L""), false);
+
+	// Lots of strings go past the first block, and a huge one gets its own
+	for (size_t i = 0; i < 5000; i++)
+	{
+		table.Intern(FF_FORMAT(L"name{}", i));
+	}
+
+	ff::String huge(100 * 1024, L'h');
+	assertRetVal(table.Intern(huge).ToString() == huge, false);
+	assertRetVal(table.Size() == 5003, false);
+	assertRetVal(table.Find(ff::HashFunc(ff::String(L"name1234"))).ToString() == L"name1234", false);
+	assertRetVal(!wcscmp(atom, name.c_str()), false);
+
+	// Atoms are still valid after a clear
+	table.Clear();
+	assertRetVal(!table.Size() && table.Find(atom.GetHash()).IsNull() && atom.ToString() == name, false);
+
+	return true;
+}
+
+static bool PersistAtomTableTest()
+{
+	ff::AtomTable table;
+	for (size_t i = 0; i < 1000; i++)
+	{
+		table.Intern(ff::String(i % 40, static_cast<wchar_t>(L'a' + i % 26)) + FF_FORMAT(L"{}", i));
+	}
+
+	ff::ComPtr<ff::IDataVector> data;
+	ff::ComPtr<ff::IDataWriter> writer;
+	assertRetVal(ff::CreateDataWriter(&data, &writer), false);
+	assertRetVal(table.Save(writer), false);
+
+	ff::AtomTable loadedTable;
+	loadedTable.Intern(ff::String(L"already here"));
+
+	ff::ComPtr<ff::IDataReader> reader;
+	assertRetVal(ff::CreateDataReader(data, 0, &reader), false);
+	assertRetVal(loadedTable.Load(reader), false);
+	assertRetVal(loadedTable.Size() == table.Size() + 1, false);
+
+	bool same = true;
+	table.ForEach([&loadedTable, &same](ff::StringAtom atom)
+	{
+		ff::StringAtom loadedAtom = loadedTable.Find(atom.GetHash());
+		same &= (loadedAtom.ToString() == atom.ToString()) && (loadedAtom.c_str() != atom.c_str());
+	});
+
+	assertRetVal(same, false);
+	assertRetVal(loadedTable.Find(ff::HashFunc(ff::String(L"already here"))).ToString() == L"already here", false);
+
+	ff::StringAtom longAtom = loadedTable.Find(ff::HashFunc(ff::String(39, L'l') + L"999"));
+	assertRetVal(longAtom.ToString().c_str() == longAtom.c_str(), false);
+
+	// Saved hashes are ignored, each string is found by its real hash
+	ff::details::AtomEntry *firstEntry = reinterpret_cast<ff::details::AtomEntry *>(data->GetVector().Data() + 24);
+	ff::String firstName(firstEntry->chars, firstEntry->size);
+	firstEntry->hash ^= 1;
+
+	ff::AtomTable rehashedTable;
+	ff::ComPtr<ff::IDataReader> rehashedReader;
+	assertRetVal(ff::CreateDataReader(data, 0, &rehashedReader), false);
+	assertRetVal(rehashedTable.Load(rehashedReader) && rehashedTable.Size() == table.Size(), false);
+	assertRetVal(rehashedTable.Find(ff::HashFunc(firstName)).ToString() == firstName, false);
+	assertRetVal(rehashedTable.Find(ff::HashFunc(firstName) ^ 1).IsNull(), false);
+
+	// Bad files are rejected
+	data->GetVector().Data()[0] ^= 1;
+	ff::AtomTable badTable;
+	ff::ComPtr<ff::IDataReader> badReader;
+	assertRetVal(ff::CreateDataReader(data, 0, &badReader), false);
+	assertRetVal(!badTable.Load(badReader) && !badTable.Size(), false);
+
+	return true;
+}
+
+// Every thread interns the same strings, they all have to get the same atoms
+static bool ThreadedAtomTableTest()
+{
+	const size_t threadCount = 8;
+	const size_t nameCount = 2000;
+
+	ff::AtomTable table;
+	ff::Vector<ff::StringAtom> atoms[threadCount];
+	std::thread threads[threadCount];
+
+	for (size_t i = 0; i < threadCount; i++)
+	{
+		threads[i] = std::thread([&table, &atoms, i, nameCount]()
+		{
+			for (size_t h = 0; h < nameCount; h++)
+			{
+				atoms[i].Push(table.Intern(FF_FORMAT(L"shared name {}", h)));
+			}
+		});
+	}
+
+	for (size_t i = 0; i < threadCount; i++)
+	{
+		threads[i].join();
+	}
+
+	assertRetVal(table.Size() == nameCount, false);
+
+	for (size_t i = 1; i < threadCount; i++)
+	{
+		assertRetVal(atoms[i] == atoms[0], false);
+	}
+
+	return true;
+}
+
+static bool StringCacheAtomTest()
+{
+	ff::StringCache cache;
+	ff::String name(L"CachedName");
+	ff::String longName(L"A cached name that's too long to be a small string");
+
+	ff::hash_t hash = cache.CacheString(name);
+	ff::hash_t longHash = cache.CacheString(longName);
+	ff::StringAtom atom = cache.GetAtoms().Find(hash);
+	assertRetVal(atom.ToString() == name && cache.GetString(hash) == name, false);
+
+	// Long strings come back without copying the chars
+	ff::String cachedLongName = cache.GetString(longHash);
+	assertRetVal(cachedLongName == longName && cachedLongName.c_str() == cache.GetAtoms().Find(longHash).c_str(), false);
+
+	// The shared chars aren't changed by editing a copy
+	ff::String editedName = cachedLongName;
+	editedName[0] = L'B';
+	assertRetVal(cache.GetString(longHash) == longName && editedName != longName, false);
+
+	// Hash strings never get cached
+	ff::String hashName = cache.GetString(cache.GetHash(ff::String(L"NotCached")));
+	assertRetVal(hashName.size() == 18 && cache.GetHash(hashName) == cache.CacheString(hashName), false);
+	assertRetVal(cache.GetAtoms().Find(cache.GetHash(hashName)).IsNull(), false);
+	assertRetVal(hashName == ff::StringCache::HashToString(ff::StringCache::HashString(ff::String(L"NotCached"))), false);
+	assertRetVal(ff::StringCache::HashString(hashName) == cache.GetHash(hashName) && ff::StringCache::HashString(name) == hash, false);
+	assertRetVal(cache.CacheString(cache.GetString(hash)) == hash && cache.GetAtoms().Size() == 2, false);
+
+	// Legacy hashes are found for cached strings and for preloaded strings
+	ff::String legacyName;
+	assertRetVal(cache.FindLegacyString(ff::HashBytesLegacy(name.c_str(), name.size() * sizeof(wchar_t)), legacyName) && legacyName == name, false);
+	assertRetVal(!cache.FindLegacyString(ff::HashBytesLegacy(L"NotCached", 9 * sizeof(wchar_t)), legacyName), false);
+
+	ff::ComPtr<ff::IDataVector> data;
+	ff::ComPtr<ff::IDataWriter> writer;
+	assertRetVal(ff::CreateDataWriter(&data, &writer) && cache.GetAtoms().Save(writer), false);
+
+	ff::StringCache loadedCache;
+	ff::ComPtr<ff::IDataReader> reader;
+	assertRetVal(ff::CreateDataReader(data, 0, &reader) && loadedCache.LoadAtoms(reader), false);
+
+	ff::String loadedName;
+	assertRetVal(loadedCache.FindLegacyString(ff::HashBytesLegacy(longName.c_str(), longName.size() * sizeof(wchar_t)), loadedName) && loadedName == longName, false);
+
+	return true;
+}
+
+bool AtomTableTest()
+{
+	assertRetVal(BasicAtomTableTest(), false);
+	assertRetVal(PersistAtomTableTest(), false);
+	assertRetVal(ThreadedAtomTableTest(), false);
+	assertRetVal(StringCacheAtomTest(), false);
+
+	return true;
+}
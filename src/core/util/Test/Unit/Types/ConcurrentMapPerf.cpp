@@ -0,0 +1,109 @@
+#include "pch.h"
+#include "App/Log.h"
+#include "App/Timer.h"
+#include "Types/ConcurrentMap.h"
+
+#include <iostream>
+#include <thread>
+
+static const size_t CONCURRENT_PERF_KEYS = 4096;
+static const size_t CONCURRENT_PERF_OPS = 1000000;
+static const size_t CONCURRENT_PERF_MAX_THREADS = 16;
+
+// The way StringCache used to work, one lock for everything
+class SingleLockMap
+{
+public:
+	bool TryAdd(ff::hash_t key, const ff::String &val)
+	{
+		{
+			ff::LockReader lock(_lock);
+			noAssertRetVal(_map.GetWithHash(key, key) == ff::INVALID_ITER, false);
+		}
+
+		ff::LockWriter lock(_lock);
+		noAssertRetVal(_map.GetWithHash(key, key) == ff::INVALID_ITER, false);
+
+		_map.SetKeyWithHash(key, key, val);
+		return true;
+	}
+
+	bool Get(ff::hash_t key, ff::String &val) const
+	{
+		ff::LockReader lock(_lock);
+		ff::BucketIter iter = _map.GetWithHash(key, key);
+		noAssertRetVal(iter != ff::INVALID_ITER, false);
+
+		val = _map.ValueAt(iter);
+		return true;
+	}
+
+private:
+	ff::FlatHashMap<ff::hash_t, ff::String, ff::NonHasher<ff::hash_t>> _map;
+	ff::ReaderWriterLock _lock;
+};
+
+// Like atomizing names while building dictionaries: mostly lookups of strings that are already cached
+template<typename MapType>
+static double RunConcurrentPerf(size_t threadCount, const ff::Vector<ff::hash_t> &keys, const ff::Vector<ff::String> &values)
+{
+	MapType map;
+	std::thread threads[CONCURRENT_PERF_MAX_THREADS];
+	ff::Timer timer;
+
+	for (size_t i = 0; i < threadCount; i++)
+	{
+		threads[i] = std::thread([&map, &keys, &values, i, threadCount]()
+		{
+			ff::String value;
+
+			for (size_t h = i, opCount = CONCURRENT_PERF_OPS / threadCount; opCount; h += 7, opCount--)
+			{
+				size_t index = h % keys.Size();
+
+				if (!map.Get(keys[index], value))
+				{
+					map.TryAdd(keys[index], values[index]);
+				}
+			}
+		});
+	}
+
+	for (size_t i = 0; i < threadCount; i++)
+	{
+		threads[i].join();
+	}
+
+	return timer.Tick();
+}
+
+bool ConcurrentMapPerfTest()
+{
+	ff::Vector<ff::hash_t> keys;
+	ff::Vector<ff::String> values;
+
+	for (size_t i = 0; i < CONCURRENT_PERF_KEYS; i++)
+	{
+		values.Push(ff::String::format_new(L"Name%lu", i));
+		keys.Push(ff::HashFunc(values.GetLast()));
+	}
+
+	for (size_t threadCount = 1; threadCount <= CONCURRENT_PERF_MAX_THREADS; threadCount *= 2)
+	{
+		double singleTime = RunConcurrentPerf<SingleLockMap>(threadCount, keys, values);
+		double shardTime = RunConcurrentPerf<ff::ConcurrentMap<ff::hash_t, ff::String, ff::NonHasher<ff::hash_t>>>(threadCount, keys, values);
+
+		ff::String status = ff::String::format_new(
+			L"Cache %lu ops on %lu threads: SingleLock:%fs, ConcurrentMap:%fs\r\n",
+			CONCURRENT_PERF_OPS,
+			threadCount,
+			singleTime,
+			shardTime);
+		ff::Log::DebugTraceF(status.c_str());
+		std::wcout << status.c_str();
+	}
+
+	std::wcout << L"\r\n";
+
+	return true;
+}
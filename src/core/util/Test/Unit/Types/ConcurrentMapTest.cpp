@@ -0,0 +1,93 @@
+#include "pch.h"
+#include "Types/ConcurrentMap.h"
+
+#include <thread>
+
+static bool BasicConcurrentMapTest()
+{
+	ff::ConcurrentMap<ff::String, int> map;
+	assertRetVal(map.IsEmpty(), false);
+
+	for (int i = 0; i < 1000; i++)
+	{
+		assertRetVal(map.TryAdd(ff::String::format_new(L"%d", i), i), false);
+	}
+
+	assertRetVal(!map.TryAdd(ff::String(L"10"), -1), false);
+	assertRetVal(map.Size() == 1000, false);
+
+	int value = 0;
+	assertRetVal(map.Get(ff::String(L"10"), value) && value == 10, false);
+	assertRetVal(!map.Get(ff::String(L"missing"), value), false);
+
+	map.SetKey(ff::String(L"10"), -10);
+	assertRetVal(map.Get(ff::String(L"10"), value) && value == -10, false);
+
+	assertRetVal(map.DeleteKey(ff::String(L"10")), false);
+	assertRetVal(!map.Exists(ff::String(L"10")), false);
+
+	size_t count = 0;
+	int total = 0;
+	map.ForEach([&count, &total](ff::StringRef key, int value)
+	{
+		count++;
+		total += value;
+	});
+
+	assertRetVal(count == 999 && total == 999 * 1000 / 2 - 10, false);
+
+	map.Clear();
+	assertRetVal(map.IsEmpty(), false);
+
+	return true;
+}
+
+// Every thread adds the same keys, only one of them can win each key
+static bool ThreadedConcurrentMapTest()
+{
+	const size_t threadCount = 8;
+	const size_t keyCount = 10000;
+
+	ff::ConcurrentMap<size_t, size_t> map;
+	size_t added[threadCount];
+	bool valid[threadCount];
+	std::thread threads[threadCount];
+
+	for (size_t i = 0; i < threadCount; i++)
+	{
+		threads[i] = std::thread([&map, &added, &valid, i, keyCount]()
+		{
+			added[i] = 0;
+			valid[i] = true;
+
+			for (size_t h = 0; h < keyCount; h++)
+			{
+				size_t key = (h + i * 1009) % keyCount;
+				added[i] += map.TryAdd(key, key * 2) ? 1 : 0;
+
+				size_t value;
+				valid[i] &= map.Get(key, value) && value == key * 2;
+			}
+		});
+	}
+
+	size_t totalAdded = 0;
+	for (size_t i = 0; i < threadCount; i++)
+	{
+		threads[i].join();
+		totalAdded += added[i];
+		assertRetVal(valid[i], false);
+	}
+
+	assertRetVal(totalAdded == keyCount && map.Size() == keyCount, false);
+
+	return true;
+}
+
+bool ConcurrentMapTest()
+{
+	assertRetVal(BasicConcurrentMapTest(), false);
+	assertRetVal(ThreadedConcurrentMapTest(), false);
+
+	return true;
+}
@@ -0,0 +1,99 @@
+#include "pch.h"
+#include "App/Log.h"
+#include "App/Timer.h"
+
+#include <iostream>
+
+static const size_t FLAT_MAP_PERF_LOOKUPS = 1000000;
+
+template<typename MapType, typename Key>
+static double RunFlatMapPerf(const ff::Vector<Key> &keys, const ff::Vector<Key> &lookups)
+{
+	MapType map;
+	for (size_t i = 0; i < keys.Size(); i++)
+	{
+		map.SetKey(keys[i], i);
+	}
+
+	size_t found = 0;
+	ff::Timer timer;
+
+	for (size_t i = 0; i < FLAT_MAP_PERF_LOOKUPS; i += lookups.Size())
+	{
+		for (const Key &key: lookups)
+		{
+			found += (map.Get(key) != ff::INVALID_ITER) ? 1 : 0;
+		}
+	}
+
+	double seconds = timer.Tick();
+	assert(found >= FLAT_MAP_PERF_LOOKUPS / 2);
+
+	return seconds;
+}
+
+template<typename Key>
+static void RunFlatMapPerfCompare(const wchar_t *name, const ff::Vector<Key> &keys)
+{
+	// Every other lookup misses
+	ff::Vector<Key> lookups;
+	for (size_t i = 0; i < 1000; i++)
+	{
+		Key key = keys[i * 7 % keys.Size()];
+		if (i & 1)
+		{
+			std::memset(&key, 0xEE, 4);
+		}
+
+		lookups.Push(key);
+	}
+
+	double setTime = RunFlatMapPerf<ff::Map<Key, size_t>, Key>(keys, lookups);
+	double flatHashTime = RunFlatMapPerf<ff::FlatHashMap<Key, size_t>, Key>(keys, lookups);
+	double flatTime = RunFlatMapPerf<ff::FlatMap<Key, size_t>, Key>(keys, lookups);
+
+	ff::String status = ff::String::format_new(
+		L"Get %s with %lu entries: Map:%fs, FlatHashMap:%fs, FlatMap:%fs\r\n",
+		name,
+		keys.Size(),
+		setTime,
+		flatHashTime,
+		flatTime);
+	ff::Log::DebugTraceF(status.c_str());
+	std::wcout << status.c_str();
+}
+
+static bool RunFlatMapPerfCompare(size_t entryCount)
+{
+	ff::Vector<size_t> intKeys;
+	ff::Vector<GUID> guidKeys;
+
+	for (size_t i = 0; i < entryCount; i++)
+	{
+		GUID guid;
+		guid.Data1 = static_cast<DWORD>(i * 2654435761u);
+		guid.Data2 = static_cast<WORD>(i);
+		guid.Data3 = static_cast<WORD>(i >> 16);
+		std::memset(guid.Data4, static_cast<int>(i), sizeof(guid.Data4));
+
+		intKeys.Push(i * 0x10001);
+		guidKeys.Push(guid);
+	}
+
+	RunFlatMapPerfCompare(L"size_t", intKeys);
+	RunFlatMapPerfCompare(L"GUID", guidKeys);
+
+	return true;
+}
+
+bool FlatMapPerfTest()
+{
+	assertRetVal(RunFlatMapPerfCompare(4), false);
+	assertRetVal(RunFlatMapPerfCompare(16), false);
+	assertRetVal(RunFlatMapPerfCompare(64), false);
+	assertRetVal(RunFlatMapPerfCompare(256), false);
+
+	std::wcout << L"\r\n";
+
+	return true;
+}
@@ -0,0 +1,163 @@
+#include "pch.h"
+
+template<typename Key>
+static bool FlatMapSearchTest(Key first, Key step)
+{
+	ff::Vector<Key> keys;
+	for (size_t i = 0; i < 100; i++)
+	{
+		keys.Push(static_cast<Key>(first + static_cast<Key>(i) * step));
+	}
+
+	// Every size and every key between the ones in the map, checked against a plain search
+	for (size_t size = 0; size <= keys.Size(); size++)
+	{
+		for (size_t i = 0; i <= size * 2; i++)
+		{
+			Key key = static_cast<Key>(first + static_cast<Key>(i) * step / 2 - 1);
+			size_t expect = 0;
+
+			while (expect < size && keys[expect] < key)
+			{
+				expect++;
+			}
+
+			size_t found = ff::details::FlatMapLowerBound<Key, ff::FlatMapLess<Key>>(keys.ConstData(), size, key);
+			assertRetVal(found == expect, false);
+		}
+	}
+
+	return true;
+}
+
+static GUID MakeTestGuid(size_t i)
+{
+	GUID guid;
+	std::memset(&guid, 0, sizeof(guid));
+	guid.Data1 = static_cast<DWORD>(i * 7919 % 1009);
+	guid.Data4[7] = static_cast<BYTE>(i);
+
+	return guid;
+}
+
+static bool FlatMapGuidTest()
+{
+	ff::FlatMap<GUID, size_t> map;
+
+	for (size_t i = 0; i < 200; i++)
+	{
+		map.SetKey(MakeTestGuid(i), i);
+	}
+
+	assertRetVal(map.Size() == 200, false);
+
+	for (size_t i = 0; i < 200; i++)
+	{
+		ff::BucketIter iter = map.Get(MakeTestGuid(i));
+		assertRetVal(iter != ff::INVALID_ITER && map.ValueAt(iter) == i, false);
+	}
+
+	GUID missing = MakeTestGuid(1000);
+	assertRetVal(!map.Exists(missing), false);
+
+	const GUID *prev = nullptr;
+	for (const auto &i: map)
+	{
+		assertRetVal(!prev || ff::FlatMapLess<GUID>()(*prev, i.GetKey()), false);
+		prev = &i.GetKey();
+	}
+
+	return true;
+}
+
+static bool FlatMapDupeTest()
+{
+	ff::FlatMap<ff::String, int> map;
+
+	map.Insert(ff::String(L"b"), 1);
+	map.Insert(ff::String(L"a"), 2);
+	map.Insert(ff::String(L"b"), 3);
+	map.SetKey(ff::String(L"c"), 4);
+	map.SetKey(ff::String(L"c"), 5);
+	assertRetVal(map.Size() == 4, false);
+
+	// duplicates come back in the order they were added
+	ff::BucketIter iter = map.Get(ff::String(L"b"));
+	assertRetVal(iter != ff::INVALID_ITER && map.ValueAt(iter) == 1, false);
+	iter = map.GetNext(iter);
+	assertRetVal(iter != ff::INVALID_ITER && map.ValueAt(iter) == 3, false);
+	assertRetVal(map.GetNext(iter) == ff::INVALID_ITER, false);
+	assertRetVal(map.ValueAt(map.Get(ff::String(L"c"))) == 5, false);
+
+	assertRetVal(map.DeleteKey(ff::String(L"b")), false);
+	assertRetVal(!map.DeleteKey(ff::String(L"b")), false);
+	assertRetVal(map.Size() == 2, false);
+
+	iter = map.DeletePos(map.Get(ff::String(L"a")));
+	assertRetVal(iter != ff::INVALID_ITER && map.KeyAt(iter) == L"c", false);
+	assertRetVal(map.DeletePos(iter) == ff::INVALID_ITER && map.IsEmpty(), false);
+
+	return true;
+}
+
+static bool FlatMapBuildTest()
+{
+	ff::Vector<size_t> keys;
+	ff::Vector<size_t> values;
+
+	for (size_t i = 0; i < 1000; i++)
+	{
+		keys.Push(i * 7919 % 500);
+		values.Push(i);
+	}
+
+	ff::FlatMap<size_t, size_t> map;
+	map.Build(std::move(keys), std::move(values));
+	assertRetVal(map.Size() == 1000 && keys.IsEmpty() && values.IsEmpty(), false);
+
+	size_t prevKey = 0;
+	size_t prevValue = 0;
+	for (const auto &i: map)
+	{
+		assertRetVal(i.GetKey() >= prevKey, false);
+		assertRetVal(i.GetKey() > prevKey || i.GetValue() >= prevValue, false);
+		prevKey = i.GetKey();
+		prevValue = i.GetValue();
+	}
+
+	for (size_t i = 0; i < 500; i++)
+	{
+		ff::BucketIter iter = map.Get(i);
+		assertRetVal(iter != ff::INVALID_ITER && map.GetNext(iter) != ff::INVALID_ITER, false);
+		assertRetVal(map.GetNext(map.GetNext(iter)) == ff::INVALID_ITER, false);
+	}
+
+	// Sorted input is moved in without sorting
+	for (size_t i = 0; i < 10; i++)
+	{
+		keys.Push(i);
+		values.Push(i * 2);
+	}
+
+	ff::FlatMap<size_t, size_t> sortedMap;
+	sortedMap.Build(std::move(keys), std::move(values));
+	assertRetVal(sortedMap.Size() == 10 && keys.IsEmpty() && values.IsEmpty(), false);
+	assertRetVal(sortedMap.ValueAt(sortedMap.Get(9)) == 18, false);
+
+	map = std::move(sortedMap);
+	assertRetVal(map.Size() == 10 && sortedMap.IsEmpty(), false);
+
+	return true;
+}
+
+bool FlatMapTest()
+{
+	assertRetVal(FlatMapSearchTest<int>(-50, 4), false);
+	assertRetVal(FlatMapSearchTest<uint64_t>(0xFFFFFFF0, 2), false);
+	assertRetVal(FlatMapSearchTest<double>(-10, 4), false);
+	assertRetVal(FlatMapGuidTest(), false);
+	assertRetVal(FlatMapDupeTest(), false);
+	assertRetVal(FlatMapBuildTest(), false);
+
+	return true;
+}
@@ -0,0 +1,80 @@
+#include "pch.h"
+#include "Types/FrameArena.h"
+
+static bool ArenaAllocTest()
+{
+	ff::FrameArena arena(256);
+
+	assertRetVal(arena.GetFrameBytes() == 0 && arena.GetReservedBytes() == 0, false);
+
+	BYTE *first = reinterpret_cast<BYTE *>(arena.Alloc(3, 1));
+	double *aligned = reinterpret_cast<double *>(arena.Alloc(sizeof(double), __alignof(double)));
+	assertRetVal(first && aligned && (reinterpret_cast<size_t>(aligned) % __alignof(double)) == 0, false);
+	assertRetVal(reinterpret_cast<BYTE *>(aligned) - first < 16, false);
+
+	// Doesn't fit in the first block
+	BYTE *big = reinterpret_cast<BYTE *>(arena.Alloc(1000));
+	std::memset(big, 1, 1000);
+	assertRetVal(arena.GetReservedBytes() >= 1256, false);
+
+	const wchar_t *str = arena.CopyString(L"Hello", 5);
+	assertRetVal(!std::wcscmp(str, L"Hello"), false);
+
+	size_t frameBytes = arena.GetFrameBytes();
+	assertRetVal(frameBytes >= 1000 + 3 + sizeof(double) + 6 * sizeof(wchar_t), false);
+
+	// The next frame gets one block big enough for everything
+	arena.Reset();
+	assertRetVal(arena.GetFrameBytes() == 0 && arena.GetLastFrameBytes() == frameBytes && arena.GetMaxFrameBytes() == frameBytes, false);
+	assertRetVal(arena.GetFrameCount() == 1 && arena.GetReservedBytes() >= frameBytes, false);
+
+	size_t reserved = arena.GetReservedBytes();
+	for (size_t i = 0; i < frameBytes / 16; i++)
+	{
+		arena.Alloc(16, 16);
+	}
+
+	arena.Reset();
+	assertRetVal(arena.GetReservedBytes() == reserved && arena.GetMaxFrameBytes() == frameBytes, false);
+
+	return true;
+}
+
+static bool FrameVectorTest()
+{
+	ff::FrameArena &arena = ff::GetFrameArena();
+	arena.Reset();
+
+	ff::FrameVector<int> ints;
+	for (int i = 0; i < 1000; i++)
+	{
+		ints.Push(i);
+	}
+
+	for (int i = 0; i < 1000; i++)
+	{
+		assertRetVal(ints[i] == i, false);
+	}
+
+	assertRetVal(arena.GetFrameBytes() >= 1000 * sizeof(int), false);
+
+	ff::FrameStringBuffer<16> buffer;
+	buffer.Push(L"Frame", 5);
+	buffer.Push(L'!');
+	buffer.Push(L'\0');
+	assertRetVal(!std::wcscmp(buffer.Data(), L"Frame!"), false);
+
+	ints.Clear();
+	buffer.Clear();
+	arena.Reset();
+
+	return true;
+}
+
+bool FrameArenaTest()
+{
+	assertRetVal(ArenaAllocTest(), false);
+	assertRetVal(FrameVectorTest(), false);
+
+	return true;
+}
@@ -0,0 +1,65 @@
+#include "pch.h"
+#include "App/Log.h"
+#include "App/Timer.h"
+
+#include <iostream>
+
+static bool RunHashPerf(size_t length)
+{
+	// Hash the same total amount of bytes for each length, starting at an odd address
+	const size_t totalBytes = 64 * 1024 * 1024;
+	const size_t count = totalBytes / length;
+
+	ff::Vector<BYTE> bytes;
+	bytes.Resize(length + 1);
+
+	for (size_t i = 0; i < bytes.Size(); i++)
+	{
+		bytes[i] = (BYTE)i;
+	}
+
+	const BYTE *data = bytes.Data() + 1;
+	ff::hash_t result = 0;
+	ff::Timer timer;
+
+	for (size_t i = 0; i < count; i++)
+	{
+		result ^= ff::HashBytes(data, length);
+	}
+
+	double hashTime = timer.Tick();
+
+	for (size_t i = 0; i < count; i++)
+	{
+		result ^= ff::HashBytesLegacy(data, length);
+	}
+
+	double legacyTime = timer.Tick();
+
+	ff::String status = ff::String::format_new(
+		L"Hash %lu byte keys: HashBytes:%.0fMB/s, HashBytesLegacy:%.0fMB/s (%I64x)\r\n",
+		length,
+		totalBytes / hashTime / (1024 * 1024),
+		totalBytes / legacyTime / (1024 * 1024),
+		result);
+	ff::Log::DebugTraceF(status.c_str());
+	std::wcout << status.c_str();
+
+	return true;
+}
+
+bool HashPerfTest()
+{
+	assertRetVal(RunHashPerf(2), false);
+	assertRetVal(RunHashPerf(8), false);
+	assertRetVal(RunHashPerf(16), false);
+	assertRetVal(RunHashPerf(24), false);
+	assertRetVal(RunHashPerf(32), false);
+	assertRetVal(RunHashPerf(64), false);
+	assertRetVal(RunHashPerf(256), false);
+	assertRetVal(RunHashPerf(4096), false);
+
+	std::wcout << L"\r\n";
+
+	return true;
+}
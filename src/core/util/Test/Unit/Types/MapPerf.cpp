@@ -0,0 +1,103 @@
+#include "pch.h"
+#include "App/Log.h"
+#include "App/Timer.h"
+
+#include <iostream>
+
+template<typename MapType>
+static void RunMapPerf(const ff::Vector<ff::String> &keys, const ff::Vector<ff::String> &missingKeys, double times[5])
+{
+	MapType map;
+	size_t found = 0;
+	ff::Timer timer;
+
+	for (size_t i = 0; i < keys.Size(); i++)
+	{
+		map.SetKey(keys[i], i);
+	}
+
+	times[0] = timer.Tick();
+
+	for (size_t i = 0; i < keys.Size(); i++)
+	{
+		found += (map.Get(keys[i]) != ff::INVALID_ITER) ? 1 : 0;
+	}
+
+	times[1] = timer.Tick();
+
+	for (size_t i = 0; i < missingKeys.Size(); i++)
+	{
+		found += (map.Get(missingKeys[i]) != ff::INVALID_ITER) ? 1 : 0;
+	}
+
+	times[2] = timer.Tick();
+
+	for (const auto &iter: map)
+	{
+		found += iter.GetValue() & 1;
+	}
+
+	times[3] = timer.Tick();
+
+	for (size_t i = 0; i < keys.Size(); i++)
+	{
+		map.DeleteKey(keys[i]);
+	}
+
+	times[4] = timer.Tick();
+
+	assert(found >= keys.Size() && map.IsEmpty());
+}
+
+static bool RunMapPerfCompare(size_t entryCount)
+{
+	ff::Vector<ff::String> keys;
+	ff::Vector<ff::String> missingKeys;
+
+	keys.Reserve(entryCount);
+	missingKeys.Reserve(entryCount);
+
+	for (size_t i = 0; i < entryCount; i++)
+	{
+		keys.Push(ff::String::format_new(L"%lu-%lu", i, i));
+		missingKeys.Push(ff::String::format_new(L"missing-%lu", i));
+	}
+
+	double setTimes[5];
+	double flatTimes[5];
+	double indexTimes[5];
+
+	RunMapPerf<ff::Map<ff::String, size_t>>(keys, missingKeys, setTimes);
+	RunMapPerf<ff::FlatHashMap<ff::String, size_t>>(keys, missingKeys, flatTimes);
+	RunMapPerf<ff::IndexMap<ff::String, size_t>>(keys, missingKeys, indexTimes);
+
+	const wchar_t *names[5] = { L"Insert", L"GetHit", L"GetMiss", L"Iterate", L"Delete" };
+
+	for (size_t i = 0; i < _countof(names); i++)
+	{
+		ff::String status = ff::String::format_new(
+			L"Map %s with %lu entries: Set:%fs, FlatHashSet:%fs, IndexSet:%fs\r\n",
+			names[i],
+			entryCount,
+			setTimes[i],
+			flatTimes[i],
+			indexTimes[i]);
+		ff::Log::DebugTraceF(status.c_str());
+		std::wcout << status.c_str();
+	}
+
+	std::wcout << L"\r\n";
+
+	return true;
+}
+
+bool MapPerfTest()
+{
+	assertRetVal(RunMapPerfCompare(10), false);
+	assertRetVal(RunMapPerfCompare(100), false);
+	assertRetVal(RunMapPerfCompare(1000), false);
+	assertRetVal(RunMapPerfCompare(10000), false);
+	assertRetVal(RunMapPerfCompare(100000), false);
+
+	return true;
+}
@@ -1,8 +1,9 @@
 #include "pch.h"
 
-bool MapTest()
+template<typename MapType>
+static bool MapTypeTest()
 {
-	ff::Map<ff::String, int> table;
+	MapType table;
 	std::array<wchar_t, 256> buf;
 
 	for (int i = 0; i < 1000; i++)
@@ -33,6 +34,11 @@ bool MapTest()
 
 		pos = table.GetNext(pos);
 		assertRetVal(pos == ff::INVALID_ITER, false);
+
+		ff::StringView view(buf.data(), str.size());
+		pos = table.GetWithHash(ff::HashFunc(view), view);
+		assertRetVal(pos != ff::INVALID_ITER && table.KeyAt(pos) == str, false);
+		assertRetVal(table.HashAt(pos) == ff::HashFunc(str), false);
 	}
 
 	assertRetVal(table.Size() == 2000, false);
@@ -53,6 +59,16 @@ bool MapTest()
 
 	assertRetVal(count == 2000, false);
 
+	ff::StringView missingView(L"missing", 7);
+	assertRetVal(table.GetWithHash(ff::HashFunc(missingView), missingView) == ff::INVALID_ITER, false);
+
+	ff::String missing(L"missing");
+	table.SetKeyWithHash(ff::HashFunc(missing), missing, 1);
+	table.SetKeyWithHash(ff::HashFunc(missing), missing, 2);
+	assertRetVal(table.Size() == 2001, false);
+	assertRetVal(table.ValueAt(table.GetWithHash(ff::HashFunc(missingView), missingView)) == 2, false);
+	assertRetVal(table.DeleteKey(missing), false);
+
 	for (const auto &iter: table)
 	{
 		int i = std::abs(iter.GetValue());
@@ -63,3 +79,105 @@ bool MapTest()
 
 	return true;
 }
+
+template<typename MapType>
+static bool MapDeleteTest()
+{
+	MapType table;
+
+	for (size_t i = 0; i < 5000; i++)
+	{
+		table.SetKey(i, i * 2);
+	}
+
+	// delete every other entry while iterating
+	size_t index = 0;
+	for (ff::BucketIter pos = table.StartIteration(); pos != ff::INVALID_ITER; index++)
+	{
+		pos = (table.KeyAt(pos) % 2) ? table.DeletePos(pos) : table.Iterate(pos);
+	}
+
+	assertRetVal(index == 5000, false);
+	assertRetVal(table.Size() == 2500, false);
+
+	for (size_t i = 0; i < 5000; i++)
+	{
+		ff::BucketIter pos = table.Get(i);
+		assertRetVal((pos != ff::INVALID_ITER) == !(i % 2), false);
+		assertRetVal(pos == ff::INVALID_ITER || table.ValueAt(pos) == i * 2, false);
+	}
+
+	// reuse deleted slots
+	for (size_t i = 0; i < 5000; i++)
+	{
+		table.SetKey(i, i * 3);
+		assertRetVal(!i || table.DeleteKey(i - 1), false);
+	}
+
+	assertRetVal(table.Size() == 1, false);
+	assertRetVal(table.ValueAt(table.Get(4999)) == 4999 * 3, false);
+
+	table.Clear();
+	assertRetVal(table.IsEmpty() && table.StartIteration() == ff::INVALID_ITER, false);
+
+	return true;
+}
+
+static bool FlatHashMapCopyCapacityTest()
+{
+	ff::FlatHashMap<size_t, size_t> table;
+	table.SetBucketCount(256, false);
+	table.SetKey(1, 2);
+
+	// a copy keeps the fixed capacity across Clear(), like the original
+	ff::FlatHashMap<size_t, size_t> copy(table);
+	copy.Clear();
+	table.Clear();
+	assertRetVal(copy.MemUsage() != 0 && table.MemUsage() != 0, false);
+
+	return true;
+}
+
+static bool IndexMapOrderTest()
+{
+	ff::IndexMap<size_t, size_t> table;
+
+	for (size_t i = 0; i < 1000; i++)
+	{
+		table.SetKey(i * 7, i);
+	}
+
+	// iteration follows insertion order until something is deleted
+	size_t index = 0;
+	for (const auto &iter: table)
+	{
+		assertRetVal(iter.GetKey() == index * 7 && iter.GetValue() == index, false);
+		assertRetVal(table.ValueAt(table.GetAt(index)) == index, false);
+		index++;
+	}
+
+	// the last entry fills the hole
+	assertRetVal(table.DeleteKey(0), false);
+	assertRetVal(table.KeyAt(table.GetAt(0)) == 999 * 7 && table.Size() == 999, false);
+
+	for (size_t i = 1; i < 1000; i++)
+	{
+		assertRetVal(table.ValueAt(table.Get(i * 7)) == i, false);
+	}
+
+	return true;
+}
+
+bool MapTest()
+{
+	assertRetVal((MapTypeTest<ff::Map<ff::String, int>>()), false);
+	assertRetVal((MapTypeTest<ff::FlatHashMap<ff::String, int>>()), false);
+	assertRetVal((MapTypeTest<ff::IndexMap<ff::String, int>>()), false);
+	assertRetVal((MapDeleteTest<ff::Map<size_t, size_t>>()), false);
+	assertRetVal((MapDeleteTest<ff::FlatHashMap<size_t, size_t>>()), false);
+	assertRetVal((MapDeleteTest<ff::IndexMap<size_t, size_t>>()), false);
+	assertRetVal(FlatHashMapCopyCapacityTest(), false);
+	assertRetVal(IndexMapOrderTest(), false);
+
+	return true;
+}
@@ -0,0 +1,145 @@
+#include "pch.h"
+#include "App/Log.h"
+#include "App/Timer.h"
+#include "String/NumberConvert.h"
+#include "String/StringFormat.h"
+
+#include <iostream>
+
+static const size_t NUMBER_PERF_COUNT = 1000000;
+
+// Like animation curves and positions in level data: a few whole numbers, mostly fractions
+static ff::Vector<double> MakePerfNumbers()
+{
+	ff::Vector<double> numbers;
+	numbers.Reserve(NUMBER_PERF_COUNT);
+
+	for (size_t i = 0; i < NUMBER_PERF_COUNT; i++)
+	{
+		switch (i % 4)
+		{
+		case 0:
+			numbers.Push(static_cast<double>(i));
+			break;
+
+		case 1:
+			numbers.Push(i / 1000.0);
+			break;
+
+		case 2:
+			numbers.Push(-1.0 / (i + 1));
+			break;
+
+		default:
+			numbers.Push(i * 1.0e-9 + 1.0e5);
+			break;
+		}
+	}
+
+	return numbers;
+}
+
+static void RunFormatNumberPerf(const ff::Vector<double> &numbers, ff::Vector<char> &text)
+{
+	wchar_t buffer[64];
+	size_t chars = 0;
+	ff::Timer timer;
+
+	for (double number : numbers)
+	{
+		// %.17g is what it takes for printf to round trip
+		chars += _snwprintf_s(buffer, _countof(buffer), _TRUNCATE, L"%.17g", number);
+	}
+
+	double printfTime = timer.Tick();
+
+	for (double number : numbers)
+	{
+		chars += ff::FormatDouble(number, buffer);
+	}
+
+	double formatTime = timer.Tick();
+
+	for (double number : numbers)
+	{
+		chars += ff::FormatFloat(static_cast<float>(number), buffer);
+	}
+
+	double floatTime = timer.Tick();
+	assert(chars);
+
+	// Text for the parse test, with a space after each number
+	text.Reserve(numbers.Size() * ff::MAX_NUMBER_CHARS);
+
+	for (double number : numbers)
+	{
+		size_t size = ff::FormatDouble(number, buffer);
+
+		for (size_t i = 0; i < size; i++)
+		{
+			text.Push(static_cast<char>(buffer[i]));
+		}
+
+		text.Push(' ');
+	}
+
+	ff::String status = FF_FORMAT(
+		L"Format {} numbers: printf %.17g:{}M/s, FormatDouble:{}M/s, FormatFloat:{}M/s\r\n",
+		numbers.Size(),
+		numbers.Size() / printfTime / 1000000.0,
+		numbers.Size() / formatTime / 1000000.0,
+		numbers.Size() / floatTime / 1000000.0);
+	ff::Log::DebugTrace(status.c_str());
+	std::wcout << status.c_str();
+}
+
+static bool RunParseNumberPerf(const ff::Vector<double> &numbers, const ff::Vector<char> &text)
+{
+	const char *end = text.ConstData() + text.Size();
+	double sum = 0;
+	ff::Timer timer;
+
+	for (const char *cur = text.ConstData(); cur != end; cur++)
+	{
+		char *numberEnd;
+		sum += strtod(cur, &numberEnd);
+		cur = numberEnd;
+	}
+
+	double strtodTime = timer.Tick();
+	size_t index = 0;
+
+	for (const char *cur = text.ConstData(); cur != end; cur++, index++)
+	{
+		double value;
+		cur += ff::ParseDouble(cur, end - cur, value);
+		assertRetVal(value == numbers[index], false);
+	}
+
+	double parseTime = timer.Tick();
+	assertRetVal(index == numbers.Size() && sum != 0, false);
+
+	ff::String status = FF_FORMAT(
+		L"Parse {} numbers ({}MB): strtod:{}M/s, ParseDouble:{}M/s\r\n",
+		numbers.Size(),
+		text.Size() / (1024.0 * 1024.0),
+		numbers.Size() / strtodTime / 1000000.0,
+		numbers.Size() / parseTime / 1000000.0);
+	ff::Log::DebugTrace(status.c_str());
+	std::wcout << status.c_str();
+
+	return true;
+}
+
+bool NumberConvertPerfTest()
+{
+	ff::Vector<double> numbers = MakePerfNumbers();
+	ff::Vector<char> text;
+
+	RunFormatNumberPerf(numbers, text);
+	assertRetVal(RunParseNumberPerf(numbers, text), false);
+
+	std::wcout << L"\r\n";
+
+	return true;
+}
@@ -0,0 +1,252 @@
+#include "pch.h"
+#include "String/NumberConvert.h"
+
+static const size_t NUMBER_TEST_COUNT = 200000;
+
+// xorshift64*, so every run tests the same numbers
+static uint64_t NextNumberBits(uint64_t &state)
+{
+	state ^= state >> 12;
+	state ^= state << 25;
+	state ^= state >> 27;
+	return state * 0x2545F4914F6CDD1Dull;
+}
+
+static double DoubleFromBits(uint64_t bits)
+{
+	double value;
+	std::memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+static uint64_t BitsFromDouble(double value)
+{
+	uint64_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	return bits;
+}
+
+static bool ParseDoubleText(const wchar_t *text, double &value)
+{
+	size_t size = wcslen(text);
+	return ff::ParseDouble(text, size, value) == size;
+}
+
+static ff::String FormatDoubleText(double value)
+{
+	wchar_t buffer[ff::MAX_NUMBER_CHARS];
+	return ff::String(buffer, ff::FormatDouble(value, buffer));
+}
+
+static ff::String FormatFloatText(float value)
+{
+	wchar_t buffer[ff::MAX_NUMBER_CHARS];
+	return ff::String(buffer, ff::FormatFloat(value, buffer));
+}
+
+// Digits of the mantissa, without leading or trailing zeros
+static size_t SignificantDigits(ff::StringRef text)
+{
+	ff::String digits;
+	for (wchar_t ch : text)
+	{
+		if (ch == 'e')
+		{
+			break;
+		}
+		else if (ch >= '0' && ch <= '9' && (ch != '0' || !digits.empty()))
+		{
+			digits.append(1, ch);
+		}
+	}
+
+	while (!digits.empty() && digits.back() == '0')
+	{
+		digits.pop_back();
+	}
+
+	return digits.size();
+}
+
+static bool KnownNumberTest()
+{
+	struct KnownNumber
+	{
+		const wchar_t *text;
+		uint64_t bits;
+	};
+
+	const KnownNumber parses[] =
+	{
+		{ L"0", 0 },
+		{ L"-0", 0x8000000000000000ull },
+		{ L"1", 0x3FF0000000000000ull },
+		{ L"0.1", 0x3FB999999999999Aull },
+		{ L"+1.5e1", 0x402E000000000000ull },
+		{ L"5.", 0x4014000000000000ull },
+		{ L".25", 0x3FD0000000000000ull },
+		{ L"9007199254740993", 0x4340000000000000ull }, // halfway, rounds to even
+		{ L"9007199254740993.0000000001", 0x4340000000000001ull }, // just over halfway
+		{ L"1.7976931348623157e308", 0x7FEFFFFFFFFFFFFFull },
+		{ L"2.2250738585072014E-308", 0x0010000000000000ull },
+		{ L"4.9406564584124654e-324", 0x0000000000000001ull }, // subnormal, goes to strtod
+		{ L"1e-400", 0 },
+		{ L"0.000000000000000000000000000001", 0x39B4484BFEEBC2A0ull },
+		{ L"123456789012345678901234567890", 0x45F8EE90FF6C373Eull },
+		{ L"-98.76e54", 0xCB901C68F8985C06ull },
+	};
+
+	for (const KnownNumber &known : parses)
+	{
+		double value;
+		assertRetVal(ParseDoubleText(known.text, value), false);
+		assertRetVal(BitsFromDouble(value) == known.bits, false);
+	}
+
+	// Only part of the text is a number
+	double value;
+	assertRetVal(ff::ParseDouble(L"12e", 3, value) == 2 && value == 12, false);
+	assertRetVal(ff::ParseDouble(L"1.5,", 4, value) == 3 && value == 1.5, false);
+	assertRetVal(ff::ParseDouble("-7e+2]", 6, value) == 5 && value == -700, false);
+	assertRetVal(ff::ParseDouble(L"123456", 3, value) == 3 && value == 123, false);
+	assertRetVal(!ff::ParseDouble(L"-", 1, value), false);
+	assertRetVal(!ff::ParseDouble(L".e5", 3, value), false);
+	assertRetVal(!ff::ParseDouble(L"inf", 3, value), false);
+
+	struct KnownText
+	{
+		double value;
+		const wchar_t *text;
+	};
+
+	const KnownText doubles[] =
+	{
+		{ 0.0, L"0" },
+		{ -0.0, L"-0" },
+		{ 100.0, L"100" },
+		{ 8.5, L"8.5" },
+		{ 0.1, L"0.1" },
+		{ 0.1 + 0.2, L"0.30000000000000004" },
+		{ 123456789.5, L"123456789.5" },
+		{ 0.0001, L"0.0001" },
+		{ 0.00001, L"1e-05" },
+		{ 1e-8, L"1e-08" },
+		{ -98.76e54, L"-9.876e+55" },
+		{ 1e16, L"10000000000000000" },
+		{ 1e17, L"1e+17" },
+		{ 1.7976931348623157e308, L"1.7976931348623157e+308" },
+		{ DoubleFromBits(1), L"5e-324" },
+		{ std::numeric_limits<double>::infinity(), L"inf" },
+		{ -std::numeric_limits<double>::infinity(), L"-inf" },
+		{ std::numeric_limits<double>::quiet_NaN(), L"nan" },
+	};
+
+	for (const KnownText &known : doubles)
+	{
+		assertRetVal(FormatDoubleText(known.value) == known.text, false);
+	}
+
+	assertRetVal(FormatFloatText(0.1f) == L"0.1", false);
+	assertRetVal(FormatFloatText(-2.5f) == L"-2.5", false);
+	assertRetVal(FormatFloatText(16777216.0f) == L"16777216", false);
+	assertRetVal(FormatFloatText(3.4028235e38f) == L"3.4028235e+38", false);
+	assertRetVal(FormatFloatText(1e-45f) == L"1e-45", false);
+	assertRetVal(FormatFloatText(1.0f / 3.0f) == L"0.33333334", false);
+
+	return true;
+}
+
+// Any double has to come back exactly from its shortest text, and the text can't be
+// any longer than the fewest digits of %e that get the same double back
+static bool RoundTripNumberTest()
+{
+	uint64_t state = 0x9E3779B97F4A7C15ull;
+
+	for (size_t i = 0; i < NUMBER_TEST_COUNT; i++)
+	{
+		uint64_t bits = NextNumberBits(state);
+		if (((bits >> 52) & 0x7FF) == 0x7FF)
+		{
+			continue;
+		}
+
+		double value = DoubleFromBits(bits);
+		ff::String text = FormatDoubleText(value);
+
+		double parsed;
+		assertRetVal(ParseDoubleText(text.c_str(), parsed), false);
+		assertRetVal(BitsFromDouble(parsed) == bits, false);
+
+		char shortest[32];
+		for (int precision = 1; precision <= 17; precision++)
+		{
+			_snprintf_s(shortest, _countof(shortest), _TRUNCATE, "%.*e", precision - 1, value);
+			if (strtod(shortest, nullptr) == value)
+			{
+				assertRetVal(SignificantDigits(text) <= static_cast<size_t>(precision), false);
+				break;
+			}
+		}
+	}
+
+	for (size_t i = 0; i < NUMBER_TEST_COUNT; i++)
+	{
+		uint32_t bits = static_cast<uint32_t>(NextNumberBits(state) >> 32);
+		if (((bits >> 23) & 0xFF) == 0xFF)
+		{
+			continue;
+		}
+
+		float value;
+		std::memcpy(&value, &bits, sizeof(value));
+		ff::String text = FormatFloatText(value);
+
+		double parsed;
+		assertRetVal(ParseDoubleText(text.c_str(), parsed), false);
+		assertRetVal(static_cast<float>(parsed) == value, false);
+	}
+
+	return true;
+}
+
+// Random digits and exponents have to parse exactly like strtod does it
+static bool ParseNumberTest()
+{
+	uint64_t state = 0x2545F4914F6CDD1Dull;
+	char text[64];
+
+	for (size_t i = 0; i < NUMBER_TEST_COUNT; i++)
+	{
+		uint64_t bits = NextNumberBits(state);
+		size_t digitCount = 1 + bits % 25;
+		int exponent = static_cast<int>((bits >> 8) % 700) - 350;
+		size_t size = 0;
+
+		for (size_t h = 0; h < digitCount; h++)
+		{
+			text[size++] = static_cast<char>('0' + NextNumberBits(state) % 10);
+
+			if (h == digitCount / 2 && (bits & 0x10000))
+			{
+				text[size++] = '.';
+			}
+		}
+
+		size += _snprintf_s(text + size, _countof(text) - size, _TRUNCATE, "e%d", exponent);
+
+		double value;
+		assertRetVal(ff::ParseDouble(text, size, value) == size, false);
+		assertRetVal(BitsFromDouble(value) == BitsFromDouble(strtod(text, nullptr)), false);
+	}
+
+	return true;
+}
+
+bool NumberConvertTest()
+{
+	assertRetVal(KnownNumberTest(), false);
+	assertRetVal(RoundTripNumberTest(), false);
+	assertRetVal(ParseNumberTest(), false);
+
+	return true;
+}
@@ -1,5 +1,7 @@
 #include "pch.h"
 
+#include <thread>
+
 static bool InternalPoolTest(bool threadSafe)
 {
 	typedef std::tuple<int, float> TestData;
@@ -13,6 +15,8 @@ static bool InternalPoolTest(bool threadSafe)
 		*data = TestData(i, (float)i);
 	}
 
+	assertRetVal(pool.GetCurAlloc() == 256 && pool.GetMaxAlloc() == 256, false);
+
 	for(int i = 256 - 1; i >= 0; i--)
 	{
 		assertRetVal(std::get<0>(*all[i]) == i && std::get<1>(*all[i]) == (float)i, false);
@@ -24,6 +28,7 @@ static bool InternalPoolTest(bool threadSafe)
 	}
 
 	all.Clear();
+	assertRetVal(pool.GetCurAlloc() == 0, false);
 
 	// now do it all again
 	for(int i = 0; i < 256; i++)
@@ -44,6 +49,79 @@ static bool InternalPoolTest(bool threadSafe)
 	}
 
 	all.Clear();
+	assertRetVal(pool.GetCurAlloc() == 0 && pool.GetTotalAlloc() == 512, false);
+
+	return true;
+}
+
+// Objects are allocated on one thread and deleted on another
+static bool CrossThreadPoolTest()
+{
+	const size_t threadCount = 4;
+	const size_t objCount = 1000;
+
+	typedef std::tuple<size_t, size_t> TestData;
+	ff::PoolAllocator<TestData> pool(true);
+	ff::Vector<TestData *> all[threadCount];
+	std::thread threads[threadCount];
+
+	for (size_t i = 0; i < threadCount; i++)
+	{
+		threads[i] = std::thread([&pool, &all, i, objCount]()
+		{
+			for (size_t h = 0; h < objCount; h++)
+			{
+				all[i].Push(pool.New(TestData(i, h)));
+			}
+		});
+	}
+
+	for (std::thread &thread: threads)
+	{
+		thread.join();
+	}
+
+	assertRetVal(pool.GetCurAlloc() == threadCount * objCount, false);
+	assertRetVal(pool.GetMaxAlloc() == threadCount * objCount, false);
+
+	bool valid[threadCount];
+
+	for (size_t i = 0; i < threadCount; i++)
+	{
+		threads[i] = std::thread([&pool, &all, &valid, i, threadCount, objCount]()
+		{
+			size_t other = (i + 1) % threadCount;
+			valid[i] = true;
+
+			for (size_t h = 0; h < objCount; h++)
+			{
+				TestData *data = all[other][h];
+				valid[i] &= (*data == TestData(other, h));
+				pool.Delete(data);
+
+				// mix in some local allocations
+				if (h % 3 == 0)
+				{
+					pool.Delete(pool.New(TestData(i, h)));
+				}
+			}
+		});
+	}
+
+	for (size_t i = 0; i < threadCount; i++)
+	{
+		threads[i].join();
+		assertRetVal(valid[i], false);
+	}
+
+	assertRetVal(pool.GetCurAlloc() == 0, false);
+	assertRetVal(pool.GetTotalAlloc() == threadCount * (objCount + (objCount + 2) / 3), false);
+	assertRetVal(pool.GetMaxAlloc() >= threadCount * objCount, false);
+
+	// objects left in the magazines of finished threads are still usable from this one
+	TestData *data = pool.New(TestData(0, 0));
+	assertRetVal(pool.GetCurAlloc() == 1, false);
+	pool.Delete(data);
 
 	return true;
 }
@@ -52,6 +130,7 @@ bool PoolTest()
 {
 	assertRetVal(InternalPoolTest(false), false);
 	assertRetVal(InternalPoolTest(true), false);
+	assertRetVal(CrossThreadPoolTest(), false);
 
 	return true;
 }
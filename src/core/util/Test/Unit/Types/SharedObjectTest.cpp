@@ -0,0 +1,209 @@
+#include "pch.h"
+
+#include <thread>
+
+// STATIC_DATA (pod)
+static long s_destroyedCount = 0;
+
+class DestroyCounter
+{
+public:
+	~DestroyCounter()
+	{
+		::InterlockedIncrement(&s_destroyedCount);
+	}
+};
+
+typedef ff::SharedObject<DestroyCounter> SharedCounter;
+
+static SharedCounter *NewSharedCounter()
+{
+	SharedCounter *obj = nullptr;
+	SharedCounter::GetUnshared(&obj);
+	return obj;
+}
+
+// The main thread owns the object and other threads add and release references
+static bool OwnerThreadRefsTest()
+{
+	long destroyed = s_destroyedCount;
+	ff::SmartPtr<SharedCounter> obj;
+	obj.Attach(NewSharedCounter());
+	assertRetVal(obj->IsOwnerThread() && !obj->IsShared(), false);
+
+	std::thread threads[4];
+	for (std::thread &thread: threads)
+	{
+		ff::SmartPtr<SharedCounter> copy = obj;
+
+		thread = std::thread([copy]()
+		{
+			for (size_t i = 0; i < 10000; i++)
+			{
+				ff::SmartPtr<SharedCounter> copy2 = copy;
+				ff::SmartPtr<SharedCounter> copy3 = copy2;
+			}
+		});
+	}
+
+	for (size_t i = 0; i < 10000; i++)
+	{
+		ff::SmartPtr<SharedCounter> copy = obj;
+	}
+
+	for (std::thread &thread: threads)
+	{
+		thread.join();
+	}
+
+	assertRetVal(!obj->IsShared() && s_destroyedCount == destroyed, false);
+
+	// The threads released the copies that they captured, which the owner has to merge
+	obj = nullptr;
+	ff::MergeBiasedRefs();
+	assertRetVal(s_destroyedCount == destroyed + 1, false);
+
+	return true;
+}
+
+// The owner lets go first, so the last reference is released on another thread
+static bool MergedRefsTest()
+{
+	long destroyed = s_destroyedCount;
+	ff::SmartPtr<SharedCounter> obj;
+	obj.Attach(NewSharedCounter());
+
+	ff::SmartPtr<SharedCounter> copy;
+	std::thread([&obj, &copy]()
+	{
+		copy = obj;
+	}).join();
+
+	obj = nullptr;
+	assertRetVal(s_destroyedCount == destroyed, false);
+
+	std::thread([&copy]()
+	{
+		copy = nullptr;
+	}).join();
+
+	assertRetVal(s_destroyedCount == destroyed + 1, false);
+
+	return true;
+}
+
+// The owner's reference is handed off without an AddRef, so the owner has to merge later
+static bool QueuedMergeTest()
+{
+	long destroyed = s_destroyedCount;
+	SharedCounter *obj = NewSharedCounter();
+
+	std::thread thread([obj]()
+	{
+		obj->Release();
+	});
+
+	thread.join();
+	assertRetVal(s_destroyedCount == destroyed, false);
+
+	ff::MergeBiasedRefs();
+	assertRetVal(s_destroyedCount == destroyed + 1, false);
+
+	return true;
+}
+
+// Objects can outlive the thread that owns them
+static bool EndedOwnerTest()
+{
+	long destroyed = s_destroyedCount;
+	SharedCounter *obj = nullptr;
+	SharedCounter *obj2 = nullptr;
+
+	std::thread thread([&obj, &obj2]()
+	{
+		ff::BeginBiasedRefThread();
+		obj = NewSharedCounter();
+		obj2 = NewSharedCounter();
+		obj2->AddRef();
+		obj2->Release();
+		ff::EndBiasedRefThread();
+	});
+
+	thread.join();
+	assertRetVal(obj->IsShared() == false && !obj->IsOwnerThread(), false);
+
+	obj->AddRef();
+	obj->Release();
+	assertRetVal(s_destroyedCount == destroyed, false);
+
+	obj->Release();
+	obj2->Release();
+	assertRetVal(s_destroyedCount == destroyed + 2, false);
+
+	return true;
+}
+
+// Strings copied back and forth between threads that all own some of them
+static bool ThreadedStringRefsTest()
+{
+	const size_t threadCount = 4;
+	const size_t stringCount = 256;
+
+	ff::Vector<ff::String> strings;
+	for (size_t i = 0; i < stringCount; i++)
+	{
+		strings.Push(ff::String::format_new(L"String%lu", i));
+	}
+
+	ff::Vector<ff::String> results[threadCount];
+	bool valid[threadCount];
+	std::thread threads[threadCount];
+
+	for (size_t i = 0; i < threadCount; i++)
+	{
+		threads[i] = std::thread([&strings, &results, &valid, i]()
+		{
+			ff::BeginBiasedRefThread();
+			valid[i] = true;
+
+			for (size_t h = 0; h < 100; h++)
+			{
+				ff::Vector<ff::String> copies = strings;
+				ff::String mine = ff::String::format_new(L"Thread%lu", i);
+				results[i].Push(mine);
+				results[i].Push(copies[h % stringCount]);
+				valid[i] &= copies[h % stringCount] == strings[h % stringCount];
+				ff::MergeBiasedRefs();
+			}
+
+			ff::EndBiasedRefThread();
+		});
+	}
+
+	for (size_t i = 0; i < threadCount; i++)
+	{
+		threads[i].join();
+		assertRetVal(valid[i], false);
+	}
+
+	for (size_t i = 0; i < threadCount; i++)
+	{
+		results[i].Clear();
+	}
+
+	strings.Clear();
+	ff::MergeBiasedRefs();
+
+	return true;
+}
+
+bool SharedObjectTest()
+{
+	assertRetVal(OwnerThreadRefsTest(), false);
+	assertRetVal(MergedRefsTest(), false);
+	assertRetVal(QueuedMergeTest(), false);
+	assertRetVal(EndedOwnerTest(), false);
+	assertRetVal(ThreadedStringRefsTest(), false);
+
+	return true;
+}
@@ -0,0 +1,164 @@
+#include "pch.h"
+#include "Types/SlabAllocator.h"
+
+#include <thread>
+
+static const ff::SlabSizeClassStats &GetSizeStats(const ff::Vector<ff::SlabSizeClassStats> &stats, size_t bytes)
+{
+	for (const ff::SlabSizeClassStats &stat: stats)
+	{
+		if (stat._size >= bytes)
+		{
+			return stat;
+		}
+	}
+
+	return stats.GetLast();
+}
+
+static bool SlabSizesTest()
+{
+	ff::SlabAllocator slabs;
+	ff::Vector<BYTE *> all;
+
+	for (size_t i = 0; i <= ff::SlabAllocator::MAX_SIZE + 256; i += 7)
+	{
+		BYTE *mem = reinterpret_cast<BYTE *>(slabs.Alloc(i));
+		assertRetVal(mem && (reinterpret_cast<size_t>(mem) & 15) == 0, false);
+
+		std::memset(mem, (int)(i & 0xFF), i);
+		all.Push(mem);
+	}
+
+	for (size_t i = 0, h = 0; h < all.Size(); i += 7, h++)
+	{
+		for (size_t j = 0; j < i; j++)
+		{
+			assertRetVal(all[h][j] == (BYTE)(i & 0xFF), false);
+		}
+	}
+
+	for (BYTE *mem: all)
+	{
+		slabs.Free(mem);
+	}
+
+	ff::Vector<ff::SlabSizeClassStats> stats;
+	slabs.GetStats(stats);
+	assertRetVal(stats.Size() == slabs.GetSizeClassCount() + 1, false);
+
+	for (const ff::SlabSizeClassStats &stat: stats)
+	{
+		assertRetVal(stat._curAlloc == 0 && stat._totalAlloc > 0, false);
+	}
+
+	return true;
+}
+
+static bool SlabStatsTest()
+{
+	ff::SlabAllocator slabs;
+	ff::Vector<void *> all;
+	ff::Vector<ff::SlabSizeClassStats> stats;
+
+	for (size_t i = 0; i < 10000; i++)
+	{
+		all.Push(slabs.Alloc(100));
+	}
+
+	all.Push(slabs.Alloc(100000));
+
+	slabs.GetStats(stats);
+	assertRetVal(GetSizeStats(stats, 100)._curAlloc == 10000, false);
+	assertRetVal(GetSizeStats(stats, 100)._slabs >= 10000 * 100 / ff::SlabAllocator::SLAB_SIZE, false);
+	assertRetVal(stats.GetLast()._curAlloc == 1, false);
+
+	for (void *mem: all)
+	{
+		slabs.Free(mem);
+	}
+
+	// Drained slabs go back to the OS, except for the ones still holding this thread's cache
+	// and one spare empty slab
+	slabs.GetStats(stats);
+	assertRetVal(GetSizeStats(stats, 100)._curAlloc == 0 && GetSizeStats(stats, 100)._maxAlloc == 10000, false);
+	assertRetVal(GetSizeStats(stats, 100)._slabs <= 3, false);
+	assertRetVal(stats.GetLast()._curAlloc == 0 && stats.GetLast()._totalAlloc == 1, false);
+
+	return true;
+}
+
+static bool SlabThreadTest()
+{
+	const size_t threadCount = 4;
+	const size_t allocCount = 2000;
+
+	ff::SlabAllocator slabs;
+	ff::Vector<size_t *> all[threadCount];
+	std::thread threads[threadCount];
+
+	for (size_t i = 0; i < threadCount; i++)
+	{
+		threads[i] = std::thread([&slabs, &all, i, allocCount]()
+		{
+			for (size_t h = 0; h < allocCount; h++)
+			{
+				size_t *mem = reinterpret_cast<size_t *>(slabs.Alloc(sizeof(size_t) * (1 + h % 64)));
+				*mem = i * allocCount + h;
+				all[i].Push(mem);
+			}
+		});
+	}
+
+	for (std::thread &thread: threads)
+	{
+		thread.join();
+	}
+
+	bool valid[threadCount];
+
+	// Free everything on a different thread than it was allocated on
+	for (size_t i = 0; i < threadCount; i++)
+	{
+		threads[i] = std::thread([&slabs, &all, &valid, i, threadCount, allocCount]()
+		{
+			size_t other = (i + 1) % threadCount;
+			valid[i] = true;
+
+			for (size_t h = 0; h < allocCount; h++)
+			{
+				valid[i] &= (*all[other][h] == other * allocCount + h);
+				slabs.Free(all[other][h]);
+			}
+		});
+	}
+
+	for (size_t i = 0; i < threadCount; i++)
+	{
+		threads[i].join();
+		assertRetVal(valid[i], false);
+	}
+
+	ff::Vector<ff::SlabSizeClassStats> stats;
+	slabs.GetStats(stats);
+
+	size_t totalAlloc = 0;
+	for (const ff::SlabSizeClassStats &stat: stats)
+	{
+		assertRetVal(stat._curAlloc == 0, false);
+		totalAlloc += stat._totalAlloc;
+	}
+
+	assertRetVal(totalAlloc == threadCount * allocCount, false);
+
+	return true;
+}
+
+bool SlabAllocatorTest()
+{
+	assertRetVal(SlabSizesTest(), false);
+	assertRetVal(SlabStatsTest(), false);
+	assertRetVal(SlabThreadTest(), false);
+
+	return true;
+}
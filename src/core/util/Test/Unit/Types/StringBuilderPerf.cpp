@@ -0,0 +1,58 @@
+#include "pch.h"
+#include "App/Log.h"
+#include "App/Timer.h"
+#include "String/StringBuilder.h"
+#include "String/StringFormat.h"
+
+#include <iostream>
+
+static const size_t BUILDER_PERF_LINES = 20000;
+
+// Like JsonWrite output: indents, quoted names, and short values.
+// String grows linearly once it gets big, so it falls further behind with more lines.
+bool StringBuilderPerfTest()
+{
+	ff::String name(L"\"name\"");
+	ff::String value(L"\"some value\"");
+	ff::Timer timer;
+
+	ff::String text;
+	for (size_t i = 0; i < BUILDER_PERF_LINES; i++)
+	{
+		text.append(4, L' ');
+		text.append(name);
+		text.append(L": ", 2);
+		text.append(value);
+		text.append(L",\r\n", 3);
+	}
+
+	double stringTime = timer.Tick();
+
+	ff::StringBuilder builder;
+	for (size_t i = 0; i < BUILDER_PERF_LINES; i++)
+	{
+		builder.Append(4, L' ');
+		builder.Append(name);
+		builder.Append(L": ", 2);
+		builder.Append(value);
+		builder.Append(L",\r\n", 3);
+	}
+
+	double builderTime = timer.Tick();
+
+	ff::String builderText = builder.ToString();
+	double toStringTime = timer.Tick();
+	assertRetVal(builderText == text, false);
+
+	ff::String status = FF_FORMAT(
+		L"Build {} lines ({} chars): String:{}s, StringBuilder:{}s, ToString:{}s\r\n",
+		BUILDER_PERF_LINES,
+		text.size(),
+		stringTime,
+		builderTime,
+		toStringTime);
+	ff::Log::DebugTrace(status.c_str());
+	std::wcout << status.c_str() << L"\r\n";
+
+	return true;
+}
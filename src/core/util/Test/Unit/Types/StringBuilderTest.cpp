@@ -0,0 +1,95 @@
+#include "pch.h"
+#include "Data/Data.h"
+#include "Data/DataWriterReader.h"
+#include "String/StringBuilder.h"
+
+// Appends pieces of every size, so they land on chunk boundaries and go past them
+static void AppendTestText(ff::StringBuilder &builder, ff::String &expect, size_t count)
+{
+	const wchar_t *text = L"0123456789abcdefghijklmnopqrstuvwxyz";
+
+	for (size_t i = 0; i < count; i++)
+	{
+		switch (i % 4)
+		{
+		case 0:
+			builder.Append(text[i % 36]);
+			expect.append(1, text[i % 36]);
+			break;
+
+		case 1:
+			builder.Append(text, i % 37);
+			expect.append(text, i % 37);
+			break;
+
+		case 2:
+			builder.Append(i % 500, L' ');
+			expect.append(i % 500, L' ');
+			break;
+
+		case 3:
+			builder += ff::String(L"\r\n");
+			expect.append(L"\r\n");
+			break;
+		}
+	}
+}
+
+static bool BasicStringBuilderTest()
+{
+	ff::StringBuilder builder;
+	assertRetVal(builder.IsEmpty() && builder.ToString().empty(), false);
+
+	ff::String expect;
+	AppendTestText(builder, expect, 5000);
+	assertRetVal(builder.GetSize() == expect.size() && builder.ToString() == expect, false);
+
+	// One piece that's bigger than any chunk
+	ff::String big(200 * 1024, L'x');
+	builder.Append(big);
+	expect.append(big);
+	assertRetVal(builder.ToString() == expect, false);
+
+	ff::StringBuilder moved(std::move(builder));
+	assertRetVal(builder.IsEmpty() && moved.ToString() == expect, false);
+
+	builder = std::move(moved);
+	assertRetVal(moved.IsEmpty() && builder.ToString() == expect, false);
+
+	builder.Clear();
+	assertRetVal(builder.IsEmpty(), false);
+
+	builder.Append(L"reused");
+	assertRetVal(builder.GetSize() == 6 && builder.ToString() == L"reused", false);
+
+	return true;
+}
+
+static bool WriterStringBuilderTest()
+{
+	ff::StringBuilder builder;
+	ff::String expect;
+	AppendTestText(builder, expect, 3000);
+
+	ff::ComPtr<ff::IDataVector> data;
+	ff::ComPtr<ff::IDataWriter> writer;
+	assertRetVal(ff::CreateDataWriter(&data, &writer), false);
+	assertRetVal(builder.Flush(writer) && builder.IsEmpty(), false);
+
+	builder.Append(L"end");
+	expect.append(L"end");
+	assertRetVal(builder.Flush(writer), false);
+
+	assertRetVal(data->GetSize() == expect.size() * sizeof(wchar_t), false);
+	assertRetVal(!std::memcmp(data->GetMem(), expect.c_str(), data->GetSize()), false);
+
+	return true;
+}
+
+bool StringBuilderTest()
+{
+	assertRetVal(BasicStringBuilderTest(), false);
+	assertRetVal(WriterStringBuilderTest(), false);
+
+	return true;
+}
@@ -0,0 +1,98 @@
+#include "pch.h"
+#include "App/Log.h"
+#include "App/Timer.h"
+#include "String/StringConvert.h"
+#include "String/StringFormat.h"
+#include "String/StringSearch.h"
+
+#include <iostream>
+
+static const size_t CONVERT_PERF_SIZE = 1024 * 1024;
+static const size_t CONVERT_PERF_LOOPS = 20;
+
+// JSON-like text, with one non-ASCII name out of every "rareEvery" entries
+static ff::Vector<char> MakeConvertPerfText(size_t rareEvery)
+{
+	ff::Vector<char> text;
+	text.Reserve(CONVERT_PERF_SIZE + 64);
+
+	for (size_t i = 0; text.Size() < CONVERT_PERF_SIZE; i++)
+	{
+		const char *entry = (i % rareEvery) ? "  \"name\": \"value\", \"count\": 1234,\r\n" : "  \"nom\": \"caf\xC3\xA9 \xE2\x82\xAC\", \"count\": 1234,\r\n";
+		text.Push(entry, strlen(entry));
+	}
+
+	return text;
+}
+
+static void RunConvertPerf(const wchar_t *name, const ff::Vector<char> &text)
+{
+	ff::Vector<wchar_t> wide;
+	ff::Vector<char> narrow;
+	wide.Resize(text.Size());
+	narrow.Resize(text.Size() * 3);
+
+	ff::Timer timer;
+	int wideCount = 0;
+	int narrowCount = 0;
+
+	for (size_t i = 0; i < CONVERT_PERF_LOOPS; i++)
+	{
+		wideCount = MultiByteToWideChar(CP_UTF8, 0, text.Data(), (int)text.Size(), wide.Data(), (int)wide.Size());
+	}
+
+	double winWideTime = timer.Tick();
+
+	for (size_t i = 0; i < CONVERT_PERF_LOOPS; i++)
+	{
+		narrowCount = WideCharToMultiByte(CP_UTF8, 0, wide.Data(), wideCount, narrow.Data(), (int)narrow.Size(), nullptr, nullptr);
+	}
+
+	double winNarrowTime = timer.Tick();
+	double wideTimes[3];
+	double narrowTimes[3];
+
+	for (size_t level = 0; level < 3; level++)
+	{
+		ff::SetSimdLevel(static_cast<ff::SimdLevel>(level));
+		timer.Tick();
+
+		for (size_t i = 0; i < CONVERT_PERF_LOOPS; i++)
+		{
+			size_t count = ff::Utf8ToUtf16(text.Data(), text.Size(), wide.Data());
+			assert(count == (size_t)wideCount);
+		}
+
+		wideTimes[level] = timer.Tick();
+
+		for (size_t i = 0; i < CONVERT_PERF_LOOPS; i++)
+		{
+			size_t count = ff::Utf16ToUtf8(wide.Data(), wideCount, narrow.Data());
+			assert(count == (size_t)narrowCount);
+		}
+
+		narrowTimes[level] = timer.Tick();
+	}
+
+	ff::String status = FF_FORMAT(
+		L"{} {}x{} bytes to UTF-16: MultiByteToWideChar:{}s, Plain:{}s, SSE2:{}s, AVX2:{}s\r\n"
+		L"{} {}x{} chars to UTF-8: WideCharToMultiByte:{}s, Plain:{}s, SSE2:{}s, AVX2:{}s\r\n",
+		name, CONVERT_PERF_LOOPS, text.Size(), winWideTime, wideTimes[0], wideTimes[1], wideTimes[2],
+		name, CONVERT_PERF_LOOPS, wideCount, winNarrowTime, narrowTimes[0], narrowTimes[1], narrowTimes[2]);
+	ff::Log::DebugTrace(status.c_str());
+	std::wcout << status.c_str();
+}
+
+bool StringConvertPerfTest()
+{
+	ff::SimdLevel cpuLevel = ff::GetSimdLevel();
+
+	RunConvertPerf(L"ASCII", MakeConvertPerfText(ff::INVALID_SIZE));
+	RunConvertPerf(L"Mixed", MakeConvertPerfText(10));
+	RunConvertPerf(L"Non-ASCII lines", MakeConvertPerfText(1));
+
+	ff::SetSimdLevel(cpuLevel);
+	std::wcout << L"\r\n";
+
+	return true;
+}
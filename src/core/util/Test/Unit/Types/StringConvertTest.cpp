@@ -0,0 +1,170 @@
+#include "pch.h"
+#include "Data/Data.h"
+#include "Data/DataWriterReader.h"
+#include "String/StringConvert.h"
+#include "String/StringSearch.h"
+#include "String/StringUtil.h"
+#include "String/Utf8String.h"
+
+// Mostly ASCII, with a few two, three, and four byte chars that can land anywhere in a vector
+static ff::Vector<char> MakeConvertText(size_t size)
+{
+	const char *pieces[] = { "{ \"name\": ", "\"value\", ", "caf\xC3\xA9 ", "\xE2\x82\xAC", "\xF0\x9F\x98\x80", "\r\n\t" };
+	ff::Vector<char> text;
+
+	for (size_t i = 0; text.Size() < size; i++)
+	{
+		const char *piece = pieces[(i * 7 + i / 3) % _countof(pieces)];
+		text.Push(piece, strlen(piece));
+	}
+
+	return text;
+}
+
+static bool KnownConvertTest()
+{
+	const char *utf8 = "A\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80z";
+	const wchar_t *utf16 = L"A\x00e9\x20ac\xd83d\xde00z";
+
+	wchar_t wide[32];
+	char narrow[32 * 3];
+	bool valid = false;
+
+	size_t wideCount = ff::Utf8ToUtf16(utf8, strlen(utf8), wide, &valid);
+	assertRetVal(valid && wideCount == wcslen(utf16) && !std::memcmp(wide, utf16, wideCount * sizeof(wchar_t)), false);
+
+	size_t narrowCount = ff::Utf16ToUtf8(utf16, wcslen(utf16), narrow, &valid);
+	assertRetVal(valid && narrowCount == strlen(utf8) && !std::memcmp(narrow, utf8, narrowCount), false);
+
+	assertRetVal(ff::StringFromUTF8(utf8) == utf16, false);
+	assertRetVal(ff::Utf8String(ff::String(utf16)) == utf8, false);
+	assertRetVal(ff::StringFromACP("plain text") == L"plain text", false);
+	assertRetVal(ff::StringToACP(ff::String(L"plain text")).Size() == 10, false);
+
+	return true;
+}
+
+// Each bad sequence turns into the U+FFFD chars that MultiByteToWideChar would give
+static bool InvalidConvertTest()
+{
+	struct InvalidText
+	{
+		const char *utf8;
+		const wchar_t *utf16;
+	};
+
+	const InvalidText texts[] =
+	{
+		{ "a\x80" "b", L"a\xfffd" L"b" }, // stray continuation
+		{ "a\xC0\xAF" "b", L"a\xfffd\xfffd" L"b" }, // overlong
+		{ "a\xE0\x80\xAF" "b", L"a\xfffd\xfffd\xfffd" L"b" }, // overlong
+		{ "a\xED\xA0\x80" "b", L"a\xfffd\xfffd\xfffd" L"b" }, // surrogate
+		{ "a\xF4\x90\x80\x80" "b", L"a\xfffd\xfffd\xfffd\xfffd" L"b" }, // above U+10FFFF
+		{ "a\xE2\x82" "b", L"a\xfffd" L"b" }, // truncated
+		{ "a\xF0\x9F\x98", L"a\xfffd" }, // truncated at the end
+		{ "a\xFF" "b", L"a\xfffd" L"b" },
+	};
+
+	for (const InvalidText &text: texts)
+	{
+		wchar_t wide[16];
+		bool valid = true;
+
+		size_t count = ff::Utf8ToUtf16(text.utf8, strlen(text.utf8), wide, &valid);
+		assertRetVal(!valid && !ff::IsValidUtf8(text.utf8, strlen(text.utf8)), false);
+		assertRetVal(count == wcslen(text.utf16) && !std::memcmp(wide, text.utf16, count * sizeof(wchar_t)), false);
+	}
+
+	// Lone surrogates
+	const wchar_t *badWide = L"a\xd83d" L"b\xde00";
+	char narrow[16];
+	bool valid = true;
+
+	size_t count = ff::Utf16ToUtf8(badWide, wcslen(badWide), narrow, &valid);
+	assertRetVal(!valid && count == 8 && !std::memcmp(narrow, "a\xEF\xBF\xBD" "b\xEF\xBF\xBD", count), false);
+
+	return true;
+}
+
+// Every level has to give the same answers as the plain loops, for every length and start
+static bool SimdConvertMatchTest(ff::SimdLevel level)
+{
+	ff::Vector<char> fullText = MakeConvertText(200);
+	ff::String fullWide = ff::StringFromUTF8(fullText.Data(), fullText.Size());
+
+	for (size_t start = 0; start < 40; start++)
+	{
+		for (size_t count = 0; start + count <= fullText.Size(); count++)
+		{
+			const char *text = fullText.Data() + start;
+			ff::Vector<wchar_t> expect;
+			ff::Vector<wchar_t> actual;
+			expect.Resize(count + 1);
+			actual.Resize(count + 1);
+
+			ff::SetSimdLevel(ff::SimdLevel::None);
+			bool expectValid = ff::IsValidUtf8(text, count);
+			expect.Resize(ff::Utf8ToUtf16(text, count, expect.Data()));
+			ff::SetSimdLevel(level);
+			assertRetVal(ff::IsValidUtf8(text, count) == expectValid, false);
+			actual.Resize(ff::Utf8ToUtf16(text, count, actual.Data()));
+			assertRetVal(actual == expect, false);
+		}
+
+		for (size_t count = 0; start + count <= fullWide.size(); count++)
+		{
+			const wchar_t *text = fullWide.c_str() + start;
+			ff::Vector<char> expect;
+			ff::Vector<char> actual;
+			expect.Resize(count * 3 + 1);
+			actual.Resize(count * 3 + 1);
+
+			ff::SetSimdLevel(ff::SimdLevel::None);
+			expect.Resize(ff::Utf16ToUtf8(text, count, expect.Data()));
+			ff::SetSimdLevel(level);
+			actual.Resize(ff::Utf16ToUtf8(text, count, actual.Data()));
+			assertRetVal(actual == expect, false);
+		}
+	}
+
+	return true;
+}
+
+// Big enough for several chunks, so chars get split between them
+static bool ReadUtf8Test()
+{
+	ff::Vector<char> text = MakeConvertText(300 * 1024);
+	ff::String expect = ff::StringFromUTF8(text.Data(), text.Size());
+
+	for (size_t start = 0; start < 4; start++)
+	{
+		ff::ComPtr<ff::IDataReader> reader;
+		assertRetVal(ff::CreateDataReader(reinterpret_cast<const BYTE *>(text.Data()), text.Size(), start, &reader), false);
+
+		ff::String actual = ff::StringFromUTF8(reader);
+		assertRetVal(actual == ff::StringFromUTF8(text.Data() + start, text.Size() - start), false);
+		assertRetVal(reader->GetPos() == text.Size(), false);
+
+		if (!start)
+		{
+			assertRetVal(actual == expect, false);
+		}
+	}
+
+	return true;
+}
+
+bool StringConvertTest()
+{
+	assertRetVal(KnownConvertTest(), false);
+	assertRetVal(InvalidConvertTest(), false);
+
+	ff::SimdLevel cpuLevel = ff::GetSimdLevel();
+	assertRetVal(SimdConvertMatchTest(ff::SimdLevel::Sse2), false);
+	assertRetVal(SimdConvertMatchTest(ff::SimdLevel::Avx2), false);
+	ff::SetSimdLevel(cpuLevel);
+
+	assertRetVal(ReadUtf8Test(), false);
+
+	return true;
+}
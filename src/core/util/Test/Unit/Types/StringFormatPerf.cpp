@@ -0,0 +1,86 @@
+#include "pch.h"
+#include "App/Log.h"
+#include "App/Timer.h"
+#include "String/StringFormat.h"
+
+#include <iostream>
+
+static const size_t FORMAT_PERF_COUNT = 1000000;
+static const size_t FORMAT_PERF_LINES = 1000;
+
+// Like the Dict keys in DictPerf.cpp
+static void RunKeyFormatPerf()
+{
+	ff::Timer timer;
+
+	for (size_t i = 0; i < FORMAT_PERF_COUNT; i++)
+	{
+		ff::String key = ff::String::format_new(L"%lu-%lu-%lu-%lu", i, i, i, i);
+	}
+
+	double printfTime = timer.Tick();
+
+	for (size_t i = 0; i < FORMAT_PERF_COUNT; i++)
+	{
+		ff::String key = FF_FORMAT(L"{}-{}-{}-{}", i, i, i, i);
+	}
+
+	double formatTime = timer.Tick();
+
+	ff::String status = FF_FORMAT(
+		L"Format {} keys: format_new:{}s, FF_FORMAT:{}s\r\n",
+		FORMAT_PERF_COUNT,
+		printfTime,
+		formatTime);
+	ff::Log::DebugTrace(status.c_str());
+	std::wcout << status.c_str();
+}
+
+// Like writing out text files, one line at a time
+static void RunAppendFormatPerf()
+{
+	ff::String text;
+	ff::Timer timer;
+
+	for (size_t i = 0; i < FORMAT_PERF_COUNT; i++)
+	{
+		if (i % FORMAT_PERF_LINES == 0)
+		{
+			text.clear();
+		}
+
+		text.append(ff::String::format_new(L"\"name%lu\": %d, %.3f\r\n", i, -static_cast<int>(i), i / 8.0));
+	}
+
+	double printfTime = timer.Tick();
+
+	for (size_t i = 0; i < FORMAT_PERF_COUNT; i++)
+	{
+		if (i % FORMAT_PERF_LINES == 0)
+		{
+			text.clear();
+		}
+
+		FF_FORMAT_APPEND(text, L"\"name{}\": {}, {:.3}\r\n", i, -static_cast<int>(i), i / 8.0);
+	}
+
+	double formatTime = timer.Tick();
+
+	ff::String status = FF_FORMAT(
+		L"Append {} lines: format_new:{}s, FF_FORMAT_APPEND:{}s\r\n",
+		FORMAT_PERF_COUNT,
+		printfTime,
+		formatTime);
+	ff::Log::DebugTrace(status.c_str());
+	std::wcout << status.c_str();
+}
+
+bool StringFormatPerfTest()
+{
+	RunKeyFormatPerf();
+	RunAppendFormatPerf();
+
+	std::wcout << L"\r\n";
+
+	return true;
+}
@@ -0,0 +1,75 @@
+#include "pch.h"
+#include "Data/Data.h"
+#include "Data/DataWriterReader.h"
+#include "String/StringFormat.h"
+
+static_assert(ff::details::CountFormatArgs(L"") == 0, "");
+static_assert(ff::details::CountFormatArgs(L"{}-{:08x}-{{}}") == 2, "");
+static_assert(ff::details::CountFormatArgs(L"{") == ff::INVALID_SIZE, "");
+static_assert(ff::details::CountFormatArgs(L"}") == ff::INVALID_SIZE, "");
+static_assert(ff::details::CountFormatArgs(L"{{}") == ff::INVALID_SIZE, "");
+
+static bool IntFormatTest()
+{
+	assertRetVal(FF_FORMAT(L"{}-{}-{}-{}", 0, 1, 22, 333) == L"0-1-22-333", false);
+	assertRetVal(FF_FORMAT(L"{}", -12345) == L"-12345", false);
+	assertRetVal(FF_FORMAT(L"{}", INT64_MIN) == L"-9223372036854775808", false);
+	assertRetVal(FF_FORMAT(L"{}", UINT64_MAX) == L"18446744073709551615", false);
+	assertRetVal(FF_FORMAT(L"{} {}", static_cast<short>(-7), static_cast<unsigned char>(200)) == L"-7 200", false);
+	assertRetVal(FF_FORMAT(L"{:x} {:X}", 0xbeef, 0xbeefu) == L"beef BEEF", false);
+	assertRetVal(FF_FORMAT(L"{:x} {:X}", -255, INT64_MIN) == L"-ff -8000000000000000", false);
+
+	// padding
+	assertRetVal(FF_FORMAT(L"[{:5}]", 42) == L"[   42]", false);
+	assertRetVal(FF_FORMAT(L"[{:<5}]", 42) == L"[42   ]", false);
+	assertRetVal(FF_FORMAT(L"[{:05}]", -42) == L"[-0042]", false);
+	assertRetVal(FF_FORMAT(L"[{:08x}]", 255) == L"[000000ff]", false);
+	assertRetVal(FF_FORMAT(L"[{:2}]", 12345) == L"[12345]", false);
+	assertRetVal(FF_FORMAT(L"{:40}", 1).size() == 40, false);
+
+	return true;
+}
+
+static bool OtherFormatTest()
+{
+	ff::String name(L"name");
+	const wchar_t *text = L"text";
+
+	assertRetVal(FF_FORMAT(L"{} {} {} {}", name, text, L"literal", L'c') == L"name text literal c", false);
+	assertRetVal(FF_FORMAT(L"{} {}", true, false) == L"true false", false);
+	assertRetVal(FF_FORMAT(L"{} {} {}", 1.0, -2.5, 0.125f) == L"1 -2.5 0.125", false);
+	assertRetVal(FF_FORMAT(L"{:.2} {:.3e}", 3.14159, 1250.0) == L"3.14 1.250e+03", false);
+	assertRetVal(FF_FORMAT(L"{:.1x} {:.2X}", 1.5, 1.0f) == L"0x1.8p+0 0X1.00P+0", false);
+	assertRetVal(FF_FORMAT(L"{} {} {} {:>6}", 1.0 / 3, 0.1f, 1e-8, 0.5) == L"0.3333333333333333 0.1 1e-08    0.5", false);
+	assertRetVal(FF_FORMAT(L"{{{}}}", 1) == L"{1}", false);
+	assertRetVal(FF_FORMAT(L"{}", reinterpret_cast<const void *>(0x1234)) == L"0x1234", false);
+	assertRetVal(ff::Format(L"no args") == L"no args", false);
+
+	ff::String str(L"Start");
+	assertRetVal(FF_FORMAT_APPEND(str, L" {}", 10) && str == L"Start 10", false);
+
+	return true;
+}
+
+static bool WriterFormatTest()
+{
+	ff::ComPtr<ff::IDataVector> data;
+	ff::ComPtr<ff::IDataWriter> writer;
+	assertRetVal(ff::CreateDataWriter(&data, &writer), false);
+	assertRetVal(FF_FORMAT_WRITE(writer, L"{}={:.1}\r\n", L"pi", 3.14159), false);
+
+	const wchar_t *expect = L"pi=3.1\r\n";
+	assertRetVal(data->GetSize() == wcslen(expect) * sizeof(wchar_t), false);
+	assertRetVal(!std::memcmp(data->GetMem(), expect, data->GetSize()), false);
+
+	return true;
+}
+
+bool StringFormatTest()
+{
+	assertRetVal(IntFormatTest(), false);
+	assertRetVal(OtherFormatTest(), false);
+	assertRetVal(WriterFormatTest(), false);
+
+	return true;
+}
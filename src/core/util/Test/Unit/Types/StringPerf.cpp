@@ -0,0 +1,152 @@
+#include "pch.h"
+#include "App/Log.h"
+#include "App/Timer.h"
+
+#include <iostream>
+#include <thread>
+
+static const size_t STRING_PERF_COPIES = 4000000;
+static const size_t STRING_PERF_MAX_THREADS = 8;
+
+// Copies and assigns strings, which is mostly AddRef and Release
+static void CopyStrings(const ff::Vector<ff::String> &strings, size_t copies)
+{
+	ff::String value;
+
+	for (size_t i = 0; i < copies; i += strings.Size())
+	{
+		for (const ff::String &str: strings)
+		{
+			ff::String copy(str);
+			value = copy;
+		}
+	}
+}
+
+static ff::Vector<ff::String> MakePerfStrings()
+{
+	ff::Vector<ff::String> strings;
+
+	for (size_t i = 0; i < 64; i++)
+	{
+		// Long enough to be shared instead of stored inside the String
+		strings.Push(ff::String::format_new(L"Shared string number %lu", i));
+	}
+
+	return strings;
+}
+
+// ownerThreads: whether each thread gets its own strings with biased counts, otherwise
+// every thread copies the strings from the main thread with interlocked counts.
+static double RunStringPerf(size_t threadCount, bool ownerThreads)
+{
+	ff::Vector<ff::String> sharedStrings = MakePerfStrings();
+	std::thread threads[STRING_PERF_MAX_THREADS];
+	ff::Timer timer;
+
+	for (size_t i = 0; i < threadCount; i++)
+	{
+		threads[i] = std::thread([&sharedStrings, threadCount, ownerThreads]()
+		{
+			if (ownerThreads)
+			{
+				ff::BeginBiasedRefThread();
+				CopyStrings(MakePerfStrings(), STRING_PERF_COPIES / threadCount);
+				ff::EndBiasedRefThread();
+			}
+			else
+			{
+				CopyStrings(sharedStrings, STRING_PERF_COPIES / threadCount);
+			}
+		});
+	}
+
+	for (size_t i = 0; i < threadCount; i++)
+	{
+		threads[i].join();
+	}
+
+	return timer.Tick();
+}
+
+static double RunStringPerfOnThisThread()
+{
+	ff::Vector<ff::String> strings = MakePerfStrings();
+	ff::Timer timer;
+
+	CopyStrings(strings, STRING_PERF_COPIES);
+
+	return timer.Tick();
+}
+
+// Creates, copies and destroys strings that are the same except for their length
+static double RunStringLengthPerf(size_t length)
+{
+	ff::String prefix(length - 4, L'x');
+	ff::Timer timer;
+
+	for (size_t i = 0; i < STRING_PERF_COPIES / 4; i++)
+	{
+		ff::String str(prefix);
+		str.append(1, static_cast<wchar_t>(L'a' + i % 26));
+		str.append(3, L'z');
+
+		ff::String copy(str);
+		copy[0] = L'y';
+	}
+
+	return timer.Tick();
+}
+
+bool StringPerfTest()
+{
+	// Short strings live inside the String, long ones also need a shared buffer
+	for (size_t length = 4; length <= 32; length *= 2)
+	{
+		double lengthTime = RunStringLengthPerf(length);
+		size_t bytes = sizeof(ff::String);
+
+		if (length > ff::String().capacity())
+		{
+			bytes += sizeof(ff::SharedStringVectorAllocator::SharedStringVector);
+		}
+
+		ff::String status = ff::String::format_new(
+			L"Create and edit %lu strings with %lu chars: %fs, %lu bytes each\r\n",
+			STRING_PERF_COPIES / 4,
+			length,
+			lengthTime,
+			bytes);
+		ff::Log::DebugTraceF(status.c_str());
+		std::wcout << status.c_str();
+	}
+
+	// The main thread has ProcessGlobals, so it owns biased counts
+	double ownerTime = RunStringPerfOnThisThread();
+
+	ff::String status = ff::String::format_new(
+		L"Copy %lu strings on their owner thread: %fs\r\n",
+		STRING_PERF_COPIES,
+		ownerTime);
+	ff::Log::DebugTraceF(status.c_str());
+	std::wcout << status.c_str();
+
+	for (size_t threadCount = 1; threadCount <= STRING_PERF_MAX_THREADS; threadCount *= 2)
+	{
+		double sharedTime = RunStringPerf(threadCount, false);
+		double ownerThreadsTime = RunStringPerf(threadCount, true);
+
+		status = ff::String::format_new(
+			L"Copy %lu strings on %lu threads: Interlocked:%fs, Biased:%fs\r\n",
+			STRING_PERF_COPIES,
+			threadCount,
+			sharedTime,
+			ownerThreadsTime);
+		ff::Log::DebugTraceF(status.c_str());
+		std::wcout << status.c_str();
+	}
+
+	std::wcout << L"\r\n";
+
+	return true;
+}
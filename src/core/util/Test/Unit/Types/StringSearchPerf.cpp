@@ -0,0 +1,106 @@
+#include "pch.h"
+#include "App/Log.h"
+#include "App/Timer.h"
+#include "String/StringFormat.h"
+#include "String/StringSearch.h"
+#include "String/StringUtil.h"
+
+#include <iostream>
+
+static const size_t SEARCH_PERF_SIZE = 1024 * 1024;
+static const size_t SEARCH_PERF_LOOPS = 20;
+
+// Long lines of mostly lowercase words, the way big text files look
+static ff::String MakeSearchPerfText()
+{
+	const wchar_t *words[] = { L"alpha", L"Bravo", L"charlie", L"delta", L"echo", L"Foxtrot", L"golf", L"hotel" };
+	ff::String text;
+	text.reserve(SEARCH_PERF_SIZE + 16);
+
+	for (size_t i = 0; text.size() < SEARCH_PERF_SIZE; i++)
+	{
+		text.append(words[(i * 7) % _countof(words)]);
+		text.append((i % 97 == 96) ? L",\r\n" : L" ");
+	}
+
+	return text;
+}
+
+static double RunSearchPerf(size_t op, ff::SimdLevel level, const ff::String &fullText)
+{
+	ff::SetSimdLevel(level);
+
+	ff::String text = fullText;
+	size_t count = text.size();
+	ff::String blanks(count, L' ');
+	size_t found = 0;
+	ff::Timer timer;
+
+	for (size_t i = 0; i < SEARCH_PERF_LOOPS; i++)
+	{
+		switch (op)
+		{
+		case 0:
+			found += ff::SearchChar(text.c_str(), count, L'~');
+			break;
+
+		case 1:
+			found += ff::SearchChars(text.c_str(), count, L"zulu", 4);
+			break;
+
+		case 2:
+			found += ff::SearchCharOf(text.c_str(), count, L"{}[]", 4);
+			break;
+
+		case 3:
+			found += ff::SearchCharNotOf(blanks.c_str(), blanks.size(), L" \t\r\n", 4);
+			break;
+
+		case 4:
+			ff::ReplaceChar(&text[0], count, L'~', L'!');
+			break;
+
+		case 5:
+			ff::ChangeCaseAscii(&text[0], count, (i % 2) != 0);
+			break;
+
+		case 6:
+			found += ff::SplitString(fullText, ff::String(L"\r\n"), false).Size();
+			break;
+		}
+	}
+
+	double time = timer.Tick();
+	assert(found || op >= 4);
+	return time;
+}
+
+bool StringSearchPerfTest()
+{
+	const wchar_t *names[] = { L"SearchChar", L"SearchChars", L"SearchCharOf", L"SearchCharNotOf", L"ReplaceChar", L"ChangeCase", L"SplitString" };
+	ff::SimdLevel cpuLevel = ff::GetSimdLevel();
+	ff::String text = MakeSearchPerfText();
+
+	for (size_t op = 0; op < _countof(names); op++)
+	{
+		double plainTime = RunSearchPerf(op, ff::SimdLevel::None, text);
+		double sse2Time = RunSearchPerf(op, ff::SimdLevel::Sse2, text);
+		double avx2Time = RunSearchPerf(op, ff::SimdLevel::Avx2, text);
+
+		ff::String status = FF_FORMAT(
+			L"{} {}x{} chars: Plain:{}s, SSE2:{}s, AVX2:{}s\r\n",
+			names[op],
+			SEARCH_PERF_LOOPS,
+			text.size(),
+			plainTime,
+			sse2Time,
+			avx2Time);
+		ff::Log::DebugTrace(status.c_str());
+		std::wcout << status.c_str();
+	}
+
+	ff::SetSimdLevel(cpuLevel);
+	std::wcout << L"\r\n";
+
+	return true;
+}
@@ -0,0 +1,150 @@
+#include "pch.h"
+#include "String/StringSearch.h"
+#include "String/StringUtil.h"
+
+// Text with a little of everything, including chars that look negative to signed compares
+static ff::String MakeSearchText(size_t size)
+{
+	const wchar_t chars[] = L"abcXYZ \t\r\n,;{}\u00e9\u00c9\u6771\uff21\xffff";
+	ff::String text;
+
+	for (size_t i = 0; i < size; i++)
+	{
+		text.append(1, chars[(i * 7919 + i / 5) % (_countof(chars) - 1)]);
+	}
+
+	return text;
+}
+
+static void EditSearchText(size_t edit, wchar_t *text, size_t count)
+{
+	switch (edit)
+	{
+	case 0:
+		ff::ReplaceChar(text, count, L'\xffff', L'a');
+		break;
+
+	case 1:
+		ff::ChangeCaseAscii(text, count, false);
+		break;
+
+	case 2:
+		ff::ChangeCaseAscii(text, count, true);
+		break;
+
+	case 3:
+		ff::ChangeCaseCrt(text, count, false);
+		break;
+
+	case 4:
+		ff::ChangeCaseCrt(text, count, true);
+		break;
+	}
+}
+
+// Every level has to give the same answers as the plain loops, for every length and start
+static bool SimdSearchMatchTest(ff::SimdLevel level)
+{
+	ff::String fullText = MakeSearchText(80);
+	const wchar_t *sets[] = { L",", L" \t\r\n", L"{}\xffff", L"abcdefghijklmnopqrstuvwxyz" };
+	const wchar_t *finds[] = { L"b", L"ab", L"\xffff" L"a", L"abcX", L"\t\r\n" };
+
+	for (size_t start = 0; start < 20; start++)
+	{
+		for (size_t count = 0; start + count <= fullText.size(); count++)
+		{
+			const wchar_t *text = fullText.c_str() + start;
+
+			for (wchar_t ch: fullText)
+			{
+				ff::SetSimdLevel(ff::SimdLevel::None);
+				size_t expect = ff::SearchChar(text, count, ch);
+				ff::SetSimdLevel(level);
+				assertRetVal(ff::SearchChar(text, count, ch) == expect, false);
+			}
+
+			for (const wchar_t *set: sets)
+			{
+				ff::SetSimdLevel(ff::SimdLevel::None);
+				size_t expectOf = ff::SearchCharOf(text, count, set, wcslen(set));
+				size_t expectNotOf = ff::SearchCharNotOf(text, count, set, wcslen(set));
+				ff::SetSimdLevel(level);
+				assertRetVal(ff::SearchCharOf(text, count, set, wcslen(set)) == expectOf, false);
+				assertRetVal(ff::SearchCharNotOf(text, count, set, wcslen(set)) == expectNotOf, false);
+			}
+
+			for (const wchar_t *find: finds)
+			{
+				ff::SetSimdLevel(ff::SimdLevel::None);
+				size_t expect = ff::SearchChars(text, count, find, wcslen(find));
+				ff::SetSimdLevel(level);
+				assertRetVal(ff::SearchChars(text, count, find, wcslen(find)) == expect, false);
+			}
+
+			for (size_t edit = 0; edit < 5; edit++)
+			{
+				ff::String expect(text, count);
+				ff::String actual(text, count);
+
+				ff::SetSimdLevel(ff::SimdLevel::None);
+				EditSearchText(edit, &expect[0], count);
+				ff::SetSimdLevel(level);
+				EditSearchText(edit, &actual[0], count);
+				assertRetVal(actual == expect, false);
+			}
+		}
+	}
+
+	return true;
+}
+
+static bool StringUtilSearchTest()
+{
+	ff::String text(L"  The quick, brown fox; jumps over the lazy dog, twice.\r\n");
+
+	ff::Vector<ff::String> split = ff::SplitString(text, ff::String(L",;"), false);
+	assertRetVal(split.Size() == 4 && split[1] == L" brown fox" && split[3] == L" twice.\r\n", false);
+
+	split = ff::SplitString(ff::String(L",a,,b,"), ff::String(L","), true);
+	assertRetVal(split.Size() == 4 && split[0].empty() && split[1] == L"a" && split[2].empty() && split[3] == L"b", false);
+
+	ff::String copy = text;
+	ff::ReplaceAll(copy, ff::String(L"the"), ff::String(L"a"));
+	ff::ReplaceAll(copy, ff::String(L"o"), ff::String(L"0o"));
+	assertRetVal(copy == L"  The quick, br0own f0ox; jumps 0over a lazy d0og, twice.\r\n", false);
+	assertRetVal(text == L"  The quick, brown fox; jumps over the lazy dog, twice.\r\n", false);
+
+	ff::ReplaceAll(copy, L' ', L'_');
+	ff::StripSpaces(copy);
+	assertRetVal(copy == L"__The_quick,_br0own_f0ox;_jumps_0over_a_lazy_d0og,_twice.", false);
+
+	copy = ff::String(L" \t\r\n") + text + ff::String(L"\t ");
+	ff::StripSpaces(copy, false, true);
+	assertRetVal(copy == ff::String(L" \t\r\n") + text.substr(0, text.size() - 2), false);
+	ff::StripSpaces(copy);
+	assertRetVal(copy == text.substr(2, text.size() - 4), false);
+
+	copy = ff::String(L" \t\r\n \t\r\n \t\r\n \t\r\n \t\r\n \t\r\n \t\r\n \t\r\n \t\r\n");
+	ff::StripSpaces(copy);
+	assertRetVal(copy.empty(), false);
+
+	copy = text;
+	ff::UpperCaseInPlace(copy);
+	assertRetVal(copy == L"  THE QUICK, BROWN FOX; JUMPS OVER THE LAZY DOG, TWICE.\r\n", false);
+	assertRetVal(ff::CanonicalizeString(copy) == L"  the quick, brown fox; jumps over the lazy dog, twice.\r\n", false);
+
+	return true;
+}
+
+bool StringSearchTest()
+{
+	ff::SimdLevel cpuLevel = ff::GetSimdLevel();
+
+	assertRetVal(SimdSearchMatchTest(ff::SimdLevel::Sse2), false);
+	assertRetVal(SimdSearchMatchTest(ff::SimdLevel::Avx2), false);
+	ff::SetSimdLevel(cpuLevel);
+
+	assertRetVal(StringUtilSearchTest(), false);
+
+	return true;
+}
@@ -122,11 +122,108 @@ bool StringTest()
 	return true;
 }
 
+// Short strings are stored inside the String, long ones share a buffer
+bool SmallStringTest()
+{
+	const wchar_t *chars = L"0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+	size_t charCount = wcslen(chars);
+
+	// Grow across the inline limit one character at a time, then shrink back
+	ff::String str;
+	for (size_t i = 1; i <= charCount; i++)
+	{
+		str.push_back(chars[i - 1]);
+		assertRetVal(str.size() == i && !wcsncmp(str.c_str(), chars, i) && !str.c_str()[i], false);
+
+		ff::String copy = str;
+		assertRetVal(copy == str && copy.size() == i, false);
+	}
+
+	while (!str.empty())
+	{
+		str.pop_back();
+		assertRetVal(str == ff::String(chars, str.size()), false);
+	}
+
+	// Copies of short strings don't share anything
+	ff::String shortStr(L"Short");
+	ff::String shortCopy = shortStr;
+	assertRetVal(shortStr == shortCopy && shortStr.c_str() != shortCopy.c_str(), false);
+
+	// Long strings are copy-on-write
+	ff::String longStr(chars);
+	ff::String longCopy = longStr;
+	assertRetVal(longCopy.c_str() == longStr.c_str(), false);
+	longCopy[0] = L'X';
+	assertRetVal(longStr[0] == L'0' && longCopy[0] == L'X', false);
+
+	// A shared long string that gets short moves inside instead of copying the buffer
+	longCopy = longStr;
+	longCopy.erase(5);
+	assertRetVal(longCopy == L"01234" && longStr == chars && longCopy.capacity() < longStr.size(), false);
+
+	shortStr.swap(longStr);
+	assertRetVal(shortStr == chars && longStr == L"Short", false);
+
+	ff::String moved = std::move(shortStr);
+	assertRetVal(moved == chars && shortStr.empty(), false);
+
+	str = L"abc";
+	str.reserve(100);
+	assertRetVal(str.capacity() >= 100 && str == L"abc", false);
+	str.shrink_to_fit();
+	assertRetVal(str.capacity() < 100 && str == L"abc", false);
+
+	// Edits in the middle that cross the limit
+	str = L"0123456789";
+	str.insert(5, L"abcdefghij");
+	assertRetVal(str == L"01234abcdefghij56789", false);
+	str.replace(2, 16, L"x");
+	assertRetVal(str == L"01x89", false);
+	str.replace(1, 1, 20, L'-');
+	assertRetVal(str == L"0--------------------x89", false);
+
+	ff::String staticShort = ff::String::from_static(L"abc");
+	ff::String staticLong = ff::String::from_static(chars);
+	assertRetVal(staticShort == L"abc" && staticLong.c_str() == chars, false);
+
+	ff::StaticString staticStr(L"Static");
+	ff::StaticString staticStr2(L"A static string that is too long to fit inside");
+	assertRetVal(staticStr.GetString() == L"Static", false);
+	assertRetVal(staticStr2.GetString() == L"A static string that is too long to fit inside", false);
+
+	str = staticStr2;
+	str += L"!";
+	assertRetVal(str.size() == staticStr2.GetString().size() + 1, false);
+
+	return true;
+}
+
 bool StringHashTest()
 {
 	const wchar_t *foobar = L"FooBar";
 	const wchar_t *foobar2 = L"Foobar";
 	assertRetVal(ff::HashFunc(foobar) == ff::HashFunc(ff::String(foobar)), false);
 	assertRetVal(ff::HashFunc(foobar) != ff::HashFunc(foobar2), false);
+
+	size_t size = wcslen(foobar) * sizeof(wchar_t);
+	assertRetVal(ff::HashBytes(foobar, size) == ff::HashBytes(foobar, size, 0), false);
+	assertRetVal(ff::HashBytes(foobar, size) != ff::HashBytes(foobar, size, 1), false);
+
+	// Different alignments and every length of the short and bulk paths
+	BYTE bytes[128];
+	BYTE unalignedBytes[129];
+	for (size_t i = 0; i < _countof(bytes); i++)
+	{
+		bytes[i] = (BYTE)(i * 7);
+		unalignedBytes[i + 1] = bytes[i];
+	}
+
+	for (size_t i = 0; i <= _countof(bytes); i++)
+	{
+		assertRetVal(ff::HashBytes(bytes, i) == ff::HashBytes(unalignedBytes + 1, i), false);
+		assertRetVal(i == 0 || ff::HashBytes(bytes, i) != ff::HashBytes(bytes, i - 1), false);
+	}
+
 	return true;
 }
@@ -0,0 +1,125 @@
+#include "pch.h"
+#include "App/Log.h"
+#include "App/Timer.h"
+#include "Data/Data.h"
+#include "Dict/Dict.h"
+#include "Dict/JsonPersist.h"
+#include "String/StringUtil.h"
+#include "String/Utf8String.h"
+
+#include <iostream>
+
+static const size_t UTF8_PERF_LOADS = 20;
+
+// Bytes used by a string, including what it points to when it isn't stored inside
+template<typename StringType, typename CharType>
+static size_t StringBytes(const StringType &str)
+{
+	size_t smallCapacity = StringType().capacity();
+	return sizeof(StringType) + ((str.capacity() > smallCapacity) ? (str.capacity() + 1) * sizeof(CharType) : 0);
+}
+
+// A JSON file that was loaded into memory, like a saved Dict
+static bool MakePerfJson(size_t entryCount, ff::IData **data)
+{
+	ff::String json(L"{\r\n");
+
+	for (size_t i = 0; i < entryCount; i++)
+	{
+		json.append(ff::String::format_new(
+			L"\t\"name%lu\": \"The value for entry number %lu\"%s\r\n",
+			i,
+			i,
+			(i + 1 < entryCount) ? L"," : L""));
+	}
+
+	json.append(L"}\r\n");
+
+	ff::Utf8String text(json);
+	ff::ComPtr<ff::IDataVector> dataVector;
+	assertRetVal(ff::CreateDataVector(0, &dataVector), false);
+	dataVector->GetVector().Push(reinterpret_cast<const BYTE *>(text.c_str()), text.size() + 1);
+
+	*data = dataVector.Detach();
+	return true;
+}
+
+static bool RunUtf8LoadPerf(size_t entryCount)
+{
+	ff::ComPtr<ff::IData> data;
+	assertRetVal(MakePerfJson(entryCount, &data), false);
+
+	const char *chars = reinterpret_cast<const char *>(data->GetMem());
+	size_t charCount = data->GetSize() - 1;
+	ff::Timer timer;
+
+	// How text gets loaded now: convert all of it to wide chars, then parse
+	for (size_t i = 0; i < UTF8_PERF_LOADS; i++)
+	{
+		ff::String wide = ff::StringFromUTF8(chars, charCount);
+	}
+
+	double wideTime = timer.Tick();
+
+	for (size_t i = 0; i < UTF8_PERF_LOADS; i++)
+	{
+		ff::Utf8String text = ff::Utf8String::FromData(data);
+	}
+
+	double utf8Time = timer.Tick();
+
+	ff::String wide = ff::StringFromUTF8(chars, charCount);
+	timer.Reset();
+
+	for (size_t i = 0; i < UTF8_PERF_LOADS; i++)
+	{
+		ff::Dict dict = ff::JsonParse(wide);
+	}
+
+	double parseTime = timer.Tick();
+
+	ff::String status = ff::String::format_new(
+		L"Load %lu entry JSON: Bytes:%lu, WideBytes:%lu, StringFromUTF8:%fs, Utf8String::FromData:%fs, JsonParse:%fs\r\n",
+		entryCount,
+		charCount,
+		wide.size() * sizeof(wchar_t),
+		wideTime / UTF8_PERF_LOADS,
+		utf8Time / UTF8_PERF_LOADS,
+		parseTime / UTF8_PERF_LOADS);
+	ff::Log::DebugTraceF(status.c_str());
+	std::wcout << status.c_str();
+
+	// Memory for the names and values of the parsed Dict, as String or Utf8String
+	ff::Dict dict = ff::JsonParse(wide);
+	ff::Vector<ff::String> names = dict.GetAllNames(false, false, false);
+	size_t wideBytes = 0;
+	size_t utf8Bytes = 0;
+
+	for (ff::StringRef name: names)
+	{
+		ff::String value = dict.GetString(name);
+		wideBytes += StringBytes<ff::String, wchar_t>(name) + StringBytes<ff::String, wchar_t>(value);
+		utf8Bytes += StringBytes<ff::Utf8String, char>(ff::Utf8String(name)) + StringBytes<ff::Utf8String, char>(ff::Utf8String(value));
+	}
+
+	status = ff::String::format_new(
+		L"Dict with %lu names and values: String:%lu bytes, Utf8String:%lu bytes\r\n",
+		names.Size(),
+		wideBytes,
+		utf8Bytes);
+	ff::Log::DebugTraceF(status.c_str());
+	std::wcout << status.c_str();
+
+	return true;
+}
+
+bool Utf8StringPerfTest()
+{
+	assertRetVal(RunUtf8LoadPerf(100), false);
+	assertRetVal(RunUtf8LoadPerf(10000), false);
+	assertRetVal(RunUtf8LoadPerf(100000), false);
+
+	std::wcout << L"\r\n";
+
+	return true;
+}
@@ -0,0 +1,127 @@
+#include "pch.h"
+#include "Data/Data.h"
+#include "String/Utf8String.h"
+
+static const size_t UTF8_SMALL_CAPACITY = 4 * sizeof(void *) - 1;
+
+static bool BasicUtf8StringTest()
+{
+	ff::Utf8String str;
+	assertRetVal(str.empty() && str.size() == 0 && !*str.c_str(), false);
+	assertRetVal(str.capacity() == UTF8_SMALL_CAPACITY, false);
+
+	str = "Hello";
+	str += ' ';
+	str += ff::Utf8String("World");
+	assertRetVal(str == "Hello World" && str.size() == 11, false);
+	assertRetVal(str.find("World") == 6 && str.find('o') == 4 && str.rfind('o') == 7, false);
+	assertRetVal(str.find("world") == ff::Utf8String::npos, false);
+
+	str.insert(5, ",");
+	str.replace(0, 5, "Goodbye");
+	str.erase(str.size() - 6);
+	assertRetVal(str == "Goodbye,", false);
+
+	str.pop_back();
+	str.push_back('!');
+	str[0] = 'g';
+	assertRetVal(str == "goodbye!" && str.front() == 'g' && str.back() == '!', false);
+	assertRetVal(str.substr(4) == "bye!" && str.substr(4, 2) == "by", false);
+
+	assertRetVal(ff::Utf8String("abc") < ff::Utf8String("abd"), false);
+	assertRetVal(ff::Utf8String("ab") < ff::Utf8String("abc"), false);
+	assertRetVal(ff::Utf8String("abc").compare("abc") == 0, false);
+	assertRetVal(ff::HashFunc(ff::Utf8String("abc")) == ff::HashFunc(ff::Utf8String("abcd").substr(0, 3)), false);
+
+	return true;
+}
+
+// Strings move outside when they get too long, and back inside when copy-on-write needs a copy anyway
+static bool LongUtf8StringTest()
+{
+	ff::Utf8String str(UTF8_SMALL_CAPACITY, 'a');
+	assertRetVal(str.capacity() == UTF8_SMALL_CAPACITY, false);
+
+	str += 'b';
+	assertRetVal(str.size() == UTF8_SMALL_CAPACITY + 1 && str.capacity() > UTF8_SMALL_CAPACITY, false);
+
+	ff::Utf8String copy = str;
+	assertRetVal(copy.c_str() == str.c_str(), false);
+
+	copy.back() = 'c';
+	assertRetVal(copy.c_str() != str.c_str() && str.back() == 'b' && copy.back() == 'c', false);
+
+	copy = str;
+	copy.erase(4);
+	assertRetVal(copy == "aaaa" && copy.capacity() == UTF8_SMALL_CAPACITY && str.back() == 'b', false);
+
+	str.append(str);
+	assertRetVal(str.size() == UTF8_SMALL_CAPACITY * 2 + 2 && str.find('b') == UTF8_SMALL_CAPACITY, false);
+
+	str.resize(2);
+	assertRetVal(str == "aa", false);
+
+	str.resize(100, 'x');
+	assertRetVal(str.size() == 100 && str.rfind('a') == 1 && str.find('x') == 2, false);
+
+	ff::Utf8String moved = std::move(str);
+	assertRetVal(str.empty() && moved.size() == 100, false);
+
+	return true;
+}
+
+static bool WideUtf8StringTest()
+{
+	ff::String wide(L"Caf\u00e9 \u6771\u4eac");
+	ff::Utf8String str(wide);
+
+	// two bytes for the accent and three for each of the CJK characters
+	assertRetVal(str.size() == 12 && str == "Caf\xc3\xa9 \xe6\x9d\xb1\xe4\xba\xac", false);
+	assertRetVal(str.ToWide() == wide, false);
+	assertRetVal(ff::Utf8String(ff::String()).empty() && ff::Utf8String().ToWide().empty(), false);
+
+	return true;
+}
+
+static bool DataUtf8StringTest()
+{
+	const char *text = "{ \"name\": \"A name that is too long to fit inside\", \"short\": \"Short\" }";
+
+	ff::ComPtr<ff::IDataVector> data;
+	assertRetVal(ff::CreateDataVector(0, &data), false);
+	data->GetVector().Push(reinterpret_cast<const BYTE *>(text), std::strlen(text) + 1);
+
+	// the whole text is null terminated, so it gets shared
+	ff::Utf8String whole = ff::Utf8String::FromData(data);
+	assertRetVal(whole.size() == std::strlen(text) && whole.c_str() == reinterpret_cast<const char *>(data->GetMem()), false);
+
+	// slices need a null after them, and small ones are always copied inside
+	ff::Utf8String name = ff::Utf8String::FromData(data, 11, 37);
+	ff::Utf8String tail = ff::Utf8String::FromData(data, 11);
+	ff::Utf8String small = ff::Utf8String::FromData(data, std::strlen(text) - 3);
+	assertRetVal(name == "A name that is too long to fit inside" && name.c_str() != whole.c_str() + 11, false);
+	assertRetVal(tail.c_str() == whole.c_str() + 11, false);
+	assertRetVal(small == "\" }" && small.c_str() != whole.c_str() + whole.size() - 3, false);
+
+	// editing shared data makes a copy and leaves the data alone
+	ff::Utf8String edit = whole;
+	edit[0] = '[';
+	assertRetVal(edit.c_str() != whole.c_str() && *whole.c_str() == '{' && text[0] == '{', false);
+
+	// the data is kept alive by the strings that point into it
+	const BYTE *mem = data->GetMem();
+	data = nullptr;
+	assertRetVal(tail.c_str() == reinterpret_cast<const char *>(mem) + 11 && whole == text, false);
+
+	return true;
+}
+
+bool Utf8StringTest()
+{
+	assertRetVal(BasicUtf8StringTest(), false);
+	assertRetVal(LongUtf8StringTest(), false);
+	assertRetVal(WideUtf8StringTest(), false);
+	assertRetVal(DataUtf8StringTest(), false);
+
+	return true;
+}
@@ -23,6 +23,14 @@ static bool InternalVectorTest()
 	T vec2 = vec;
 	assertRetVal(vec == vec2, false);
 
+	// Moving takes the data and leaves the source empty
+	T vec3;
+	vec3.Push(TestData(-1, -1.0f));
+	vec3 = std::move(vec2);
+	assertRetVal(vec3 == vec && vec2.IsEmpty(), false);
+	vec2 = std::move(vec3);
+	assertRetVal(vec2 == vec && vec3.IsEmpty(), false);
+
 	vec.Delete(4, 4);
 	assertRetVal(vec.Size() == 12, false);
 	assertRetVal(*vec.Data(4) == TestData(8, 8.0f), false);
@@ -47,11 +55,34 @@ static bool InternalVectorTest()
 	return true;
 }
 
+template<typename T>
+static bool VectorMoveStringTest()
+{
+	T vec;
+	vec.Push(ff::String(L"one"));
+
+	T vec2;
+	vec2.Push(ff::String(L"two"));
+	vec2.Push(ff::String(L"three"));
+	vec2.Push(ff::String(L"four"));
+
+	vec = std::move(vec2);
+	assertRetVal(vec.Size() == 3 && vec[0] == L"two" && vec[2] == L"four" && vec2.IsEmpty(), false);
+
+	vec2.Push(ff::String(L"five"));
+	vec = std::move(vec2);
+	assertRetVal(vec.Size() == 1 && vec[0] == L"five" && vec2.IsEmpty(), false);
+
+	return true;
+}
+
 bool VectorTest()
 {
 	assertRetVal(InternalVectorTest<typename ff::Vector<TestData COMMA 0>>(), false);
 	assertRetVal(InternalVectorTest<typename ff::Vector<TestData COMMA 2>>(), false);
 	assertRetVal(InternalVectorTest<typename ff::Vector<TestData COMMA 8>>(), false);
+	assertRetVal(VectorMoveStringTest<typename ff::Vector<ff::String COMMA 0>>(), false);
+	assertRetVal(VectorMoveStringTest<typename ff::Vector<ff::String COMMA 2>>(), false);
 
 	return true;
 }
@@ -41,6 +41,7 @@ namespace ff
 	{
 		GCS_COM_BASE,
 		GCS_COM_LISTENER,
+		GCS_DICT_CHAIN,
 		GCS_DIRECT_INPUT,
 		GCS_ENTITY_SYSTEM_BASE,
 		GCS_FILE_UTIL,
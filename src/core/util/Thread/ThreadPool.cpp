@@ -489,6 +489,8 @@ unsigned int ff::CThreadPool::WorkerThread(void *pThreadPoolContext)
 			pool.OnComplete(pWork); // don't use pWork after this
 		}
 
+		ff::MergeBiasedRefs();
+
 		Sleep(0);
 	}
 
@@ -0,0 +1,216 @@
+#pragma once
+
+namespace ff
+{
+	/// Hash map that many threads can use at once, for process-wide caches.
+	///
+	/// Keys are spread across ShardCount shards by the top bits of their hash, and each shard
+	/// is a FlatHashMap with its own reader/writer lock. Threads only contend when they touch
+	/// the same shard at the same time, and lookups only ever take a read lock. Values are
+	/// copied out, since another thread can change the map as soon as the lock is released.
+	template<typename Key, typename Value, typename Hash = Hasher<Key>, size_t ShardCount = 16>
+	class ConcurrentMap
+	{
+		static_assert(ShardCount && ShardCount <= 256 && !(ShardCount & (ShardCount - 1)), "ShardCount must be a power of two");
+
+	public:
+		ConcurrentMap(bool threadSafe = true);
+		~ConcurrentMap();
+
+		size_t Size() const;
+		bool   IsEmpty() const;
+		void   SetKey(const Key &key, const Value &val); // replaces an existing value
+		bool   TryAdd(const Key &key, const Value &val); // returns false if the key already exists
+		bool   DeleteKey(const Key &key);
+		void   Clear();
+
+		bool   Exists(const Key &key) const;
+		bool   Get(const Key &key, Value &val) const;
+
+		// for when the hash is already known, KeyView can be any type that KeyEquals() can compare to Key
+		bool   TryAddWithHash(hash_t hash, const Key &key, const Value &val);
+		template<typename KeyView> bool ExistsWithHash(hash_t hash, const KeyView &key) const;
+		template<typename KeyView> bool GetWithHash(hash_t hash, const KeyView &key, Value &val) const;
+
+		// Calls func(key, value) for everything, while one shard at a time is locked for reading
+		template<typename Func> void ForEach(Func func) const;
+
+	private:
+		typedef FlatHashMap<Key, Value, Hash> MapType;
+
+		// Each shard gets its own cache lines, so that locking one doesn't slow down its neighbors
+		struct alignas(64) Shard
+		{
+			Shard(bool threadSafe) : _lock(threadSafe) { }
+
+			ReaderWriterLock _lock;
+			MapType _map;
+		};
+
+		Shard &GetShard(hash_t hash) { return _shards[static_cast<size_t>(hash >> 56) & (ShardCount - 1)]; }
+		const Shard &GetShard(hash_t hash) const { return _shards[static_cast<size_t>(hash >> 56) & (ShardCount - 1)]; }
+
+		Shard *_shards;
+
+		ConcurrentMap(const ConcurrentMap &rhs) = delete;
+		ConcurrentMap &operator=(const ConcurrentMap &rhs) = delete;
+	};
+}
+
+template<typename Key, typename Value, typename Hash, size_t ShardCount>
+ff::ConcurrentMap<Key, Value, Hash, ShardCount>::ConcurrentMap(bool threadSafe)
+{
+	// Shards are over-aligned, so they can't come from plain new
+	_shards = reinterpret_cast<Shard *>(_aligned_malloc(sizeof(Shard) * ShardCount, __alignof(Shard)));
+
+	for (size_t i = 0; i < ShardCount; i++)
+	{
+		::new(_shards + i) Shard(threadSafe);
+	}
+}
+
+template<typename Key, typename Value, typename Hash, size_t ShardCount>
+ff::ConcurrentMap<Key, Value, Hash, ShardCount>::~ConcurrentMap()
+{
+	for (size_t i = 0; i < ShardCount; i++)
+	{
+		_shards[i].~Shard();
+	}
+
+	_aligned_free(_shards);
+}
+
+template<typename Key, typename Value, typename Hash, size_t ShardCount>
+size_t ff::ConcurrentMap<Key, Value, Hash, ShardCount>::Size() const
+{
+	size_t size = 0;
+
+	for (size_t i = 0; i < ShardCount; i++)
+	{
+		LockReader lock(_shards[i]._lock);
+		size += _shards[i]._map.Size();
+	}
+
+	return size;
+}
+
+template<typename Key, typename Value, typename Hash, size_t ShardCount>
+bool ff::ConcurrentMap<Key, Value, Hash, ShardCount>::IsEmpty() const
+{
+	for (size_t i = 0; i < ShardCount; i++)
+	{
+		LockReader lock(_shards[i]._lock);
+
+		if (!_shards[i]._map.IsEmpty())
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+template<typename Key, typename Value, typename Hash, size_t ShardCount>
+void ff::ConcurrentMap<Key, Value, Hash, ShardCount>::SetKey(const Key &key, const Value &val)
+{
+	hash_t hash = Hash()(key);
+	Shard &shard = GetShard(hash);
+
+	LockWriter lock(shard._lock);
+	shard._map.SetKeyWithHash(hash, key, val);
+}
+
+template<typename Key, typename Value, typename Hash, size_t ShardCount>
+bool ff::ConcurrentMap<Key, Value, Hash, ShardCount>::TryAdd(const Key &key, const Value &val)
+{
+	return TryAddWithHash(Hash()(key), key, val);
+}
+
+template<typename Key, typename Value, typename Hash, size_t ShardCount>
+bool ff::ConcurrentMap<Key, Value, Hash, ShardCount>::DeleteKey(const Key &key)
+{
+	hash_t hash = Hash()(key);
+	Shard &shard = GetShard(hash);
+
+	LockWriter lock(shard._lock);
+	return shard._map.DeleteKey(key);
+}
+
+template<typename Key, typename Value, typename Hash, size_t ShardCount>
+void ff::ConcurrentMap<Key, Value, Hash, ShardCount>::Clear()
+{
+	for (size_t i = 0; i < ShardCount; i++)
+	{
+		LockWriter lock(_shards[i]._lock);
+		_shards[i]._map.Clear();
+	}
+}
+
+template<typename Key, typename Value, typename Hash, size_t ShardCount>
+bool ff::ConcurrentMap<Key, Value, Hash, ShardCount>::Exists(const Key &key) const
+{
+	return ExistsWithHash(Hash()(key), key);
+}
+
+template<typename Key, typename Value, typename Hash, size_t ShardCount>
+bool ff::ConcurrentMap<Key, Value, Hash, ShardCount>::Get(const Key &key, Value &val) const
+{
+	return GetWithHash(Hash()(key), key, val);
+}
+
+template<typename Key, typename Value, typename Hash, size_t ShardCount>
+bool ff::ConcurrentMap<Key, Value, Hash, ShardCount>::TryAddWithHash(hash_t hash, const Key &key, const Value &val)
+{
+	Shard &shard = GetShard(hash);
+
+	// Most calls find the key already there, so check that without blocking other readers
+	{
+		LockReader lock(shard._lock);
+		noAssertRetVal(shard._map.GetWithHash(hash, key) == INVALID_ITER, false);
+	}
+
+	LockWriter lock(shard._lock);
+	noAssertRetVal(shard._map.GetWithHash(hash, key) == INVALID_ITER, false);
+
+	shard._map.SetKeyWithHash(hash, key, val);
+	return true;
+}
+
+template<typename Key, typename Value, typename Hash, size_t ShardCount>
+template<typename KeyView>
+bool ff::ConcurrentMap<Key, Value, Hash, ShardCount>::ExistsWithHash(hash_t hash, const KeyView &key) const
+{
+	const Shard &shard = GetShard(hash);
+
+	LockReader lock(shard._lock);
+	return shard._map.GetWithHash(hash, key) != INVALID_ITER;
+}
+
+template<typename Key, typename Value, typename Hash, size_t ShardCount>
+template<typename KeyView>
+bool ff::ConcurrentMap<Key, Value, Hash, ShardCount>::GetWithHash(hash_t hash, const KeyView &key, Value &val) const
+{
+	const Shard &shard = GetShard(hash);
+
+	LockReader lock(shard._lock);
+	BucketIter iter = shard._map.GetWithHash(hash, key);
+	noAssertRetVal(iter != INVALID_ITER, false);
+
+	val = shard._map.ValueAt(iter);
+	return true;
+}
+
+template<typename Key, typename Value, typename Hash, size_t ShardCount>
+template<typename Func>
+void ff::ConcurrentMap<Key, Value, Hash, ShardCount>::ForEach(Func func) const
+{
+	for (size_t i = 0; i < ShardCount; i++)
+	{
+		LockReader lock(_shards[i]._lock);
+
+		for (const auto &iter: _shards[i]._map)
+		{
+			func(iter.GetKey(), iter.GetValue());
+		}
+	}
+}
@@ -0,0 +1,815 @@
+#pragma once
+
+#if defined(_M_IX86) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+namespace ff
+{
+	namespace details
+	{
+		/// Control bytes for FlatHashSet slots. Full slots store 7 bits of the hash (0-127),
+		/// so a single signed compare tells full slots apart from empty/deleted ones.
+		typedef signed char FlatCtrl;
+
+		static const FlatCtrl FLAT_CTRL_EMPTY = -128;
+		static const FlatCtrl FLAT_CTRL_DELETED = -2;
+		static const size_t FLAT_GROUP_SIZE = 16;
+
+		/// Matches a run of FLAT_GROUP_SIZE control bytes at once, bit N of each
+		/// mask is set when control byte N matches.
+		struct FlatGroup
+		{
+#if defined(_M_IX86) || defined(_M_X64)
+			FlatGroup(const FlatCtrl *ctrl)
+				: _ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i *>(ctrl)))
+			{
+			}
+
+			unsigned int Match(FlatCtrl h2) const
+			{
+				return static_cast<unsigned int>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), _ctrl)));
+			}
+
+			unsigned int MatchEmpty() const
+			{
+				return Match(FLAT_CTRL_EMPTY);
+			}
+
+			unsigned int MatchFull() const
+			{
+				// the high bit is only clear for full slots
+				return static_cast<unsigned int>(~_mm_movemask_epi8(_ctrl)) & 0xFFFF;
+			}
+
+			unsigned int MatchFree() const
+			{
+				return static_cast<unsigned int>(_mm_movemask_epi8(_ctrl));
+			}
+
+			__m128i _ctrl;
+#else
+			FlatGroup(const FlatCtrl *ctrl)
+				: _ctrl(ctrl)
+			{
+			}
+
+			unsigned int Match(FlatCtrl h2) const
+			{
+				unsigned int mask = 0;
+				for (size_t i = 0; i < FLAT_GROUP_SIZE; i++)
+				{
+					mask |= (_ctrl[i] == h2) ? (1u << i) : 0;
+				}
+
+				return mask;
+			}
+
+			unsigned int MatchEmpty() const
+			{
+				return Match(FLAT_CTRL_EMPTY);
+			}
+
+			unsigned int MatchFull() const
+			{
+				return ~MatchFree() & 0xFFFF;
+			}
+
+			unsigned int MatchFree() const
+			{
+				unsigned int mask = 0;
+				for (size_t i = 0; i < FLAT_GROUP_SIZE; i++)
+				{
+					mask |= (_ctrl[i] < 0) ? (1u << i) : 0;
+				}
+
+				return mask;
+			}
+
+			const FlatCtrl *_ctrl;
+#endif
+		};
+
+		inline size_t FlatLowestBit(unsigned int mask)
+		{
+			assert(mask);
+			DWORD index;
+			_BitScanForward(&index, mask);
+			return index;
+		}
+	}
+
+	/// Open-addressing hash set with the same API as Set.
+	///
+	/// Keys are stored inline next to their full hash, with one control byte per slot
+	/// that holds 7 more bits of the hash. Lookups match 16 control bytes at a time,
+	/// so they rarely touch a key that doesn't match. The tradeoff is that keys move
+	/// when the table grows, so don't keep pointers to them (use Set for that).
+	template<typename Key, typename Hash = Hasher<Key>>
+	class FlatHashSet
+	{
+	public:
+		FlatHashSet();
+		FlatHashSet(const FlatHashSet<Key, Hash> &rhs);
+		FlatHashSet(FlatHashSet<Key, Hash> &&rhs);
+		~FlatHashSet();
+
+		FlatHashSet<Key, Hash> &operator=(const FlatHashSet<Key, Hash> &rhs);
+
+		size_t     Size() const;
+		BucketIter SetKey(const Key &key); // doesn't allow duplicates
+		BucketIter SetKey(Key &&key); // doesn't allow duplicates
+		BucketIter Insert(const Key &key); // allows duplicates
+		BucketIter Insert(Key &&key); // allows duplicates
+		bool       DeleteKey(const Key &key); // deletes all matching keys
+		BucketIter DeletePos(BucketIter pos); // returns item after the deleted item
+		void       Clear();
+		bool       IsEmpty() const;
+
+		bool       Exists(const Key &key) const;
+		BucketIter Get(const Key &key) const;
+		BucketIter GetAt(size_t nIndex)  const;
+		BucketIter GetNext(BucketIter pos) const;
+
+		// for when the hash is already known, KeyView can be any type that KeyEquals() can compare to Key
+		BucketIter SetKeyWithHash(hash_t hash, const Key &key); // doesn't allow duplicates
+		BucketIter SetKeyWithHash(hash_t hash, Key &&key); // doesn't allow duplicates
+		template<typename KeyView> BucketIter GetWithHash(hash_t hash, const KeyView &key) const;
+
+		const Key &KeyAt(BucketIter pos) const;
+		hash_t     HashAt(BucketIter pos) const;
+
+		// for iteration through the hash table
+		BucketIter StartIteration()        const;
+		BucketIter Iterate(BucketIter pos) const;
+
+		// advanced
+		void SetBucketCount(size_t nCount, bool bAllowGrow);
+		size_t MemUsage() const;
+		void DebugDump() const;
+
+	private:
+		struct SSlot
+		{
+			SSlot(hash_t hash, const Key &key) : _hash(hash), _key(key) { }
+			SSlot(hash_t hash, Key &&key) : _hash(hash), _key(std::move(key)) { }
+
+			hash_t _hash;
+			Key _key;
+		};
+
+		static const size_t MIN_CAPACITY = details::FLAT_GROUP_SIZE;
+
+		static hash_t MixHash(hash_t hash)         { return hash * 0x9E3779B97F4A7C15ull; }
+		static details::FlatCtrl H2(hash_t mixed)  { return static_cast<details::FlatCtrl>(mixed & 0x7F); }
+		static bool KeysEqual(const Key &lhs, const Key &rhs) { return !(lhs < rhs) && !(rhs < lhs); }
+		template<typename KeyView>
+		static bool KeysEqual(const Key &lhs, const KeyView &rhs) { return KeyEquals(lhs, rhs); }
+
+		SSlot *GetSlot(BucketIter pos) const       { return reinterpret_cast<SSlot *>(pos); }
+		BucketIter GetBucketIter(SSlot *slot) const { return reinterpret_cast<BucketIter>(slot); }
+		size_t GetSlotIndex(BucketIter pos) const  { return GetSlot(pos) - _slots; }
+		size_t HomeIndex(hash_t mixed) const       { return static_cast<size_t>(mixed >> _shift); }
+
+		void SetCtrl(size_t index, details::FlatCtrl ctrl);
+		template<typename KeyView>
+		size_t Find(hash_t hash, const KeyView &key) const;
+		size_t FindNext(size_t index) const;
+		size_t FindFree(hash_t hash) const;
+		size_t FindFull(size_t index) const;
+		void EraseIndex(size_t index);
+		void Reserve(size_t count);
+		void Rehash(size_t capacity);
+		void FreeTable();
+
+		template<typename K>
+		BucketIter InsertKey(hash_t hash, K &&key, bool bAllowDupes);
+
+		details::FlatCtrl *_ctrl;
+		SSlot *_slots;
+		size_t _capacity;
+		size_t _size;
+		size_t _deleted;
+		size_t _shift;
+		bool _keepCapacity;
+
+	// Imperfect C++ iterators
+	public:
+		template<typename IT>
+		class Iterator : public std::iterator<std::input_iterator_tag, IT>
+		{
+			typedef Iterator<IT> MyType;
+			typedef FlatHashSet<Key, Hash> SetType;
+
+		public:
+			Iterator(const SetType *owner, BucketIter iter)
+			{
+				_owner = owner;
+				_iter = iter;
+			}
+
+			Iterator(const MyType &rhs)
+			{
+				_owner = rhs._owner;
+				_iter = rhs._iter;
+			}
+
+			const IT &operator*() const
+			{
+				return _owner->KeyAt(_iter);
+			}
+
+			const IT *operator->() const
+			{
+				return &_owner->KeyAt(_iter);
+			}
+
+			MyType &operator++()
+			{
+				_iter = _owner->Iterate(_iter);
+				return *this;
+			}
+
+			MyType operator++(int)
+			{
+				MyType pre = *this;
+				_iter = _owner->Iterate(_iter);
+				return pre;
+			}
+
+			bool operator==(const MyType &rhs) const
+			{
+				return _owner == rhs._owner && _iter == rhs._iter;
+			}
+
+			bool operator!=(const MyType &rhs) const
+			{
+				return _owner != rhs._owner || _iter != rhs._iter;
+			}
+
+		private:
+			const SetType *_owner;
+			BucketIter _iter;
+		};
+
+		typedef Iterator<Key> const_iterator;
+
+		const_iterator begin() const  { return const_iterator(this, StartIteration()); }
+		const_iterator end() const    { return const_iterator(this, nullptr); }
+		const_iterator cbegin() const { return const_iterator(this, StartIteration()); }
+		const_iterator cend() const   { return const_iterator(this, nullptr); }
+	};
+}
+
+template<typename Key, typename Hash>
+ff::FlatHashSet<Key, Hash>::FlatHashSet()
+	: _ctrl(nullptr)
+	, _slots(nullptr)
+	, _capacity(0)
+	, _size(0)
+	, _deleted(0)
+	, _shift(0)
+	, _keepCapacity(false)
+{
+}
+
+template<typename Key, typename Hash>
+ff::FlatHashSet<Key, Hash>::FlatHashSet(const FlatHashSet<Key, Hash> &rhs)
+	: _ctrl(nullptr)
+	, _slots(nullptr)
+	, _capacity(0)
+	, _size(0)
+	, _deleted(0)
+	, _shift(0)
+	, _keepCapacity(rhs._keepCapacity)
+{
+	*this = rhs;
+}
+
+template<typename Key, typename Hash>
+ff::FlatHashSet<Key, Hash>::FlatHashSet(FlatHashSet<Key, Hash> &&rhs)
+	: _ctrl(rhs._ctrl)
+	, _slots(rhs._slots)
+	, _capacity(rhs._capacity)
+	, _size(rhs._size)
+	, _deleted(rhs._deleted)
+	, _shift(rhs._shift)
+	, _keepCapacity(rhs._keepCapacity)
+{
+	rhs._ctrl = nullptr;
+	rhs._slots = nullptr;
+	rhs._capacity = 0;
+	rhs._size = 0;
+	rhs._deleted = 0;
+	rhs._shift = 0;
+	rhs._keepCapacity = false;
+}
+
+template<typename Key, typename Hash>
+ff::FlatHashSet<Key, Hash>::~FlatHashSet()
+{
+	_keepCapacity = false;
+	Clear();
+}
+
+template<typename Key, typename Hash>
+ff::FlatHashSet<Key, Hash> &ff::FlatHashSet<Key, Hash>::operator=(const FlatHashSet<Key, Hash> &rhs)
+{
+	if (this != &rhs)
+	{
+		Clear();
+		Reserve(rhs._size);
+
+		for (size_t i = rhs.FindFull(0); i != INVALID_SIZE; i = rhs.FindFull(i + 1))
+		{
+			InsertKey(rhs._slots[i]._hash, rhs._slots[i]._key, true);
+		}
+	}
+
+	return *this;
+}
+
+template<typename Key, typename Hash>
+size_t ff::FlatHashSet<Key, Hash>::Size() const
+{
+	return _size;
+}
+
+template<typename Key, typename Hash>
+ff::BucketIter ff::FlatHashSet<Key, Hash>::SetKey(const Key &key)
+{
+	return InsertKey(Hash()(key), key, false);
+}
+
+template<typename Key, typename Hash>
+ff::BucketIter ff::FlatHashSet<Key, Hash>::SetKey(Key &&key)
+{
+	hash_t hash = Hash()(key);
+	return InsertKey(hash, std::move(key), false);
+}
+
+template<typename Key, typename Hash>
+ff::BucketIter ff::FlatHashSet<Key, Hash>::Insert(const Key &key)
+{
+	return InsertKey(Hash()(key), key, true);
+}
+
+template<typename Key, typename Hash>
+ff::BucketIter ff::FlatHashSet<Key, Hash>::Insert(Key &&key)
+{
+	hash_t hash = Hash()(key);
+	return InsertKey(hash, std::move(key), true);
+}
+
+template<typename Key, typename Hash>
+bool ff::FlatHashSet<Key, Hash>::DeleteKey(const Key &key)
+{
+	size_t index = _size ? Find(Hash()(key), key) : INVALID_SIZE;
+
+	if (index != INVALID_SIZE)
+	{
+		// find all duplicate keys to delete
+		for (size_t next = FindNext(index); next != INVALID_SIZE; next = FindNext(index))
+		{
+			EraseIndex(next);
+		}
+
+		EraseIndex(index);
+		return true;
+	}
+
+	return false;
+}
+
+template<typename Key, typename Hash>
+ff::BucketIter ff::FlatHashSet<Key, Hash>::DeletePos(BucketIter pos)
+{
+	if (pos != INVALID_ITER)
+	{
+		size_t index = GetSlotIndex(pos);
+		EraseIndex(index);
+
+		// Slots never move on delete, so the next item is just the next full slot
+		index = FindFull(index + 1);
+		return GetBucketIter(index != INVALID_SIZE ? &_slots[index] : nullptr);
+	}
+
+	return GetBucketIter(nullptr);
+}
+
+template<typename Key, typename Hash>
+void ff::FlatHashSet<Key, Hash>::Clear()
+{
+	for (size_t i = FindFull(0); i != INVALID_SIZE; i = FindFull(i + 1))
+	{
+		_slots[i].~SSlot();
+	}
+
+	_size = 0;
+	_deleted = 0;
+
+	if (_keepCapacity && _capacity)
+	{
+		std::memset(_ctrl, details::FLAT_CTRL_EMPTY, _capacity + details::FLAT_GROUP_SIZE);
+	}
+	else
+	{
+		FreeTable();
+	}
+}
+
+template<typename Key, typename Hash>
+bool ff::FlatHashSet<Key, Hash>::IsEmpty() const
+{
+	return _size == 0;
+}
+
+template<typename Key, typename Hash>
+bool ff::FlatHashSet<Key, Hash>::Exists(const Key &key) const
+{
+	return Get(key) != INVALID_ITER;
+}
+
+template<typename Key, typename Hash>
+ff::BucketIter ff::FlatHashSet<Key, Hash>::Get(const Key &key) const
+{
+	if (_size)
+	{
+		size_t index = Find(Hash()(key), key);
+		if (index != INVALID_SIZE)
+		{
+			return GetBucketIter(&_slots[index]);
+		}
+	}
+
+	return GetBucketIter(nullptr);
+}
+
+template<typename Key, typename Hash>
+ff::BucketIter ff::FlatHashSet<Key, Hash>::GetAt(size_t nIndex) const
+{
+	if (nIndex < _size)
+	{
+		for (size_t i = FindFull(0); i != INVALID_SIZE; i = FindFull(i + 1))
+		{
+			if (!nIndex--)
+			{
+				return GetBucketIter(&_slots[i]);
+			}
+		}
+	}
+
+	assertRetVal(false, GetBucketIter(nullptr));
+}
+
+template<typename Key, typename Hash>
+ff::BucketIter ff::FlatHashSet<Key, Hash>::GetNext(BucketIter pos) const
+{
+	if (pos != INVALID_ITER)
+	{
+		size_t index = FindNext(GetSlotIndex(pos));
+		if (index != INVALID_SIZE)
+		{
+			return GetBucketIter(&_slots[index]);
+		}
+	}
+
+	return GetBucketIter(nullptr);
+}
+
+template<typename Key, typename Hash>
+ff::BucketIter ff::FlatHashSet<Key, Hash>::SetKeyWithHash(hash_t hash, const Key &key)
+{
+	assert(hash == Hash()(key));
+	return InsertKey(hash, key, false);
+}
+
+template<typename Key, typename Hash>
+ff::BucketIter ff::FlatHashSet<Key, Hash>::SetKeyWithHash(hash_t hash, Key &&key)
+{
+	assert(hash == Hash()(key));
+	return InsertKey(hash, std::move(key), false);
+}
+
+template<typename Key, typename Hash>
+template<typename KeyView>
+ff::BucketIter ff::FlatHashSet<Key, Hash>::GetWithHash(hash_t hash, const KeyView &key) const
+{
+	if (_size)
+	{
+		size_t index = Find(hash, key);
+		if (index != INVALID_SIZE)
+		{
+			return GetBucketIter(&_slots[index]);
+		}
+	}
+
+	return GetBucketIter(nullptr);
+}
+
+template<typename Key, typename Hash>
+const Key &ff::FlatHashSet<Key, Hash>::KeyAt(BucketIter pos) const
+{
+	assert(pos != INVALID_ITER);
+	return GetSlot(pos)->_key;
+}
+
+template<typename Key, typename Hash>
+ff::hash_t ff::FlatHashSet<Key, Hash>::HashAt(BucketIter pos) const
+{
+	assert(pos != INVALID_ITER);
+	return GetSlot(pos)->_hash;
+}
+
+template<typename Key, typename Hash>
+ff::BucketIter ff::FlatHashSet<Key, Hash>::StartIteration() const
+{
+	size_t index = _size ? FindFull(0) : INVALID_SIZE;
+	return GetBucketIter(index != INVALID_SIZE ? &_slots[index] : nullptr);
+}
+
+template<typename Key, typename Hash>
+ff::BucketIter ff::FlatHashSet<Key, Hash>::Iterate(BucketIter pos) const
+{
+	assert(pos != INVALID_ITER);
+
+	if (pos != INVALID_ITER)
+	{
+		size_t index = FindFull(GetSlotIndex(pos) + 1);
+		if (index != INVALID_SIZE)
+		{
+			return GetBucketIter(&_slots[index]);
+		}
+	}
+
+	return GetBucketIter(nullptr);
+}
+
+template<typename Key, typename Hash>
+void ff::FlatHashSet<Key, Hash>::SetBucketCount(size_t nCount, bool bAllowGrow)
+{
+	Reserve(nCount);
+
+	// Open addressing must always grow when full, but a fixed capacity is kept across Clear()
+	_keepCapacity = !bAllowGrow;
+}
+
+template<typename Key, typename Hash>
+size_t ff::FlatHashSet<Key, Hash>::MemUsage() const
+{
+	return _capacity ? _capacity * sizeof(SSlot) + _capacity + details::FLAT_GROUP_SIZE : 0;
+}
+
+template<typename Key, typename Hash>
+void ff::FlatHashSet<Key, Hash>::DebugDump() const
+{
+	Log::DebugTraceF(L"Size %lu, with %lu slots and %lu deleted.\n", Size(), _capacity, _deleted);
+	Log::DebugTraceF(L"---------------------------\n");
+
+	size_t totalProbe = 0;
+	size_t maxProbe = 0;
+
+	for (size_t i = FindFull(0); i != INVALID_SIZE; i = FindFull(i + 1))
+	{
+		size_t probe = (i - HomeIndex(MixHash(_slots[i]._hash))) & (_capacity - 1);
+		totalProbe += probe;
+		maxProbe = std::max(maxProbe, probe);
+	}
+
+	Log::DebugTraceF(L"Average probe:%lu, Max probe:%lu\n", _size ? totalProbe / _size : 0, maxProbe);
+}
+
+template<typename Key, typename Hash>
+void ff::FlatHashSet<Key, Hash>::SetCtrl(size_t index, details::FlatCtrl ctrl)
+{
+	_ctrl[index] = ctrl;
+
+	// The bytes past the end clone the start, so a group can be loaded from any index
+	if (index < details::FLAT_GROUP_SIZE)
+	{
+		_ctrl[_capacity + index] = ctrl;
+	}
+}
+
+template<typename Key, typename Hash>
+template<typename KeyView>
+size_t ff::FlatHashSet<Key, Hash>::Find(hash_t hash, const KeyView &key) const
+{
+	hash_t mixed = MixHash(hash);
+	details::FlatCtrl h2 = H2(mixed);
+	size_t mask = _capacity - 1;
+
+	for (size_t pos = HomeIndex(mixed); ; pos = (pos + details::FLAT_GROUP_SIZE) & mask)
+	{
+		details::FlatGroup group(_ctrl + pos);
+
+		for (unsigned int match = group.Match(h2); match; match &= match - 1)
+		{
+			size_t index = (pos + details::FlatLowestBit(match)) & mask;
+			const SSlot &slot = _slots[index];
+
+			if (slot._hash == hash && KeysEqual(slot._key, key))
+			{
+				return index;
+			}
+		}
+
+		if (group.MatchEmpty())
+		{
+			return INVALID_SIZE;
+		}
+	}
+}
+
+template<typename Key, typename Hash>
+size_t ff::FlatHashSet<Key, Hash>::FindNext(size_t index) const
+{
+	// Duplicates are always further along the same probe run, which ends at an empty slot
+	const SSlot &slot = _slots[index];
+	details::FlatCtrl h2 = _ctrl[index];
+	size_t mask = _capacity - 1;
+
+	for (size_t i = (index + 1) & mask; i != index && _ctrl[i] != details::FLAT_CTRL_EMPTY; i = (i + 1) & mask)
+	{
+		if (_ctrl[i] == h2 && _slots[i]._hash == slot._hash && KeysEqual(_slots[i]._key, slot._key))
+		{
+			return i;
+		}
+	}
+
+	return INVALID_SIZE;
+}
+
+template<typename Key, typename Hash>
+size_t ff::FlatHashSet<Key, Hash>::FindFree(hash_t hash) const
+{
+	size_t mask = _capacity - 1;
+
+	for (size_t pos = HomeIndex(MixHash(hash)); ; pos = (pos + details::FLAT_GROUP_SIZE) & mask)
+	{
+		unsigned int match = details::FlatGroup(_ctrl + pos).MatchFree();
+		if (match)
+		{
+			return (pos + details::FlatLowestBit(match)) & mask;
+		}
+	}
+}
+
+template<typename Key, typename Hash>
+size_t ff::FlatHashSet<Key, Hash>::FindFull(size_t index) const
+{
+	for (; index < _capacity; index += details::FLAT_GROUP_SIZE)
+	{
+		unsigned int match = details::FlatGroup(_ctrl + index).MatchFull();
+
+		// ignore the cloned control bytes past the end
+		if (_capacity - index < details::FLAT_GROUP_SIZE)
+		{
+			match &= (1u << (_capacity - index)) - 1;
+		}
+
+		if (match)
+		{
+			return index + details::FlatLowestBit(match);
+		}
+	}
+
+	return INVALID_SIZE;
+}
+
+template<typename Key, typename Hash>
+void ff::FlatHashSet<Key, Hash>::EraseIndex(size_t index)
+{
+	assert(_ctrl[index] >= 0);
+
+	_slots[index].~SSlot();
+	_size--;
+
+	// A slot can only become empty again when no probe run continues through it
+	if (_ctrl[(index + 1) & (_capacity - 1)] == details::FLAT_CTRL_EMPTY)
+	{
+		SetCtrl(index, details::FLAT_CTRL_EMPTY);
+	}
+	else
+	{
+		SetCtrl(index, details::FLAT_CTRL_DELETED);
+		_deleted++;
+	}
+}
+
+template<typename Key, typename Hash>
+void ff::FlatHashSet<Key, Hash>::Reserve(size_t count)
+{
+	// Keep the load under 7/8 so every probe run ends at an empty slot
+	size_t capacity = _capacity ? _capacity : MIN_CAPACITY;
+	while (count >= capacity - capacity / 8)
+	{
+		capacity *= 2;
+	}
+
+	if (capacity != _capacity)
+	{
+		Rehash(capacity);
+	}
+}
+
+template<typename Key, typename Hash>
+void ff::FlatHashSet<Key, Hash>::Rehash(size_t capacity)
+{
+	assert(capacity >= MIN_CAPACITY && NearestPowerOfTwo(capacity) == capacity);
+
+	details::FlatCtrl *oldCtrl = _ctrl;
+	SSlot *oldSlots = _slots;
+	size_t oldCapacity = _capacity;
+
+	_ctrl = reinterpret_cast<details::FlatCtrl *>(_aligned_malloc(capacity + details::FLAT_GROUP_SIZE, details::FLAT_GROUP_SIZE));
+	_slots = reinterpret_cast<SSlot *>(_aligned_malloc(capacity * sizeof(SSlot), std::max<size_t>(__alignof(SSlot), sizeof(void *))));
+	_capacity = capacity;
+	_deleted = 0;
+	_shift = 64;
+
+	for (size_t i = capacity; i > 1; i /= 2)
+	{
+		_shift--;
+	}
+
+	std::memset(_ctrl, details::FLAT_CTRL_EMPTY, capacity + details::FLAT_GROUP_SIZE);
+
+	for (size_t i = 0; i < oldCapacity; i++)
+	{
+		if (oldCtrl[i] >= 0)
+		{
+			SSlot &oldSlot = oldSlots[i];
+			size_t index = FindFree(oldSlot._hash);
+
+			::new(&_slots[index]) SSlot(oldSlot._hash, std::move(oldSlot._key));
+			SetCtrl(index, H2(MixHash(oldSlot._hash)));
+			oldSlot.~SSlot();
+		}
+	}
+
+	if (oldCapacity)
+	{
+		_aligned_free(oldCtrl);
+		_aligned_free(oldSlots);
+	}
+}
+
+template<typename Key, typename Hash>
+void ff::FlatHashSet<Key, Hash>::FreeTable()
+{
+	assert(!_size);
+
+	if (_capacity)
+	{
+		_aligned_free(_ctrl);
+		_aligned_free(_slots);
+
+		_ctrl = nullptr;
+		_slots = nullptr;
+		_capacity = 0;
+		_deleted = 0;
+		_shift = 0;
+	}
+}
+
+template<typename Key, typename Hash>
+template<typename K>
+ff::BucketIter ff::FlatHashSet<Key, Hash>::InsertKey(hash_t hash, K &&key, bool bAllowDupes)
+{
+	if (!bAllowDupes && _size)
+	{
+		size_t index = Find(hash, key);
+		if (index != INVALID_SIZE)
+		{
+			// Delete dupes of the existing entry
+			for (size_t next = FindNext(index); next != INVALID_SIZE; next = FindNext(index))
+			{
+				EraseIndex(next);
+			}
+
+			// Update the existing entry
+			_slots[index]._key = std::forward<K>(key);
+			return GetBucketIter(&_slots[index]);
+		}
+	}
+
+	if (!_capacity)
+	{
+		Rehash(MIN_CAPACITY);
+	}
+	else if (_size + _deleted + 1 >= _capacity - _capacity / 8)
+	{
+		// Reclaim deleted slots in place when they are the reason for the rehash
+		Rehash(_size < _capacity / 2 ? _capacity : _capacity * 2);
+	}
+
+	size_t index = FindFree(hash);
+	_deleted -= (_ctrl[index] == details::FLAT_CTRL_DELETED) ? 1 : 0;
+
+	::new(&_slots[index]) SSlot(hash, std::forward<K>(key));
+	SetCtrl(index, H2(MixHash(hash)));
+	_size++;
+
+	return GetBucketIter(&_slots[index]);
+}
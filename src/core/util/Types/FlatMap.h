@@ -0,0 +1,487 @@
+#pragma once
+
+namespace ff
+{
+	/// Orders the keys in a FlatMap, using operator< by default
+	template<typename Key>
+	struct FlatMapLess
+	{
+		bool operator()(const Key &lhs, const Key &rhs) const
+		{
+			return lhs < rhs;
+		}
+	};
+
+	/// GUIDs are ordered as two 64-bit numbers, which is cheaper than the memcmp in their operator<
+	/// (the order is different, but FlatMap only needs it to be consistent)
+	template<>
+	struct FlatMapLess<GUID>
+	{
+		bool operator()(const GUID &lhs, const GUID &rhs) const
+		{
+			uint64_t l[2], r[2];
+			std::memcpy(l, &lhs, sizeof(GUID));
+			std::memcpy(r, &rhs, sizeof(GUID));
+
+			return (l[0] < r[0]) | ((l[0] == r[0]) & (l[1] < r[1]));
+		}
+	};
+
+	namespace details
+	{
+		/// Finds the first key that isn't less than the key being searched for. The binary
+		/// search avoids branches by always halving the range and picking the next half
+		/// with a conditional move.
+		template<typename Key, typename Compare>
+		size_t FlatMapLowerBound(const Key *keys, size_t size, const Key &key)
+		{
+			if (!size)
+			{
+				return 0;
+			}
+
+			Compare less;
+			const Key *base = keys;
+
+			while (size > 1)
+			{
+				size_t half = size / 2;
+				base = less(base[half], key) ? base + half : base;
+				size -= half;
+			}
+
+			return (base - keys) + (less(*base, key) ? 1 : 0);
+		}
+	}
+
+	/// Map with the same API as Map, for small tables that are mostly read.
+	///
+	/// Keys and values are stored in two separate sorted arrays, so a lookup is a binary
+	/// search through tightly packed keys and nothing is allocated per entry. Adding or
+	/// deleting a key moves everything after it, so use Build() to fill a big table all
+	/// at once. Iteration is in key order, and every change invalidates all iterators
+	/// (except the one DeletePos returns).
+	template<typename Key, typename Value, typename Compare = FlatMapLess<Key>>
+	class FlatMap
+	{
+		typedef FlatMap<Key, Value, Compare> MyType;
+
+	public:
+		FlatMap();
+		FlatMap(const MyType &rhs);
+		FlatMap(MyType &&rhs);
+		~FlatMap();
+
+		MyType &operator=(const MyType &rhs);
+		MyType &operator=(MyType &&rhs);
+
+		size_t       Size() const;
+		BucketIter   SetKey(const Key &key, const Value &val); // doesn't allow duplicates
+		BucketIter   SetKey(Key &&key, Value &&val); // doesn't allow duplicates
+		BucketIter   Insert(const Key &key, const Value &val); // allows duplicates
+		BucketIter   Insert(Key &&key, Value &&val); // allows duplicates
+		bool         DeleteKey(const Key &key); // deletes all matching keys
+		BucketIter   DeletePos(BucketIter pos); // returns item after the deleted item
+		void         Clear();
+		bool         IsEmpty() const;
+		void         Reserve(size_t count);
+
+		// Replaces everything with unsorted keys and values, duplicates stay in their original order
+		void         Build(Vector<Key> &&keys, Vector<Value> &&values);
+
+		bool         Exists(const Key &key) const;
+		BucketIter   Get(const Key &key) const; // the first matching key
+		BucketIter   GetAt(size_t nIndex) const;
+		BucketIter   GetNext(BucketIter pos) const; // the next matching key
+
+		const Key   &KeyAt(BucketIter pos) const;
+		const Value &ValueAt(BucketIter pos) const;
+		Value       &ValueAt(BucketIter pos);
+
+		// for iteration through the map
+		BucketIter   StartIteration()        const;
+		BucketIter   Iterate(BucketIter pos) const;
+
+		// advanced
+		size_t       MemUsage() const;
+		void         DebugDump() const;
+
+	private:
+		// BucketIter is the index plus one, so that zero is INVALID_ITER
+		static size_t GetIndex(BucketIter pos) { return reinterpret_cast<size_t>(pos) - 1; }
+		static BucketIter GetBucketIter(size_t index) { return reinterpret_cast<BucketIter>(index + 1); }
+
+		size_t LowerBound(const Key &key) const;
+		size_t UpperBound(const Key &key) const;
+		bool KeyMatches(size_t index, const Key &key) const;
+
+		Vector<Key> _keys;
+		Vector<Value> _values;
+
+	// Imperfect C++ iterators
+	public:
+		/// What the iterator points to, with the same accessors as KeyValue
+		class Entry
+		{
+		public:
+			Entry(const MyType *owner, size_t index)
+				: _owner(owner)
+				, _index(index)
+			{
+			}
+
+			const Key &GetKey() const { return _owner->_keys[_index]; }
+			const Value &GetValue() const { return _owner->_values[_index]; }
+			Value &GetEditableValue() const { return const_cast<Value &>(_owner->_values[_index]); }
+
+		private:
+			const MyType *_owner;
+			size_t _index;
+		};
+
+		class Iterator : public std::iterator<std::input_iterator_tag, Entry>
+		{
+		public:
+			Iterator(const MyType *owner, size_t index)
+				: _owner(owner)
+				, _index(index)
+			{
+			}
+
+			Entry operator*() const
+			{
+				return Entry(_owner, _index);
+			}
+
+			Iterator &operator++()
+			{
+				_index++;
+				return *this;
+			}
+
+			Iterator operator++(int)
+			{
+				Iterator pre = *this;
+				_index++;
+				return pre;
+			}
+
+			bool operator==(const Iterator &rhs) const
+			{
+				return _owner == rhs._owner && _index == rhs._index;
+			}
+
+			bool operator!=(const Iterator &rhs) const
+			{
+				return _owner != rhs._owner || _index != rhs._index;
+			}
+
+		private:
+			const MyType *_owner;
+			size_t _index;
+		};
+
+		typedef Iterator const_iterator;
+
+		const_iterator begin() const  { return const_iterator(this, 0); }
+		const_iterator end() const    { return const_iterator(this, Size()); }
+		const_iterator cbegin() const { return const_iterator(this, 0); }
+		const_iterator cend() const   { return const_iterator(this, Size()); }
+	};
+}
+
+template<typename Key, typename Value, typename Compare>
+ff::FlatMap<Key, Value, Compare>::FlatMap()
+{
+}
+
+template<typename Key, typename Value, typename Compare>
+ff::FlatMap<Key, Value, Compare>::FlatMap(const MyType &rhs)
+	: _keys(rhs._keys)
+	, _values(rhs._values)
+{
+}
+
+template<typename Key, typename Value, typename Compare>
+ff::FlatMap<Key, Value, Compare>::FlatMap(MyType &&rhs)
+	: _keys(std::move(rhs._keys))
+	, _values(std::move(rhs._values))
+{
+}
+
+template<typename Key, typename Value, typename Compare>
+ff::FlatMap<Key, Value, Compare>::~FlatMap()
+{
+}
+
+template<typename Key, typename Value, typename Compare>
+ff::FlatMap<Key, Value, Compare> &ff::FlatMap<Key, Value, Compare>::operator=(const MyType &rhs)
+{
+	_keys = rhs._keys;
+	_values = rhs._values;
+	return *this;
+}
+
+template<typename Key, typename Value, typename Compare>
+ff::FlatMap<Key, Value, Compare> &ff::FlatMap<Key, Value, Compare>::operator=(MyType &&rhs)
+{
+	_keys = std::move(rhs._keys);
+	_values = std::move(rhs._values);
+	return *this;
+}
+
+template<typename Key, typename Value, typename Compare>
+size_t ff::FlatMap<Key, Value, Compare>::Size() const
+{
+	return _keys.Size();
+}
+
+template<typename Key, typename Value, typename Compare>
+ff::BucketIter ff::FlatMap<Key, Value, Compare>::SetKey(const Key &key, const Value &val)
+{
+	size_t index = LowerBound(key);
+
+	if (KeyMatches(index, key))
+	{
+		_values[index] = val;
+	}
+	else
+	{
+		_keys.Insert(index, key);
+		_values.Insert(index, val);
+	}
+
+	return GetBucketIter(index);
+}
+
+template<typename Key, typename Value, typename Compare>
+ff::BucketIter ff::FlatMap<Key, Value, Compare>::SetKey(Key &&key, Value &&val)
+{
+	size_t index = LowerBound(key);
+
+	if (KeyMatches(index, key))
+	{
+		_values[index] = std::move(val);
+	}
+	else
+	{
+		_keys.Insert(index, std::move(key));
+		_values.Insert(index, std::move(val));
+	}
+
+	return GetBucketIter(index);
+}
+
+template<typename Key, typename Value, typename Compare>
+ff::BucketIter ff::FlatMap<Key, Value, Compare>::Insert(const Key &key, const Value &val)
+{
+	size_t index = UpperBound(key);
+	_keys.Insert(index, key);
+	_values.Insert(index, val);
+
+	return GetBucketIter(index);
+}
+
+template<typename Key, typename Value, typename Compare>
+ff::BucketIter ff::FlatMap<Key, Value, Compare>::Insert(Key &&key, Value &&val)
+{
+	size_t index = UpperBound(key);
+	_keys.Insert(index, std::move(key));
+	_values.Insert(index, std::move(val));
+
+	return GetBucketIter(index);
+}
+
+template<typename Key, typename Value, typename Compare>
+bool ff::FlatMap<Key, Value, Compare>::DeleteKey(const Key &key)
+{
+	size_t index = LowerBound(key);
+	size_t count = 0;
+
+	while (KeyMatches(index + count, key))
+	{
+		count++;
+	}
+
+	if (count)
+	{
+		_keys.Delete(index, count);
+		_values.Delete(index, count);
+	}
+
+	return count != 0;
+}
+
+template<typename Key, typename Value, typename Compare>
+ff::BucketIter ff::FlatMap<Key, Value, Compare>::DeletePos(BucketIter pos)
+{
+	assertRetVal(pos != INVALID_ITER, INVALID_ITER);
+
+	size_t index = GetIndex(pos);
+	_keys.Delete(index);
+	_values.Delete(index);
+
+	return (index < Size()) ? pos : INVALID_ITER;
+}
+
+template<typename Key, typename Value, typename Compare>
+void ff::FlatMap<Key, Value, Compare>::Clear()
+{
+	_keys.Clear();
+	_values.Clear();
+}
+
+template<typename Key, typename Value, typename Compare>
+bool ff::FlatMap<Key, Value, Compare>::IsEmpty() const
+{
+	return _keys.IsEmpty();
+}
+
+template<typename Key, typename Value, typename Compare>
+void ff::FlatMap<Key, Value, Compare>::Reserve(size_t count)
+{
+	_keys.Reserve(count);
+	_values.Reserve(count);
+}
+
+template<typename Key, typename Value, typename Compare>
+void ff::FlatMap<Key, Value, Compare>::Build(Vector<Key> &&keys, Vector<Value> &&values)
+{
+	assertRet(keys.Size() == values.Size());
+
+	Compare less;
+	bool sorted = true;
+
+	for (size_t i = 1; sorted && i < keys.Size(); i++)
+	{
+		sorted = !less(keys[i], keys[i - 1]);
+	}
+
+	if (sorted)
+	{
+		_keys = std::move(keys);
+		_values = std::move(values);
+		return;
+	}
+
+	Vector<size_t> order;
+	order.Resize(keys.Size());
+
+	for (size_t i = 0; i < order.Size(); i++)
+	{
+		order[i] = i;
+	}
+
+	std::stable_sort(order.Data(), order.Data() + order.Size(), [&keys, &less](size_t lhs, size_t rhs)
+	{
+		return less(keys[lhs], keys[rhs]);
+	});
+
+	Clear();
+	Reserve(order.Size());
+
+	for (size_t i: order)
+	{
+		_keys.Push(std::move(keys[i]));
+		_values.Push(std::move(values[i]));
+	}
+
+	keys.Clear();
+	values.Clear();
+}
+
+template<typename Key, typename Value, typename Compare>
+bool ff::FlatMap<Key, Value, Compare>::Exists(const Key &key) const
+{
+	return KeyMatches(LowerBound(key), key);
+}
+
+template<typename Key, typename Value, typename Compare>
+ff::BucketIter ff::FlatMap<Key, Value, Compare>::Get(const Key &key) const
+{
+	size_t index = LowerBound(key);
+	return KeyMatches(index, key) ? GetBucketIter(index) : INVALID_ITER;
+}
+
+template<typename Key, typename Value, typename Compare>
+ff::BucketIter ff::FlatMap<Key, Value, Compare>::GetAt(size_t nIndex) const
+{
+	return (nIndex < Size()) ? GetBucketIter(nIndex) : INVALID_ITER;
+}
+
+template<typename Key, typename Value, typename Compare>
+ff::BucketIter ff::FlatMap<Key, Value, Compare>::GetNext(BucketIter pos) const
+{
+	assertRetVal(pos != INVALID_ITER, INVALID_ITER);
+
+	size_t index = GetIndex(pos);
+	return KeyMatches(index + 1, _keys[index]) ? GetBucketIter(index + 1) : INVALID_ITER;
+}
+
+template<typename Key, typename Value, typename Compare>
+const Key &ff::FlatMap<Key, Value, Compare>::KeyAt(BucketIter pos) const
+{
+	return _keys[GetIndex(pos)];
+}
+
+template<typename Key, typename Value, typename Compare>
+const Value &ff::FlatMap<Key, Value, Compare>::ValueAt(BucketIter pos) const
+{
+	return _values[GetIndex(pos)];
+}
+
+template<typename Key, typename Value, typename Compare>
+Value &ff::FlatMap<Key, Value, Compare>::ValueAt(BucketIter pos)
+{
+	return _values[GetIndex(pos)];
+}
+
+template<typename Key, typename Value, typename Compare>
+ff::BucketIter ff::FlatMap<Key, Value, Compare>::StartIteration() const
+{
+	return GetAt(0);
+}
+
+template<typename Key, typename Value, typename Compare>
+ff::BucketIter ff::FlatMap<Key, Value, Compare>::Iterate(BucketIter pos) const
+{
+	return (pos != INVALID_ITER) ? GetAt(GetIndex(pos) + 1) : INVALID_ITER;
+}
+
+template<typename Key, typename Value, typename Compare>
+size_t ff::FlatMap<Key, Value, Compare>::MemUsage() const
+{
+	return _keys.BytesAllocated() + _values.BytesAllocated();
+}
+
+template<typename Key, typename Value, typename Compare>
+void ff::FlatMap<Key, Value, Compare>::DebugDump() const
+{
+	Log::DebugTraceF(L"Size %lu, allocated %lu.\n", Size(), _keys.Allocated());
+}
+
+template<typename Key, typename Value, typename Compare>
+size_t ff::FlatMap<Key, Value, Compare>::LowerBound(const Key &key) const
+{
+	return _keys.Size() ? details::FlatMapLowerBound<Key, Compare>(_keys.ConstData(), _keys.Size(), key) : 0;
+}
+
+template<typename Key, typename Value, typename Compare>
+size_t ff::FlatMap<Key, Value, Compare>::UpperBound(const Key &key) const
+{
+	size_t index = LowerBound(key);
+
+	while (KeyMatches(index, key))
+	{
+		index++;
+	}
+
+	return index;
+}
+
+template<typename Key, typename Value, typename Compare>
+bool ff::FlatMap<Key, Value, Compare>::KeyMatches(size_t index, const Key &key) const
+{
+	// keys at or after LowerBound(key) are never less than key
+	return index < _keys.Size() && !Compare()(key, _keys[index]);
+}
@@ -0,0 +1,200 @@
+#include "pch.h"
+#include "App/Log.h"
+#include "Types/FrameArena.h"
+
+static const BYTE FRAME_ARENA_POISON = 0xDD;
+static const size_t FRAME_ARENA_ALIGN = 16;
+
+// STATIC_DATA (object)
+static ff::FrameArena s_frameArena;
+
+ff::FrameArena &ff::GetFrameArena()
+{
+	return s_frameArena;
+}
+
+ff::FrameArena::FrameArena(size_t blockSize)
+	: _curBlock(0)
+	, _cur(nullptr)
+	, _end(nullptr)
+	, _blockSize(blockSize)
+	, _fullBlockBytes(0)
+	, _lastFrameBytes(0)
+	, _maxFrameBytes(0)
+	, _frameCount(0)
+#ifdef _DEBUG
+	, _threadId(0)
+#endif
+{
+	assert(blockSize);
+}
+
+ff::FrameArena::~FrameArena()
+{
+	FreeBlocks();
+}
+
+void *ff::FrameArena::Alloc(size_t bytes, size_t align)
+{
+	assert(align && !(align & (align - 1)));
+#ifdef _DEBUG
+	assert(!_threadId || _threadId == ::GetCurrentThreadId());
+#endif
+	BYTE *data = reinterpret_cast<BYTE *>((reinterpret_cast<size_t>(_cur) + align - 1) & ~(align - 1));
+
+	if (!_cur || data > _end || bytes > static_cast<size_t>(_end - data))
+	{
+		return AllocSlow(bytes, align);
+	}
+
+	_cur = data + bytes;
+	return data;
+}
+
+const wchar_t *ff::FrameArena::CopyString(const wchar_t *str, size_t len)
+{
+	wchar_t *data = reinterpret_cast<wchar_t *>(Alloc((len + 1) * sizeof(wchar_t), __alignof(wchar_t)));
+	std::memcpy(data, str, len * sizeof(wchar_t));
+	data[len] = 0;
+
+	return data;
+}
+
+BYTE *ff::FrameArena::AllocSlow(size_t bytes, size_t align)
+{
+	size_t needed = bytes + align - 1;
+	size_t next = _cur ? _curBlock + 1 : 0;
+
+	// Use a block left over from a previous frame, if it's big enough
+	while (next < _blocks.Size() && _blocks[next]._size < needed)
+	{
+		next++;
+	}
+
+	if (next == _blocks.Size())
+	{
+		ScopeStaticMemAlloc staticAlloc;
+
+		Block block;
+		block._size = std::max(_blockSize, needed);
+		block._data = reinterpret_cast<BYTE *>(_aligned_malloc(block._size, FRAME_ARENA_ALIGN));
+		assertRetVal(block._data, nullptr);
+
+#ifdef _DEBUG
+		std::memset(block._data, FRAME_ARENA_POISON, block._size);
+#endif
+		_blocks.Push(block);
+	}
+
+	if (_cur)
+	{
+		_fullBlockBytes += _cur - _blocks[_curBlock]._data;
+	}
+
+	_curBlock = next;
+	_cur = _blocks[next]._data;
+	_end = _cur + _blocks[next]._size;
+
+	BYTE *data = reinterpret_cast<BYTE *>((reinterpret_cast<size_t>(_cur) + align - 1) & ~(align - 1));
+	_cur = data + bytes;
+
+	return data;
+}
+
+void ff::FrameArena::Reset()
+{
+#ifdef _DEBUG
+	assert(!_threadId || _threadId == ::GetCurrentThreadId());
+	_threadId = ::GetCurrentThreadId();
+#endif
+
+	size_t frameBytes = GetFrameBytes();
+	_lastFrameBytes = frameBytes;
+	_frameCount++;
+
+	if (frameBytes > _maxFrameBytes)
+	{
+		_maxFrameBytes = frameBytes;
+#ifdef _DEBUG
+		Log::DebugTraceF(L"FrameArena: New high water mark of %lu bytes in frame %lu\n", frameBytes, _frameCount);
+#endif
+	}
+
+	if (_curBlock > 0)
+	{
+		// The frame needed more than one block, replace them all with one big enough for the high water mark
+		size_t size = (_maxFrameBytes + _blockSize - 1) / _blockSize * _blockSize;
+		FreeBlocks();
+
+		ScopeStaticMemAlloc staticAlloc;
+
+		Block block;
+		block._size = size;
+		block._data = reinterpret_cast<BYTE *>(_aligned_malloc(size, FRAME_ARENA_ALIGN));
+
+		if (block._data)
+		{
+#ifdef _DEBUG
+			std::memset(block._data, FRAME_ARENA_POISON, block._size);
+#endif
+			_blocks.Push(block);
+		}
+	}
+#ifdef _DEBUG
+	else if (_cur)
+	{
+		// Anything still pointing into the old frame will see garbage
+		std::memset(_blocks[0]._data, FRAME_ARENA_POISON, _cur - _blocks[0]._data);
+	}
+#endif
+
+	_curBlock = 0;
+	_fullBlockBytes = 0;
+	_cur = _blocks.Size() ? _blocks[0]._data : nullptr;
+	_end = _blocks.Size() ? _cur + _blocks[0]._size : nullptr;
+}
+
+size_t ff::FrameArena::GetFrameBytes() const
+{
+	return _cur ? _fullBlockBytes + (_cur - _blocks[_curBlock]._data) : 0;
+}
+
+size_t ff::FrameArena::GetLastFrameBytes() const
+{
+	return _lastFrameBytes;
+}
+
+size_t ff::FrameArena::GetMaxFrameBytes() const
+{
+	return _maxFrameBytes;
+}
+
+size_t ff::FrameArena::GetFrameCount() const
+{
+	return _frameCount;
+}
+
+size_t ff::FrameArena::GetReservedBytes() const
+{
+	size_t bytes = 0;
+
+	for (const Block &block: _blocks)
+	{
+		bytes += block._size;
+	}
+
+	return bytes;
+}
+
+void ff::FrameArena::FreeBlocks()
+{
+	for (const Block &block: _blocks)
+	{
+		_aligned_free(block._data);
+	}
+
+	_blocks.Clear();
+	_curBlock = 0;
+	_cur = nullptr;
+	_end = nullptr;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+namespace ff
+{
+	/// Monotonic allocator for memory that only needs to live until the end of a frame.
+	///
+	/// Allocating is a pointer bump, freeing does nothing. All memory is reclaimed at once
+	/// by Reset(), which AppGlobals calls at the start of each FrameAdvance. Not thread-safe,
+	/// only use the frame arena on the thread that runs the game loop.
+	class FrameArena
+	{
+	public:
+		UTIL_API FrameArena(size_t blockSize = 64 * 1024);
+		UTIL_API ~FrameArena();
+
+		UTIL_API void *Alloc(size_t bytes, size_t align = sizeof(void *));
+		UTIL_API const wchar_t *CopyString(const wchar_t *str, size_t len);
+		UTIL_API void Reset();
+
+		// Stats
+		UTIL_API size_t GetFrameBytes() const; // used so far this frame
+		UTIL_API size_t GetLastFrameBytes() const; // used by the previous frame
+		UTIL_API size_t GetMaxFrameBytes() const; // high water mark across all frames
+		UTIL_API size_t GetFrameCount() const;
+		UTIL_API size_t GetReservedBytes() const;
+
+	private:
+		FrameArena(const FrameArena &rhs) = delete;
+		FrameArena &operator=(const FrameArena &rhs) = delete;
+
+		struct Block
+		{
+			BYTE *_data;
+			size_t _size;
+		};
+
+		BYTE *AllocSlow(size_t bytes, size_t align);
+		void FreeBlocks();
+
+		Vector<Block, 4> _blocks;
+		size_t _curBlock;
+		BYTE *_cur;
+		BYTE *_end;
+		size_t _blockSize;
+		size_t _fullBlockBytes; // bytes used in blocks before _curBlock
+		size_t _lastFrameBytes;
+		size_t _maxFrameBytes;
+		size_t _frameCount;
+#ifdef _DEBUG
+		unsigned int _threadId;
+#endif
+	};
+
+	/// The arena that gets reset every frame
+	UTIL_API FrameArena &GetFrameArena();
+
+	/// Allocator policy for Vector that gets its memory from the frame arena.
+	/// Anything using it must be gone before the next frame starts.
+	template<typename T>
+	struct FrameAllocator
+	{
+		T *Malloc(size_t count)
+		{
+			return reinterpret_cast<T *>(GetFrameArena().Alloc(count * sizeof(T), __alignof(T)));
+		}
+
+		void Free(T *data)
+		{
+		}
+	};
+
+	template<typename T, size_t StackSize = 0>
+	using FrameVector = Vector<T, StackSize, FrameAllocator<T>>;
+
+	/// For building temporary strings, call Push(L'\0') before using Data() as a C string
+	template<size_t StackSize = 0>
+	using FrameStringBuffer = Vector<wchar_t, StackSize, FrameAllocator<wchar_t>>;
+}
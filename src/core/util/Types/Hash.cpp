@@ -1,5 +1,140 @@
 #include "pch.h"
 
+// Based on wyhash (final version 4) by Wang Yi, released into the public domain.
+// See https://github.com/wangyi-fudan/wyhash
+
+static const uint64_t s_hashSecret[4] =
+{
+	0xa0761d6478bd642full,
+	0xe7037ed1a0b428dbull,
+	0x8ebc6af09c88c6e3ull,
+	0x589965cc75374cc3ull,
+};
+
+inline static void HashMultiply(uint64_t &a, uint64_t &b)
+{
+#if defined(_M_X64)
+	a = _umul128(a, b, &b);
+#else
+	uint64_t ha = a >> 32, hb = b >> 32, la = (uint32_t)a, lb = (uint32_t)b;
+	uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+	uint64_t t = rl + (rm0 << 32);
+	uint64_t carry = (t < rl) ? 1 : 0;
+	uint64_t lo = t + (rm1 << 32);
+	carry += (lo < t) ? 1 : 0;
+
+	a = lo;
+	b = rh + (rm0 >> 32) + (rm1 >> 32) + carry;
+#endif
+}
+
+inline static uint64_t HashMultiplyMix(uint64_t a, uint64_t b)
+{
+	HashMultiply(a, b);
+	return a ^ b;
+}
+
+// memcpy makes the reads safe at any alignment, it compiles down to a single load
+inline static uint64_t HashRead8(const BYTE *data)
+{
+	uint64_t value;
+	std::memcpy(&value, data, sizeof(value));
+	return value;
+}
+
+inline static uint64_t HashRead4(const BYTE *data)
+{
+	uint32_t value;
+	std::memcpy(&value, data, sizeof(value));
+	return value;
+}
+
+inline static ff::hash_t HashFinish(uint64_t a, uint64_t b, uint64_t seed, size_t length)
+{
+	a ^= s_hashSecret[1];
+	b ^= seed;
+	HashMultiply(a, b);
+
+	return HashMultiplyMix(a ^ s_hashSecret[0] ^ length, b ^ s_hashSecret[1]);
+}
+
+// Hashes with an already mixed seed
+static ff::hash_t InternalHashBytes(const void *data, size_t length, uint64_t seed)
+{
+	const BYTE *bytes = (const BYTE *)data;
+	uint64_t a;
+	uint64_t b;
+
+	if (length <= 16)
+	{
+		// Short path, covers wide strings up to 8 characters without any loop
+		if (length >= 4)
+		{
+			size_t offset = (length >> 3) << 2;
+			a = (HashRead4(bytes) << 32) | HashRead4(bytes + offset);
+			b = (HashRead4(bytes + length - 4) << 32) | HashRead4(bytes + length - 4 - offset);
+		}
+		else if (length > 0)
+		{
+			a = ((uint64_t)bytes[0] << 16) | ((uint64_t)bytes[length >> 1] << 8) | bytes[length - 1];
+			b = 0;
+		}
+		else
+		{
+			a = 0;
+			b = 0;
+		}
+	}
+	else
+	{
+		size_t remaining = length;
+
+		if (remaining > 48)
+		{
+			// Three independent lanes keep the multipliers busy
+			uint64_t seed1 = seed;
+			uint64_t seed2 = seed;
+
+			do
+			{
+				seed = HashMultiplyMix(HashRead8(bytes) ^ s_hashSecret[1], HashRead8(bytes + 8) ^ seed);
+				seed1 = HashMultiplyMix(HashRead8(bytes + 16) ^ s_hashSecret[2], HashRead8(bytes + 24) ^ seed1);
+				seed2 = HashMultiplyMix(HashRead8(bytes + 32) ^ s_hashSecret[3], HashRead8(bytes + 40) ^ seed2);
+				bytes += 48;
+				remaining -= 48;
+			}
+			while (remaining > 48);
+
+			seed ^= seed1 ^ seed2;
+		}
+
+		while (remaining > 16)
+		{
+			seed = HashMultiplyMix(HashRead8(bytes) ^ s_hashSecret[1], HashRead8(bytes + 8) ^ seed);
+			bytes += 16;
+			remaining -= 16;
+		}
+
+		a = HashRead8(bytes + remaining - 16);
+		b = HashRead8(bytes + remaining - 8);
+	}
+
+	return HashFinish(a, b, seed, length);
+}
+
+ff::hash_t ff::HashBytes(const void *data, size_t length)
+{
+	// Same as a zero seed, after it gets mixed: HashMultiplyMix(s_hashSecret[0], s_hashSecret[1])
+	return InternalHashBytes(data, length, 0x1ff5c2923a788d2cull);
+}
+
+ff::hash_t ff::HashBytes(const void *data, size_t length, hash_t seed)
+{
+	return InternalHashBytes(data, length, seed ^ HashMultiplyMix(seed ^ s_hashSecret[0], s_hashSecret[1]));
+}
+
+// The original hash function, before HashBytes was replaced
+
 static const ff::hash_t MAGIC_HASH_INIT = 0x9e3779b9;
 
 inline static ff::hash_t CreateHashResult(DWORD b, DWORD c)
@@ -39,7 +174,7 @@ inline static void FinalHashMix(DWORD &a, DWORD &b, DWORD &c)
 // See http://burtleburtle.net/bob/hash/evahash.html
 // See http://burtleburtle.net/bob/c/lookup3.c
 
-ff::hash_t ff::HashBytes(const void *data, size_t length)
+ff::hash_t ff::HashBytesLegacy(const void *data, size_t length)
 {
 	DWORD a = MAGIC_HASH_INIT + (DWORD)length; // + (DWORD)nInitVal;
 	DWORD b = a;
@@ -7,6 +7,12 @@ namespace ff
 	/// Able to hash any bytes in memory, but it's better to use the hashing templates
 	UTIL_API hash_t HashBytes(const void *data, size_t length);
 
+	/// Same as HashBytes, but a random seed makes it hard to find colliding keys ahead of time
+	UTIL_API hash_t HashBytes(const void *data, size_t length, hash_t seed);
+
+	/// The hash that HashBytes used before version 2 of saved dicts, only for loading old data
+	UTIL_API hash_t HashBytesLegacy(const void *data, size_t length);
+
 	/// Generic function for hashing any type, it should be plain-old-data to work well
 	template<typename T>
 	hash_t HashFunc(const T &value)
@@ -38,6 +44,13 @@ namespace ff
 		}
 	};
 
+	/// Compares a stored key with a borrowed key view that hashes the same way, see Set::GetWithHash
+	template<typename Key, typename KeyView>
+	bool KeyEquals(const Key &key, const KeyView &keyView)
+	{
+		return key == keyView;
+	}
+
 	/// For when an object is its own hash
 	template<typename T>
 	struct NonHasher
@@ -0,0 +1,650 @@
+#pragma once
+
+namespace ff
+{
+	/// Hash set with the same API as Set, that keeps its keys in one dense array.
+	///
+	/// Iterating is a linear scan through the array, in insertion order until something
+	/// is deleted. Deleting moves the last key into the hole, so iterators stay valid
+	/// when keys are added but not when they're deleted (except the one DeletePos returns).
+	/// Lookups go through a separate table of 32-bit indexes into the key array.
+	template<typename Key, typename Hash = Hasher<Key>>
+	class IndexSet
+	{
+	public:
+		IndexSet();
+		IndexSet(const IndexSet<Key, Hash> &rhs);
+		IndexSet(IndexSet<Key, Hash> &&rhs);
+		~IndexSet();
+
+		IndexSet<Key, Hash> &operator=(const IndexSet<Key, Hash> &rhs);
+
+		size_t     Size() const;
+		BucketIter SetKey(const Key &key); // doesn't allow duplicates
+		BucketIter SetKey(Key &&key); // doesn't allow duplicates
+		BucketIter Insert(const Key &key); // allows duplicates
+		BucketIter Insert(Key &&key); // allows duplicates
+		bool       DeleteKey(const Key &key); // deletes all matching keys
+		BucketIter DeletePos(BucketIter pos); // returns item after the deleted item
+		void       Clear();
+		bool       IsEmpty() const;
+
+		bool       Exists(const Key &key) const;
+		BucketIter Get(const Key &key) const;
+		BucketIter GetAt(size_t nIndex)  const;
+		BucketIter GetNext(BucketIter pos) const;
+
+		// for when the hash is already known, KeyView can be any type that KeyEquals() can compare to Key
+		BucketIter SetKeyWithHash(hash_t hash, const Key &key); // doesn't allow duplicates
+		BucketIter SetKeyWithHash(hash_t hash, Key &&key); // doesn't allow duplicates
+		template<typename KeyView> BucketIter GetWithHash(hash_t hash, const KeyView &key) const;
+
+		const Key &KeyAt(BucketIter pos) const;
+		hash_t     HashAt(BucketIter pos) const;
+
+		// for iteration through the hash table
+		BucketIter StartIteration()        const;
+		BucketIter Iterate(BucketIter pos) const;
+
+		// advanced
+		void SetBucketCount(size_t nCount, bool bAllowGrow);
+		size_t MemUsage() const;
+		void DebugDump() const;
+
+	private:
+		struct SEntry
+		{
+			SEntry() : _hash(0) { }
+			SEntry(hash_t hash, const Key &key) : _hash(hash), _key(key) { }
+			SEntry(hash_t hash, Key &&key) : _hash(hash), _key(std::move(key)) { }
+
+			hash_t _hash;
+			Key _key;
+		};
+
+		/// One slot in the index table, EMPTY_ENTRY when unused
+		struct SSlot
+		{
+			DWORD _entry;
+			DWORD _hash; // low bits of the entry's hash, to skip most entries that don't match
+		};
+
+		static const DWORD EMPTY_ENTRY = 0xFFFFFFFF;
+		static const size_t MIN_CAPACITY = 8;
+
+		static bool KeysEqual(const Key &lhs, const Key &rhs) { return !(lhs < rhs) && !(rhs < lhs); }
+		template<typename KeyView>
+		static bool KeysEqual(const Key &lhs, const KeyView &rhs) { return KeyEquals(lhs, rhs); }
+
+		// BucketIter is the entry index plus one, so that zero is INVALID_ITER
+		static size_t GetEntryIndex(BucketIter pos) { return reinterpret_cast<size_t>(pos) - 1; }
+		static BucketIter GetBucketIter(size_t index) { return reinterpret_cast<BucketIter>(index + 1); }
+		size_t HomeIndex(DWORD hash) const { return static_cast<size_t>((hash * 0x9E3779B97F4A7C15ull) >> _shift); }
+
+		template<typename KeyView>
+		size_t FindSlot(hash_t hash, const KeyView &key) const;
+		size_t FindSlotOfEntry(size_t entry) const;
+		size_t FindNextSlot(size_t slot) const;
+		void EraseEntry(size_t entry, size_t slot);
+		void Reserve(size_t count);
+		void Rehash(size_t capacity);
+		void FreeTable();
+
+		template<typename K>
+		BucketIter InsertKey(hash_t hash, K &&key, bool bAllowDupes);
+
+		Vector<SEntry> _entries;
+		SSlot *_slots;
+		size_t _capacity;
+		size_t _shift;
+		bool _keepCapacity;
+
+	// Imperfect C++ iterators
+	public:
+		template<typename IT>
+		class Iterator : public std::iterator<std::input_iterator_tag, IT>
+		{
+			typedef Iterator<IT> MyType;
+			typedef IndexSet<Key, Hash> SetType;
+
+		public:
+			Iterator(const SetType *owner, BucketIter iter)
+			{
+				_owner = owner;
+				_iter = iter;
+			}
+
+			Iterator(const MyType &rhs)
+			{
+				_owner = rhs._owner;
+				_iter = rhs._iter;
+			}
+
+			const IT &operator*() const
+			{
+				return _owner->KeyAt(_iter);
+			}
+
+			const IT *operator->() const
+			{
+				return &_owner->KeyAt(_iter);
+			}
+
+			MyType &operator++()
+			{
+				_iter = _owner->Iterate(_iter);
+				return *this;
+			}
+
+			MyType operator++(int)
+			{
+				MyType pre = *this;
+				_iter = _owner->Iterate(_iter);
+				return pre;
+			}
+
+			bool operator==(const MyType &rhs) const
+			{
+				return _owner == rhs._owner && _iter == rhs._iter;
+			}
+
+			bool operator!=(const MyType &rhs) const
+			{
+				return _owner != rhs._owner || _iter != rhs._iter;
+			}
+
+		private:
+			const SetType *_owner;
+			BucketIter _iter;
+		};
+
+		typedef Iterator<Key> const_iterator;
+
+		const_iterator begin() const  { return const_iterator(this, StartIteration()); }
+		const_iterator end() const    { return const_iterator(this, nullptr); }
+		const_iterator cbegin() const { return const_iterator(this, StartIteration()); }
+		const_iterator cend() const   { return const_iterator(this, nullptr); }
+	};
+}
+
+template<typename Key, typename Hash>
+ff::IndexSet<Key, Hash>::IndexSet()
+	: _slots(nullptr)
+	, _capacity(0)
+	, _shift(0)
+	, _keepCapacity(false)
+{
+}
+
+template<typename Key, typename Hash>
+ff::IndexSet<Key, Hash>::IndexSet(const IndexSet<Key, Hash> &rhs)
+	: _slots(nullptr)
+	, _capacity(0)
+	, _shift(0)
+	, _keepCapacity(false)
+{
+	*this = rhs;
+}
+
+template<typename Key, typename Hash>
+ff::IndexSet<Key, Hash>::IndexSet(IndexSet<Key, Hash> &&rhs)
+	: _entries(std::move(rhs._entries))
+	, _slots(rhs._slots)
+	, _capacity(rhs._capacity)
+	, _shift(rhs._shift)
+	, _keepCapacity(rhs._keepCapacity)
+{
+	rhs._slots = nullptr;
+	rhs._capacity = 0;
+	rhs._shift = 0;
+	rhs._keepCapacity = false;
+}
+
+template<typename Key, typename Hash>
+ff::IndexSet<Key, Hash>::~IndexSet()
+{
+	_keepCapacity = false;
+	Clear();
+}
+
+template<typename Key, typename Hash>
+ff::IndexSet<Key, Hash> &ff::IndexSet<Key, Hash>::operator=(const IndexSet<Key, Hash> &rhs)
+{
+	if (this != &rhs)
+	{
+		Clear();
+		Reserve(rhs.Size());
+
+		for (const SEntry &entry: rhs._entries)
+		{
+			InsertKey(entry._hash, entry._key, true);
+		}
+	}
+
+	return *this;
+}
+
+template<typename Key, typename Hash>
+size_t ff::IndexSet<Key, Hash>::Size() const
+{
+	return _entries.Size();
+}
+
+template<typename Key, typename Hash>
+ff::BucketIter ff::IndexSet<Key, Hash>::SetKey(const Key &key)
+{
+	return InsertKey(Hash()(key), key, false);
+}
+
+template<typename Key, typename Hash>
+ff::BucketIter ff::IndexSet<Key, Hash>::SetKey(Key &&key)
+{
+	hash_t hash = Hash()(key);
+	return InsertKey(hash, std::move(key), false);
+}
+
+template<typename Key, typename Hash>
+ff::BucketIter ff::IndexSet<Key, Hash>::Insert(const Key &key)
+{
+	return InsertKey(Hash()(key), key, true);
+}
+
+template<typename Key, typename Hash>
+ff::BucketIter ff::IndexSet<Key, Hash>::Insert(Key &&key)
+{
+	hash_t hash = Hash()(key);
+	return InsertKey(hash, std::move(key), true);
+}
+
+template<typename Key, typename Hash>
+bool ff::IndexSet<Key, Hash>::DeleteKey(const Key &key)
+{
+	if (_entries.Size())
+	{
+		hash_t hash = Hash()(key);
+		size_t slot = FindSlot(hash, key);
+
+		if (slot != INVALID_SIZE)
+		{
+			// Deleting shifts later slots back, so start over each time to find duplicates
+			do
+			{
+				EraseEntry(_slots[slot]._entry, slot);
+				slot = FindSlot(hash, key);
+			}
+			while (slot != INVALID_SIZE);
+
+			return true;
+		}
+	}
+
+	return false;
+}
+
+template<typename Key, typename Hash>
+ff::BucketIter ff::IndexSet<Key, Hash>::DeletePos(BucketIter pos)
+{
+	if (pos != INVALID_ITER)
+	{
+		size_t entry = GetEntryIndex(pos);
+		EraseEntry(entry, FindSlotOfEntry(entry));
+
+		// The last entry moved into the deleted one, and it hasn't been iterated yet
+		return (entry < _entries.Size()) ? pos : INVALID_ITER;
+	}
+
+	return INVALID_ITER;
+}
+
+template<typename Key, typename Hash>
+void ff::IndexSet<Key, Hash>::Clear()
+{
+	if (_keepCapacity && _capacity)
+	{
+		_entries.Clear();
+		std::memset(_slots, 0xFF, _capacity * sizeof(SSlot));
+	}
+	else
+	{
+		_entries.ClearAndReduce();
+		FreeTable();
+	}
+}
+
+template<typename Key, typename Hash>
+bool ff::IndexSet<Key, Hash>::IsEmpty() const
+{
+	return _entries.IsEmpty();
+}
+
+template<typename Key, typename Hash>
+bool ff::IndexSet<Key, Hash>::Exists(const Key &key) const
+{
+	return Get(key) != INVALID_ITER;
+}
+
+template<typename Key, typename Hash>
+ff::BucketIter ff::IndexSet<Key, Hash>::Get(const Key &key) const
+{
+	return GetWithHash(Hash()(key), key);
+}
+
+template<typename Key, typename Hash>
+ff::BucketIter ff::IndexSet<Key, Hash>::GetAt(size_t nIndex) const
+{
+	assertRetVal(nIndex < _entries.Size(), INVALID_ITER);
+	return GetBucketIter(nIndex);
+}
+
+template<typename Key, typename Hash>
+ff::BucketIter ff::IndexSet<Key, Hash>::GetNext(BucketIter pos) const
+{
+	if (pos != INVALID_ITER)
+	{
+		size_t slot = FindNextSlot(FindSlotOfEntry(GetEntryIndex(pos)));
+		if (slot != INVALID_SIZE)
+		{
+			return GetBucketIter(_slots[slot]._entry);
+		}
+	}
+
+	return INVALID_ITER;
+}
+
+template<typename Key, typename Hash>
+ff::BucketIter ff::IndexSet<Key, Hash>::SetKeyWithHash(hash_t hash, const Key &key)
+{
+	assert(hash == Hash()(key));
+	return InsertKey(hash, key, false);
+}
+
+template<typename Key, typename Hash>
+ff::BucketIter ff::IndexSet<Key, Hash>::SetKeyWithHash(hash_t hash, Key &&key)
+{
+	assert(hash == Hash()(key));
+	return InsertKey(hash, std::move(key), false);
+}
+
+template<typename Key, typename Hash>
+template<typename KeyView>
+ff::BucketIter ff::IndexSet<Key, Hash>::GetWithHash(hash_t hash, const KeyView &key) const
+{
+	if (_entries.Size())
+	{
+		size_t slot = FindSlot(hash, key);
+		if (slot != INVALID_SIZE)
+		{
+			return GetBucketIter(_slots[slot]._entry);
+		}
+	}
+
+	return INVALID_ITER;
+}
+
+template<typename Key, typename Hash>
+const Key &ff::IndexSet<Key, Hash>::KeyAt(BucketIter pos) const
+{
+	assert(pos != INVALID_ITER);
+	return _entries[GetEntryIndex(pos)]._key;
+}
+
+template<typename Key, typename Hash>
+ff::hash_t ff::IndexSet<Key, Hash>::HashAt(BucketIter pos) const
+{
+	assert(pos != INVALID_ITER);
+	return _entries[GetEntryIndex(pos)]._hash;
+}
+
+template<typename Key, typename Hash>
+ff::BucketIter ff::IndexSet<Key, Hash>::StartIteration() const
+{
+	return _entries.Size() ? GetBucketIter(0) : INVALID_ITER;
+}
+
+template<typename Key, typename Hash>
+ff::BucketIter ff::IndexSet<Key, Hash>::Iterate(BucketIter pos) const
+{
+	assert(pos != INVALID_ITER);
+
+	size_t next = GetEntryIndex(pos) + 1;
+	return (next < _entries.Size()) ? GetBucketIter(next) : INVALID_ITER;
+}
+
+template<typename Key, typename Hash>
+void ff::IndexSet<Key, Hash>::SetBucketCount(size_t nCount, bool bAllowGrow)
+{
+	_entries.Reserve(nCount);
+	Reserve(nCount);
+
+	// The index table must always grow when full, but a fixed capacity is kept across Clear()
+	_keepCapacity = !bAllowGrow;
+}
+
+template<typename Key, typename Hash>
+size_t ff::IndexSet<Key, Hash>::MemUsage() const
+{
+	return _entries.BytesAllocated() + _capacity * sizeof(SSlot);
+}
+
+template<typename Key, typename Hash>
+void ff::IndexSet<Key, Hash>::DebugDump() const
+{
+	Log::DebugTraceF(L"Size %lu, with %lu index slots.\n", Size(), _capacity);
+	Log::DebugTraceF(L"---------------------------\n");
+
+	size_t totalProbe = 0;
+	size_t maxProbe = 0;
+
+	for (size_t i = 0; i < _capacity; i++)
+	{
+		if (_slots[i]._entry != EMPTY_ENTRY)
+		{
+			size_t probe = (i - HomeIndex(_slots[i]._hash)) & (_capacity - 1);
+			totalProbe += probe;
+			maxProbe = std::max(maxProbe, probe);
+		}
+	}
+
+	Log::DebugTraceF(L"Average probe:%lu, Max probe:%lu\n", Size() ? totalProbe / Size() : 0, maxProbe);
+}
+
+template<typename Key, typename Hash>
+template<typename KeyView>
+size_t ff::IndexSet<Key, Hash>::FindSlot(hash_t hash, const KeyView &key) const
+{
+	DWORD hash32 = static_cast<DWORD>(hash);
+	size_t mask = _capacity - 1;
+
+	for (size_t i = HomeIndex(hash32); _slots[i]._entry != EMPTY_ENTRY; i = (i + 1) & mask)
+	{
+		if (_slots[i]._hash == hash32)
+		{
+			const SEntry &entry = _entries[_slots[i]._entry];
+			if (entry._hash == hash && KeysEqual(entry._key, key))
+			{
+				return i;
+			}
+		}
+	}
+
+	return INVALID_SIZE;
+}
+
+template<typename Key, typename Hash>
+size_t ff::IndexSet<Key, Hash>::FindSlotOfEntry(size_t entry) const
+{
+	size_t mask = _capacity - 1;
+
+	for (size_t i = HomeIndex(static_cast<DWORD>(_entries[entry]._hash)); ; i = (i + 1) & mask)
+	{
+		assert(_slots[i]._entry != EMPTY_ENTRY);
+
+		if (_slots[i]._entry == entry)
+		{
+			return i;
+		}
+	}
+}
+
+template<typename Key, typename Hash>
+size_t ff::IndexSet<Key, Hash>::FindNextSlot(size_t slot) const
+{
+	// Duplicates are always further along the same probe run, which ends at an empty slot
+	const SEntry &entry = _entries[_slots[slot]._entry];
+	size_t mask = _capacity - 1;
+
+	for (size_t i = (slot + 1) & mask; _slots[i]._entry != EMPTY_ENTRY; i = (i + 1) & mask)
+	{
+		if (_slots[i]._hash == _slots[slot]._hash)
+		{
+			const SEntry &other = _entries[_slots[i]._entry];
+			if (other._hash == entry._hash && KeysEqual(other._key, entry._key))
+			{
+				return i;
+			}
+		}
+	}
+
+	return INVALID_SIZE;
+}
+
+template<typename Key, typename Hash>
+void ff::IndexSet<Key, Hash>::EraseEntry(size_t entry, size_t slot)
+{
+	assert(_slots[slot]._entry == entry);
+	size_t mask = _capacity - 1;
+
+	// Shift the rest of the probe run back, so no deleted markers are needed
+	for (size_t next = (slot + 1) & mask; _slots[next]._entry != EMPTY_ENTRY; next = (next + 1) & mask)
+	{
+		size_t home = HomeIndex(_slots[next]._hash);
+		if (((next - home) & mask) >= ((next - slot) & mask))
+		{
+			_slots[slot] = _slots[next];
+			slot = next;
+		}
+	}
+
+	_slots[slot]._entry = EMPTY_ENTRY;
+
+	// Move the last entry into the hole
+	size_t last = _entries.Size() - 1;
+	if (entry != last)
+	{
+		_slots[FindSlotOfEntry(last)]._entry = static_cast<DWORD>(entry);
+		_entries[entry] = std::move(_entries[last]);
+	}
+
+	_entries.Delete(last);
+}
+
+template<typename Key, typename Hash>
+void ff::IndexSet<Key, Hash>::Reserve(size_t count)
+{
+	// Keep the index table at most 3/4 full so probe runs stay short
+	size_t capacity = _capacity ? _capacity : MIN_CAPACITY;
+	while (count >= capacity - capacity / 4)
+	{
+		capacity *= 2;
+	}
+
+	if (capacity != _capacity)
+	{
+		Rehash(capacity);
+	}
+}
+
+template<typename Key, typename Hash>
+void ff::IndexSet<Key, Hash>::Rehash(size_t capacity)
+{
+	assert(capacity >= MIN_CAPACITY && NearestPowerOfTwo(capacity) == capacity);
+	assertRet(capacity <= EMPTY_ENTRY);
+
+	if (_capacity)
+	{
+		_aligned_free(_slots);
+	}
+
+	_slots = reinterpret_cast<SSlot *>(_aligned_malloc(capacity * sizeof(SSlot), sizeof(SSlot)));
+	_capacity = capacity;
+	_shift = 64;
+
+	for (size_t i = capacity; i > 1; i /= 2)
+	{
+		_shift--;
+	}
+
+	std::memset(_slots, 0xFF, capacity * sizeof(SSlot));
+
+	size_t mask = capacity - 1;
+	for (size_t entry = 0; entry < _entries.Size(); entry++)
+	{
+		DWORD hash32 = static_cast<DWORD>(_entries[entry]._hash);
+		size_t i = HomeIndex(hash32);
+
+		while (_slots[i]._entry != EMPTY_ENTRY)
+		{
+			i = (i + 1) & mask;
+		}
+
+		_slots[i]._entry = static_cast<DWORD>(entry);
+		_slots[i]._hash = hash32;
+	}
+}
+
+template<typename Key, typename Hash>
+void ff::IndexSet<Key, Hash>::FreeTable()
+{
+	assert(_entries.IsEmpty());
+
+	if (_capacity)
+	{
+		_aligned_free(_slots);
+
+		_slots = nullptr;
+		_capacity = 0;
+		_shift = 0;
+	}
+}
+
+template<typename Key, typename Hash>
+template<typename K>
+ff::BucketIter ff::IndexSet<Key, Hash>::InsertKey(hash_t hash, K &&key, bool bAllowDupes)
+{
+	if (!bAllowDupes && _entries.Size())
+	{
+		size_t slot = FindSlot(hash, key);
+		if (slot != INVALID_SIZE)
+		{
+			// Delete dupes of the existing entry
+			for (size_t next = FindNextSlot(slot); next != INVALID_SIZE; next = FindNextSlot(slot))
+			{
+				EraseEntry(_slots[next]._entry, next);
+			}
+
+			// Update the existing entry, deleting dupes only shifts slots after it
+			size_t entry = _slots[slot]._entry;
+			_entries[entry]._key = std::forward<K>(key);
+			return GetBucketIter(entry);
+		}
+	}
+
+	Reserve(_entries.Size() + 1);
+
+	DWORD hash32 = static_cast<DWORD>(hash);
+	size_t mask = _capacity - 1;
+	size_t i = HomeIndex(hash32);
+
+	while (_slots[i]._entry != EMPTY_ENTRY)
+	{
+		i = (i + 1) & mask;
+	}
+
+	size_t entry = _entries.Size();
+	_entries.Push(SEntry(hash, std::forward<K>(key)));
+
+	_slots[i]._entry = static_cast<DWORD>(entry);
+	_slots[i]._hash = hash32;
+
+	return GetBucketIter(entry);
+}
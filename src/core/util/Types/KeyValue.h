@@ -30,6 +30,13 @@ namespace ff
 		Value _val;
 	};
 
+	/// Only compares the key, for Map::GetWithHash
+	template<typename Key, typename Value, typename KeyView>
+	bool KeyEquals(const KeyValue<Key, Value> &keyValue, const KeyView &keyView)
+	{
+		return KeyEquals(keyValue.GetKey(), keyView);
+	}
+
 	template<typename Key, typename Value>
 	struct HashKeyValue
 	{
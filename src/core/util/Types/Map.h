@@ -2,7 +2,10 @@
 
 namespace ff
 {
-	template<typename Key, typename Value, typename Hash = Hasher<Key>>
+	/// SetImpl picks the hash table that stores the entries, Set keeps the address of every
+	/// entry stable while FlatHashSet is faster but moves entries when it grows. IndexSet
+	/// is best when iterating is more common than adding and deleting.
+	template<typename Key, typename Value, typename Hash = Hasher<Key>, template<typename, typename> class SetImpl = Set>
 	class Map
 	{
 		typedef KeyValue<Key, Value> KeyValueType;
@@ -15,15 +18,15 @@ namespace ff
 			}
 		};
 
-		typedef Set<KeyValueType, HashMapKey> SetType;
+		typedef SetImpl<KeyValueType, HashMapKey> SetType;
 
 	public:
 		Map();
-		Map(const Map<Key, Value, Hash> &rhs);
-		Map(Map<Key, Value, Hash> &&rhs);
+		Map(const Map<Key, Value, Hash, SetImpl> &rhs);
+		Map(Map<Key, Value, Hash, SetImpl> &&rhs);
 		~Map();
 
-		Map<Key, Value, Hash> &operator=(const Map<Key, Value, Hash> &rhs);
+		Map<Key, Value, Hash, SetImpl> &operator=(const Map<Key, Value, Hash, SetImpl> &rhs);
 
 		size_t       Size() const;
 		BucketIter   SetKey(const Key &key, const Value &val); // doesn't allow duplicates
@@ -40,6 +43,11 @@ namespace ff
 		BucketIter   GetAt(size_t nIndex) const;
 		BucketIter   GetNext(BucketIter pos) const;
 
+		// for when the hash is already known, KeyView can be any type that KeyEquals() can compare to Key
+		BucketIter   SetKeyWithHash(hash_t hash, const Key &key, const Value &val); // doesn't allow duplicates
+		BucketIter   SetKeyWithHash(hash_t hash, Key &&key, Value &&val); // doesn't allow duplicates
+		template<typename KeyView> BucketIter GetWithHash(hash_t hash, const KeyView &key) const;
+
 		const Key   &KeyAt(BucketIter pos) const;
 		const Value &ValueAt(BucketIter pos) const;
 		Value       &ValueAt(BucketIter pos);
@@ -62,170 +70,197 @@ namespace ff
 	private:
 		SetType _set;
 	};
+
+	/// A Map stored in an open-addressing hash table, see FlatHashSet
+	template<typename Key, typename Value, typename Hash = Hasher<Key>>
+	using FlatHashMap = Map<Key, Value, Hash, FlatHashSet>;
+
+	/// A Map that stores its entries in one dense array for fast iteration, see IndexSet
+	template<typename Key, typename Value, typename Hash = Hasher<Key>>
+	using IndexMap = Map<Key, Value, Hash, IndexSet>;
 }
 
-template<typename Key, typename Value, typename Hash>
-ff::Map<Key, Value, Hash>::Map()
+template<typename Key, typename Value, typename Hash, template<typename, typename> class SetImpl>
+ff::Map<Key, Value, Hash, SetImpl>::Map()
 {
 }
 
-template<typename Key, typename Value, typename Hash>
-ff::Map<Key, Value, Hash>::Map(const Map<Key, Value, Hash> &rhs)
+template<typename Key, typename Value, typename Hash, template<typename, typename> class SetImpl>
+ff::Map<Key, Value, Hash, SetImpl>::Map(const Map<Key, Value, Hash, SetImpl> &rhs)
 	: _set(rhs._set)
 {
 }
 
-template<typename Key, typename Value, typename Hash>
-ff::Map<Key, Value, Hash>::Map(Map<Key, Value, Hash> &&rhs)
+template<typename Key, typename Value, typename Hash, template<typename, typename> class SetImpl>
+ff::Map<Key, Value, Hash, SetImpl>::Map(Map<Key, Value, Hash, SetImpl> &&rhs)
 	: _set(std::move(rhs._set))
 {
 }
 
-template<typename Key, typename Value, typename Hash>
-ff::Map<Key, Value, Hash>::~Map()
+template<typename Key, typename Value, typename Hash, template<typename, typename> class SetImpl>
+ff::Map<Key, Value, Hash, SetImpl>::~Map()
 {
 }
 
-template<typename Key, typename Value, typename Hash>
-ff::Map<Key, Value, Hash> &ff::Map<Key, Value, Hash>::operator=(const Map<Key, Value, Hash> &rhs)
+template<typename Key, typename Value, typename Hash, template<typename, typename> class SetImpl>
+ff::Map<Key, Value, Hash, SetImpl> &ff::Map<Key, Value, Hash, SetImpl>::operator=(const Map<Key, Value, Hash, SetImpl> &rhs)
 {
 	_set = rhs._set;
 	return *this;
 }
 
-template<typename Key, typename Value, typename Hash>
-ff::BucketIter ff::Map<Key, Value, Hash>::SetKey(const Key &key, const Value &val)
+template<typename Key, typename Value, typename Hash, template<typename, typename> class SetImpl>
+ff::BucketIter ff::Map<Key, Value, Hash, SetImpl>::SetKey(const Key &key, const Value &val)
 {
 	return _set.SetKey(KeyValueType(key, val));
 }
 
-template<typename Key, typename Value, typename Hash>
-ff::BucketIter ff::Map<Key, Value, Hash>::SetKey(Key &&key, Value &&val)
+template<typename Key, typename Value, typename Hash, template<typename, typename> class SetImpl>
+ff::BucketIter ff::Map<Key, Value, Hash, SetImpl>::SetKey(Key &&key, Value &&val)
 {
 	return _set.SetKey(KeyValueType(std::move(key), std::move(val)));
 }
 
-template<typename Key, typename Value, typename Hash>
-ff::BucketIter ff::Map<Key, Value, Hash>::Insert(const Key &key, const Value &val)
+template<typename Key, typename Value, typename Hash, template<typename, typename> class SetImpl>
+ff::BucketIter ff::Map<Key, Value, Hash, SetImpl>::Insert(const Key &key, const Value &val)
 {
 	return _set.Insert(KeyValueType(key, val));
 }
 
-template<typename Key, typename Value, typename Hash>
-ff::BucketIter ff::Map<Key, Value, Hash>::Insert(Key &&key, Value &&val)
+template<typename Key, typename Value, typename Hash, template<typename, typename> class SetImpl>
+ff::BucketIter ff::Map<Key, Value, Hash, SetImpl>::Insert(Key &&key, Value &&val)
 {
 	return _set.Insert(KeyValueType(std::move(key), std::move(val)));
 }
 
-template<typename Key, typename Value, typename Hash>
-bool ff::Map<Key, Value, Hash>::DeleteKey(const Key &key)
+template<typename Key, typename Value, typename Hash, template<typename, typename> class SetImpl>
+bool ff::Map<Key, Value, Hash, SetImpl>::DeleteKey(const Key &key)
 {
 	// Since the value won't be accessed, it's OK to do this dangerous cast
 	const KeyValueType &keyValue = *reinterpret_cast<const KeyValueType *>(&key);
 	return _set.DeleteKey(keyValue);
 }
 
-template<typename Key, typename Value, typename Hash>
-ff::BucketIter ff::Map<Key, Value, Hash>::DeletePos(BucketIter pos)
+template<typename Key, typename Value, typename Hash, template<typename, typename> class SetImpl>
+ff::BucketIter ff::Map<Key, Value, Hash, SetImpl>::DeletePos(BucketIter pos)
 {
 	return _set.DeletePos(pos);
 }
 
-template<typename Key, typename Value, typename Hash>
-void ff::Map<Key, Value, Hash>::Clear()
+template<typename Key, typename Value, typename Hash, template<typename, typename> class SetImpl>
+void ff::Map<Key, Value, Hash, SetImpl>::Clear()
 {
 	_set.Clear();
 }
 
-template<typename Key, typename Value, typename Hash>
-bool ff::Map<Key, Value, Hash>::IsEmpty() const
+template<typename Key, typename Value, typename Hash, template<typename, typename> class SetImpl>
+bool ff::Map<Key, Value, Hash, SetImpl>::IsEmpty() const
 {
 	return _set.IsEmpty();
 }
 
-template<typename Key, typename Value, typename Hash>
-ff::BucketIter ff::Map<Key, Value, Hash>::Get(const Key &key) const
+template<typename Key, typename Value, typename Hash, template<typename, typename> class SetImpl>
+ff::BucketIter ff::Map<Key, Value, Hash, SetImpl>::Get(const Key &key) const
 {
 	// Since the value won't be accessed, it's OK to do this dangerous cast
 	const KeyValueType &keyValue = *reinterpret_cast<const KeyValueType *>(&key);
 	return _set.Get(keyValue);
 }
 
-template<typename Key, typename Value, typename Hash>
-ff::BucketIter ff::Map<Key, Value, Hash>::GetNext(BucketIter pos) const
+template<typename Key, typename Value, typename Hash, template<typename, typename> class SetImpl>
+ff::BucketIter ff::Map<Key, Value, Hash, SetImpl>::GetNext(BucketIter pos) const
 {
 	return _set.GetNext(pos);
 }
 
-template<typename Key, typename Value, typename Hash>
-ff::BucketIter ff::Map<Key, Value, Hash>::GetAt(size_t nIndex) const
+template<typename Key, typename Value, typename Hash, template<typename, typename> class SetImpl>
+ff::BucketIter ff::Map<Key, Value, Hash, SetImpl>::SetKeyWithHash(hash_t hash, const Key &key, const Value &val)
+{
+	return _set.SetKeyWithHash(hash, KeyValueType(key, val));
+}
+
+template<typename Key, typename Value, typename Hash, template<typename, typename> class SetImpl>
+ff::BucketIter ff::Map<Key, Value, Hash, SetImpl>::SetKeyWithHash(hash_t hash, Key &&key, Value &&val)
+{
+	return _set.SetKeyWithHash(hash, KeyValueType(std::move(key), std::move(val)));
+}
+
+template<typename Key, typename Value, typename Hash, template<typename, typename> class SetImpl>
+template<typename KeyView>
+ff::BucketIter ff::Map<Key, Value, Hash, SetImpl>::GetWithHash(hash_t hash, const KeyView &key) const
+{
+	return _set.GetWithHash(hash, key);
+}
+
+template<typename Key, typename Value, typename Hash, template<typename, typename> class SetImpl>
+ff::BucketIter ff::Map<Key, Value, Hash, SetImpl>::GetAt(size_t nIndex) const
 {
 	return _set.GetAt(nIndex);
 }
 
-template<typename Key, typename Value, typename Hash>
-size_t ff::Map<Key, Value, Hash>::Size() const
+template<typename Key, typename Value, typename Hash, template<typename, typename> class SetImpl>
+size_t ff::Map<Key, Value, Hash, SetImpl>::Size() const
 {
 	return _set.Size();
 }
 
-template<typename Key, typename Value, typename Hash>
-const Key &ff::Map<Key, Value, Hash>::KeyAt(BucketIter pos) const
+template<typename Key, typename Value, typename Hash, template<typename, typename> class SetImpl>
+const Key &ff::Map<Key, Value, Hash, SetImpl>::KeyAt(BucketIter pos) const
 {
 	return _set.KeyAt(pos).GetKey();
 }
 
-template<typename Key, typename Value, typename Hash>
-const Value &ff::Map<Key, Value, Hash>::ValueAt(BucketIter pos) const
+template<typename Key, typename Value, typename Hash, template<typename, typename> class SetImpl>
+const Value &ff::Map<Key, Value, Hash, SetImpl>::ValueAt(BucketIter pos) const
 {
 	return _set.KeyAt(pos).GetValue();
 }
 
-template<typename Key, typename Value, typename Hash>
-Value &ff::Map<Key, Value, Hash>::ValueAt(BucketIter pos)
+template<typename Key, typename Value, typename Hash, template<typename, typename> class SetImpl>
+Value &ff::Map<Key, Value, Hash, SetImpl>::ValueAt(BucketIter pos)
 {
 	// Only the key must not be changed, the value doesn't matter
 	return const_cast<Value &>(_set.KeyAt(pos).GetValue());
 }
 
-template<typename Key, typename Value, typename Hash>
-ff::hash_t ff::Map<Key, Value, Hash>::HashAt(BucketIter pos) const
+template<typename Key, typename Value, typename Hash, template<typename, typename> class SetImpl>
+ff::hash_t ff::Map<Key, Value, Hash, SetImpl>::HashAt(BucketIter pos) const
 {
 	return _set.HashAt(pos);
 }
 
-template<typename Key, typename Value, typename Hash>
-bool ff::Map<Key, Value, Hash>::Exists(const Key &key) const
+template<typename Key, typename Value, typename Hash, template<typename, typename> class SetImpl>
+bool ff::Map<Key, Value, Hash, SetImpl>::Exists(const Key &key) const
 {
 	return Get(key) != INVALID_ITER;
 }
 
-template<typename Key, typename Value, typename Hash>
-ff::BucketIter ff::Map<Key, Value, Hash>::StartIteration() const
+template<typename Key, typename Value, typename Hash, template<typename, typename> class SetImpl>
+ff::BucketIter ff::Map<Key, Value, Hash, SetImpl>::StartIteration() const
 {
 	return _set.StartIteration();
 }
 
-template<typename Key, typename Value, typename Hash>
-ff::BucketIter ff::Map<Key, Value, Hash>::Iterate(BucketIter pos) const
+template<typename Key, typename Value, typename Hash, template<typename, typename> class SetImpl>
+ff::BucketIter ff::Map<Key, Value, Hash, SetImpl>::Iterate(BucketIter pos) const
 {
 	return _set.Iterate(pos);
 }
 
-template<typename Key, typename Value, typename Hash>
-void ff::Map<Key, Value, Hash>::SetBucketCount(size_t nCount, bool bAllowGrow)
+template<typename Key, typename Value, typename Hash, template<typename, typename> class SetImpl>
+void ff::Map<Key, Value, Hash, SetImpl>::SetBucketCount(size_t nCount, bool bAllowGrow)
 {
 	return _set.SetBucketCount(nCount, bAllowGrow);
 }
 
-template<typename Key, typename Value, typename Hash>
-size_t ff::Map<Key, Value, Hash>::MemUsage() const
+template<typename Key, typename Value, typename Hash, template<typename, typename> class SetImpl>
+size_t ff::Map<Key, Value, Hash, SetImpl>::MemUsage() const
 {
 	return _set.MemUsage();
 }
 
-template<typename Key, typename Value, typename Hash>
-void ff::Map<Key, Value, Hash>::DebugDump() const
+template<typename Key, typename Value, typename Hash, template<typename, typename> class SetImpl>
+void ff::Map<Key, Value, Hash, SetImpl>::DebugDump() const
 {
 	_set.DebugDump();
 }
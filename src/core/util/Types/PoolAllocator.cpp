@@ -0,0 +1,37 @@
+#include "pch.h"
+#include "Types/PoolAllocator.h"
+
+// STATIC_DATA (pod)
+static long s_nextMagazineId = 0;
+static __declspec(thread) ff::details::PoolMagazine **s_threadMagazines = nullptr;
+static __declspec(thread) size_t s_threadMagazineCount = 0;
+
+size_t ff::details::NewPoolMagazineId()
+{
+	// IDs are never reused, so a destroyed pool's magazine pointer is never seen again
+	return (size_t)::InterlockedIncrement(&s_nextMagazineId);
+}
+
+ff::details::PoolMagazine *ff::details::GetThreadPoolMagazine(size_t id)
+{
+	return (id < s_threadMagazineCount) ? s_threadMagazines[id] : nullptr;
+}
+
+void ff::details::SetThreadPoolMagazine(size_t id, PoolMagazine *magazine)
+{
+	if (id >= s_threadMagazineCount)
+	{
+		// The table lives as long as the thread
+		ScopeStaticMemAlloc staticAlloc;
+
+		size_t newCount = std::max<size_t>(id + 1, s_threadMagazineCount * 2);
+		PoolMagazine **newMagazines = (PoolMagazine **)::realloc(s_threadMagazines, newCount * sizeof(PoolMagazine *));
+		assertRet(newMagazines);
+
+		std::memset(newMagazines + s_threadMagazineCount, 0, (newCount - s_threadMagazineCount) * sizeof(PoolMagazine *));
+		s_threadMagazines = newMagazines;
+		s_threadMagazineCount = newCount;
+	}
+
+	s_threadMagazines[id] = magazine;
+}
@@ -55,6 +55,24 @@ namespace ff
 				Free(_pool);
 			}
 		};
+
+		/// A small per-thread stack of free objects for one thread-safe pool.
+		///
+		/// Only the owning thread touches _objs and _count without the pool's lock, other
+		/// threads only read the counts for stats. Objects move between the magazine and
+		/// the shared free list in batches of half the magazine.
+		struct PoolMagazine
+		{
+			static const size_t MAX_COUNT = 32;
+
+			void *_objs[MAX_COUNT];
+			size_t _count;
+			size_t _allocs;
+		};
+
+		UTIL_API size_t NewPoolMagazineId();
+		UTIL_API PoolMagazine *GetThreadPoolMagazine(size_t id);
+		UTIL_API void SetThreadPoolMagazine(size_t id, PoolMagazine *magazine);
 	}
 
 	/// A generic way to interact with a pool allocator.
@@ -68,7 +86,11 @@ namespace ff
 		virtual void DeleteVoid(void *obj) = 0;
 	};
 
-	/// Reuses memory when creating objects
+	/// Reuses memory when creating objects.
+	///
+	/// Thread-safe pools give each thread a magazine of free objects, so most calls to
+	/// New and Delete don't lock. Objects can be deleted on any thread. When a thread exits,
+	/// the few objects left in its magazine aren't reused until the pool is destroyed.
 	template<typename T>
 	class PoolAllocator : public IPoolAllocator
 	{
@@ -97,14 +119,24 @@ namespace ff
 		PoolAllocator &operator=(const PoolAllocator &rhs);
 
 		T *NewUnconstructed();
+		details::PoolObj<T> *PopFree();
+		void PushFree(details::PoolObj<T> *poolObj);
+		details::PoolMagazine *GetMagazine();
+		void RefillMagazine(details::PoolMagazine *magazine);
+		void DrainMagazine(details::PoolMagazine *magazine);
+		size_t InternalCurAlloc() const;
+
+		static details::PoolObj<T> *MagazineMark() { return reinterpret_cast<details::PoolObj<T> *>(1); }
 
 		Mutex _mutex;
 		Vector<details::SubPool<T>> _subPools;
 		details::PoolObj<T> *_firstFree;
-		size_t _curAlloc;
-		size_t _maxAlloc;
-		size_t _totalAlloc;
-		size_t _freeAlloc;
+		size_t _curAlloc; // includes objects in magazines
+		mutable size_t _maxAlloc;
+		size_t _totalAlloc; // doesn't include allocations from magazines
+		size_t _freeAlloc; // doesn't include objects in magazines
+		size_t _magazineId;
+		Vector<details::PoolMagazine *> _magazines;
 #ifdef _DEBUG
 		Vector<const T *> _allAlloc;
 #endif
@@ -118,6 +150,7 @@ namespace ff
 		, _maxAlloc(0)
 		, _totalAlloc(0)
 		, _freeAlloc(0)
+		, _magazineId(threadSafe ? details::NewPoolMagazineId() : 0)
 	{
 	}
 
@@ -130,6 +163,8 @@ namespace ff
 		, _maxAlloc(rhs._maxAlloc)
 		, _totalAlloc(rhs._totalAlloc)
 		, _freeAlloc(rhs._freeAlloc)
+		, _magazineId(rhs._magazineId)
+		, _magazines(std::move(rhs._magazines))
 #ifdef _DEBUG
 		, _allAlloc(std::move(rhs._allAlloc))
 #endif
@@ -141,12 +176,20 @@ namespace ff
 		rhs._maxAlloc = 0;
 		rhs._totalAlloc = 0;
 		rhs._freeAlloc = 0;
+
+		// thread magazines now belong to this pool, along with the objects in them
+		rhs._magazineId = _magazineId ? details::NewPoolMagazineId() : 0;
 	}
 
 	template<typename T>
 	PoolAllocator<T>::~PoolAllocator()
 	{
-		assert(_curAlloc == 0);
+		assert(GetCurAlloc() == 0);
+
+		for (details::PoolMagazine *magazine: _magazines)
+		{
+			delete magazine;
+		}
 #ifdef _DEBUG
 		for (const T *leaked: _allAlloc)
 		{
@@ -172,8 +215,43 @@ namespace ff
 	template<typename T>
 	T *PoolAllocator<T>::NewUnconstructed()
 	{
+		details::PoolObj<T> *poolObj;
+
+		if (_magazineId)
+		{
+			details::PoolMagazine *magazine = GetMagazine();
+			if (!magazine->_count)
+			{
+				RefillMagazine(magazine);
+			}
+
+			poolObj = reinterpret_cast<details::PoolObj<T> *>(magazine->_objs[--magazine->_count]);
+			magazine->_allocs++;
+
+			assert(poolObj->_nextFree == MagazineMark());
+			poolObj->_nextFree = nullptr;
+		}
+		else
+		{
+			LockMutex lock(_mutex);
+			poolObj = PopFree();
+
+			_curAlloc++;
+			_totalAlloc++;
+			_maxAlloc = std::max<size_t>(_curAlloc, _maxAlloc);
+		}
+#ifdef _DEBUG
+		// just in case this pool is static
 		LockMutex lock(_mutex);
+		ScopeStaticMemAlloc staticAlloc;
+		_allAlloc.Push(poolObj->ToObj());
+#endif
+		return poolObj->ToObj();
+	}
 
+	template<typename T>
+	details::PoolObj<T> *PoolAllocator<T>::PopFree()
+	{
 		if (_firstFree == nullptr)
 		{
 			// figure out the size of the new pool by doubling the size of the last pool
@@ -190,17 +268,83 @@ namespace ff
 		details::PoolObj<T> *poolObj = _firstFree;
 		_firstFree = poolObj->_nextFree;
 		poolObj->_nextFree = nullptr;
-
 		_freeAlloc--;
-		_curAlloc++;
-		_totalAlloc++;
-		_maxAlloc = std::max<size_t>(_curAlloc, _maxAlloc);
-#ifdef _DEBUG
-		// just in case this pool is static
-		ScopeStaticMemAlloc staticAlloc;
-		_allAlloc.Push(poolObj->ToObj());
-#endif
-		return poolObj->ToObj();
+
+		return poolObj;
+	}
+
+	template<typename T>
+	void PoolAllocator<T>::PushFree(details::PoolObj<T> *poolObj)
+	{
+		poolObj->_nextFree = _firstFree;
+		_firstFree = poolObj;
+		_freeAlloc++;
+	}
+
+	template<typename T>
+	details::PoolMagazine *PoolAllocator<T>::GetMagazine()
+	{
+		details::PoolMagazine *magazine = details::GetThreadPoolMagazine(_magazineId);
+
+		if (magazine == nullptr)
+		{
+			// first use of this pool on the current thread
+			LockMutex lock(_mutex);
+			ScopeStaticMemAlloc staticAlloc;
+
+			magazine = new details::PoolMagazine();
+			_magazines.Push(magazine);
+			details::SetThreadPoolMagazine(_magazineId, magazine);
+		}
+
+		return magazine;
+	}
+
+	template<typename T>
+	void PoolAllocator<T>::RefillMagazine(details::PoolMagazine *magazine)
+	{
+		LockMutex lock(_mutex);
+		assert(!magazine->_count);
+
+		for (size_t i = 0; i < details::PoolMagazine::MAX_COUNT / 2; i++)
+		{
+			details::PoolObj<T> *poolObj = PopFree();
+			poolObj->_nextFree = MagazineMark();
+			magazine->_objs[magazine->_count++] = poolObj;
+		}
+
+		_curAlloc += magazine->_count;
+		_maxAlloc = std::max<size_t>(InternalCurAlloc(), _maxAlloc);
+	}
+
+	template<typename T>
+	void PoolAllocator<T>::DrainMagazine(details::PoolMagazine *magazine)
+	{
+		LockMutex lock(_mutex);
+		assert(magazine->_count == details::PoolMagazine::MAX_COUNT);
+
+		_maxAlloc = std::max<size_t>(InternalCurAlloc(), _maxAlloc);
+
+		for (size_t i = 0; i < details::PoolMagazine::MAX_COUNT / 2; i++)
+		{
+			PushFree(reinterpret_cast<details::PoolObj<T> *>(magazine->_objs[--magazine->_count]));
+		}
+
+		_curAlloc -= details::PoolMagazine::MAX_COUNT / 2;
+	}
+
+	template<typename T>
+	size_t PoolAllocator<T>::InternalCurAlloc() const
+	{
+		// Other threads may be changing their magazines, so this is only exact when they're idle
+		size_t curAlloc = _curAlloc;
+
+		for (const details::PoolMagazine *magazine: _magazines)
+		{
+			curAlloc -= magazine->_count;
+		}
+
+		return curAlloc;
 	}
 
 	template<typename T>
@@ -234,19 +378,35 @@ namespace ff
 		{
 			details::PoolObj<T> *poolObj = details::PoolObj<T>::FromObj(obj);
 			obj->~T();
-
-			LockMutex lock(_mutex);
 			assert(!poolObj->_nextFree);
-			poolObj->_nextFree = _firstFree;
-			_firstFree = poolObj;
-
-			assert(_curAlloc > 0);
-			_freeAlloc++;
-			_curAlloc--;
 #ifdef _DEBUG
-			_allAlloc[_allAlloc.Find(obj)] = _allAlloc.GetLast();
-			_allAlloc.Pop();
+			{
+				LockMutex lock(_mutex);
+				_allAlloc[_allAlloc.Find(obj)] = _allAlloc.GetLast();
+				_allAlloc.Pop();
+			}
 #endif
+			if (_magazineId)
+			{
+				// The object may have come from another thread's magazine, that's fine
+				// since any object from this pool can go into any of its magazines.
+				details::PoolMagazine *magazine = GetMagazine();
+				if (magazine->_count == details::PoolMagazine::MAX_COUNT)
+				{
+					DrainMagazine(magazine);
+				}
+
+				poolObj->_nextFree = MagazineMark();
+				magazine->_objs[magazine->_count++] = poolObj;
+			}
+			else
+			{
+				LockMutex lock(_mutex);
+				PushFree(poolObj);
+
+				assert(_curAlloc > 0);
+				_curAlloc--;
+			}
 		}
 	}
 
@@ -254,20 +414,30 @@ namespace ff
 	size_t PoolAllocator<T>::GetCurAlloc() const
 	{
 		LockMutex lock(_mutex);
-		return _curAlloc;
+		return InternalCurAlloc();
 	}
 
 	template<typename T>
 	size_t PoolAllocator<T>::GetTotalAlloc() const
 	{
 		LockMutex lock(_mutex);
-		return _totalAlloc;
+		size_t totalAlloc = _totalAlloc;
+
+		for (const details::PoolMagazine *magazine: _magazines)
+		{
+			totalAlloc += magazine->_allocs;
+		}
+
+		return totalAlloc;
 	}
 
 	template<typename T>
 	size_t PoolAllocator<T>::GetMaxAlloc() const
 	{
+		// With magazines, the max is only checked when objects move in and out of them,
+		// so it can be low by a magazine's worth of objects per thread.
 		LockMutex lock(_mutex);
+		_maxAlloc = std::max<size_t>(InternalCurAlloc(), _maxAlloc);
 		return _maxAlloc;
 	}
 
@@ -275,14 +445,21 @@ namespace ff
 	size_t PoolAllocator<T>::GetNumFree() const
 	{
 		LockMutex lock(_mutex);
-		return _freeAlloc;
+		size_t freeAlloc = _freeAlloc;
+
+		for (const details::PoolMagazine *magazine: _magazines)
+		{
+			freeAlloc += magazine->_count;
+		}
+
+		return freeAlloc;
 	}
 
 	template<typename T>
 	size_t PoolAllocator<T>::MemUsage() const
 	{
 		LockMutex lock(_mutex);
-		size_t bytes = _subPools.ByteSize();
+		size_t bytes = _subPools.ByteSize() + _magazines.Size() * sizeof(details::PoolMagazine);
 
 		for (const details::SubPool<T> &subPool: _subPools)
 		{
@@ -31,6 +31,11 @@ namespace ff
 		BucketIter GetAt(size_t nIndex)  const;
 		BucketIter GetNext(BucketIter pos) const;
 
+		// for when the hash is already known, KeyView can be any type that KeyEquals() can compare to Key
+		BucketIter SetKeyWithHash(hash_t hash, const Key &key); // doesn't allow duplicates
+		BucketIter SetKeyWithHash(hash_t hash, Key &&key); // doesn't allow duplicates
+		template<typename KeyView> BucketIter GetWithHash(hash_t hash, const KeyView &key) const;
+
 		const Key &KeyAt(BucketIter pos) const;
 		hash_t     HashAt(BucketIter pos) const;
 
@@ -449,6 +454,58 @@ ff::BucketIter ff::Set<Key, Hash>::GetNext(BucketIter pos) const
 	return GetBucketIter(nullptr);
 }
 
+template<typename Key, typename Hash>
+ff::BucketIter ff::Set<Key, Hash>::SetKeyWithHash(hash_t hash, const Key &key)
+{
+	assert(hash == Hash()(key));
+
+	SEntry entry;
+	entry._hash = hash;
+	entry._key = NewKey(key);
+
+	return InsertEntry(&entry, false);
+}
+
+template<typename Key, typename Hash>
+ff::BucketIter ff::Set<Key, Hash>::SetKeyWithHash(hash_t hash, Key &&key)
+{
+	assert(hash == Hash()(key));
+
+	SEntry entry;
+	entry._hash = hash;
+	entry._key = NewKey(std::move(key));
+
+	return InsertEntry(&entry, false);
+}
+
+template<typename Key, typename Hash>
+template<typename KeyView>
+ff::BucketIter ff::Set<Key, Hash>::GetWithHash(hash_t hash, const KeyView &key) const
+{
+	if (_size)
+	{
+		BucketType *pBucket = _buckets[GetHashBucket(hash)];
+
+		if (pBucket)
+		{
+			// Buckets are sorted by hash first, so only entries with the same hash need a key compare
+			SEntry *pEnd = pBucket->Data() + pBucket->Size();
+			SEntry *pEntry = std::lower_bound(pBucket->Data(), pEnd, hash,
+				[](const SEntry &entry, hash_t hash) { return entry._hash < hash; });
+
+			for (; pEntry != pEnd && pEntry->_hash == hash; pEntry++)
+			{
+				if (KeyEquals(*pEntry->_key, key))
+				{
+					return GetBucketIter(pEntry);
+				}
+			}
+		}
+	}
+
+	return GetBucketIter(nullptr);
+}
+
 template<typename Key, typename Hash>
 const Key &ff::Set<Key, Hash>::KeyAt(BucketIter pos) const
 {
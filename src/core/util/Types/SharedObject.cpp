@@ -0,0 +1,97 @@
+#include "pch.h"
+
+namespace ff
+{
+	namespace details
+	{
+		struct BiasedRefMerge
+		{
+			void *_obj;
+			BiasedRefMergeFunc _func;
+		};
+
+		struct BiasedRefThread
+		{
+			BiasedRefThread() : _ended(false) { }
+
+			Mutex _mutex;
+			Vector<BiasedRefMerge> _merges;
+			bool _ended;
+		};
+	}
+}
+
+// STATIC_DATA (pod)
+static __declspec(thread) ff::details::BiasedRefThread *s_biasedRefThread = nullptr;
+
+static void RunBiasedRefMerges(ff::details::BiasedRefThread *thread, bool ended)
+{
+	ff::Vector<ff::details::BiasedRefMerge> merges;
+	{
+		ff::LockMutex lock(thread->_mutex);
+		thread->_ended = thread->_ended || ended;
+		merges = thread->_merges;
+		thread->_merges.ClearAndReduce();
+	}
+
+	// Merging can delete objects, which can queue up more merges
+	for (const ff::details::BiasedRefMerge &merge: merges)
+	{
+		merge._func(merge._obj);
+	}
+}
+
+ff::details::BiasedRefThread *ff::details::GetBiasedRefThread()
+{
+	return s_biasedRefThread;
+}
+
+void ff::details::QueueBiasedRefMerge(BiasedRefThread *owner, void *obj, BiasedRefMergeFunc func)
+{
+	assertRet(owner);
+	{
+		LockMutex lock(owner->_mutex);
+
+		if (!owner->_ended)
+		{
+			BiasedRefMerge merge;
+			merge._obj = obj;
+			merge._func = func;
+			owner->_merges.Push(merge);
+			return;
+		}
+	}
+
+	// The owner thread is done with its biased counts, so anyone can merge them now
+	func(obj);
+}
+
+void ff::BeginBiasedRefThread()
+{
+	if (!s_biasedRefThread)
+	{
+		// Other threads can still queue merges after this thread ends, so the record is never freed
+		ScopeStaticMemAlloc staticAlloc;
+		s_biasedRefThread = new details::BiasedRefThread();
+	}
+}
+
+void ff::MergeBiasedRefs()
+{
+	if (s_biasedRefThread)
+	{
+		RunBiasedRefMerges(s_biasedRefThread, false);
+	}
+}
+
+void ff::EndBiasedRefThread()
+{
+	details::BiasedRefThread *thread = s_biasedRefThread;
+
+	if (thread)
+	{
+		// Objects owned by this thread use their interlocked counts from now on
+		s_biasedRefThread = nullptr;
+		RunBiasedRefMerges(thread, true);
+	}
+}
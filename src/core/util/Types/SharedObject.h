@@ -2,13 +2,41 @@
 
 namespace ff
 {
+	namespace details
+	{
+		/// Per-thread record for biased reference counting, see SharedObject.
+		///
+		/// Threads only have one between BeginBiasedRefThread and EndBiasedRefThread (ThreadGlobals
+		/// does that), other threads get nullptr and always use interlocked counts. Records are
+		/// never freed or reused, so an object's owner can't be mistaken for a newer thread.
+		struct BiasedRefThread;
+
+		typedef void (*BiasedRefMergeFunc)(void *obj);
+
+		UTIL_API BiasedRefThread *GetBiasedRefThread();
+		UTIL_API void QueueBiasedRefMerge(BiasedRefThread *owner, void *obj, BiasedRefMergeFunc func);
+	}
+
+	// Threads that own biased counts should call MergeBiasedRefs now and then (like once a frame
+	// or after each work item), otherwise objects handed off to other threads stay alive until
+	// EndBiasedRefThread.
+	UTIL_API void BeginBiasedRefThread();
+	UTIL_API void MergeBiasedRefs();
+	UTIL_API void EndBiasedRefThread();
+
 	/// Stupidity to avoid infinite template recursion
 	template<typename T>
 	struct SharedObjectAllocator;
 
 	/// This adds shared reference counting to any object.
 	///
-	/// AddRef and Release are thread safe.
+	/// AddRef and Release are thread safe. The count is biased toward the thread that created
+	/// the object, which changes its own part of the count without interlocked operations.
+	/// Other threads use a separate interlocked count. When the owner lets go of its last
+	/// reference, the counts are merged and every thread uses the interlocked count from then on.
+	/// If other threads release more than they added first, the owner merges later on
+	/// (see MergeBiasedRefs). New objects must get their first reference on the creating thread,
+	/// like GetUnshared does.
 	template<typename T, typename Allocator = SharedObjectAllocator<T>>
 	class SharedObject : public T
 	{
@@ -33,8 +61,20 @@ namespace ff
 		static void GetUnshared(MyType **obj);
 
 	private:
-		long _refs;
-		unsigned int _threadId;
+		void ReleaseShared();
+		void MergeUnused();
+		static void MergeQueued(void *obj);
+
+		// The low bits of _shared are flags, the count is above them
+		static const long REF_MERGED = 1;
+		static const long REF_QUEUED = 2;
+		static const long REF_SHIFT = 2;
+		static const long REF_ONE = 1 << REF_SHIFT;
+		static const long REFS_DISABLED = LONG_MIN | REF_MERGED;
+
+		details::BiasedRefThread *_owner;
+		long _biased; // only used by the owner thread until merged
+		long _shared;
 	};
 
 	template<typename T>
@@ -44,72 +84,91 @@ namespace ff
 
 	template<typename T, typename Allocator>
 	SharedObject<T, Allocator>::SharedObject()
-		: _refs(0)
-		, _threadId(GetCurrentThreadId())
+		: _owner(details::GetBiasedRefThread())
+		, _biased(0)
+		, _shared(_owner ? 0 : REF_MERGED)
 	{
 	}
 
 	template<typename T, typename Allocator>
 	SharedObject<T, Allocator>::SharedObject(const MyType &rhs)
 		: T(rhs)
-		, _refs(0)
-		, _threadId(GetCurrentThreadId())
+		, _owner(details::GetBiasedRefThread())
+		, _biased(0)
+		, _shared(_owner ? 0 : REF_MERGED)
 	{
 	}
 
 	template<typename T, typename Allocator>
 	SharedObject<T, Allocator>::SharedObject(MyType &&rhs)
 		: T(std::move(rhs))
-		, _refs(rhs._refs)
-		, _threadId(rhs._threadId)
+		, _owner(rhs._owner)
+		, _biased(rhs._biased)
+		, _shared(rhs._shared)
 	{
-		rhs._refs = 0;
+		rhs._biased = 0;
+		rhs._shared = REF_MERGED;
 	}
 
 	template<typename T, typename Allocator>
 	SharedObject<T, Allocator>::SharedObject(const T &rhs)
 		: T(rhs)
-		, _refs(0)
-		, _threadId(GetCurrentThreadId())
+		, _owner(details::GetBiasedRefThread())
+		, _biased(0)
+		, _shared(_owner ? 0 : REF_MERGED)
 	{
 	}
 
 	template<typename T, typename Allocator>
 	SharedObject<T, Allocator>::SharedObject(T &&rhs)
 		: T(std::move(rhs))
-		, _refs(0)
-		, _threadId(GetCurrentThreadId())
+		, _owner(details::GetBiasedRefThread())
+		, _biased(0)
+		, _shared(_owner ? 0 : REF_MERGED)
 	{
 	}
 
 	template<typename T, typename Allocator>
 	SharedObject<T, Allocator>::~SharedObject()
 	{
-		assert(_refs == 0 || _refs == -1);
+		assert(!_biased && (!(_shared >> REF_SHIFT) || _shared == REFS_DISABLED));
 	}
 
 	template<typename T, typename Allocator>
 	void SharedObject<T, Allocator>::AddRef()
 	{
-		if (_refs != -1)
+		if (IsOwnerThread())
+		{
+			_biased++;
+		}
+		else if (_shared != REFS_DISABLED)
 		{
-			InterlockedIncrement(&_refs);
+			InterlockedExchangeAdd(&_shared, REF_ONE);
 		}
 	}
 
 	template<typename T, typename Allocator>
 	void SharedObject<T, Allocator>::Release()
 	{
-		if (_refs != -1 && InterlockedDecrement(&_refs) == 0)
+		if (IsOwnerThread())
+		{
+			if (!--_biased)
+			{
+				MergeUnused();
+			}
+		}
+		else if (_shared != REFS_DISABLED)
 		{
-			Allocator().DeleteOne(this);
+			ReleaseShared();
 		}
 	}
 
 	template<typename T, typename Allocator>
 	void SharedObject<T, Allocator>::DisableRefs()
 	{
-		_refs = -1;
+		_owner = nullptr;
+		_biased = 0;
+		_shared = REFS_DISABLED;
 	}
 
 	template<typename T, typename Allocator>
@@ -117,13 +176,92 @@ namespace ff
 	{
 		// Shared objects aren't designed to be modified and used on different threads.
 		// Multi-thread use must be strictly read-only (so an interlocked check here isn't necessary).
-		return _refs != 1;
+		return _biased + (_shared >> REF_SHIFT) != 1;
 	}
 
 	template<typename T, typename Allocator>
 	bool SharedObject<T, Allocator>::IsOwnerThread() const
 	{
-		return GetCurrentThreadId() == _threadId;
+		// Only the owner thread merges, so it can trust this flag without an interlocked read
+		return !(_shared & REF_MERGED) && _owner == details::GetBiasedRefThread();
+	}
+
+	template<typename T, typename Allocator>
+	void SharedObject<T, Allocator>::ReleaseShared()
+	{
+		if (_shared & REF_MERGED)
+		{
+			// Once merged, the whole count is shared
+			if (InterlockedExchangeAdd(&_shared, -REF_ONE) < REF_ONE * 2)
+			{
+				Allocator().DeleteOne(this);
+			}
+
+			return;
+		}
+
+		long oldRefs;
+		long newRefs;
+
+		do
+		{
+			oldRefs = _shared;
+			newRefs = oldRefs - REF_ONE;
+
+			if (!(newRefs & REF_MERGED) && newRefs < 0)
+			{
+				// The owner's biased references must be keeping this alive
+				newRefs |= REF_QUEUED;
+			}
+		}
+		while (InterlockedCompareExchange(&_shared, newRefs, oldRefs) != oldRefs);
+
+		if (newRefs & REF_MERGED)
+		{
+			if (newRefs < REF_ONE)
+			{
+				Allocator().DeleteOne(this);
+			}
+		}
+		else if ((newRefs & REF_QUEUED) && !(oldRefs & REF_QUEUED))
+		{
+			details::QueueBiasedRefMerge(_owner, this, &MyType::MergeQueued);
+		}
+	}
+
+	template<typename T, typename Allocator>
+	void SharedObject<T, Allocator>::MergeUnused()
+	{
+		// The owner thread has no references left, so other threads can have the whole count
+		for (long refs = _shared; !(refs & REF_QUEUED); refs = _shared)
+		{
+			if (InterlockedCompareExchange(&_shared, refs | REF_MERGED, refs) == refs)
+			{
+				if (refs < REF_ONE)
+				{
+					Allocator().DeleteOne(this);
+				}
+
+				return;
+			}
+		}
+
+		// Otherwise the owner thread will merge when the queue gets to this object
+	}
+
+	// static
+	template<typename T, typename Allocator>
+	void SharedObject<T, Allocator>::MergeQueued(void *obj)
+	{
+		// Called on the owner thread, or after it ended
+		MyType *self = static_cast<MyType *>(obj);
+		long biased = self->_biased * REF_ONE + REF_MERGED;
+		self->_biased = 0;
+
+		if (InterlockedExchangeAdd(&self->_shared, biased) + biased < REF_ONE)
+		{
+			Allocator().DeleteOne(self);
+		}
 	}
 
 	// static
@@ -135,12 +273,12 @@ namespace ff
 		if (*obj == nullptr)
 		{
 			*obj = Allocator().NewOne();
-			(*obj)->_refs = 1;
+			(*obj)->AddRef();
 		}
 		else if ((*obj)->IsShared())
 		{
 			MyType *newObj = Allocator().NewOne(**obj);
-			newObj->_refs = 1;
+			newObj->AddRef();
 			(*obj)->Release();
 			*obj = newObj;
 		}
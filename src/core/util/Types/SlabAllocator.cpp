@@ -0,0 +1,538 @@
+#include "pch.h"
+#include "App/Log.h"
+#include "Types/SlabAllocator.h"
+
+static const size_t SLAB_HEADER_SIZE = 64;
+static const size_t SLAB_SHIFT = 16;
+static const size_t LARGE_HEADER_SIZE = 16;
+static const size_t LARGE_BLOCK_TAG = 'EGRL';
+
+// Free can only mask an address to find its slab if the block really is in a slab, a big block from
+// the heap has nothing readable there. So each 64K of address space has a bit that says if it's a slab.
+// The bits are in leaves that only get allocated for parts of the address space that have slabs.
+static const size_t SLAB_ADDRESS_BITS = (sizeof(void *) == 8) ? 47 : 32;
+static const size_t SLAB_MAP_LEAF_BITS = (sizeof(void *) == 8) ? 20 : 16;
+static const size_t SLAB_MAP_ROOT_SIZE = static_cast<size_t>(1) << (SLAB_ADDRESS_BITS - SLAB_SHIFT - SLAB_MAP_LEAF_BITS);
+static const size_t SLAB_MAP_WORD_BITS = sizeof(size_t) * 8;
+static const size_t SLAB_MAP_LEAF_WORDS = (static_cast<size_t>(1) << SLAB_MAP_LEAF_BITS) / SLAB_MAP_WORD_BITS;
+static_assert(ff::SlabAllocator::SLAB_SIZE == static_cast<size_t>(1) << SLAB_SHIFT, "SLAB_SHIFT doesn't match SLAB_SIZE");
+
+// Lives at the start of each slab, the blocks come after it
+struct ff::SlabAllocator::Slab
+{
+	Slab *_next; // in the size class's list of slabs with free blocks
+	Slab *_prev;
+	void *_firstFree;
+	BYTE *_unused; // blocks past here have never been handed out
+	size_t _used;
+	size_t _capacity;
+	size_t _sizeClass;
+	size_t _bytes;
+};
+
+// In front of each block that's too big for a size class
+struct ff::SlabAllocator::LargeHeader
+{
+	size_t _bytes;
+	size_t _tag; // LARGE_BLOCK_TAG
+};
+
+struct ff::SlabAllocator::SizeClass
+{
+	Mutex _mutex;
+	size_t _size;
+	size_t _batch; // how many blocks move between a magazine and the slabs at once
+	size_t _magazineId;
+	Slab *_partial;
+	Slab *_empty;
+	Vector<details::PoolMagazine *> _magazines;
+	size_t _curAlloc; // includes blocks in magazines
+	size_t _maxAlloc;
+	size_t _slabs;
+};
+
+static BYTE *AllocPages(size_t bytes)
+{
+#if METRO_APP
+	return reinterpret_cast<BYTE *>(_aligned_malloc(bytes, ff::SlabAllocator::SLAB_SIZE));
+#else
+	// VirtualAlloc always returns addresses aligned to 64K
+	return reinterpret_cast<BYTE *>(::VirtualAlloc(nullptr, bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+#endif
+}
+
+static void FreePages(BYTE *mem)
+{
+#if METRO_APP
+	_aligned_free(mem);
+#else
+	::VirtualFree(mem, 0, MEM_RELEASE);
+#endif
+}
+
+ff::SlabAllocator &ff::GetSlabAllocator()
+{
+	// STATIC_DATA (object)
+	static SlabAllocator *s_slabAllocator = nullptr;
+
+	if (!s_slabAllocator)
+	{
+		LockMutex lock(GCS_MEM_ALLOC);
+
+		if (!s_slabAllocator)
+		{
+			ScopeStaticMemAlloc staticAlloc;
+			s_slabAllocator = new SlabAllocator();
+		}
+	}
+
+	return *s_slabAllocator;
+}
+
+ff::SlabAllocator::SlabAllocator()
+	: _classes(nullptr)
+	, _classCount(0)
+	, _largeCurAlloc(0)
+	, _largeMaxAlloc(0)
+	, _largeTotalAlloc(0)
+{
+	ScopeStaticMemAlloc staticAlloc;
+	_slabMap = new size_t *[SLAB_MAP_ROOT_SIZE]();
+
+	// Four size classes for each power of two: 16, 32, 48, 64, 80, 96, 112, 128, 160...
+	size_t sizes[64];
+
+	for (size_t size = 16; size <= 64; size += 16)
+	{
+		sizes[_classCount++] = size;
+	}
+
+	for (size_t base = 64; base < MAX_SIZE; base *= 2)
+	{
+		for (size_t i = 1; i <= 4; i++)
+		{
+			sizes[_classCount++] = base + base / 4 * i;
+		}
+	}
+
+	_classes = new SizeClass[_classCount];
+
+	for (size_t i = 0, size = 0; i < _classCount; i++)
+	{
+		SizeClass &sizeClass = _classes[i];
+		sizeClass._size = sizes[i];
+		sizeClass._batch = std::max<size_t>(1, std::min<size_t>(details::PoolMagazine::MAX_COUNT / 2, SLAB_SIZE / 32 / sizes[i]));
+		sizeClass._magazineId = details::NewPoolMagazineId();
+		sizeClass._partial = nullptr;
+		sizeClass._empty = nullptr;
+		sizeClass._curAlloc = 0;
+		sizeClass._maxAlloc = 0;
+		sizeClass._slabs = 0;
+
+		for (; size <= sizes[i]; size += 16)
+		{
+			_classForSize[size / 16] = (BYTE)i;
+		}
+	}
+}
+
+ff::SlabAllocator::~SlabAllocator()
+{
+	assert(_largeCurAlloc == 0);
+
+	for (size_t i = 0; i < _classCount; i++)
+	{
+		SizeClass &sizeClass = _classes[i];
+		assert(InternalCurAlloc(sizeClass) == 0);
+
+		for (details::PoolMagazine *magazine: sizeClass._magazines)
+		{
+			while (magazine->_count)
+			{
+				FreeToSlab(sizeClass, magazine->_objs[--magazine->_count]);
+			}
+
+			delete magazine;
+		}
+
+		// Full slabs aren't in any list, so they only get freed when nothing was leaked
+		while (sizeClass._partial)
+		{
+			Slab *slab = sizeClass._partial;
+			sizeClass._partial = slab->_next;
+			DeleteSlab(slab);
+		}
+
+		if (sizeClass._empty)
+		{
+			DeleteSlab(sizeClass._empty);
+		}
+	}
+
+	delete[] _classes;
+
+	for (size_t i = 0; i < SLAB_MAP_ROOT_SIZE; i++)
+	{
+		delete[] _slabMap[i];
+	}
+
+	delete[] _slabMap;
+}
+
+void *ff::SlabAllocator::Alloc(size_t bytes)
+{
+	if (bytes > MAX_SIZE)
+	{
+		return AllocLarge(bytes);
+	}
+
+	SizeClass &sizeClass = _classes[_classForSize[(bytes + 15) / 16]];
+	details::PoolMagazine *magazine = GetMagazine(sizeClass);
+
+	if (!magazine->_count)
+	{
+		RefillMagazine(sizeClass, magazine);
+		assertRetVal(magazine->_count, nullptr);
+	}
+
+	magazine->_allocs++;
+	return magazine->_objs[--magazine->_count];
+}
+
+void ff::SlabAllocator::Free(void *mem)
+{
+	if (mem)
+	{
+		if (!IsSlab(mem))
+		{
+			FreeLarge(mem);
+		}
+		else
+		{
+			SizeClass &sizeClass = _classes[SlabFromMem(mem)->_sizeClass];
+			details::PoolMagazine *magazine = GetMagazine(sizeClass);
+
+			if (magazine->_count >= sizeClass._batch * 2)
+			{
+				DrainMagazine(sizeClass, magazine);
+			}
+
+			magazine->_objs[magazine->_count++] = mem;
+		}
+	}
+}
+
+size_t ff::SlabAllocator::GetSizeClassCount() const
+{
+	return _classCount;
+}
+
+void ff::SlabAllocator::GetStats(Vector<SlabSizeClassStats> &stats) const
+{
+	stats.Clear();
+	stats.Reserve(_classCount + 1);
+
+	for (size_t i = 0; i < _classCount; i++)
+	{
+		SizeClass &sizeClass = _classes[i];
+		LockMutex lock(sizeClass._mutex);
+
+		SlabSizeClassStats stat;
+		stat._size = sizeClass._size;
+		stat._curAlloc = InternalCurAlloc(sizeClass);
+		stat._maxAlloc = sizeClass._maxAlloc = std::max(sizeClass._maxAlloc, stat._curAlloc);
+		stat._totalAlloc = 0;
+		stat._slabs = sizeClass._slabs;
+
+		for (const details::PoolMagazine *magazine: sizeClass._magazines)
+		{
+			stat._totalAlloc += magazine->_allocs;
+		}
+
+		stats.Push(stat);
+	}
+
+	LockMutex lock(_largeMutex);
+
+	SlabSizeClassStats stat;
+	stat._size = 0;
+	stat._curAlloc = _largeCurAlloc;
+	stat._maxAlloc = _largeMaxAlloc;
+	stat._totalAlloc = _largeTotalAlloc;
+	stat._slabs = _largeCurAlloc;
+
+	stats.Push(stat);
+}
+
+void ff::SlabAllocator::DebugDump() const
+{
+#ifdef _DEBUG
+	Vector<SlabSizeClassStats> stats;
+	GetStats(stats);
+
+	Log::DebugTraceF(L"- DUMPING SLAB ALLOCATION STATS -----------------------\n");
+
+	for (const SlabSizeClassStats &stat: stats)
+	{
+		if (stat._totalAlloc)
+		{
+			Log::DebugTraceF(L"    Size %5lu: total:%8lu, max:%6lu, cur:%6lu, slabs:%4lu\n",
+				stat._size, stat._totalAlloc, stat._maxAlloc, stat._curAlloc, stat._slabs);
+		}
+	}
+
+	Log::DebugTraceF(L"- completed slab dumping ------------------------------\n\n");
+#endif
+}
+
+ff::details::PoolMagazine *ff::SlabAllocator::GetMagazine(SizeClass &sizeClass)
+{
+	details::PoolMagazine *magazine = details::GetThreadPoolMagazine(sizeClass._magazineId);
+
+	if (magazine == nullptr)
+	{
+		// first use of this size class on the current thread
+		LockMutex lock(sizeClass._mutex);
+		ScopeStaticMemAlloc staticAlloc;
+
+		magazine = new details::PoolMagazine();
+		sizeClass._magazines.Push(magazine);
+		details::SetThreadPoolMagazine(sizeClass._magazineId, magazine);
+	}
+
+	return magazine;
+}
+
+void ff::SlabAllocator::RefillMagazine(SizeClass &sizeClass, details::PoolMagazine *magazine)
+{
+	LockMutex lock(sizeClass._mutex);
+	assert(!magazine->_count);
+
+	sizeClass._maxAlloc = std::max(InternalCurAlloc(sizeClass), sizeClass._maxAlloc);
+
+	while (magazine->_count < sizeClass._batch)
+	{
+		Slab *slab = sizeClass._partial;
+
+		if (!slab)
+		{
+			slab = sizeClass._empty ? sizeClass._empty : NewSlab(sizeClass);
+			sizeClass._empty = nullptr;
+
+			if (!slab)
+			{
+				break;
+			}
+
+			slab->_prev = nullptr;
+			slab->_next = nullptr;
+			sizeClass._partial = slab;
+		}
+
+		void *mem = slab->_firstFree;
+
+		if (mem)
+		{
+			slab->_firstFree = *reinterpret_cast<void **>(mem);
+		}
+		else
+		{
+			mem = slab->_unused;
+			slab->_unused += sizeClass._size;
+		}
+
+		if (++slab->_used == slab->_capacity)
+		{
+			// full slabs aren't in any list, freeing a block puts them back
+			sizeClass._partial = slab->_next;
+
+			if (slab->_next)
+			{
+				slab->_next->_prev = nullptr;
+			}
+		}
+
+		magazine->_objs[magazine->_count++] = mem;
+	}
+
+	sizeClass._curAlloc += magazine->_count;
+}
+
+void ff::SlabAllocator::DrainMagazine(SizeClass &sizeClass, details::PoolMagazine *magazine)
+{
+	LockMutex lock(sizeClass._mutex);
+
+	sizeClass._maxAlloc = std::max(InternalCurAlloc(sizeClass), sizeClass._maxAlloc);
+	sizeClass._curAlloc -= sizeClass._batch;
+
+	for (size_t i = 0; i < sizeClass._batch; i++)
+	{
+		FreeToSlab(sizeClass, magazine->_objs[--magazine->_count]);
+	}
+}
+
+void ff::SlabAllocator::FreeToSlab(SizeClass &sizeClass, void *mem)
+{
+	Slab *slab = SlabFromMem(mem);
+
+	*reinterpret_cast<void **>(mem) = slab->_firstFree;
+	slab->_firstFree = mem;
+
+	if (slab->_used-- == slab->_capacity)
+	{
+		// it was full, so now it can hand out blocks again
+		slab->_prev = nullptr;
+		slab->_next = sizeClass._partial;
+
+		if (slab->_next)
+		{
+			slab->_next->_prev = slab;
+		}
+
+		sizeClass._partial = slab;
+	}
+
+	if (!slab->_used)
+	{
+		if (slab->_prev)
+		{
+			slab->_prev->_next = slab->_next;
+		}
+		else
+		{
+			sizeClass._partial = slab->_next;
+		}
+
+		if (slab->_next)
+		{
+			slab->_next->_prev = slab->_prev;
+		}
+
+		if (sizeClass._empty)
+		{
+			DeleteSlab(slab);
+			sizeClass._slabs--;
+		}
+		else
+		{
+			sizeClass._empty = slab;
+		}
+	}
+}
+
+void *ff::SlabAllocator::AllocLarge(size_t bytes)
+{
+	// Going to the OS for every big block is slow, so they come from the CRT heap instead
+	static_assert(sizeof(LargeHeader) <= LARGE_HEADER_SIZE, "Large block header is too big");
+	BYTE *mem = reinterpret_cast<BYTE *>(_aligned_malloc(bytes + LARGE_HEADER_SIZE, LARGE_HEADER_SIZE));
+	assertRetVal(mem, nullptr);
+
+	LargeHeader *header = reinterpret_cast<LargeHeader *>(mem);
+	header->_bytes = bytes;
+	header->_tag = LARGE_BLOCK_TAG;
+
+	LockMutex lock(_largeMutex);
+	_largeCurAlloc++;
+	_largeTotalAlloc++;
+	_largeMaxAlloc = std::max(_largeCurAlloc, _largeMaxAlloc);
+
+	return mem + LARGE_HEADER_SIZE;
+}
+
+void ff::SlabAllocator::FreeLarge(void *mem)
+{
+	LargeHeader *header = reinterpret_cast<LargeHeader *>(reinterpret_cast<BYTE *>(mem) - LARGE_HEADER_SIZE);
+	assertRet(header->_tag == LARGE_BLOCK_TAG);
+
+	header->_tag = 0;
+	_aligned_free(header);
+
+	LockMutex lock(_largeMutex);
+	assert(_largeCurAlloc > 0);
+	_largeCurAlloc--;
+}
+
+ff::SlabAllocator::Slab *ff::SlabAllocator::NewSlab(SizeClass &sizeClass)
+{
+	static_assert(sizeof(Slab) <= SLAB_HEADER_SIZE, "Slab header is too big");
+
+	BYTE *mem = AllocPages(SLAB_SIZE);
+	assertRetVal(mem, nullptr);
+
+	Slab *slab = reinterpret_cast<Slab *>(mem);
+	slab->_next = nullptr;
+	slab->_prev = nullptr;
+	slab->_firstFree = nullptr;
+	slab->_unused = mem + SLAB_HEADER_SIZE;
+	slab->_used = 0;
+	slab->_capacity = (SLAB_SIZE - SLAB_HEADER_SIZE) / sizeClass._size;
+	slab->_sizeClass = &sizeClass - _classes;
+	slab->_bytes = SLAB_SIZE;
+
+	if (!SetSlabBit(mem, true))
+	{
+		FreePages(mem);
+		return nullptr;
+	}
+
+	sizeClass._slabs++;
+
+	return slab;
+}
+
+void ff::SlabAllocator::DeleteSlab(Slab *slab)
+{
+	SetSlabBit(slab, false);
+	FreePages(reinterpret_cast<BYTE *>(slab));
+}
+
+size_t ff::SlabAllocator::InternalCurAlloc(const SizeClass &sizeClass)
+{
+	// Other threads may be changing their magazines, so this is only exact when they're idle
+	size_t curAlloc = sizeClass._curAlloc;
+
+	for (const details::PoolMagazine *magazine: sizeClass._magazines)
+	{
+		curAlloc -= magazine->_count;
+	}
+
+	return curAlloc;
+}
+
+ff::SlabAllocator::Slab *ff::SlabAllocator::SlabFromMem(void *mem)
+{
+	return reinterpret_cast<Slab *>(reinterpret_cast<size_t>(mem) & ~(SLAB_SIZE - 1));
+}
+
+bool ff::SlabAllocator::IsSlab(const void *mem) const
+{
+	size_t index = reinterpret_cast<size_t>(mem) >> SLAB_SHIFT;
+	size_t root = index >> SLAB_MAP_LEAF_BITS;
+	size_t bit = index & ((static_cast<size_t>(1) << SLAB_MAP_LEAF_BITS) - 1);
+	const size_t *leaf = (root < SLAB_MAP_ROOT_SIZE) ? _slabMap[root] : nullptr;
+
+	return leaf && (leaf[bit / SLAB_MAP_WORD_BITS] & (static_cast<size_t>(1) << (bit % SLAB_MAP_WORD_BITS))) != 0;
+}
+
+bool ff::SlabAllocator::SetSlabBit(const void *slab, bool isSlab)
+{
+	size_t index = reinterpret_cast<size_t>(slab) >> SLAB_SHIFT;
+	size_t root = index >> SLAB_MAP_LEAF_BITS;
+	size_t bit = index & ((static_cast<size_t>(1) << SLAB_MAP_LEAF_BITS) - 1);
+	assertRetVal(root < SLAB_MAP_ROOT_SIZE, false);
+
+	LockMutex lock(_slabMapMutex);
+
+	if (!_slabMap[root])
+	{
+		// The leaf is zeroed before other threads can see it, they only look up their own slabs
+		ScopeStaticMemAlloc staticAlloc;
+		_slabMap[root] = new size_t[SLAB_MAP_LEAF_WORDS]();
+	}
+
+	size_t &word = _slabMap[root][bit / SLAB_MAP_WORD_BITS];
+	size_t mask = static_cast<size_t>(1) << (bit % SLAB_MAP_WORD_BITS);
+	word = isSlab ? (word | mask) : (word & ~mask);
+
+	return true;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+namespace ff
+{
+	struct SlabSizeClassStats
+	{
+		size_t _size; // zero for allocations too big for a size class
+		size_t _curAlloc;
+		size_t _maxAlloc;
+		size_t _totalAlloc;
+		size_t _slabs;
+	};
+
+	/// General purpose allocator for small blocks of memory, sorted into size classes.
+	///
+	/// Each size class carves its blocks out of 64K slabs that come straight from the OS,
+	/// and slabs are given back once all of their blocks are freed (one empty slab per size
+	/// class is kept around). Threads allocate and free through a small per-thread cache,
+	/// so most calls don't lock. Blocks can be freed on any thread and are 16 byte aligned.
+	/// Anything bigger than the largest size class comes from the CRT heap.
+	class SlabAllocator
+	{
+	public:
+		UTIL_API SlabAllocator();
+		UTIL_API ~SlabAllocator();
+
+		UTIL_API void *Alloc(size_t bytes);
+		UTIL_API void Free(void *mem);
+
+		UTIL_API size_t GetSizeClassCount() const;
+		UTIL_API void GetStats(Vector<SlabSizeClassStats> &stats) const; // the last one is for big allocations
+		UTIL_API void DebugDump() const;
+
+		static const size_t SLAB_SIZE = 64 * 1024;
+		static const size_t MAX_SIZE = 8 * 1024;
+
+	private:
+		SlabAllocator(const SlabAllocator &rhs) = delete;
+		SlabAllocator &operator=(const SlabAllocator &rhs) = delete;
+
+		struct Slab;
+		struct SizeClass;
+		struct LargeHeader;
+
+		details::PoolMagazine *GetMagazine(SizeClass &sizeClass);
+		void RefillMagazine(SizeClass &sizeClass, details::PoolMagazine *magazine);
+		void DrainMagazine(SizeClass &sizeClass, details::PoolMagazine *magazine);
+		void FreeToSlab(SizeClass &sizeClass, void *mem);
+		void *AllocLarge(size_t bytes);
+		void FreeLarge(void *mem);
+		Slab *NewSlab(SizeClass &sizeClass);
+		void DeleteSlab(Slab *slab);
+		static size_t InternalCurAlloc(const SizeClass &sizeClass);
+		static Slab *SlabFromMem(void *mem);
+		bool IsSlab(const void *mem) const;
+		bool SetSlabBit(const void *slab, bool isSlab);
+
+		SizeClass *_classes;
+		size_t _classCount;
+		BYTE _classForSize[MAX_SIZE / 16 + 1];
+
+		Mutex _largeMutex;
+		size_t _largeCurAlloc;
+		size_t _largeMaxAlloc;
+		size_t _largeTotalAlloc;
+
+		Mutex _slabMapMutex;
+		size_t *volatile *_slabMap; // one bit for each 64K of address space, set for slabs
+	};
+
+	/// The allocator shared by strings and values. It's never destroyed, so memory
+	/// can be freed to it during any stage of shutdown.
+	UTIL_API SlabAllocator &GetSlabAllocator();
+}
@@ -16,6 +16,7 @@ namespace ff
 
 		// Operators
 		MyType  &operator=(const MyType &rhs);
+		MyType  &operator=(MyType &&rhs);
 		bool     operator==(const MyType &rhs) const;
 		bool     operator!=(const MyType &rhs) const;
 
@@ -310,6 +311,41 @@ ff::Vector<T, StackSize, Allocator> &ff::Vector<T, StackSize, Allocator>::operat
 	return *this;
 }
 
+template<typename T, size_t StackSize, typename Allocator>
+ff::Vector<T, StackSize, Allocator> &ff::Vector<T, StackSize, Allocator>::operator=(MyType &&rhs)
+{
+	if (this != &rhs)
+	{
+		if (!IS_POD && !IsStaticData())
+		{
+			for (size_t i = 0; i < _size; i++)
+			{
+				_data[i].~T();
+			}
+		}
+
+		ReleaseData();
+
+		if (rhs._data == reinterpret_cast<T *>(rhs._stack))
+		{
+			std::memcpy(_data, rhs._data, rhs.ByteSize());
+		}
+		else
+		{
+			_data = rhs._data;
+		}
+
+		_alloc = rhs._alloc;
+		_size = rhs._size;
+
+		rhs._data  = reinterpret_cast<T *>(rhs._stack);
+		rhs._alloc = StackSize;
+		rhs._size  = 0;
+	}
+
+	return *this;
+}
+
 template<typename T, size_t StackSize, typename Allocator>
 bool ff::Vector<T, StackSize, Allocator>::operator==(const MyType &rhs) const
 {
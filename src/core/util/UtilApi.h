@@ -25,8 +25,11 @@
 #include "Types/List.h"
 
 #include "Types/Set.h"
+#include "Types/FlatHashSet.h"
+#include "Types/IndexSet.h"
 #include "Types/KeyValue.h"
 #include "Types/Map.h"
+#include "Types/FlatMap.h"
 
 #include "Types/Point.h"
 #include "Types/Rect.h"